@@ -0,0 +1,59 @@
+/**
+ * Tests that $out copies the indexes of the output collection when they are built only after all
+ * documents have been written, and that a unique index violation still fails the $out and leaves
+ * the output collection untouched.
+ *
+ * This test assumes that collections are not implicitly sharded, since $out is prohibited if the
+ * output collection is sharded.
+ * @tags: [assumes_unsharded_collection, does_not_support_stepdowns]
+ */
+(function() {
+"use strict";
+
+load("jstests/aggregation/extras/merge_helpers.js");  // For dropWithoutImplicitRecreate.
+load("jstests/libs/fixture_helpers.js");             // For FixtureHelpers.
+
+function setBuildIndexesAfterLoad(value) {
+    FixtureHelpers.runCommandOnEachPrimary({
+        db: db.getSiblingDB("admin"),
+        cmdObj: {setParameter: 1, internalQueryOutBuildIndexesAfterLoad: value}
+    });
+}
+setBuildIndexesAfterLoad(true);
+
+const coll = db.out_builds_indexes_after_load_source;
+const targetCollName = "out_builds_indexes_after_load_target";
+const targetColl = db[targetCollName];
+coll.drop();
+dropWithoutImplicitRecreate(targetCollName);
+
+const numDocs = 1000;
+const bulk = coll.initializeUnorderedBulkOp();
+for (let i = 0; i < numDocs; ++i) {
+    bulk.insert({_id: i, a: i % 10, b: i});
+}
+assert.commandWorked(bulk.execute());
+
+assert.commandWorked(targetColl.insert({_id: "original"}));
+assert.commandWorked(targetColl.createIndex({a: 1}));
+assert.commandWorked(targetColl.createIndex({b: 1}, {unique: true}));
+
+// The secondary indexes are present and usable once $out has replaced the collection.
+coll.aggregate([{$out: targetCollName}]);
+assert.eq(numDocs, targetColl.find().itcount());
+const indexNames = targetColl.getIndexes().map(index => index.name).sort();
+assert.eq(["_id_", "a_1", "b_1"], indexNames);
+assert.eq(numDocs / 10, targetColl.find({a: 3}).hint({a: 1}).itcount());
+assert.eq(1, targetColl.find({b: 7}).hint({b: 1}).itcount());
+
+// Output violating the unique index is only detected when the index is built, but still fails the
+// $out with a duplicate key error and leaves the previous contents in place.
+assert.commandFailedWithCode(
+    db.runCommand(
+        {aggregate: coll.getName(), pipeline: [{$set: {b: 0}}, {$out: targetCollName}], cursor: {}}),
+    ErrorCodes.DuplicateKey);
+assert.eq(numDocs, targetColl.find().itcount());
+assert.eq(1, targetColl.find({b: 7}).itcount());
+
+setBuildIndexesAfterLoad(false);
+}());
@@ -0,0 +1,80 @@
+/**
+ * Tests that the results of read-only aggregations are served from the pipeline result cache when
+ * it is enabled, and that writes to any collection an aggregation reads invalidate its results.
+ */
+(function() {
+"use strict";
+
+const conn = MongoRunner.runMongod({setParameter: {internalQueryEnablePipelineResultCache: true}});
+const db = conn.getDB("test");
+const coll = db.pipeline_result_cache;
+const foreign = db.pipeline_result_cache_foreign;
+
+function getCacheMetrics() {
+    return assert.commandWorked(db.serverStatus()).metrics.query.pipelineResultCache;
+}
+
+// Runs 'pipeline' and asserts that it returns 'expected' and was or was not served from the cache.
+function assertResults(pipeline, expected, {cached}) {
+    const before = getCacheMetrics();
+    assert.eq(expected, coll.aggregate(pipeline).toArray());
+    const after = getCacheMetrics();
+    assert.eq(after.hits - before.hits, cached ? 1 : 0, {before: before, after: after});
+}
+
+assert.commandWorked(coll.insert([{_id: 0, g: "a", v: 1}, {_id: 1, g: "b", v: 2}]));
+assert.commandWorked(foreign.insert({_id: "a", label: "first"}));
+
+const groupPipeline = [{$group: {_id: "$g", total: {$sum: "$v"}}}, {$sort: {_id: 1}}];
+assertResults(groupPipeline, [{_id: "a", total: 1}, {_id: "b", total: 2}], {cached: false});
+assertResults(groupPipeline, [{_id: "a", total: 1}, {_id: "b", total: 2}], {cached: true});
+
+// A write to the collection invalidates the cached results.
+assert.commandWorked(coll.insert({_id: 2, g: "a", v: 3}));
+assertResults(groupPipeline, [{_id: "a", total: 4}, {_id: "b", total: 2}], {cached: false});
+assertResults(groupPipeline, [{_id: "a", total: 4}, {_id: "b", total: 2}], {cached: true});
+
+// So does a write to a foreign collection read by a $lookup.
+const lookupPipeline = [
+    {$match: {_id: 0}},
+    {$lookup: {from: foreign.getName(), localField: "g", foreignField: "_id", as: "labels"}},
+    {$project: {_id: 1, labels: "$labels.label"}}
+];
+assertResults(lookupPipeline, [{_id: 0, labels: ["first"]}], {cached: false});
+assertResults(lookupPipeline, [{_id: 0, labels: ["first"]}], {cached: true});
+assert.commandWorked(foreign.update({_id: "a"}, {$set: {label: "second"}}));
+assertResults(lookupPipeline, [{_id: 0, labels: ["second"]}], {cached: false});
+
+// Dropping and recreating the collection invalidates the cached results.
+assertResults(groupPipeline, [{_id: "a", total: 4}, {_id: "b", total: 2}], {cached: true});
+coll.drop();
+assert.commandWorked(coll.insert({_id: 0, g: "c", v: 5}));
+assertResults(groupPipeline, [{_id: "c", total: 5}], {cached: false});
+
+// Nondeterministic pipelines are never cached.
+const nowPipeline = [{$project: {_id: 1, now: {$gt: ["$$NOW", new Date(0)]}}}];
+assertResults(nowPipeline, [{_id: 0, now: true}], {cached: false});
+assertResults(nowPipeline, [{_id: 0, now: true}], {cached: false});
+
+// Results which do not fit in the first batch are not cached.
+const bigBatchPipeline = [{$match: {}}];
+assert.commandWorked(coll.insert({_id: 1, g: "d", v: 6}));
+for (let i = 0; i < 2; ++i) {
+    const res = assert.commandWorked(db.runCommand(
+        {aggregate: coll.getName(), pipeline: bigBatchPipeline, cursor: {batchSize: 1}}));
+    assert.neq(res.cursor.id, 0, res);
+    assert.commandWorked(db.runCommand({killCursors: coll.getName(), cursors: [res.cursor.id]}));
+}
+
+// The cache is not consulted when it is disabled.
+assert.commandWorked(
+    db.adminCommand({setParameter: 1, internalQueryEnablePipelineResultCache: false}));
+assertResults(groupPipeline, [{_id: "c", total: 5}, {_id: "d", total: 6}], {cached: false});
+assertResults(groupPipeline, [{_id: "c", total: 5}, {_id: "d", total: 6}], {cached: false});
+
+const metrics = getCacheMetrics();
+assert.gt(metrics.inserts, 0, metrics);
+assert.gt(metrics.invalidations, 0, metrics);
+
+MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,59 @@
+/**
+ * Test that a hash-based index intersection executed by the slot-based execution engine spills its
+ * hash table to disk if the query allows disk use. Otherwise the intersection plan runs out of
+ * memory during the trial period and another plan is chosen.
+ * @tags: [requires_find_command]
+ */
+(function() {
+"use strict";
+
+load("jstests/libs/analyze_plan.js");
+
+// Only allow the hash join to use 1 kB of memory.
+const kMaxMemoryUsageBytes = 1024;
+const kNumDocs = 1000;
+
+const conn = MongoRunner.runMongod({
+    setParameter: {
+        internalQueryEnableSlotBasedExecutionEngine: true,
+        internalQueryPlannerEnableHashIntersection: true,
+        internalQueryForceIntersectionPlans: true,
+        internalQueryMaxBlockingSortMemoryUsageBytes: kMaxMemoryUsageBytes,
+    }
+});
+assert.neq(null, conn, "mongod was unable to start up");
+
+const coll = conn.getDB("test").sbe_and_hash_spill;
+coll.drop();
+
+const docs = [];
+for (let i = 0; i < kNumDocs; ++i) {
+    docs.push({_id: i, a: i, b: kNumDocs - i});
+}
+assert.commandWorked(coll.insert(docs));
+assert.commandWorked(coll.createIndexes([{a: 1}, {b: 1}]));
+
+// Range predicates on both fields produce index scans which are not sorted by record id, so the
+// intersection can only be computed with a hash join.
+const filter = {a: {$gte: 0}, b: {$gte: 0}};
+
+function find(allowDiskUse) {
+    const cursor = coll.find(filter);
+    return allowDiskUse ? cursor.allowDiskUse() : cursor;
+}
+
+function winningPlanHasAndHash(allowDiskUse) {
+    const explain = find(allowDiskUse).explain();
+    return planHasStage(conn.getDB("test"), explain.queryPlanner.winningPlan, "AND_HASH");
+}
+
+// With disk use allowed the intersection spills and wins.
+assert(winningPlanHasAndHash(true));
+assert.eq(kNumDocs, find(true).itcount());
+
+// Without it the intersection fails during the trial period, and a single index scan wins.
+assert(!winningPlanHasAndHash(false));
+assert.eq(kNumDocs, find(false).itcount());
+
+MongoRunner.stopMongod(conn);
+}());
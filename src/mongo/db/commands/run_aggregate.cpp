@@ -53,6 +53,7 @@
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/pipeline/pipeline_d.h"
+#include "mongo/db/pipeline/pipeline_result_cache.h"
 #include "mongo/db/pipeline/plan_executor_pipeline.h"
 #include "mongo/db/pipeline/process_interface/mongo_process_interface.h"
 #include "mongo/db/query/collation/collator_factory_interface.h"
@@ -110,14 +111,16 @@ bool canOptimizeAwayPipeline(const Pipeline* pipeline,
  * Returns true if we need to keep a ClientCursor saved for this pipeline (for future getMore
  * requests). Otherwise, returns false. The passed 'nsForCursor' is only used to determine the
  * namespace used in the returned cursor, which will be registered with the global cursor manager,
- * and thus will be different from that in 'request'.
+ * and thus will be different from that in 'request'. If 'resultsToCache' is not null, every
+ * document returned in the first batch is also appended to it.
  */
 bool handleCursorCommand(OperationContext* opCtx,
                          boost::intrusive_ptr<ExpressionContext> expCtx,
                          const NamespaceString& nsForCursor,
                          std::vector<ClientCursor*> cursors,
                          const AggregationRequest& request,
-                         rpc::ReplyBuilderInterface* result) {
+                         rpc::ReplyBuilderInterface* result,
+                         std::vector<BSONObj>* resultsToCache) {
     invariant(!cursors.empty());
     long long batchSize = request.getBatchSize();
 
@@ -215,6 +218,9 @@ bool handleCursorCommand(OperationContext* opCtx,
         // If this executor produces a postBatchResumeToken, add it to the cursor response.
         responseBuilder.setPostBatchResumeToken(exec->getPostBatchResumeToken());
         responseBuilder.append(nextDoc);
+        if (resultsToCache) {
+            resultsToCache->push_back(nextDoc.getOwned());
+        }
     }
 
     if (cursor) {
@@ -245,6 +251,88 @@ bool handleCursorCommand(OperationContext* opCtx,
     return static_cast<bool>(cursor);
 }
 
+/**
+ * Returns the namespaces read by the aggregation in 'request', in a fixed order, if its results
+ * may be served from or stored in the PipelineResultCache. Returns boost::none if the aggregation
+ * must always be executed: for instance, if it reads at a point in time other than the latest, or
+ * runs on a shard, where chunk ownership rather than writes decides which documents it sees.
+ */
+boost::optional<std::vector<NamespaceString>> getResultCacheNamespaces(
+    OperationContext* opCtx,
+    const AggregationRequest& request,
+    const LiteParsedPipeline& liteParsedPipeline) {
+    if (!PipelineResultCache::isEnabled() || request.getExplain() ||
+        opCtx->inMultiDocumentTransaction() || request.isFromMongos() || request.needsMerge() ||
+        request.getExchangeSpec() || request.getRequestResumeToken() ||
+        request.getBatchSize() == 0 || liteParsedPipeline.hasChangeStream() ||
+        ShardingState::get(opCtx)->enabled()) {
+        return boost::none;
+    }
+
+    const auto& readConcernArgs = repl::ReadConcernArgs::get(opCtx);
+    if (readConcernArgs.getLevel() != repl::ReadConcernLevel::kLocalReadConcern ||
+        readConcernArgs.getArgsOpTime() || readConcernArgs.getArgsAfterClusterTime() ||
+        readConcernArgs.getArgsAtClusterTime()) {
+        return boost::none;
+    }
+
+    std::vector<NamespaceString> namespaces{request.getNamespaceString()};
+    const auto involvedNamespaces = liteParsedPipeline.getInvolvedNamespaces();
+    namespaces.insert(namespaces.end(), involvedNamespaces.begin(), involvedNamespaces.end());
+    std::sort(namespaces.begin(), namespaces.end());
+    namespaces.erase(std::unique(namespaces.begin(), namespaces.end()), namespaces.end());
+
+    // Collectionless aggregations read server state rather than a collection, and writes to the
+    // local database, such as those to the oplog, do not necessarily go through the OpObserver.
+    for (auto&& nss : namespaces) {
+        if (nss.isCollectionlessAggregateNS() || nss.isLocal() || nss.isSystem()) {
+            return boost::none;
+        }
+    }
+    return namespaces;
+}
+
+/**
+ * Returns true if none of the foreign namespaces of the pipeline are views. The results of an
+ * aggregation which reads from a view also depend on the collections the view reads from, whose
+ * epochs are not tracked for the aggregation.
+ */
+bool readsOnlyCollections(const ExpressionContext& expCtx,
+                          const LiteParsedPipeline& liteParsedPipeline) {
+    for (auto&& involvedNs : liteParsedPipeline.getInvolvedNamespaces()) {
+        const auto& resolvedNs = expCtx.getResolvedNamespace(involvedNs);
+        if (resolvedNs.ns != involvedNs || !resolvedNs.pipeline.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Replies to an aggregation with results from the PipelineResultCache, as an exhausted cursor
+ * whose first batch holds all of them.
+ */
+void replyWithCachedResults(OperationContext* opCtx,
+                            const NamespaceString& nsForCursor,
+                            const std::vector<BSONObj>& results,
+                            rpc::ReplyBuilderInterface* result) {
+    CursorResponseBuilder::Options options;
+    options.isInitialResponse = true;
+    CursorResponseBuilder responseBuilder(result, options);
+    for (auto&& doc : results) {
+        responseBuilder.append(doc);
+    }
+    responseBuilder.done(0LL, nsForCursor.ns());
+
+    auto curOp = CurOp::get(opCtx);
+    {
+        stdx::lock_guard<Client> lk(*opCtx->getClient());
+        curOp->setPlanSummary_inlock("PIPELINE_RESULT_CACHE"_sd);
+    }
+    curOp->debug().nreturned = results.size();
+    curOp->debug().cursorExhausted = true;
+}
+
 StatusWith<StringMap<ExpressionContext::ResolvedNamespace>> resolveInvolvedNamespaces(
     OperationContext* opCtx, const AggregationRequest& request) {
     const LiteParsedPipeline liteParsedPipeline(request);
@@ -499,6 +587,16 @@ Status runAggregate(OperationContext* opCtx,
     std::vector<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> execs;
     boost::intrusive_ptr<ExpressionContext> expCtx;
     auto curOp = CurOp::get(opCtx);
+
+    // If the results of this aggregation may be served from or stored in the pipeline result
+    // cache, the write epochs of the namespaces it reads. These must be read before any snapshot
+    // is opened; see PipelineResultCache::getEpochs().
+    boost::optional<PipelineResultCache::Epochs> resultCacheEpochs;
+    if (auto namespaces = getResultCacheNamespaces(opCtx, request, liteParsedPipeline)) {
+        resultCacheEpochs = PipelineResultCache::get(opCtx).getEpochs(*namespaces);
+    }
+    // The key under which this aggregation's results are cached, if they are cacheable.
+    boost::optional<std::string> resultCacheKey;
     {
         // If we are in a transaction, check whether the parsed pipeline supports
         // being in a transaction.
@@ -638,6 +736,33 @@ Status runAggregate(OperationContext* opCtx,
             }
         }
 
+        // Look for the results of an identical aggregation in the pipeline result cache. The key
+        // is built from the pipeline as parsed, before optimization, so that equivalent spellings
+        // of the same stages share an entry.
+        if (resultCacheEpochs && readsOnlyCollections(*expCtx, liteParsedPipeline)) {
+            auto serializedPipeline = pipeline->serialize();
+            if (PipelineResultCache::isCacheablePipeline(serializedPipeline) &&
+                PipelineResultCache::isCacheableLetParameters(request.getLetParameters())) {
+                BSONObjBuilder options;
+                options.append("collation", request.getCollation());
+                options.append("hint", request.getHint());
+                options.append("let", request.getLetParameters());
+                options.appendNumber("batchSize", request.getBatchSize());
+                if (uuid) {
+                    uuid->appendToBuilder(&options, "collectionUUID");
+                }
+                resultCacheKey =
+                    PipelineResultCache::makeKey(nss, serializedPipeline, options.done());
+
+                if (auto cachedResults = PipelineResultCache::get(opCtx).lookup(
+                        *resultCacheKey, *resultCacheEpochs)) {
+                    liteParsedPipeline.tickGlobalStageCounters();
+                    replyWithCachedResults(opCtx, origNss, *cachedResults, result);
+                    return Status::OK();
+                }
+            }
+        }
+
         pipeline->optimizePipeline();
 
         // Check if the pipeline has a $geoNear stage, as it will be ripped away during the build
@@ -768,10 +893,20 @@ Status runAggregate(OperationContext* opCtx,
         }
     } else {
         // Cursor must be specified, if explain is not.
-        const bool keepCursor =
-            handleCursorCommand(opCtx, expCtx, origNss, std::move(cursors), request, result);
+        std::vector<BSONObj> resultsToCache;
+        const bool keepCursor = handleCursorCommand(opCtx,
+                                                    expCtx,
+                                                    origNss,
+                                                    std::move(cursors),
+                                                    request,
+                                                    result,
+                                                    resultCacheKey ? &resultsToCache : nullptr);
         if (keepCursor) {
             cursorFreer.dismiss();
+        } else if (resultCacheKey) {
+            // The aggregation returned all of its results in the first batch.
+            PipelineResultCache::get(opCtx).insert(
+                *resultCacheKey, std::move(*resultCacheEpochs), std::move(resultsToCache));
         }
 
         PlanSummaryStats stats;
@@ -44,6 +44,7 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/collection_query_info.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_yield_policy.h"
 #include "mongo/db/query/query_knobs_gen.h"
@@ -54,6 +55,27 @@
 #include "mongo/util/transitional_tools_do_not_use/vector_spooling.h"
 
 namespace mongo {
+namespace {
+
+/**
+ * Checks for interrupt, without yielding, while the candidate plans of a replan during execution
+ * are trialled. The executor cannot yield while this stage is being worked.
+ */
+class InterruptOnlyYieldPolicy final : public PlanYieldPolicy {
+public:
+    InterruptOnlyYieldPolicy(ClockSource* cs)
+        : PlanYieldPolicy(PlanYieldPolicy::YieldPolicy::INTERRUPT_ONLY,
+                          cs,
+                          internalQueryExecYieldIterations.load(),
+                          Milliseconds{internalQueryExecYieldPeriodMS.load()}) {}
+
+private:
+    Status yield(OperationContext*, std::function<void()> whileYieldingFn) override {
+        MONGO_UNREACHABLE;
+    }
+};
+
+}  // namespace
 
 // static
 const char* CachedPlanStage::kStageType = "CACHED_PLAN";
@@ -94,6 +116,17 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 
     // The trial period ends without replanning if the cached plan produces this many results.
     size_t numResults = trial_period::getTrialPeriodNumToReturn(*_canonicalQuery);
+    _trialNumResults = std::max<size_t>(numResults, 1);
+
+    // Only finds are monitored after the trial period. Updates, deletes and counts run a stage
+    // above this one which may hold working set members across a replan.
+    const auto& qr = _canonicalQuery->getQueryRequest();
+    _monitorExecution = internalQueryEnableAdaptiveReplanning.load() &&
+        !(_plannerParams.options &
+          (QueryPlannerParams::PRESERVE_RECORD_ID | QueryPlannerParams::IS_COUNT)) &&
+        !qr.isTailable();
+    _canSkipReturnedResults =
+        qr.getSort().isEmpty() && !qr.getSkip() && !qr.getLimit() && !qr.getNToReturn();
 
     for (size_t i = 0; i < maxWorksBeforeReplan; ++i) {
         // Might need to yield between calls to work due to the timer elapsing.
@@ -124,7 +157,10 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
                           str::stream() << "cached plan returned: " << ex.toStatus());
         }
 
+        ++_executionWorks;
         if (PlanStage::ADVANCED == state) {
+            ++_executionAdvanced;
+
             // Save result for later.
             WorkingSetMember* member = _ws->get(id);
             // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we yield.
@@ -192,6 +228,9 @@ Status CachedPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
 }
 
 Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache, std::string reason) {
+    // A query is replanned at most once.
+    _monitorExecution = false;
+
     // We're going to start over with a new plan. Clear out info from our old plan.
     {
         std::queue<WorkingSetID> emptyQueue;
@@ -281,11 +320,104 @@ PlanStage::StageState CachedPlanStage::doWork(WorkingSetID* out) {
     if (!_results.empty()) {
         *out = _results.front();
         _results.pop();
+        onResultReturned(*out);
         return PlanStage::ADVANCED;
     }
 
     // Nothing left in trial period buffer.
-    return child()->work(out);
+    const auto state = child()->work(out);
+
+    if (_monitorExecution) {
+        ++_executionWorks;
+        if (PlanStage::ADVANCED == state) {
+            ++_executionAdvanced;
+        } else if (PlanStage::IS_EOF != state && shouldReplanDuringExecution()) {
+            replanDuringExecution();
+            return PlanStage::NEED_TIME;
+        }
+    }
+
+    if (PlanStage::ADVANCED == state) {
+        if (_replannedDuringExecution) {
+            auto member = _ws->get(*out);
+            if (member->hasRecordId() && _returnedRecordIds.count(member->recordId)) {
+                // The plan this one replaced already returned this result.
+                _ws->free(*out);
+                return PlanStage::NEED_TIME;
+            }
+        }
+        onResultReturned(*out);
+    }
+    return state;
+}
+
+bool CachedPlanStage::shouldReplanDuringExecution() const {
+    if (_executionWorks < static_cast<size_t>(internalQueryAdaptiveReplanningMinWorks.load())) {
+        return false;
+    }
+
+    // When the plan was cached, it took '_decisionWorks' works to produce a full trial period's
+    // worth of results, or to reach EOF with fewer.
+    const double expectedWorksPerResult =
+        static_cast<double>(std::max<size_t>(_decisionWorks, 1)) / _trialNumResults;
+    return _executionWorks > internalQueryAdaptiveReplanningRatio.load() *
+        expectedWorksPerResult * (_executionAdvanced + 1);
+}
+
+void CachedPlanStage::replanDuringExecution() {
+    LOGV2_DEBUG(5073317,
+                1,
+                "Cached plan is much less efficient than expected, replanning during execution",
+                "query"_attr = redact(_canonicalQuery->toStringShort()),
+                "planSummary"_attr = Explain::getPlanSummary(child().get()),
+                "decisionWorks"_attr = _decisionWorks,
+                "works"_attr = _executionWorks,
+                "advanced"_attr = _executionAdvanced,
+                "numReturned"_attr = _numReturned);
+
+    std::string reason = str::stream()
+        << "cached plan was less efficient than expected during execution: expected "
+        << _decisionWorks << " works per " << _trialNumResults << " results but it took "
+        << _executionWorks << " works to produce " << _executionAdvanced << " results";
+
+    QueryPlannerParams plannerParams;
+    plannerParams.options = _plannerParams.options;
+    fillOutPlannerParams(expCtx()->opCtx, collection(), _canonicalQuery, &plannerParams);
+    _plannerParams = std::move(plannerParams);
+
+    // The executor cannot yield while this stage is being worked, so the new candidates' trial
+    // period runs without yielding, but can still be interrupted or time out.
+    InterruptOnlyYieldPolicy yieldPolicy(
+        expCtx()->opCtx->getServiceContext()->getFastClockSource());
+    const bool shouldCache = true;
+    uassertStatusOK(replan(&yieldPolicy, shouldCache, std::move(reason)));
+    _replannedDuringExecution = true;
+}
+
+void CachedPlanStage::onResultReturned(WorkingSetID id) {
+    ++_numReturned;
+    if (!_monitorExecution) {
+        return;
+    }
+    if (!_canSkipReturnedResults) {
+        // A new plan could not tell which results were already returned, so it would return them
+        // again, or more than the limit in all.
+        _monitorExecution = false;
+        return;
+    }
+
+    auto member = _ws->get(id);
+    if (!member->hasRecordId() ||
+        _returnedRecordIds.size() >=
+            static_cast<size_t>(internalQueryAdaptiveReplanningMaxDedupRecordIds.load())) {
+        // The results returned so far can no longer all be skipped by a new plan, so the query
+        // can no longer be replanned during execution.
+        _canSkipReturnedResults = false;
+        _monitorExecution = false;
+        _returnedRecordIds.clear();
+        return;
+    }
+    _returnedRecordIds.insert(member->recordId);
 }
 
 std::unique_ptr<PlanStageStats> CachedPlanStage::getStats() {
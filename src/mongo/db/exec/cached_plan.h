@@ -39,6 +39,7 @@
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/record_id.h"
+#include "mongo/stdx/unordered_set.h"
 
 namespace mongo {
 
@@ -53,6 +54,13 @@ class PlanYieldPolicy;
  * occur with the set of indices in 'params'. As a future improvement, we could instead refresh the
  * list of indices in 'params' prior to replanning, and thus avoid inheriting from
  * RequiresAllIndicesStage.
+ *
+ * If internalQueryEnableAdaptiveReplanning is set, a find keeps monitoring the cached plan after
+ * the trial period, and replans once if the plan's works per result grow to be
+ * internalQueryAdaptiveReplanningRatio times what was expected when it was cached. Since some
+ * results may already have been returned by then, this is only done if either none have, or the
+ * query returns results in no particular order and the RecordIds of all returned results were
+ * remembered, so that the new plan can skip them.
  */
 class CachedPlanStage final : public RequiresAllIndicesStage {
 public:
@@ -109,6 +117,25 @@ private:
      */
     Status tryYield(PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Returns true if the cached plan has taken so many more works per result than expected that
+     * it should be replaced during execution.
+     */
+    bool shouldReplanDuringExecution() const;
+
+    /**
+     * Replaces the cached plan with a newly planned one during execution. The indices are
+     * refreshed first, since they are no longer required to stay intact after the trial period.
+     * Throws if planning fails.
+     */
+    void replanDuringExecution();
+
+    /**
+     * Records that the result 'id' is being returned, so that it can be skipped if the query is
+     * replanned during execution.
+     */
+    void onResultReturned(WorkingSetID id);
+
     // Not owned.
     WorkingSet* _ws;
 
@@ -128,6 +155,29 @@ private:
     // Any results produced during trial period execution are kept here.
     std::queue<WorkingSetID> _results;
 
+    // The number of results the trial period ends after.
+    size_t _trialNumResults = 1;
+
+    // True while the cached plan is monitored so that it can be replanned during execution.
+    bool _monitorExecution = false;
+
+    // The works performed and results produced by the cached plan while it is monitored,
+    // including during the trial period.
+    size_t _executionWorks = 0;
+    size_t _executionAdvanced = 0;
+
+    // The number of results returned by this stage.
+    size_t _numReturned = 0;
+
+    // True if the results returned so far can be skipped by a new plan, because the query returns
+    // them in no particular order and all of their RecordIds are in '_returnedRecordIds'.
+    bool _canSkipReturnedResults = false;
+    stdx::unordered_set<RecordId, RecordId::Hasher> _returnedRecordIds;
+
+    // True once the query has been replanned during execution, after which any result in
+    // '_returnedRecordIds' is skipped.
+    bool _replannedDuringExecution = false;
+
     // Stats
     CachedPlanStats _specificStats;
 };
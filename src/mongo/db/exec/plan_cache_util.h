@@ -76,6 +76,9 @@ void logNotCachingNoData(std::string&& solution);
  *    * Always cached.
  *    * Never cached.
  *    * Cached, except in certain special cases.
+ *
+ * If the execution engine provides an 'executionTree' for the winning plan, it is stored in the
+ * cache entry along with the winning solution.
  */
 template <typename PlanStageType, typename ResultType, typename Data>
 void updatePlanCache(
@@ -85,7 +88,8 @@ void updatePlanCache(
     const CanonicalQuery& query,
     std::unique_ptr<plan_ranker::PlanRankingDecision> ranking,
     const std::vector<plan_ranker::BaseCandidatePlan<PlanStageType, ResultType, Data>>&
-        candidates) {
+        candidates,
+    std::shared_ptr<const CachedExecutionTree> executionTree = nullptr) {
     auto winnerIdx = ranking->candidateOrder[0];
     invariant(winnerIdx >= 0 && winnerIdx < candidates.size());
 
@@ -160,7 +164,9 @@ void updatePlanCache(
                                 ->set(query,
                                       solutions,
                                       std::move(ranking),
-                                      opCtx->getServiceContext()->getPreciseClockSource()->now()));
+                                      opCtx->getServiceContext()->getPreciseClockSource()->now(),
+                                      boost::none,
+                                      std::move(executionTree)));
         }
     }
 }
@@ -74,6 +74,10 @@ std::unique_ptr<vm::CodeFragment> EConstant::compile(CompileCtx& ctx) const {
     return code;
 }
 
+std::unique_ptr<vm::BlockKernel> EConstant::compileBlock(CompileCtx& ctx) const {
+    return vm::makeConstantKernel(_tag, _val);
+}
+
 std::vector<DebugPrinter::Block> EConstant::debugPrint() const {
     std::vector<DebugPrinter::Block> ret;
     std::stringstream ss;
@@ -103,6 +107,15 @@ std::unique_ptr<vm::CodeFragment> EVariable::compile(CompileCtx& ctx) const {
     return code;
 }
 
+std::unique_ptr<vm::BlockKernel> EVariable::compileBlock(CompileCtx& ctx) const {
+    if (_frameId) {
+        return nullptr;
+    }
+
+    auto block = ctx.root->getBlock(ctx, _var);
+    return block ? vm::makeVariableKernel(block) : nullptr;
+}
+
 std::vector<DebugPrinter::Block> EVariable::debugPrint() const {
     std::vector<DebugPrinter::Block> ret;
 
@@ -219,6 +232,58 @@ std::unique_ptr<vm::CodeFragment> EPrimBinary::compile(CompileCtx& ctx) const {
     return code;
 }
 
+std::unique_ptr<vm::BlockKernel> EPrimBinary::compileBlock(CompileCtx& ctx) const {
+    vm::BlockOp op;
+    switch (_op) {
+        case EPrimBinary::add:
+            op = vm::BlockOp::add;
+            break;
+        case EPrimBinary::sub:
+            op = vm::BlockOp::sub;
+            break;
+        case EPrimBinary::mul:
+            op = vm::BlockOp::mul;
+            break;
+        case EPrimBinary::lessEq:
+            op = vm::BlockOp::lessEq;
+            break;
+        case EPrimBinary::less:
+            op = vm::BlockOp::less;
+            break;
+        case EPrimBinary::greater:
+            op = vm::BlockOp::greater;
+            break;
+        case EPrimBinary::greaterEq:
+            op = vm::BlockOp::greaterEq;
+            break;
+        case EPrimBinary::eq:
+            op = vm::BlockOp::eq;
+            break;
+        case EPrimBinary::neq:
+            op = vm::BlockOp::neq;
+            break;
+        case EPrimBinary::logicAnd:
+            op = vm::BlockOp::logicAnd;
+            break;
+        case EPrimBinary::logicOr:
+            op = vm::BlockOp::logicOr;
+            break;
+        default:
+            return nullptr;
+    }
+
+    auto lhs = _nodes[0]->compileBlock(ctx);
+    if (!lhs) {
+        return nullptr;
+    }
+    auto rhs = _nodes[1]->compileBlock(ctx);
+    if (!rhs) {
+        return nullptr;
+    }
+
+    return vm::makeBinaryKernel(op, std::move(lhs), std::move(rhs));
+}
+
 std::vector<DebugPrinter::Block> EPrimBinary::debugPrint() const {
     std::vector<DebugPrinter::Block> ret;
 
@@ -360,6 +425,31 @@ static stdx::unordered_map<std::string, BuiltinFn> kBuiltinFunctions = {
     {"addToSet", BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::addToSet, true}},
     {"doubleDoubleSum",
      BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::doubleDoubleSum, true}},
+    {"concat", BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::concat, false}},
+    {"substrBytes", BuiltinFn{[](size_t n) { return n == 3; }, vm::Builtin::substrBytes, false}},
+    {"substrCP", BuiltinFn{[](size_t n) { return n == 3; }, vm::Builtin::substrCP, false}},
+    {"toLower", BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::toLower, false}},
+    {"toUpper", BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::toUpper, false}},
+    {"coerceToString",
+     BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::coerceToString, false}},
+    {"dateToString",
+     BuiltinFn{[](size_t n) { return n == 4; }, vm::Builtin::dateToString, false}},
+    {"convert", BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::convert, false}},
+    {"mergeObjects", BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::mergeObjects, false}},
+    {"aggMergeObjects",
+     BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::aggMergeObjects, true}},
+    {"minOf", BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::minOf, false}},
+    {"maxOf", BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::maxOf, false}},
+    {"avgOf", BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::avgOf, false}},
+    {"stdDevPopOf", BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::stdDevPopOf, false}},
+    {"stdDevSampOf", BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::stdDevSampOf, false}},
+    {"aggAvg", BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::aggAvg, true}},
+    {"avgFinalize", BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::avgFinalize, false}},
+    {"aggStdDev", BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::aggStdDev, true}},
+    {"stdDevPopFinalize",
+     BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::stdDevPopFinalize, false}},
+    {"stdDevSampFinalize",
+     BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::stdDevSampFinalize, false}},
 };
 
 /**
@@ -768,6 +858,26 @@ std::unique_ptr<RuntimeEnvironment> RuntimeEnvironment::makeCopy(bool isSmp) {
     return std::unique_ptr<RuntimeEnvironment>(new RuntimeEnvironment(*this));
 }
 
+std::unique_ptr<RuntimeEnvironment> RuntimeEnvironment::makeDeepCopy() const {
+    auto env = std::make_unique<RuntimeEnvironment>();
+    env->_state->slots = _state->slots;
+    env->_state->typeTags = _state->typeTags;
+    env->_state->vals = _state->vals;
+    env->_state->owned = _state->owned;
+
+    for (size_t idx = 0; idx < _state->vals.size(); ++idx) {
+        if (_state->owned[idx]) {
+            auto [tag, val] = copyValue(_state->typeTags[idx], _state->vals[idx]);
+            env->_state->vals[idx] = val;
+        }
+    }
+
+    for (auto&& [type, slot] : _state->slots) {
+        env->emplaceAccessor(slot.first, slot.second);
+    }
+    return env;
+}
+
 void RuntimeEnvironment::debugString(StringBuilder* builder) {
     *builder << "env: { ";
     for (auto&& [type, slot] : _state->slots) {
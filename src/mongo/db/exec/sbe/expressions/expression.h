@@ -36,6 +36,7 @@
 #include "mongo/db/exec/sbe/util/debug_print.h"
 #include "mongo/db/exec/sbe/values/id_generators.h"
 #include "mongo/db/exec/sbe/values/value.h"
+#include "mongo/db/exec/sbe/vm/block_kernels.h"
 #include "mongo/db/exec/sbe/vm/vm.h"
 #include "mongo/stdx/unordered_map.h"
 #include "mongo/util/string_map.h"
@@ -118,6 +119,12 @@ public:
      */
     std::unique_ptr<RuntimeEnvironment> makeCopy(bool isSmp);
 
+    /**
+     * Make a copy of this environment which owns copies of all the slot values, so that the slots
+     * of the copy can be reset without affecting this environment. Unowned values are shared.
+     */
+    std::unique_ptr<RuntimeEnvironment> makeDeepCopy() const;
+
     /**
      * Dumps all the slots currently defined in this environment into the given string builder.
      */
@@ -239,6 +246,15 @@ public:
      */
     virtual std::unique_ptr<vm::CodeFragment> compile(CompileCtx& ctx) const = 0;
 
+    /**
+     * Returns a kernel evaluating this expression over whole blocks of values produced by the
+     * stages running in the block mode, or nullptr if the expression cannot be evaluated this way
+     * and the bytecode must be used for every row instead.
+     */
+    virtual std::unique_ptr<vm::BlockKernel> compileBlock(CompileCtx& ctx) const {
+        return nullptr;
+    }
+
     virtual std::vector<DebugPrinter::Block> debugPrint() const = 0;
 
 protected:
@@ -327,6 +343,8 @@ public:
 
     std::unique_ptr<vm::CodeFragment> compile(CompileCtx& ctx) const override;
 
+    std::unique_ptr<vm::BlockKernel> compileBlock(CompileCtx& ctx) const override;
+
     std::vector<DebugPrinter::Block> debugPrint() const override;
 
 private:
@@ -348,6 +366,8 @@ public:
 
     std::unique_ptr<vm::CodeFragment> compile(CompileCtx& ctx) const override;
 
+    std::unique_ptr<vm::BlockKernel> compileBlock(CompileCtx& ctx) const override;
+
     std::vector<DebugPrinter::Block> debugPrint() const override;
 
 private:
@@ -393,6 +413,8 @@ public:
 
     std::unique_ptr<vm::CodeFragment> compile(CompileCtx& ctx) const override;
 
+    std::unique_ptr<vm::BlockKernel> compileBlock(CompileCtx& ctx) const override;
+
     std::vector<DebugPrinter::Block> debugPrint() const override;
 
 private:
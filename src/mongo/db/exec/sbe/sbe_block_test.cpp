@@ -0,0 +1,220 @@
+/**
+ *    Copyright (C) 2018-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for the block mode of sbe::FilterStage and sbe::ProjectStage.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/sbe_plan_stage_test.h"
+#include "mongo/db/exec/sbe/stages/bson_scan.h"
+#include "mongo/db/exec/sbe/stages/filter.h"
+#include "mongo/db/exec/sbe/stages/project.h"
+
+namespace mongo::sbe {
+
+class BlockModeTest : public PlanStageTestFixture {
+public:
+    using MakeTreeFn = std::function<std::pair<value::SlotVector, std::unique_ptr<PlanStage>>(
+        value::SlotId a, value::SlotId b, std::unique_ptr<PlanStage> scan)>;
+
+    /**
+     * Runs the tree built by 'makeTree' on top of a scan of 'docs' producing the fields 'a' and
+     * 'b', and returns all the results. The caller owns the returned array.
+     */
+    std::pair<value::TypeTags, value::Value> runTree(const std::vector<BSONObj>& docs,
+                                                     bool blockMode,
+                                                     const MakeTreeFn& makeTree) {
+        BufBuilder buf;
+        for (auto& doc : docs) {
+            buf.appendBuf(doc.objdata(), doc.objsize());
+        }
+
+        auto a = generateSlotId();
+        auto b = generateSlotId();
+        auto scan = makeS<BSONScanStage>(
+            buf.buf(), buf.buf() + buf.len(), boost::none, std::vector<std::string>{"a", "b"},
+            makeSV(a, b), blockMode);
+
+        auto [outputSlots, stage] = makeTree(a, b, std::move(scan));
+        auto accessors = prepareTree(stage.get(), outputSlots);
+        return getAllResultsMulti(stage.get(), accessors);
+    }
+
+    /**
+     * Asserts that the tree produces the same results in the block mode as it does a row at a
+     * time.
+     */
+    void assertBlockModeMatchesRowMode(const std::vector<BSONObj>& docs,
+                                       const MakeTreeFn& makeTree) {
+        auto [rowTag, rowVal] = runTree(docs, false, makeTree);
+        value::ValueGuard rowGuard{rowTag, rowVal};
+
+        auto [blockTag, blockVal] = runTree(docs, true, makeTree);
+        value::ValueGuard blockGuard{blockTag, blockVal};
+
+        ASSERT_GT(value::getArrayView(rowVal)->size(), 0U);
+        ASSERT_TRUE(valueEquals(rowTag, rowVal, blockTag, blockVal));
+    }
+
+    /**
+     * Builds a filter on 'a * 2 > 1000 && b < 700' with a projection of 'a + b' on top of it.
+     */
+    std::pair<value::SlotVector, std::unique_ptr<PlanStage>> makeFilterProject(
+        value::SlotId a, value::SlotId b, std::unique_ptr<PlanStage> scan) {
+        auto filter = makeS<FilterStage<false>>(
+            std::move(scan),
+            makeE<EPrimBinary>(
+                EPrimBinary::logicAnd,
+                makeE<EPrimBinary>(
+                    EPrimBinary::greater,
+                    makeE<EPrimBinary>(EPrimBinary::mul,
+                                       makeE<EVariable>(a),
+                                       makeE<EConstant>(value::TypeTags::NumberInt32,
+                                                        value::bitcastFrom<int32_t>(2))),
+                    makeE<EConstant>(value::TypeTags::NumberInt32,
+                                     value::bitcastFrom<int32_t>(1000))),
+                makeE<EPrimBinary>(EPrimBinary::less,
+                                   makeE<EVariable>(b),
+                                   makeE<EConstant>(value::TypeTags::NumberDouble,
+                                                    value::bitcastFrom<double>(700.0)))));
+
+        auto sum = generateSlotId();
+        auto project = makeProjectStage(
+            std::move(filter),
+            sum,
+            makeE<EPrimBinary>(EPrimBinary::add, makeE<EVariable>(a), makeE<EVariable>(b)));
+
+        return {makeSV(a, sum), std::move(project)};
+    }
+};
+
+TEST_F(BlockModeTest, FilterAndProjectOverNumbersMatchRowMode) {
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 3000; ++i) {
+        docs.push_back(BSON("a" << i << "b" << static_cast<long long>(i % 1000)));
+    }
+
+    assertBlockModeMatchesRowMode(docs, [this](auto a, auto b, auto scan) {
+        return makeFilterProject(a, b, std::move(scan));
+    });
+}
+
+TEST_F(BlockModeTest, FilterAndProjectOverMixedTypesMatchRowMode) {
+    // The blocks with strings, doubles and missing fields cannot be handled by the kernels and
+    // have to fall back to the bytecode.
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 3000; ++i) {
+        if (i % 97 == 0) {
+            docs.push_back(BSON("a" << i));
+        } else if (i % 89 == 0) {
+            docs.push_back(BSON("a" << i << "b"
+                                    << "str"));
+        } else if (i < 1500) {
+            docs.push_back(BSON("a" << i << "b" << (i % 1000) + 0.5));
+        } else {
+            docs.push_back(BSON("b" << i % 1000 << "a" << i));
+        }
+    }
+
+    assertBlockModeMatchesRowMode(docs, [this](auto a, auto b, auto scan) {
+        return makeFilterProject(a, b, std::move(scan));
+    });
+}
+
+TEST_F(BlockModeTest, ArithmeticOverflowMatchesRowMode) {
+    // The int64 multiplication overflows into a decimal, which only the bytecode can produce.
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 2000; ++i) {
+        docs.push_back(BSON("a" << std::numeric_limits<long long>::max() - i << "b" << i));
+    }
+
+    assertBlockModeMatchesRowMode(
+        docs, [this](value::SlotId a, value::SlotId b, std::unique_ptr<PlanStage> scan) {
+            auto product = generateSlotId();
+            auto project = makeProjectStage(
+                std::move(scan),
+                product,
+                makeE<EPrimBinary>(EPrimBinary::mul, makeE<EVariable>(a), makeE<EVariable>(b)));
+            return std::make_pair(makeSV(b, product), std::move(project));
+        });
+}
+
+TEST_F(BlockModeTest, StackedFiltersMatchRowMode) {
+    // The outer filter consumes the blocks compacted by the inner filter, and the projection in
+    // between evaluates its expression over the compacted blocks.
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 5000; ++i) {
+        docs.push_back(BSON("a" << i << "b" << (i * 7) % 13));
+    }
+
+    assertBlockModeMatchesRowMode(
+        docs, [this](value::SlotId a, value::SlotId b, std::unique_ptr<PlanStage> scan) {
+            auto inner = makeS<FilterStage<false>>(
+                std::move(scan),
+                makeE<EPrimBinary>(EPrimBinary::neq,
+                                   makeE<EVariable>(b),
+                                   makeE<EConstant>(value::TypeTags::NumberInt32,
+                                                    value::bitcastFrom<int32_t>(3))));
+            auto diff = generateSlotId();
+            auto project = makeProjectStage(
+                std::move(inner),
+                diff,
+                makeE<EPrimBinary>(EPrimBinary::sub, makeE<EVariable>(a), makeE<EVariable>(b)));
+            auto outer = makeS<FilterStage<false>>(
+                std::move(project),
+                makeE<EPrimBinary>(EPrimBinary::lessEq,
+                                   makeE<EVariable>(diff),
+                                   makeE<EConstant>(value::TypeTags::NumberInt64,
+                                                    value::bitcastFrom<int64_t>(2500))));
+            return std::make_pair(makeSV(a, b, diff), std::move(outer));
+        });
+}
+
+TEST_F(BlockModeTest, ValueBlockCompactKeepsSelectedRowsInOrder) {
+    value::ValueBlock block;
+    for (int32_t i = 0; i < 10; ++i) {
+        block.push_back(false, value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(i));
+    }
+    auto [strTag, strVal] = value::makeNewString("a string long enough to be heap allocated");
+    block.push_back(true, strTag, strVal);
+
+    std::vector<uint8_t> selection(block.size(), 0);
+    selection[1] = selection[4] = selection[9] = 1;
+    block.compact(selection);
+
+    ASSERT_EQ(block.size(), 3U);
+    ASSERT_EQ(block.commonTag(block.size()), value::TypeTags::NumberInt32);
+    ASSERT_EQ(value::bitcastTo<int32_t>(block.getViewOfValue(0).second), 1);
+    ASSERT_EQ(value::bitcastTo<int32_t>(block.getViewOfValue(1).second), 4);
+    ASSERT_EQ(value::bitcastTo<int32_t>(block.getViewOfValue(2).second), 9);
+}
+
+}  // namespace mongo::sbe
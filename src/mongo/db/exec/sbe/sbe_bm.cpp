@@ -0,0 +1,264 @@
+/**
+ *    Copyright (C) 2018-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/exec/sbe/stages/bson_scan.h"
+#include "mongo/db/exec/sbe/stages/co_scan.h"
+#include "mongo/db/exec/sbe/stages/filter.h"
+#include "mongo/db/exec/sbe/stages/project.h"
+
+namespace mongo::sbe {
+namespace {
+constexpr int32_t kNumDocs = 1 << 18;
+
+/**
+ * Generates 'kNumDocs' documents of the shape {a: <int>, b: <double>, c: <string>}.
+ */
+BufBuilder makeDocs() {
+    BufBuilder buf;
+    for (int32_t i = 0; i < kNumDocs; ++i) {
+        auto doc = BSON("a" << i << "b" << (i % 1000) * 0.5 << "c"
+                            << "some string");
+        buf.appendBuf(doc.objdata(), doc.objsize());
+    }
+    return buf;
+}
+
+std::unique_ptr<EExpression> makeInt32(int32_t val) {
+    return makeE<EConstant>(value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(val));
+}
+
+/**
+ * Runs the plan 'bsonscan -> filter(a >= 0 && b < x) -> [project(a * 2 + b)]' to the end, with
+ * the scan producing blocks of rows or a row at a time. The benchmark argument is the percentage of
+ * the rows passing the filter.
+ */
+void runNumericFilter(benchmark::State& state, bool blockMode, bool withProject) {
+    auto docs = makeDocs();
+    auto selectivity = state.range(0);
+
+    for (auto _ : state) {
+        value::SlotIdGenerator ids;
+        auto a = ids.generate();
+        auto b = ids.generate();
+        std::unique_ptr<PlanStage> stage = makeS<BSONScanStage>(docs.buf(),
+                                                                docs.buf() + docs.len(),
+                                                                boost::none,
+                                                                std::vector<std::string>{"a", "b"},
+                                                                makeSV(a, b),
+                                                                blockMode);
+
+        // The values of 'b' are uniformly distributed over [0, 500).
+        auto threshold = makeE<EConstant>(value::TypeTags::NumberDouble,
+                                          value::bitcastFrom<double>(selectivity * 5.0));
+        stage = makeS<FilterStage<false>>(
+            std::move(stage),
+            makeE<EPrimBinary>(
+                EPrimBinary::logicAnd,
+                makeE<EPrimBinary>(EPrimBinary::greaterEq, makeE<EVariable>(a), makeInt32(0)),
+                makeE<EPrimBinary>(EPrimBinary::less, makeE<EVariable>(b), std::move(threshold))));
+
+        auto outSlot = a;
+        if (withProject) {
+            outSlot = ids.generate();
+            stage = makeProjectStage(
+                std::move(stage),
+                outSlot,
+                makeE<EPrimBinary>(
+                    EPrimBinary::add,
+                    makeE<EPrimBinary>(EPrimBinary::mul, makeE<EVariable>(a), makeInt32(2)),
+                    makeE<EVariable>(b)));
+        }
+
+        CompileCtx ctx{std::make_unique<RuntimeEnvironment>()};
+        stage->prepare(ctx);
+        auto accessor = stage->getAccessor(ctx, outSlot);
+        stage->open(false);
+
+        size_t count = 0;
+        while (stage->getNext() == PlanState::ADVANCED) {
+            benchmark::DoNotOptimize(accessor->getViewOfValue());
+            ++count;
+        }
+        stage->close();
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * kNumDocs);
+}
+
+void BM_NumericFilterRow(benchmark::State& state) {
+    runNumericFilter(state, false, false);
+}
+
+void BM_NumericFilterBlock(benchmark::State& state) {
+    runNumericFilter(state, true, false);
+}
+
+void BM_NumericFilterProjectRow(benchmark::State& state) {
+    runNumericFilter(state, false, true);
+}
+
+void BM_NumericFilterProjectBlock(benchmark::State& state) {
+    runNumericFilter(state, true, true);
+}
+
+/**
+ * Compiles and runs expressions the same way EExpressionTestFixture does: the inputs are bound to
+ * correlated slots, so the expressions are evaluated without any plan stages around them.
+ */
+class ExpressionBenchmark {
+public:
+    ExpressionBenchmark() : _ctx{std::make_unique<RuntimeEnvironment>()} {
+        _ctx.root = &_emptyStage;
+    }
+
+    value::SlotId bindAccessor(value::SlotAccessor* accessor) {
+        auto slot = _slotIdGenerator.generate();
+        _ctx.pushCorrelated(slot, accessor);
+        return slot;
+    }
+
+    /**
+     * Runs the expression over the inputs set up by the caller. The bytecode size is reported
+     * along with the time, so the effect of the superinstructions is visible.
+     */
+    void run(benchmark::State& state, const EExpression& expr) {
+        auto code = expr.compile(_ctx);
+        for (auto _ : state) {
+            auto [owned, tag, val] = _vm.run(code.get());
+            if (owned) {
+                value::releaseValue(tag, val);
+            }
+            benchmark::DoNotOptimize(val);
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["bytecodeSize"] = code->instrs().size();
+    }
+
+private:
+    value::SlotIdGenerator _slotIdGenerator;
+    CoScanStage _emptyStage;
+    CompileCtx _ctx;
+    vm::ByteCode _vm;
+};
+
+void BM_ExprGetFieldCompare(benchmark::State& state) {
+    ExpressionBenchmark bm;
+    value::ViewOfValueAccessor input;
+    auto inputSlot = bm.bindAccessor(&input);
+
+    auto doc = BSON("x" << 1 << "y"
+                        << "str"
+                        << "a" << 42);
+    input.reset(value::TypeTags::bsonObject, value::bitcastFrom<const char*>(doc.objdata()));
+
+    // getField(input, "a") < 100
+    auto expr = makeE<EPrimBinary>(
+        EPrimBinary::less,
+        makeE<EFunction>("getField", makeEs(makeE<EVariable>(inputSlot), makeE<EConstant>("a"))),
+        makeInt32(100));
+    bm.run(state, *expr);
+}
+
+void BM_ExprArithmetic(benchmark::State& state) {
+    ExpressionBenchmark bm;
+    value::ViewOfValueAccessor a;
+    value::ViewOfValueAccessor b;
+    auto aSlot = bm.bindAccessor(&a);
+    auto bSlot = bm.bindAccessor(&b);
+    a.reset(value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(7));
+    b.reset(value::TypeTags::NumberDouble, value::bitcastFrom<double>(2.5));
+
+    // a * 2 + b - 3
+    auto expr = makeE<EPrimBinary>(
+        EPrimBinary::sub,
+        makeE<EPrimBinary>(
+            EPrimBinary::add,
+            makeE<EPrimBinary>(EPrimBinary::mul, makeE<EVariable>(aSlot), makeInt32(2)),
+            makeE<EVariable>(bSlot)),
+        makeInt32(3));
+    bm.run(state, *expr);
+}
+
+void BM_ExprLogicAnd(benchmark::State& state) {
+    ExpressionBenchmark bm;
+    value::ViewOfValueAccessor a;
+    auto aSlot = bm.bindAccessor(&a);
+    a.reset(value::TypeTags::NumberInt64, value::bitcastFrom<int64_t>(50));
+
+    // a > 0 && a <= 100
+    auto expr = makeE<EPrimBinary>(
+        EPrimBinary::logicAnd,
+        makeE<EPrimBinary>(EPrimBinary::greater, makeE<EVariable>(aSlot), makeInt32(0)),
+        makeE<EPrimBinary>(EPrimBinary::lessEq, makeE<EVariable>(aSlot), makeInt32(100)));
+    bm.run(state, *expr);
+}
+
+void BM_ExprIf(benchmark::State& state) {
+    ExpressionBenchmark bm;
+    value::ViewOfValueAccessor a;
+    auto aSlot = bm.bindAccessor(&a);
+    a.reset(value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(10));
+
+    // if a == 10 then a else 0
+    auto expr = makeE<EIf>(
+        makeE<EPrimBinary>(EPrimBinary::eq, makeE<EVariable>(aSlot), makeInt32(10)),
+        makeE<EVariable>(aSlot),
+        makeInt32(0));
+    bm.run(state, *expr);
+}
+
+void BM_ExprNumericConvert(benchmark::State& state) {
+    ExpressionBenchmark bm;
+    value::ViewOfValueAccessor a;
+    auto aSlot = bm.bindAccessor(&a);
+    a.reset(value::TypeTags::NumberDouble, value::bitcastFrom<double>(12.0));
+
+    auto expr = makeE<ENumericConvert>(makeE<EVariable>(aSlot), value::TypeTags::NumberInt64);
+    bm.run(state, *expr);
+}
+
+BENCHMARK(BM_NumericFilterRow)->Arg(1)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_NumericFilterBlock)->Arg(1)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_NumericFilterProjectRow)->Arg(1)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_NumericFilterProjectBlock)->Arg(1)->Arg(10)->Arg(50)->Arg(100);
+
+BENCHMARK(BM_ExprGetFieldCompare);
+BENCHMARK(BM_ExprArithmetic);
+BENCHMARK(BM_ExprLogicAnd);
+BENCHMARK(BM_ExprIf);
+BENCHMARK(BM_ExprNumericConvert);
+}  // namespace
+}  // namespace mongo::sbe
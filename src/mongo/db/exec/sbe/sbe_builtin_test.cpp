@@ -0,0 +1,230 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+/**
+ * This file contains tests for the VM builtins used to lower agg expressions and accumulators.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/expression_test_base.h"
+#include "mongo/db/exec/sbe/values/bson.h"
+
+namespace mongo::sbe {
+
+class SBEBuiltinTest : public EExpressionTestFixture {
+protected:
+    /**
+     * Makes a constant expression holding the value of the single field of 'obj'.
+     */
+    std::unique_ptr<EExpression> makeC(const BSONObj& obj) {
+        auto elem = obj.firstElement();
+        auto [tag, val] = bson::convertFrom(false,
+                                            elem.rawdata(),
+                                            elem.rawdata() + elem.size(),
+                                            elem.fieldNameSize() - 1);
+        return makeE<EConstant>(tag, val);
+    }
+
+    /**
+     * Evaluates 'expr' and checks that the result is equal to the single field of 'expected'.
+     */
+    void assertResult(const EExpression& expr, const BSONObj& expected) {
+        auto compiledExpr = compileExpression(expr);
+        auto [tag, val] = runCompiledExpression(compiledExpr.get());
+        value::ValueGuard guard{tag, val};
+
+        auto expectedElem = expected.firstElement();
+        auto [expectedTag, expectedVal] =
+            bson::convertFrom(true,
+                              expectedElem.rawdata(),
+                              expectedElem.rawdata() + expectedElem.size(),
+                              expectedElem.fieldNameSize() - 1);
+        ASSERT_EQ(tag, expectedTag);
+        auto [cmpTag, cmpVal] = value::compareValue(tag, val, expectedTag, expectedVal);
+        ASSERT_EQ(cmpTag, value::TypeTags::NumberInt32);
+        ASSERT_EQ(value::bitcastTo<int32_t>(cmpVal), 0)
+            << "got: " << std::make_pair(tag, val) << " expected: " << expectedElem;
+    }
+
+    void assertNothing(const EExpression& expr) {
+        auto compiledExpr = compileExpression(expr);
+        auto [tag, val] = runCompiledExpression(compiledExpr.get());
+        value::ValueGuard guard{tag, val};
+        ASSERT_EQ(tag, value::TypeTags::Nothing);
+    }
+};
+
+TEST_F(SBEBuiltinTest, Concat) {
+    assertResult(*makeE<EFunction>("concat",
+                                   makeEs(makeC(BSON("" << "abc")),
+                                          makeC(BSON("" << "")),
+                                          makeC(BSON("" << "a longer string than 7 bytes")))),
+                 BSON("" << "abca longer string than 7 bytes"));
+    assertResult(*makeE<EFunction>("concat",
+                                   makeEs(makeC(BSON("" << "abc")), makeC(BSON("" << BSONNULL)))),
+                 BSON("" << BSONNULL));
+    ASSERT_THROWS_CODE(
+        assertNothing(*makeE<EFunction>("concat",
+                                        makeEs(makeC(BSON("" << "abc")), makeC(BSON("" << 1))))),
+        DBException,
+        5073321);
+}
+
+TEST_F(SBEBuiltinTest, Substr) {
+    assertResult(
+        *makeE<EFunction>(
+            "substrBytes",
+            makeEs(makeC(BSON("" << "hello")), makeC(BSON("" << 1)), makeC(BSON("" << 3)))),
+        BSON("" << "ell"));
+    assertResult(
+        *makeE<EFunction>(
+            "substrBytes",
+            makeEs(makeC(BSON("" << "hello")), makeC(BSON("" << 2)), makeC(BSON("" << -1)))),
+        BSON("" << "llo"));
+    assertResult(*makeE<EFunction>(
+                     "substrBytes",
+                     makeEs(makeC(BSON("" << 12345)), makeC(BSON("" << 0)), makeC(BSON("" << 2)))),
+                 BSON("" << "12"));
+
+    // "éa" is three bytes but two code points.
+    assertResult(
+        *makeE<EFunction>(
+            "substrCP",
+            makeEs(makeC(BSON("" << "\xc3\xa9" "a")), makeC(BSON("" << 1)), makeC(BSON("" << 1)))),
+        BSON("" << "a"));
+    ASSERT_THROWS_CODE(
+        assertNothing(*makeE<EFunction>("substrBytes",
+                                        makeEs(makeC(BSON("" << "\xc3\xa9" "a")),
+                                               makeC(BSON("" << 1)),
+                                               makeC(BSON("" << 1))))),
+        DBException,
+        5073325);
+}
+
+TEST_F(SBEBuiltinTest, CaseConversion) {
+    assertResult(*makeE<EFunction>("toLower", makeEs(makeC(BSON("" << "AbC")))),
+                 BSON("" << "abc"));
+    assertResult(*makeE<EFunction>("toUpper", makeEs(makeC(BSON("" << "AbC")))),
+                 BSON("" << "ABC"));
+    assertResult(*makeE<EFunction>("toUpper", makeEs(makeC(BSON("" << BSONNULL)))),
+                 BSON("" << ""));
+    assertResult(*makeE<EFunction>("toLower", makeEs(makeC(BSON("" << 1.5)))), BSON("" << "1.5"));
+}
+
+TEST_F(SBEBuiltinTest, Convert) {
+    auto convert = [&](const BSONObj& input, BSONType type) {
+        return makeE<EFunction>(
+            "convert",
+            makeEs(makeC(input),
+                   makeE<EConstant>(value::TypeTags::NumberInt32,
+                                    value::bitcastFrom<int32_t>(type))));
+    };
+
+    assertResult(*convert(BSON("" << "42"), BSONType::NumberInt), BSON("" << 42));
+    assertResult(*convert(BSON("" << 2.9), BSONType::NumberLong), BSON("" << 2LL));
+    assertResult(*convert(BSON("" << 7), BSONType::NumberDouble), BSON("" << 7.0));
+    assertResult(*convert(BSON("" << true), BSONType::String), BSON("" << "true"));
+    assertResult(*convert(BSON("" << 0), BSONType::Bool), BSON("" << false));
+    assertResult(*convert(BSON("" << "abc"), BSONType::Bool), BSON("" << true));
+
+    // Failed conversions produce Nothing, the caller decides how to report them.
+    assertNothing(*convert(BSON("" << "abc"), BSONType::NumberInt));
+    assertNothing(*convert(BSON("" << 1e10), BSONType::NumberInt));
+    assertNothing(*convert(BSON("" << BSON("a" << 1)), BSONType::String));
+}
+
+TEST_F(SBEBuiltinTest, MinMaxAvgOfArguments) {
+    assertResult(*makeE<EFunction>("minOf",
+                                   makeEs(makeC(BSON("" << 3)),
+                                          makeC(BSON("" << BSONNULL)),
+                                          makeC(BSON("" << 1.5)),
+                                          makeC(BSON("" << "str")))),
+                 BSON("" << 1.5));
+    assertResult(*makeE<EFunction>("maxOf",
+                                   makeEs(makeC(BSON("" << 3)),
+                                          makeC(BSON("" << BSONNULL)),
+                                          makeC(BSON("" << 1.5)),
+                                          makeC(BSON("" << "str")))),
+                 BSON("" << "str"));
+
+    // Undefined is ignored like null.
+    BSONObjBuilder undefinedBob;
+    undefinedBob.appendUndefined("");
+    const auto undefinedObj = undefinedBob.obj();
+    assertResult(
+        *makeE<EFunction>("minOf", makeEs(makeC(undefinedObj), makeC(BSON("" << "str")))),
+        BSON("" << "str"));
+    assertResult(*makeE<EFunction>("maxOf", makeEs(makeC(undefinedObj))), BSON("" << BSONNULL));
+
+    // A single array argument is treated as the list of arguments.
+    assertResult(*makeE<EFunction>("maxOf", makeEs(makeC(BSON("" << BSON_ARRAY(1 << 5 << 2))))),
+                 BSON("" << 5));
+    assertResult(*makeE<EFunction>("avgOf", makeEs(makeC(BSON("" << BSON_ARRAY(1 << 2 << "a"))))),
+                 BSON("" << 1.5));
+    assertResult(*makeE<EFunction>("avgOf", makeEs(makeC(BSON("" << BSONNULL)))),
+                 BSON("" << BSONNULL));
+    assertResult(*makeE<EFunction>(
+                     "stdDevPopOf", makeEs(makeC(BSON("" << 1)), makeC(BSON("" << 3)))),
+                 BSON("" << 1.0));
+    assertResult(*makeE<EFunction>("stdDevSampOf", makeEs(makeC(BSON("" << 1)))),
+                 BSON("" << BSONNULL));
+}
+
+TEST_F(SBEBuiltinTest, MergeObjects) {
+    assertResult(*makeE<EFunction>("mergeObjects",
+                                   makeEs(makeC(BSON("" << BSON("a" << 1 << "b" << 2))),
+                                          makeC(BSON("" << BSONNULL)),
+                                          makeC(BSON("" << BSON("c" << 3 << "a" << 4))))),
+                 BSON("" << BSON("a" << 4 << "b" << 2 << "c" << 3)));
+    ASSERT_THROWS_CODE(
+        assertNothing(*makeE<EFunction>("mergeObjects", makeEs(makeC(BSON("" << 1))))),
+        DBException,
+        5073337);
+}
+
+TEST_F(SBEBuiltinTest, DateToString) {
+    auto tzdb = std::make_unique<TimeZoneDatabase>();
+    auto date = Date_t::fromMillisSinceEpoch(1600000000123LL);
+    auto dateToString = [&](StringData format, StringData timezone) {
+        return makeE<EFunction>(
+            "dateToString",
+            makeEs(makeE<EConstant>(value::TypeTags::timeZoneDB, value::bitcastFrom(tzdb.get())),
+                   makeC(BSON("" << date)),
+                   makeC(BSON("" << format)),
+                   makeC(BSON("" << timezone))));
+    };
+
+    assertResult(*dateToString("%Y-%m-%dT%H:%M:%S.%LZ", ""),
+                 BSON("" << "2020-09-13T12:26:40.123Z"));
+    assertResult(*dateToString("%H:%M", "America/New_York"), BSON("" << "08:26"));
+}
+
+}  // namespace mongo::sbe
@@ -0,0 +1,147 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for sbe::ExchangeConsumer and sbe::ExchangeProducer.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/sbe_plan_stage_test.h"
+#include "mongo/db/exec/sbe/stages/exchange.h"
+
+namespace mongo::sbe {
+
+class ExchangeStageTest : public PlanStageTestFixture {
+public:
+    /**
+     * Makes an exchange over 'numOfProducers' copies of a mock scan that produces the 64-bit
+     * integers 0 thru 'numRows' - 1. Every producer runs its own copy of the scan, so every row
+     * is handed to the consumer 'numOfProducers' times.
+     */
+    std::pair<value::SlotId, std::unique_ptr<PlanStage>> makeExchange(
+        int64_t numRows, size_t numOfProducers, std::unique_ptr<EExpression> failure = nullptr) {
+        auto [inputTag, inputVal] = value::makeNewArray();
+        value::ValueGuard inputGuard{inputTag, inputVal};
+        auto inputView = value::getArrayView(inputVal);
+        for (int64_t i = 0; i < numRows; ++i) {
+            inputView->push_back(value::TypeTags::NumberInt64, value::bitcastFrom<int64_t>(i));
+        }
+
+        inputGuard.reset();
+        auto [scanSlot, scanStage] = generateMockScan(inputTag, inputVal);
+
+        if (failure) {
+            scanStage =
+                makeProjectStage(std::move(scanStage), generateSlotId(), std::move(failure));
+        }
+
+        auto exchange = makeS<ExchangeConsumer>(std::move(scanStage),
+                                                numOfProducers,
+                                                makeSV(scanSlot),
+                                                ExchangePolicy::roundrobin,
+                                                nullptr,
+                                                nullptr);
+        return {scanSlot, std::move(exchange)};
+    }
+};
+
+TEST_F(ExchangeStageTest, SingleProducerPreservesOrder) {
+    // Use enough rows to cycle through several exchange buffers.
+    const int64_t numRows = 5000;
+    auto [slot, exchange] = makeExchange(numRows, 1);
+
+    auto resultAccessor = prepareTree(exchange.get(), slot);
+
+    for (int64_t i = 0; i < numRows; ++i) {
+        ASSERT_TRUE(exchange->getNext() == PlanState::ADVANCED);
+
+        auto [tag, val] = resultAccessor->getViewOfValue();
+        ASSERT_TRUE(tag == value::TypeTags::NumberInt64);
+        ASSERT_EQ(value::bitcastTo<int64_t>(val), i);
+    }
+
+    ASSERT_TRUE(exchange->getNext() == PlanState::IS_EOF);
+    exchange->close();
+}
+
+TEST_F(ExchangeStageTest, MultipleProducersReturnEveryRow) {
+    const int64_t numRows = 5000;
+    const size_t numOfProducers = 4;
+    auto [slot, exchange] = makeExchange(numRows, numOfProducers);
+
+    auto resultAccessor = prepareTree(exchange.get(), slot);
+
+    // The rows of different producers interleave in no particular order, but every producer must
+    // hand over all of its rows exactly once.
+    std::vector<size_t> counts(numRows, 0);
+    while (exchange->getNext() == PlanState::ADVANCED) {
+        auto [tag, val] = resultAccessor->getViewOfValue();
+        ASSERT_TRUE(tag == value::TypeTags::NumberInt64);
+        auto row = value::bitcastTo<int64_t>(val);
+        ASSERT_GTE(row, 0);
+        ASSERT_LT(row, numRows);
+        ++counts[row];
+    }
+    exchange->close();
+
+    for (int64_t i = 0; i < numRows; ++i) {
+        ASSERT_EQ(counts[i], numOfProducers);
+    }
+}
+
+TEST_F(ExchangeStageTest, LimitStopsProducersEarly) {
+    // Produce far more rows than the exchange pipes can buffer, so that the producers are blocked
+    // on a full pipe when the consumer stops reading.
+    auto [slot, exchange] = makeExchange(100000, 2);
+    auto limit = makeS<LimitSkipStage>(std::move(exchange), 10, boost::none);
+
+    prepareTree(limit.get());
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(limit->getNext() == PlanState::ADVANCED);
+    }
+    ASSERT_TRUE(limit->getNext() == PlanState::IS_EOF);
+
+    // Closing the consumer must release the blocked producers and wait for them to finish.
+    limit->close();
+}
+
+TEST_F(ExchangeStageTest, ProducerErrorIsRethrownToConsumer) {
+    auto [slot, exchange] =
+        makeExchange(5000, 2, makeE<EFail>(ErrorCodes::BadValue, "producer failed"));
+
+    prepareTree(exchange.get());
+
+    // The error must surface from getNext() rather than the consumer seeing an early EOF.
+    ASSERT_THROWS_CODE(exchange->getNext(), DBException, ErrorCodes::BadValue);
+    ASSERT_THROWS_CODE(exchange->close(), DBException, ErrorCodes::BadValue);
+}
+
+}  // namespace mongo::sbe
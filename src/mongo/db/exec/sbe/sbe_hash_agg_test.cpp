@@ -0,0 +1,293 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+/**
+ * This file contains tests for sbe::HashAggStage.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/sbe_plan_stage_test.h"
+#include "mongo/db/exec/sbe/stages/hash_agg.h"
+#include "mongo/db/exec/sbe/stages/project.h"
+#include "mongo/db/exec/sbe/stages/sort.h"
+#include "mongo/db/storage/storage_options.h"
+#include "mongo/unittest/temp_dir.h"
+
+namespace mongo::sbe {
+
+class HashAggStageTest : public PlanStageTestFixture {
+public:
+    void setUp() override {
+        PlanStageTestFixture::setUp();
+        _origDbPath = storageGlobalParams.dbpath;
+        storageGlobalParams.dbpath = _tempDir.path();
+    }
+
+    void tearDown() override {
+        storageGlobalParams.dbpath = _origDbPath;
+        PlanStageTestFixture::tearDown();
+    }
+
+    /**
+     * Builds a group-by on slot0 computing the sum of slot1, with the output sorted by the group
+     * key so that the results do not depend on the hash table iteration order.
+     */
+    MakeStageFn<value::SlotVector> makeGroupSumFn(bool allowDiskUse, size_t memoryLimit) {
+        return [this, allowDiskUse, memoryLimit](value::SlotVector scanSlots,
+                                                 std::unique_ptr<PlanStage> scanStage) {
+            auto sumSlot = generateSlotId();
+            auto spillSlot = generateSlotId();
+
+            value::SlotMap<std::pair<value::SlotId, std::unique_ptr<EExpression>>> mergingExprs;
+            mergingExprs.emplace(
+                sumSlot,
+                std::make_pair(spillSlot,
+                               makeE<EFunction>("sum", makeEs(makeE<EVariable>(spillSlot)))));
+
+            auto groupStage = makeS<HashAggStage>(
+                std::move(scanStage),
+                makeSV(scanSlots[0]),
+                makeEM(sumSlot, makeE<EFunction>("sum", makeEs(makeE<EVariable>(scanSlots[1])))),
+                std::move(mergingExprs),
+                allowDiskUse,
+                memoryLimit);
+
+            auto sortStage =
+                makeS<SortStage>(std::move(groupStage),
+                                 makeSV(scanSlots[0]),
+                                 std::vector<value::SortDirection>{value::SortDirection::Ascending},
+                                 makeSV(sumSlot),
+                                 std::numeric_limits<std::size_t>::max(),
+                                 204857600,
+                                 false,
+                                 nullptr);
+
+            return std::make_pair(makeSV(scanSlots[0], sumSlot), std::move(sortStage));
+        };
+    }
+
+    BSONArray makeInput() {
+        return BSON_ARRAY(BSON_ARRAY(3 << 1) << BSON_ARRAY(1 << 2) << BSON_ARRAY(2 << 3)
+                                             << BSON_ARRAY(1 << 4) << BSON_ARRAY(3 << 5)
+                                             << BSON_ARRAY(1 << 6) << BSON_ARRAY(2 << 7));
+    }
+
+    BSONArray makeExpectedOutput() {
+        return BSON_ARRAY(BSON_ARRAY(1 << 12) << BSON_ARRAY(2 << 10) << BSON_ARRAY(3 << 6));
+    }
+
+private:
+    unittest::TempDir _tempDir{"sbe_hash_agg_test"};
+    std::string _origDbPath;
+};
+
+TEST_F(HashAggStageTest, GroupSumInMemory) {
+    auto [inputTag, inputVal] = makeValue(makeInput());
+    auto [expectedTag, expectedVal] = makeValue(makeExpectedOutput());
+
+    runTestMulti(2,
+                 inputTag,
+                 inputVal,
+                 expectedTag,
+                 expectedVal,
+                 makeGroupSumFn(false, std::numeric_limits<size_t>::max()));
+}
+
+TEST_F(HashAggStageTest, GroupSumSpillsAndMergesPartialAggregates) {
+    auto [inputTag, inputVal] = makeValue(makeInput());
+    auto [expectedTag, expectedVal] = makeValue(makeExpectedOutput());
+
+    // With a one byte limit every new group forces the hash table to be spilled, so each key ends
+    // up in several spilled runs which have to be merged.
+    runTestMulti(2, inputTag, inputVal, expectedTag, expectedVal, makeGroupSumFn(true, 1));
+}
+
+TEST_F(HashAggStageTest, GroupSpillReportsStats) {
+    auto [scanSlots, scanStage] = generateMockScanMulti(2, makeInput());
+    auto [outputSlots, stage] = makeGroupSumFn(true, 1)(scanSlots, std::move(scanStage));
+
+    auto accessors = prepareTree(stage.get(), outputSlots);
+    auto [resultsTag, resultsVal] = getAllResultsMulti(stage.get(), accessors);
+    value::ValueGuard resultsGuard{resultsTag, resultsVal};
+
+    auto stats = stage->getStats();
+    ASSERT_EQ(1U, stats->children.size());
+    auto groupStats = static_cast<const HashAggStats*>(stats->children[0]->specific.get());
+    ASSERT(groupStats);
+    ASSERT_TRUE(groupStats->usedDisk);
+    ASSERT_GT(groupStats->spills, 1U);
+    ASSERT_EQ(groupStats->spilledRecords, 7U);
+}
+
+TEST_F(HashAggStageTest, GroupSpillCanBeReopened) {
+    auto [expectedTag, expectedVal] = makeValue(makeExpectedOutput());
+    value::ValueGuard expectedGuard{expectedTag, expectedVal};
+
+    auto [scanSlots, scanStage] = generateMockScanMulti(2, makeInput());
+    auto [outputSlots, stage] = makeGroupSumFn(true, 1)(scanSlots, std::move(scanStage));
+
+    auto accessors = prepareTree(stage.get(), outputSlots);
+    for (int i = 0; i < 2; ++i) {
+        if (i) {
+            stage->close();
+            stage->open(true);
+        }
+
+        // Each open must start from a fresh spill file rather than appending to the previous one.
+        auto [resultsTag, resultsVal] = getAllResultsMulti(stage.get(), accessors);
+        value::ValueGuard resultsGuard{resultsTag, resultsVal};
+        ASSERT_TRUE(valueEquals(resultsTag, resultsVal, expectedTag, expectedVal));
+    }
+}
+
+TEST_F(HashAggStageTest, GroupRequiresMergingExpressionForEveryAggregateToSpill) {
+    auto [scanSlots, scanStage] = generateMockScanMulti(2, makeInput());
+    auto sumSlot = generateSlotId();
+    auto countSlot = generateSlotId();
+    auto spillSlot = generateSlotId();
+
+    // Only 'sumSlot' has a merging expression.
+    value::SlotMap<std::pair<value::SlotId, std::unique_ptr<EExpression>>> mergingExprs;
+    mergingExprs.emplace(
+        sumSlot,
+        std::make_pair(spillSlot, makeE<EFunction>("sum", makeEs(makeE<EVariable>(spillSlot)))));
+
+    auto one = makeE<EConstant>(value::TypeTags::NumberInt64, value::bitcastFrom<int64_t>(1));
+    ASSERT_THROWS_CODE(
+        makeS<HashAggStage>(std::move(scanStage),
+                            makeSV(scanSlots[0]),
+                            makeEM(sumSlot,
+                                   makeE<EFunction>("sum", makeEs(makeE<EVariable>(scanSlots[1]))),
+                                   countSlot,
+                                   makeE<EFunction>("sum", makeEs(std::move(one)))),
+                            std::move(mergingExprs),
+                            true,
+                            1),
+        DBException,
+        5072900);
+}
+
+TEST_F(HashAggStageTest, GroupFailsWhenMemoryLimitExceededWithoutDiskUse) {
+    auto [scanSlots, scanStage] = generateMockScanMulti(2, makeInput());
+    auto [outputSlots, stage] = makeGroupSumFn(false, 1)(scanSlots, std::move(scanStage));
+
+    ASSERT_THROWS_CODE(prepareTree(stage.get(), outputSlots),
+                       DBException,
+                       ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed);
+}
+
+TEST_F(HashAggStageTest, GroupAvgAndStdDevWithFinalize) {
+    auto input = BSON_ARRAY(BSON_ARRAY(1 << 2) << BSON_ARRAY(2 << 3) << BSON_ARRAY(1 << 4)
+                                               << BSON_ARRAY(3 << 1) << BSON_ARRAY(2 << 5)
+                                               << BSON_ARRAY(1 << 6) << BSON_ARRAY(2 << 7));
+    auto expected = BSON_ARRAY(BSON_ARRAY(1 << 4.0 << 2.0) << BSON_ARRAY(2 << 5.0 << 2.0)
+                                                           << BSON_ARRAY(3 << 1.0 << BSONNULL));
+    auto [inputTag, inputVal] = makeValue(input);
+    auto [expectedTag, expectedVal] = makeValue(expected);
+
+    auto makeStageFn = [this](value::SlotVector scanSlots, std::unique_ptr<PlanStage> scanStage) {
+        auto avgPartialSlot = generateSlotId();
+        auto stdDevPartialSlot = generateSlotId();
+        auto groupStage = makeS<HashAggStage>(
+            std::move(scanStage),
+            makeSV(scanSlots[0]),
+            makeEM(avgPartialSlot,
+                   makeE<EFunction>("aggAvg", makeEs(makeE<EVariable>(scanSlots[1]))),
+                   stdDevPartialSlot,
+                   makeE<EFunction>("aggStdDev", makeEs(makeE<EVariable>(scanSlots[1])))));
+
+        auto avgSlot = generateSlotId();
+        auto stdDevSlot = generateSlotId();
+        auto finalizeStage = makeProjectStage(
+            std::move(groupStage),
+            avgSlot,
+            makeE<EFunction>("avgFinalize", makeEs(makeE<EVariable>(avgPartialSlot))),
+            stdDevSlot,
+            makeE<EFunction>("stdDevSampFinalize", makeEs(makeE<EVariable>(stdDevPartialSlot))));
+
+        auto sortStage =
+            makeS<SortStage>(std::move(finalizeStage),
+                             makeSV(scanSlots[0]),
+                             std::vector<value::SortDirection>{value::SortDirection::Ascending},
+                             makeSV(avgSlot, stdDevSlot),
+                             std::numeric_limits<std::size_t>::max(),
+                             204857600,
+                             false,
+                             nullptr);
+
+        return std::make_pair(makeSV(scanSlots[0], avgSlot, stdDevSlot), std::move(sortStage));
+    };
+
+    runTestMulti(2, inputTag, inputVal, expectedTag, expectedVal, makeStageFn);
+}
+
+TEST_F(HashAggStageTest, GroupAvgKeepsCompensatedSum) {
+    // In group 1 a plain double sum would lose each 1 to the rounding of 1e16. The compensation
+    // has to survive being carried from row to row in the partial average.
+    auto input = BSON_ARRAY(BSON_ARRAY(1 << 1e16) << BSON_ARRAY(1 << 1.0) << BSON_ARRAY(1 << 1.0)
+                                                  << BSON_ARRAY(2 << 1LL)
+                                                  << BSON_ARRAY(2 << Decimal128("2")));
+    auto expected =
+        BSON_ARRAY(BSON_ARRAY(1 << (1e16 + 2) / 3) << BSON_ARRAY(2 << Decimal128("1.5")));
+    auto [inputTag, inputVal] = makeValue(input);
+    auto [expectedTag, expectedVal] = makeValue(expected);
+
+    auto makeStageFn = [this](value::SlotVector scanSlots, std::unique_ptr<PlanStage> scanStage) {
+        auto avgPartialSlot = generateSlotId();
+        auto groupStage = makeS<HashAggStage>(
+            std::move(scanStage),
+            makeSV(scanSlots[0]),
+            makeEM(avgPartialSlot,
+                   makeE<EFunction>("aggAvg", makeEs(makeE<EVariable>(scanSlots[1])))));
+
+        auto avgSlot = generateSlotId();
+        auto finalizeStage = makeProjectStage(
+            std::move(groupStage),
+            avgSlot,
+            makeE<EFunction>("avgFinalize", makeEs(makeE<EVariable>(avgPartialSlot))));
+
+        auto sortStage =
+            makeS<SortStage>(std::move(finalizeStage),
+                             makeSV(scanSlots[0]),
+                             std::vector<value::SortDirection>{value::SortDirection::Ascending},
+                             makeSV(avgSlot),
+                             std::numeric_limits<std::size_t>::max(),
+                             204857600,
+                             false,
+                             nullptr);
+
+        return std::make_pair(makeSV(scanSlots[0], avgSlot), std::move(sortStage));
+    };
+
+    runTestMulti(2, inputTag, inputVal, expectedTag, expectedVal, makeStageFn);
+}
+
+}  // namespace mongo::sbe
@@ -0,0 +1,183 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+/**
+ * This file contains tests for sbe::HashJoinStage.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/sbe_plan_stage_test.h"
+#include "mongo/db/exec/sbe/stages/hash_join.h"
+#include "mongo/db/exec/sbe/stages/sort.h"
+#include "mongo/db/storage/storage_options.h"
+#include "mongo/unittest/temp_dir.h"
+
+namespace mongo::sbe {
+
+class HashJoinStageTest : public PlanStageTestFixture {
+public:
+    void setUp() override {
+        PlanStageTestFixture::setUp();
+        _origDbPath = storageGlobalParams.dbpath;
+        storageGlobalParams.dbpath = _tempDir.path();
+    }
+
+    void tearDown() override {
+        storageGlobalParams.dbpath = _origDbPath;
+        PlanStageTestFixture::tearDown();
+    }
+
+    /**
+     * Joins the (key, a) outer rows with the (key, b) inner rows on the key. The output is sorted
+     * by (a, b) so that the results do not depend on the hash table iteration order.
+     */
+    std::pair<value::SlotVector, std::unique_ptr<PlanStage>> makeJoin(bool allowDiskUse,
+                                                                      size_t memoryLimit) {
+        auto [outerSlots, outerStage] = generateMockScanMulti(2, makeOuterInput());
+        auto [innerSlots, innerStage] = generateMockScanMulti(2, makeInnerInput());
+
+        auto joinStage = makeS<HashJoinStage>(std::move(outerStage),
+                                              std::move(innerStage),
+                                              makeSV(outerSlots[0]),
+                                              makeSV(outerSlots[1]),
+                                              makeSV(innerSlots[0]),
+                                              makeSV(innerSlots[1]),
+                                              allowDiskUse,
+                                              memoryLimit);
+
+        auto sortStage = makeS<SortStage>(
+            std::move(joinStage),
+            makeSV(outerSlots[1], innerSlots[1]),
+            std::vector<value::SortDirection>{value::SortDirection::Ascending,
+                                              value::SortDirection::Ascending},
+            makeSV(outerSlots[0]),
+            std::numeric_limits<std::size_t>::max(),
+            204857600,
+            false,
+            nullptr);
+
+        return {makeSV(outerSlots[0], outerSlots[1], innerSlots[1]), std::move(sortStage)};
+    }
+
+    BSONArray makeOuterInput() {
+        return BSON_ARRAY(BSON_ARRAY(1 << 10) << BSON_ARRAY(2 << 20) << BSON_ARRAY(3 << 30)
+                                              << BSON_ARRAY(1 << 11));
+    }
+
+    BSONArray makeInnerInput() {
+        return BSON_ARRAY(BSON_ARRAY(1 << 100) << BSON_ARRAY(3 << 300) << BSON_ARRAY(4 << 400)
+                                               << BSON_ARRAY(1 << 101));
+    }
+
+    void runJoinTest(bool allowDiskUse, size_t memoryLimit) {
+        auto [outputSlots, stage] = makeJoin(allowDiskUse, memoryLimit);
+
+        auto accessors = prepareTree(stage.get(), outputSlots);
+        auto [resultsTag, resultsVal] = getAllResultsMulti(stage.get(), accessors);
+        value::ValueGuard resultsGuard{resultsTag, resultsVal};
+
+        auto [expectedTag, expectedVal] = makeValue(BSON_ARRAY(
+            BSON_ARRAY(1 << 10 << 100) << BSON_ARRAY(1 << 10 << 101) << BSON_ARRAY(1 << 11 << 100)
+                                       << BSON_ARRAY(1 << 11 << 101)
+                                       << BSON_ARRAY(3 << 30 << 300)));
+        value::ValueGuard expectedGuard{expectedTag, expectedVal};
+
+        ASSERT_TRUE(valueEquals(resultsTag, resultsVal, expectedTag, expectedVal));
+
+        _lastStats = stage->getStats();
+    }
+
+    const HashJoinStats* lastJoinStats() const {
+        ASSERT_EQ(1U, _lastStats->children.size());
+        return static_cast<const HashJoinStats*>(_lastStats->children[0]->specific.get());
+    }
+
+private:
+    unittest::TempDir _tempDir{"sbe_hash_join_test"};
+    std::string _origDbPath;
+    std::unique_ptr<PlanStageStats> _lastStats;
+};
+
+TEST_F(HashJoinStageTest, JoinInMemory) {
+    runJoinTest(false, std::numeric_limits<size_t>::max());
+
+    auto joinStats = lastJoinStats();
+    ASSERT(joinStats);
+    ASSERT_FALSE(joinStats->usedDisk);
+    ASSERT_EQ(joinStats->numPartitions, 0U);
+}
+
+TEST_F(HashJoinStageTest, JoinSpillsAndJoinsPartitionByPartition) {
+    // With a one byte limit the first build row already triggers partitioning, and every row is
+    // written out as a separate run.
+    runJoinTest(true, 1);
+
+    auto joinStats = lastJoinStats();
+    ASSERT(joinStats);
+    ASSERT_TRUE(joinStats->usedDisk);
+    ASSERT_GT(joinStats->numPartitions, 1U);
+    ASSERT_EQ(joinStats->spilledBuildRecords, 4U);
+    ASSERT_EQ(joinStats->spilledProbeRecords, 4U);
+    ASSERT_GT(joinStats->spilledBytes, 0U);
+}
+
+TEST_F(HashJoinStageTest, JoinSpillStatsStartOverOnReopen) {
+    auto [outputSlots, stage] = makeJoin(true, 1);
+
+    auto accessors = prepareTree(stage.get(), outputSlots);
+    for (int i = 0; i < 2; ++i) {
+        if (i) {
+            stage->close();
+            stage->open(true);
+        }
+
+        auto [resultsTag, resultsVal] = getAllResultsMulti(stage.get(), accessors);
+        value::ValueGuard resultsGuard{resultsTag, resultsVal};
+    }
+
+    auto stats = stage->getStats();
+    ASSERT_EQ(1U, stats->children.size());
+    auto joinStats = static_cast<const HashJoinStats*>(stats->children[0]->specific.get());
+    ASSERT(joinStats);
+    ASSERT_TRUE(joinStats->usedDisk);
+    ASSERT_EQ(joinStats->spilledBuildRecords, 4U);
+    ASSERT_EQ(joinStats->spilledProbeRecords, 4U);
+}
+
+TEST_F(HashJoinStageTest, JoinFailsWhenMemoryLimitExceededWithoutDiskUse) {
+    auto [outputSlots, stage] = makeJoin(false, 1);
+
+    ASSERT_THROWS_CODE(prepareTree(stage.get(), outputSlots),
+                       DBException,
+                       ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed);
+}
+
+}  // namespace mongo::sbe
@@ -0,0 +1,175 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <unordered_map>
+
+#include "mongo/db/exec/sbe/values/row_hash_table.h"
+#include "mongo/db/exec/sbe/values/slot.h"
+#include "mongo/stdx/unordered_map.h"
+
+namespace mongo::sbe::value {
+namespace {
+// The number of input rows fed to the tables in every iteration, the number of distinct keys
+// among them is the benchmark argument.
+constexpr int64_t kNumRows = 1 << 20;
+
+/**
+ * Generates 'kNumRows' (int64, string) keys drawn from 'numDistinct' distinct values.
+ */
+std::vector<std::pair<int64_t, std::string>> makeKeys(int64_t numDistinct) {
+    std::mt19937_64 gen(1234);
+    std::uniform_int_distribution<int64_t> dist(0, numDistinct - 1);
+
+    std::vector<std::pair<int64_t, std::string>> keys;
+    keys.reserve(kNumRows);
+    for (int64_t i = 0; i < kNumRows; ++i) {
+        auto k = dist(gen);
+        keys.emplace_back(k, "customer-" + std::to_string(k % 1000));
+    }
+    return keys;
+}
+
+/**
+ * Mimics the inner loop of 'HashAggStage::open()': look up the group, create it if needed and
+ * update a count accumulator.
+ */
+void BM_GroupNodeHashMap(benchmark::State& state) {
+    using TableType = stdx::unordered_map<MaterializedRow, MaterializedRow, MaterializedRowHasher>;
+    auto keys = makeKeys(state.range(0));
+
+    for (auto _ : state) {
+        TableType ht;
+        for (auto& [a, b] : keys) {
+            MaterializedRow key{2};
+            key.reset(0, false, TypeTags::NumberInt64, bitcastFrom(a));
+            key.reset(1, false, TypeTags::StringBig, bitcastFrom(b.c_str()));
+
+            auto [it, inserted] = ht.try_emplace(std::move(key), MaterializedRow{0});
+            if (inserted) {
+                const_cast<MaterializedRow&>(it->first).makeOwned();
+                it->second.resize(1);
+                it->second.reset(0, false, TypeTags::NumberInt64, 0);
+            }
+            auto [tag, val] = it->second.getViewOfValue(0);
+            it->second.reset(0, false, tag, bitcastFrom(bitcastTo<int64_t>(val) + 1));
+        }
+        benchmark::DoNotOptimize(ht.size());
+    }
+    state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+
+void BM_GroupRowHashTable(benchmark::State& state) {
+    auto keys = makeKeys(state.range(0));
+    ViewOfValueAccessor keyA;
+    ViewOfValueAccessor keyB;
+    std::vector<SlotAccessor*> keyAccessors{&keyA, &keyB};
+
+    for (auto _ : state) {
+        RowHashTable ht{2, 1};
+        for (auto& [a, b] : keys) {
+            keyA.reset(TypeTags::NumberInt64, bitcastFrom(a));
+            keyB.reset(TypeTags::StringBig, bitcastFrom(b.c_str()));
+
+            auto [row, inserted] = ht.findOrInsert(keyAccessors);
+            auto [tag, val] = ht.getValue(row, 0);
+            auto count = inserted ? 0 : bitcastTo<int64_t>(val);
+            ht.resetValue(row, 0, false, TypeTags::NumberInt64, bitcastFrom(count + 1));
+        }
+        benchmark::DoNotOptimize(ht.size());
+    }
+    state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+
+/**
+ * Mimics 'HashJoinStage': build a multimap from 'numDistinct' rows and probe it with every input
+ * row.
+ */
+void BM_JoinProbeNodeMultimap(benchmark::State& state) {
+    using TableType =
+        std::unordered_multimap<MaterializedRow, MaterializedRow, MaterializedRowHasher>;  // NOLINT
+    auto keys = makeKeys(state.range(0));
+
+    TableType ht;
+    for (int64_t k = 0; k < state.range(0); ++k) {
+        MaterializedRow key{1};
+        key.reset(0, false, TypeTags::NumberInt64, bitcastFrom(k));
+        ht.emplace(std::move(key), MaterializedRow{0});
+    }
+
+    MaterializedRow probeKey{1};
+    for (auto _ : state) {
+        size_t matches = 0;
+        for (auto& [a, b] : keys) {
+            probeKey.reset(0, false, TypeTags::NumberInt64, bitcastFrom(a));
+            auto [low, hi] = ht.equal_range(probeKey);
+            for (; low != hi; ++low) {
+                ++matches;
+            }
+        }
+        benchmark::DoNotOptimize(matches);
+    }
+    state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+
+void BM_JoinProbeRowHashTable(benchmark::State& state) {
+    auto keys = makeKeys(state.range(0));
+    ViewOfValueAccessor keyA;
+    std::vector<SlotAccessor*> keyAccessors{&keyA};
+
+    RowHashTable ht{1, 0};
+    for (int64_t k = 0; k < state.range(0); ++k) {
+        keyA.reset(TypeTags::NumberInt64, bitcastFrom(k));
+        ht.insert(keyAccessors);
+    }
+
+    for (auto _ : state) {
+        size_t matches = 0;
+        for (auto& [a, b] : keys) {
+            keyA.reset(TypeTags::NumberInt64, bitcastFrom(a));
+            for (auto row = ht.find(keyAccessors); row != RowHashTable::kNoRow;
+                 row = ht.next(row)) {
+                ++matches;
+            }
+        }
+        benchmark::DoNotOptimize(matches);
+    }
+    state.SetItemsProcessed(state.iterations() * kNumRows);
+}
+
+BENCHMARK(BM_GroupNodeHashMap)->RangeMultiplier(32)->Range(32, 1 << 20);
+BENCHMARK(BM_GroupRowHashTable)->RangeMultiplier(32)->Range(32, 1 << 20);
+BENCHMARK(BM_JoinProbeNodeMultimap)->RangeMultiplier(32)->Range(32, 1 << 20);
+BENCHMARK(BM_JoinProbeRowHashTable)->RangeMultiplier(32)->Range(32, 1 << 20);
+}  // namespace
+}  // namespace mongo::sbe::value
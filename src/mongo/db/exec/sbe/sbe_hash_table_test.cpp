@@ -0,0 +1,178 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+/**
+ * This file contains tests for sbe::value::RowHashTable.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/values/row_hash_table.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo::sbe::value {
+namespace {
+class RowHashTableTest : public unittest::Test {
+protected:
+    void setKey(int64_t a, std::string_view b) {
+        _keyA.reset(TypeTags::NumberInt64, bitcastFrom(a));
+        auto [tag, val] = makeNewString(b);
+        _keyB.reset(tag, val);
+    }
+
+    OwnedValueAccessor _keyA;
+    OwnedValueAccessor _keyB;
+    std::vector<SlotAccessor*> _keys{&_keyA, &_keyB};
+};
+
+TEST_F(RowHashTableTest, FindOrInsertReturnsSameRowForEqualKeys) {
+    RowHashTable table{2, 1};
+
+    setKey(1, "a very long string which does not fit into a small string");
+    auto [row1, inserted1] = table.findOrInsert(_keys);
+    ASSERT_TRUE(inserted1);
+    table.resetValue(row1, 0, false, TypeTags::NumberInt32, bitcastFrom<int32_t>(10));
+
+    setKey(2, "b");
+    auto [row2, inserted2] = table.findOrInsert(_keys);
+    ASSERT_TRUE(inserted2);
+    ASSERT_NE(row1, row2);
+
+    // Numerically equal keys of a different type must match.
+    _keyA.reset(TypeTags::NumberDouble, bitcastFrom<double>(1.0));
+    auto [strTag, strVal] =
+        makeNewString("a very long string which does not fit into a small string");
+    _keyB.reset(strTag, strVal);
+    auto [row3, inserted3] = table.findOrInsert(_keys);
+    ASSERT_FALSE(inserted3);
+    ASSERT_EQ(row1, row3);
+
+    auto [tag, val] = table.getValue(row3, 0);
+    ASSERT(tag == TypeTags::NumberInt32);
+    ASSERT_EQ(bitcastTo<int32_t>(val), 10);
+    ASSERT_EQ(table.size(), 2U);
+}
+
+TEST_F(RowHashTableTest, KeysAreDeepCopied) {
+    RowHashTable table{2, 0};
+
+    setKey(7, "a string which is too long to be stored inline in the value");
+    auto [row, inserted] = table.findOrInsert(_keys);
+    ASSERT_TRUE(inserted);
+
+    // Overwriting the input must not affect the copy held by the table.
+    setKey(8, "x");
+    auto [tag, val] = table.getKey(row, 1);
+    ASSERT_EQ(getStringView(tag, val),
+              std::string_view{"a string which is too long to be stored inline in the value"});
+}
+
+TEST_F(RowHashTableTest, GrowsAndKeepsAllRows) {
+    RowHashTable table{2, 1};
+
+    const int64_t kNumKeys = 10000;
+    for (int64_t i = 0; i < kNumKeys; ++i) {
+        setKey(i, "k");
+        auto [row, inserted] = table.findOrInsert(_keys);
+        ASSERT_TRUE(inserted);
+        table.resetValue(row, 0, false, TypeTags::NumberInt64, bitcastFrom(i * 2));
+    }
+    ASSERT_EQ(table.size(), static_cast<size_t>(kNumKeys));
+
+    for (int64_t i = 0; i < kNumKeys; ++i) {
+        setKey(i, "k");
+        auto row = table.find(_keys);
+        ASSERT_NE(row, RowHashTable::kNoRow);
+        auto [tag, val] = table.getValue(row, 0);
+        ASSERT_EQ(bitcastTo<int64_t>(val), i * 2);
+    }
+
+    setKey(kNumKeys, "k");
+    ASSERT_EQ(table.find(_keys), RowHashTable::kNoRow);
+}
+
+TEST_F(RowHashTableTest, InsertChainsDuplicateKeys) {
+    RowHashTable table{2, 1};
+
+    for (int32_t i = 0; i < 3; ++i) {
+        setKey(5, "dup");
+        auto row = table.insert(_keys);
+        table.resetValue(row, 0, false, TypeTags::NumberInt32, bitcastFrom(i));
+    }
+    setKey(6, "dup");
+    table.insert(_keys);
+
+    setKey(5, "dup");
+    int32_t sum = 0;
+    size_t count = 0;
+    for (auto row = table.find(_keys); row != RowHashTable::kNoRow; row = table.next(row)) {
+        auto [tag, val] = table.getValue(row, 0);
+        sum += bitcastTo<int32_t>(val);
+        ++count;
+    }
+    ASSERT_EQ(count, 3U);
+    ASSERT_EQ(sum, 3);
+}
+
+TEST_F(RowHashTableTest, RowAccessorExposesKeyAndValueColumns) {
+    RowHashTable table{2, 1};
+    size_t currentRow = 0;
+    MaterializedRowAccessor<RowHashTable> keyAccessor{table, currentRow, 0};
+    MaterializedRowAccessor<RowHashTable> valueAccessor{table, currentRow, 2};
+
+    setKey(3, "abc");
+    auto [row, inserted] = table.findOrInsert(_keys);
+    currentRow = row;
+    valueAccessor.reset(false, TypeTags::NumberInt32, bitcastFrom<int32_t>(42));
+
+    auto [keyTag, keyVal] = keyAccessor.getViewOfValue();
+    ASSERT(keyTag == TypeTags::NumberInt64);
+    ASSERT_EQ(bitcastTo<int64_t>(keyVal), 3);
+
+    auto [valTag, valVal] = valueAccessor.getViewOfValue();
+    ASSERT(valTag == TypeTags::NumberInt32);
+    ASSERT_EQ(bitcastTo<int32_t>(valVal), 42);
+}
+
+TEST_F(RowHashTableTest, ClearReleasesRows) {
+    RowHashTable table{2, 0};
+    setKey(1, "a");
+    table.findOrInsert(_keys);
+    table.clear();
+
+    ASSERT_TRUE(table.empty());
+    ASSERT_EQ(table.find(_keys), RowHashTable::kNoRow);
+
+    auto [row, inserted] = table.findOrInsert(_keys);
+    ASSERT_TRUE(inserted);
+    ASSERT_EQ(row, 0U);
+}
+}  // namespace
+}  // namespace mongo::sbe::value
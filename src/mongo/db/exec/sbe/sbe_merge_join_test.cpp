@@ -0,0 +1,109 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+/**
+ * This file contains tests for sbe::MergeJoinStage.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/sbe_plan_stage_test.h"
+#include "mongo/db/exec/sbe/stages/merge_join.h"
+
+namespace mongo::sbe {
+
+class MergeJoinStageTest : public PlanStageTestFixture {
+public:
+    /**
+     * Joins the (key, a) outer rows with the (key, b) inner rows on the key, and checks that the
+     * join returns the (key, a, b) rows in 'expected'. Both inputs must be sorted on the key in the
+     * direction given by 'dir'.
+     */
+    void runJoinTest(BSONArray outer,
+                     BSONArray inner,
+                     value::SortDirection dir,
+                     BSONArray expected) {
+        auto [outerSlots, outerStage] = generateMockScanMulti(2, outer);
+        auto [innerSlots, innerStage] = generateMockScanMulti(2, inner);
+
+        auto stage = makeS<MergeJoinStage>(std::move(outerStage),
+                                           std::move(innerStage),
+                                           makeSV(outerSlots[0]),
+                                           makeSV(outerSlots[1]),
+                                           makeSV(innerSlots[0]),
+                                           std::vector<value::SortDirection>{dir});
+
+        auto accessors =
+            prepareTree(stage.get(), makeSV(outerSlots[0], outerSlots[1], innerSlots[1]));
+        auto [resultsTag, resultsVal] = getAllResultsMulti(stage.get(), accessors);
+        value::ValueGuard resultsGuard{resultsTag, resultsVal};
+
+        auto [expectedTag, expectedVal] = makeValue(expected);
+        value::ValueGuard expectedGuard{expectedTag, expectedVal};
+
+        ASSERT_TRUE(valueEquals(resultsTag, resultsVal, expectedTag, expectedVal));
+    }
+};
+
+TEST_F(MergeJoinStageTest, JoinAscendingInputsWithDuplicates) {
+    auto outer = BSON_ARRAY(BSON_ARRAY(1 << 10) << BSON_ARRAY(1 << 11) << BSON_ARRAY(2 << 20)
+                                                << BSON_ARRAY(3 << 30) << BSON_ARRAY(5 << 50));
+    auto inner = BSON_ARRAY(BSON_ARRAY(0 << 0)
+                            << BSON_ARRAY(1 << 100) << BSON_ARRAY(1 << 101) << BSON_ARRAY(3 << 300)
+                            << BSON_ARRAY(4 << 400) << BSON_ARRAY(5 << 500)
+                            << BSON_ARRAY(6 << 600));
+
+    // Every buffered outer row is returned once for each matching inner row.
+    auto expected = BSON_ARRAY(BSON_ARRAY(1 << 10 << 100)
+                               << BSON_ARRAY(1 << 11 << 100) << BSON_ARRAY(1 << 10 << 101)
+                               << BSON_ARRAY(1 << 11 << 101) << BSON_ARRAY(3 << 30 << 300)
+                               << BSON_ARRAY(5 << 50 << 500));
+
+    runJoinTest(outer, inner, value::SortDirection::Ascending, expected);
+}
+
+TEST_F(MergeJoinStageTest, JoinDescendingInputs) {
+    auto outer = BSON_ARRAY(BSON_ARRAY(5 << 50) << BSON_ARRAY(3 << 30) << BSON_ARRAY(2 << 20));
+    auto inner = BSON_ARRAY(BSON_ARRAY(4 << 400) << BSON_ARRAY(3 << 300) << BSON_ARRAY(2 << 200)
+                                                 << BSON_ARRAY(1 << 100));
+
+    auto expected = BSON_ARRAY(BSON_ARRAY(3 << 30 << 300) << BSON_ARRAY(2 << 20 << 200));
+
+    runJoinTest(outer, inner, value::SortDirection::Descending, expected);
+}
+
+TEST_F(MergeJoinStageTest, JoinWithNoMatchesReturnsNothing) {
+    auto outer = BSON_ARRAY(BSON_ARRAY(1 << 10) << BSON_ARRAY(3 << 30));
+    auto inner = BSON_ARRAY(BSON_ARRAY(2 << 200) << BSON_ARRAY(4 << 400));
+
+    runJoinTest(outer, inner, value::SortDirection::Ascending, BSONArray{});
+}
+
+}  // namespace mongo::sbe
@@ -73,4 +73,181 @@ TEST_F(SortStageTest, SortNumbersTest) {
     runTestMulti(2, inputTag, inputVal, expectedTag, expectedVal, makeStageFn);
 }
 
+TEST_F(SortStageTest, SortCompoundKeysWithLimitTest) {
+    auto [scanSlots, scanStage] = generateMockScanMulti(
+        3,
+        BSON_ARRAY(BSON_ARRAY(1 << "x"
+                                << "A")
+                   << BSON_ARRAY(2 << "y"
+                                   << "B")
+                   << BSON_ARRAY(1 << "z"
+                                   << "C")
+                   << BSON_ARRAY(3 << "x"
+                                   << "D")
+                   << BSON_ARRAY(2 << "x"
+                                   << "E")));
+
+    // Sort by slot0 in ascending and by slot1 in descending order, and keep the top three rows.
+    auto sortStage = makeS<SortStage>(
+        std::move(scanStage),
+        makeSV(scanSlots[0], scanSlots[1]),
+        std::vector<value::SortDirection>{value::SortDirection::Ascending,
+                                          value::SortDirection::Descending},
+        makeSV(scanSlots[2]),
+        3,
+        204857600,
+        false,
+        nullptr);
+
+    auto accessors = prepareTree(sortStage.get(), scanSlots);
+    auto [resultsTag, resultsVal] = getAllResultsMulti(sortStage.get(), accessors);
+    value::ValueGuard resultsGuard{resultsTag, resultsVal};
+
+    auto [expectedTag, expectedVal] = makeValue(BSON_ARRAY(BSON_ARRAY(1 << "z"
+                                                                        << "C")
+                                                           << BSON_ARRAY(1 << "x"
+                                                                           << "A")
+                                                           << BSON_ARRAY(2 << "y"
+                                                                           << "B")));
+    value::ValueGuard expectedGuard{expectedTag, expectedVal};
+
+    ASSERT_TRUE(valueEquals(resultsTag, resultsVal, expectedTag, expectedVal));
+
+    // The rows which did not make it into the top three once it had been filled were dropped
+    // without being materialized.
+    auto stats = static_cast<const SortStats*>(sortStage->getSpecificStats());
+    ASSERT_EQ(stats->keysSorted, 5U);
+    ASSERT_EQ(stats->keysSkippedByLimit, 2U);
+    ASSERT_FALSE(stats->usedDisk);
+}
+
+TEST_F(SortStageTest, SortWithZeroLimitReturnsNothing) {
+    auto [scanSlots, scanStage] = generateMockScanMulti(
+        2, BSON_ARRAY(BSON_ARRAY(2 << "A") << BSON_ARRAY(1 << "B") << BSON_ARRAY(3 << "C")));
+
+    auto sortStage =
+        makeS<SortStage>(std::move(scanStage),
+                         makeSV(scanSlots[0]),
+                         std::vector<value::SortDirection>{value::SortDirection::Ascending},
+                         makeSV(scanSlots[1]),
+                         0,
+                         204857600,
+                         false,
+                         nullptr);
+
+    prepareTree(sortStage.get(), scanSlots);
+    ASSERT_TRUE(sortStage->getNext() == PlanState::IS_EOF);
+
+    auto stats = static_cast<const SortStats*>(sortStage->getSpecificStats());
+    ASSERT_EQ(stats->keysSorted, 3U);
+    ASSERT_EQ(stats->keysSkippedByLimit, 3U);
+}
+
+TEST_F(SortStageTest, SortWithLimitFailsWhenMemoryLimitExceededWithoutDiskUse) {
+    auto [scanSlots, scanStage] = generateMockScanMulti(
+        2, BSON_ARRAY(BSON_ARRAY(2 << "A") << BSON_ARRAY(1 << "B") << BSON_ARRAY(3 << "C")));
+
+    auto sortStage =
+        makeS<SortStage>(std::move(scanStage),
+                         makeSV(scanSlots[0]),
+                         std::vector<value::SortDirection>{value::SortDirection::Ascending},
+                         makeSV(scanSlots[1]),
+                         2,
+                         1,
+                         false,
+                         nullptr);
+
+    ASSERT_THROWS_CODE(prepareTree(sortStage.get(), scanSlots),
+                       DBException,
+                       ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed);
+}
+
+TEST_F(SortStageTest, SortStatsStartOverOnReopen) {
+    auto [scanSlots, scanStage] = generateMockScanMulti(
+        2, BSON_ARRAY(BSON_ARRAY(2 << "A") << BSON_ARRAY(1 << "B") << BSON_ARRAY(3 << "C")));
+
+    auto sortStage =
+        makeS<SortStage>(std::move(scanStage),
+                         makeSV(scanSlots[0]),
+                         std::vector<value::SortDirection>{value::SortDirection::Ascending},
+                         makeSV(scanSlots[1]),
+                         1,
+                         204857600,
+                         false,
+                         nullptr);
+
+    auto accessors = prepareTree(sortStage.get(), scanSlots);
+    for (int i = 0; i < 2; ++i) {
+        if (i) {
+            sortStage->close();
+            sortStage->open(true);
+        }
+
+        auto [resultsTag, resultsVal] = getAllResultsMulti(sortStage.get(), accessors);
+        value::ValueGuard resultsGuard{resultsTag, resultsVal};
+    }
+
+    // Only the second run is counted.
+    auto stats = static_cast<const SortStats*>(sortStage->getSpecificStats());
+    ASSERT_EQ(stats->keysSorted, 3U);
+    ASSERT_EQ(stats->keysSkippedByLimit, 1U);
+}
+
+TEST_F(SortStageTest, SortByKeyStringValues) {
+    using namespace std::literals;
+
+    auto [scanSlot, scanStage] = generateMockScan(BSON_ARRAY(3 << 1 << 2));
+
+    // Sort by a KeyString made of each value.
+    auto ksSlot = generateSlotId();
+    auto projectStage = makeProjectStage(
+        std::move(scanStage),
+        ksSlot,
+        makeE<EFunction>("ks"sv,
+                         makeEs(makeE<EConstant>(value::TypeTags::NumberInt64, 1),
+                                makeE<EConstant>(value::TypeTags::NumberInt32, 0),
+                                makeE<EVariable>(scanSlot),
+                                makeE<EConstant>(value::TypeTags::NumberInt64, 0))));
+
+    auto sortStage =
+        makeS<SortStage>(std::move(projectStage),
+                         makeSV(ksSlot),
+                         std::vector<value::SortDirection>{value::SortDirection::Ascending},
+                         makeSV(scanSlot),
+                         std::numeric_limits<std::size_t>::max(),
+                         204857600,
+                         false,
+                         nullptr);
+
+    auto resultAccessor = prepareTree(sortStage.get(), scanSlot);
+    auto [resultsTag, resultsVal] = getAllResults(sortStage.get(), resultAccessor);
+    value::ValueGuard resultsGuard{resultsTag, resultsVal};
+
+    auto [expectedTag, expectedVal] = makeValue(BSON_ARRAY(1 << 2 << 3));
+    value::ValueGuard expectedGuard{expectedTag, expectedVal};
+
+    ASSERT_TRUE(valueEquals(resultsTag, resultsVal, expectedTag, expectedVal));
+}
+
+TEST_F(SortStageTest, SortByCompiledRegexFails) {
+    auto [scanSlot, scanStage] = generateMockScan(BSON_ARRAY(1 << 2));
+
+    auto regexSlot = generateSlotId();
+    auto [regexTag, regexVal] = value::makeCopyPcreRegex(pcrecpp::RE("a"));
+    auto projectStage =
+        makeProjectStage(std::move(scanStage), regexSlot, makeE<EConstant>(regexTag, regexVal));
+
+    auto sortStage =
+        makeS<SortStage>(std::move(projectStage),
+                         makeSV(regexSlot),
+                         std::vector<value::SortDirection>{value::SortDirection::Ascending},
+                         makeSV(scanSlot),
+                         std::numeric_limits<std::size_t>::max(),
+                         204857600,
+                         false,
+                         nullptr);
+
+    ASSERT_THROWS_CODE(prepareTree(sortStage.get()), DBException, 5073339);
+}
+
 }  // namespace mongo::sbe
@@ -159,4 +159,57 @@ TEST(SBEVM, Add) {
     }
 }
 
+TEST(SBEVM, ConstantOperandsAreFusedIntoSuperinstructions) {
+    auto [objTag, objVal] = value::makeNewObject();
+    value::ValueGuard objGuard{objTag, objVal};
+    value::getObjectView(objVal)->push_back(
+        "a", value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(3));
+    auto [fieldTag, fieldVal] = value::makeNewString("a");
+    value::ValueGuard fieldGuard{fieldTag, fieldVal};
+
+    // getField(obj, "a") < 5
+    vm::CodeFragment code;
+    code.appendConstVal(objTag, objVal);
+    code.appendConstVal(fieldTag, fieldVal);
+    code.appendGetField();
+    code.appendConstVal(value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(5));
+    code.appendLess();
+
+    // Both the getField and the less consume the constant pushed right before them, so they are
+    // encoded with it and the only instructions left are the three constants.
+    const auto constValSize =
+        sizeof(vm::Instruction) + sizeof(value::TypeTags) + sizeof(value::Value);
+    ASSERT_EQ(code.instrs().size(), 3 * constValSize);
+    ASSERT_EQ(code.stackSize(), 1);
+
+    vm::ByteCode interpreter;
+    ASSERT_TRUE(interpreter.runPredicate(&code));
+}
+
+TEST(SBEVM, ConstantsJumpedOverAreNotFused) {
+    // 4 < (if false then 5 else 7), laid out as: push 4, push false, jmpTrue then, push 7,
+    // jmp end, then: push 5, end: less.
+    auto thenBranch = std::make_unique<vm::CodeFragment>();
+    thenBranch->appendConstVal(value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(5));
+
+    auto elseBranch = std::make_unique<vm::CodeFragment>();
+    elseBranch->appendConstVal(value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(7));
+    elseBranch->appendJump(thenBranch->instrs().size());
+
+    vm::CodeFragment code;
+    code.appendConstVal(value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(4));
+    code.appendConstVal(value::TypeTags::Boolean, value::bitcastFrom<bool>(false));
+    code.appendJumpTrue(elseBranch->instrs().size());
+    code.append(std::move(elseBranch), std::move(thenBranch));
+
+    // The else branch jumps to the end, past the start of the last constant, so fusing it with the
+    // less would make the jump skip the comparison.
+    auto sizeBeforeLess = code.instrs().size();
+    code.appendLess();
+    ASSERT_EQ(code.instrs().size(), sizeBeforeLess + sizeof(vm::Instruction));
+
+    vm::ByteCode interpreter;
+    ASSERT_TRUE(interpreter.runPredicate(&code));
+}
+
 }  // namespace mongo::sbe
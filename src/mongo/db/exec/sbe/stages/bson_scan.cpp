@@ -40,17 +40,20 @@ BSONScanStage::BSONScanStage(const char* bsonBegin,
                              const char* bsonEnd,
                              boost::optional<value::SlotId> recordSlot,
                              std::vector<std::string> fields,
-                             value::SlotVector vars)
+                             value::SlotVector vars,
+                             bool blockMode)
     : PlanStage("bsonscan"_sd),
       _bsonBegin(bsonBegin),
       _bsonEnd(bsonEnd),
       _recordSlot(recordSlot),
       _fields(std::move(fields)),
       _vars(std::move(vars)),
+      _blockMode(blockMode),
       _bsonCurrent(bsonBegin) {}
 
 std::unique_ptr<PlanStage> BSONScanStage::clone() const {
-    return std::make_unique<BSONScanStage>(_bsonBegin, _bsonEnd, _recordSlot, _fields, _vars);
+    return std::make_unique<BSONScanStage>(
+        _bsonBegin, _bsonEnd, _recordSlot, _fields, _vars, _blockMode);
 }
 
 void BSONScanStage::prepare(CompileCtx& ctx) {
@@ -65,6 +68,15 @@ void BSONScanStage::prepare(CompileCtx& ctx) {
         auto [itRename, insertedRename] = _varAccessors.emplace(_vars[idx], it->second.get());
         uassert(4822842, str::stream() << "duplicate field: " << _vars[idx], insertedRename);
     }
+
+    if (_blockMode) {
+        _recordBlock = std::make_unique<value::ValueBlock>();
+        for (size_t idx = 0; idx < _fields.size(); ++idx) {
+            auto [it, inserted] =
+                _fieldBlocks.emplace(_fields[idx], std::make_unique<value::ValueBlock>());
+            _varBlocks.emplace(_vars[idx], it->second.get());
+        }
+    }
 }
 
 value::SlotAccessor* BSONScanStage::getAccessor(CompileCtx& ctx, value::SlotId slot) {
@@ -79,6 +91,24 @@ value::SlotAccessor* BSONScanStage::getAccessor(CompileCtx& ctx, value::SlotId s
     return ctx.getAccessor(slot);
 }
 
+bool BSONScanStage::canProduceBlocks() const {
+    return _blockMode;
+}
+
+value::ValueBlock* BSONScanStage::getBlock(CompileCtx& ctx, value::SlotId slot) {
+    invariant(_blockMode);
+
+    if (_recordSlot && *_recordSlot == slot) {
+        return _recordBlock.get();
+    }
+
+    if (auto it = _varBlocks.find(slot); it != _varBlocks.end()) {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
 void BSONScanStage::open(bool reOpen) {
     _commonStats.opens++;
     _bsonCurrent = _bsonBegin;
@@ -126,6 +156,34 @@ PlanState BSONScanStage::getNext() {
     return trackPlanState(PlanState::IS_EOF);
 }
 
+size_t BSONScanStage::getNextBlock() {
+    invariant(_blockMode);
+
+    _recordBlock->clear();
+    for (auto& [name, block] : _fieldBlocks) {
+        block->clear();
+    }
+
+    // The documents are not going anywhere while the stage is open, so the blocks can hold the
+    // views into them directly.
+    size_t size = 0;
+    while (size < value::kBlockSize && _bsonCurrent < _bsonEnd) {
+        _recordBlock->push_back(
+            false, value::TypeTags::bsonObject, value::bitcastFrom<const char*>(_bsonCurrent));
+        value::appendFieldsToBlocks(_bsonCurrent, _fieldBlocks);
+
+        _bsonCurrent += value::readFromMemory<uint32_t>(_bsonCurrent);
+        ++size;
+    }
+
+    if (size == 0) {
+        _commonStats.isEOF = true;
+    }
+    _commonStats.advances += size;
+    _specificStats.numReads += size;
+    return size;
+}
+
 void BSONScanStage::close() {
     _commonStats.closes++;
 }
@@ -40,7 +40,8 @@ public:
                   const char* bsonEnd,
                   boost::optional<value::SlotId> recordSlot,
                   std::vector<std::string> fields,
-                  value::SlotVector vars);
+                  value::SlotVector vars,
+                  bool blockMode = false);
 
     std::unique_ptr<PlanStage> clone() const final;
 
@@ -50,6 +51,10 @@ public:
     PlanState getNext() final;
     void close() final;
 
+    bool canProduceBlocks() const final;
+    value::ValueBlock* getBlock(CompileCtx& ctx, value::SlotId slot) final;
+    size_t getNextBlock() final;
+
     std::unique_ptr<PlanStageStats> getStats() const final;
     const SpecificStats* getSpecificStats() const final;
 
@@ -62,12 +67,17 @@ private:
     const boost::optional<value::SlotId> _recordSlot;
     const std::vector<std::string> _fields;
     const value::SlotVector _vars;
+    const bool _blockMode;
 
     std::unique_ptr<value::ViewOfValueAccessor> _recordAccessor;
 
     value::FieldAccessorMap _fieldAccessors;
     value::SlotAccessorMap _varAccessors;
 
+    std::unique_ptr<value::ValueBlock> _recordBlock;
+    value::FieldBlockMap _fieldBlocks;
+    value::SlotMap<value::ValueBlock*> _varBlocks;
+
     const char* _bsonCurrent;
 
     ScanStats _specificStats;
@@ -33,6 +33,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/query/query_knobs_gen.h"
 
 namespace mongo::sbe {
 std::unique_ptr<ThreadPool> s_globalThreadPool;
@@ -42,13 +43,50 @@ MONGO_INITIALIZER(s_globalThreadPool)(InitializerContext* context) {
     options.threadNamePrefix = "ExchProd";
     options.minThreads = 0;
     options.maxThreads = 128;
-    options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
     s_globalThreadPool = std::make_unique<ThreadPool>(options);
     s_globalThreadPool->startup();
 
     return Status::OK();
 }
 
+namespace {
+/**
+ * Yields the subtree of a single producer. Every producer runs on its own operation context and
+ * thread, so it cannot share the consumer's yield policy; it saves and restores only its own
+ * subtree and abandons only its own snapshot.
+ */
+class ExchangeProducerYieldPolicy final : public PlanYieldPolicy {
+public:
+    ExchangeProducerYieldPolicy(OperationContext* opCtx, PlanStage* root)
+        : PlanYieldPolicy(YieldPolicy::YIELD_AUTO,
+                          opCtx->getServiceContext()->getFastClockSource(),
+                          internalQueryExecYieldIterations.load(),
+                          Milliseconds{internalQueryExecYieldPeriodMS.load()}),
+          _root(root) {}
+
+private:
+    Status yield(OperationContext* opCtx, std::function<void()> whileYieldingFn) override {
+        try {
+            _root->saveState();
+
+            opCtx->recoveryUnit()->abandonSnapshot();
+
+            if (whileYieldingFn) {
+                whileYieldingFn();
+            }
+
+            _root->restoreState();
+        } catch (...) {
+            return exceptionToStatus();
+        }
+
+        return Status::OK();
+    }
+
+    PlanStage* const _root;
+};
+}  // namespace
+
 ExchangePipe::ExchangePipe(size_t size) {
     // All buffers start empty.
     _fullCount = 0;
@@ -134,6 +172,17 @@ ExchangePipe* ExchangeState::pipe(size_t consumerTid, size_t producerTid) {
     return _consumers[consumerTid]->pipe(producerTid);
 }
 
+void ExchangeState::checkConsumerForInterrupt() const {
+    if (!_consumerOpCtx) {
+        return;
+    }
+
+    stdx::lock_guard<Client> lk(*_consumerOpCtx->getClient());
+    if (auto killStatus = _consumerOpCtx->getKillStatus(); killStatus != ErrorCodes::OK) {
+        uasserted(killStatus, "exchange consumer was interrupted");
+    }
+}
+
 ExchangeBuffer* ExchangeConsumer::getBuffer(size_t producerId) {
     if (_fullBuffers[producerId]) {
         return _fullBuffers[producerId].get();
@@ -248,21 +297,52 @@ void ExchangeConsumer::open(bool reOpen) {
                 }
             }
 
+            // The producers run on their own operation contexts. They share the consumer's
+            // deadline, and check the consumer for interrupt as they go.
+            const auto deadline = _opCtx ? _opCtx->getDeadline() : Date_t::max();
+            const auto timeoutError =
+                _opCtx ? _opCtx->getTimeoutError() : ErrorCodes::MaxTimeMSExpired;
+            _state->setConsumerOpCtx(_opCtx);
+            auto serviceContext = _opCtx ? _opCtx->getServiceContext() : getGlobalServiceContext();
+
             // Start n producers.
             invariant(_state->producerCompileCtxs().size() == _state->numOfProducers());
             for (size_t idx = 0; idx < _state->numOfProducers(); ++idx) {
                 auto pf = makePromiseFuture<void>();
                 s_globalThreadPool->schedule(
-                    [this, idx, promise = std::move(pf.promise)](auto status) mutable {
+                    [this,
+                     idx,
+                     deadline,
+                     timeoutError,
+                     serviceContext,
+                     promise = std::move(pf.promise)](auto status) mutable {
                         invariant(status);
 
-                        auto opCtx = cc().makeOperationContext();
-
-                        promise.setWith([&] {
-                            ExchangeProducer::start(opCtx.get(),
-                                                    _state->producerCompileCtxs()[idx],
-                                                    std::move(_state->producerPlans()[idx]));
-                        });
+                        // The client lives only as long as the producer, and is gone before the
+                        // consumer learns that the producer has finished. Pool threads thus never
+                        // hold on to a client of a service context that may be torn down.
+                        Status result = Status::OK();
+                        {
+                            ThreadClient tc("ExchProd", serviceContext);
+                            auto opCtx = tc->makeOperationContext();
+                            if (deadline != Date_t::max()) {
+                                opCtx->setDeadlineByDate(deadline, timeoutError);
+                            }
+
+                            try {
+                                ExchangeProducer::start(opCtx.get(),
+                                                        _state->producerCompileCtxs()[idx],
+                                                        std::move(_state->producerPlans()[idx]));
+                            } catch (...) {
+                                result = exceptionToStatus();
+                            }
+                        }
+
+                        if (result.isOK()) {
+                            promise.emplaceValue();
+                        } else {
+                            promise.setError(std::move(result));
+                        }
                     });
                 _state->addProducerFuture(std::move(pf.future));
             }
@@ -297,6 +377,13 @@ PlanState ExchangeConsumer::getNext() {
         while (_eofs < _state->numOfProducers()) {
             auto buffer = getBuffer(0);
             if (!buffer) {
+                // The pipe is only closed under a reading consumer if a producer failed. Wait for
+                // the producers and rethrow the error rather than cutting the stream short.
+                if (_tid == 0) {
+                    for (size_t idx = 0; idx < _state->numOfProducers(); ++idx) {
+                        _state->producerResults()[idx].get();
+                    }
+                }
                 // early out
                 return trackPlanState(PlanState::IS_EOF);
             }
@@ -438,6 +525,14 @@ void ExchangeProducer::closePipes() {
     }
 }
 
+void ExchangeProducer::checkForInterrupt() {
+    if (--_interruptCounter == 0) {
+        _interruptCounter = kInterruptCheckPeriod;
+        _opCtx->checkForInterrupt();
+        _state->checkConsumerForInterrupt();
+    }
+}
+
 ExchangeProducer::ExchangeProducer(std::unique_ptr<PlanStage> input,
                                    std::shared_ptr<ExchangeState> state)
     : PlanStage("exchangep"_sd), _state(state) {
@@ -459,6 +554,10 @@ void ExchangeProducer::start(OperationContext* opCtx,
 
     p->attachFromOperationContext(opCtx);
 
+    // Stages that were built to yield yield on behalf of this producer.
+    ExchangeProducerYieldPolicy yieldPolicy{opCtx, p};
+    p->attachNewYieldPolicy(&yieldPolicy);
+
     try {
         p->prepare(ctx);
         p->open(false);
@@ -515,6 +614,8 @@ bool ExchangeProducer::appendData(size_t consumerId) {
 
 PlanState ExchangeProducer::getNext() {
     while (_children[0]->getNext() == PlanState::ADVANCED) {
+        checkForInterrupt();
+
         // Push to the correct pipe.
         switch (_state->policy()) {
             case ExchangePolicy::broadcast: {
@@ -217,6 +217,16 @@ public:
     }
     ExchangePipe* pipe(size_t consumerTid, size_t producerTid);
 
+    void setConsumerOpCtx(OperationContext* opCtx) {
+        _consumerOpCtx = opCtx;
+    }
+
+    /**
+     * Throws if the operation on whose behalf the consumers run has been killed, so that the
+     * producers, which run on their own operation contexts, stop along with it.
+     */
+    void checkConsumerForInterrupt() const;
+
 private:
     const ExchangePolicy _policy;
     const size_t _numOfProducers;
@@ -229,6 +239,10 @@ private:
     // Variables (fields) that pass through the exchange.
     const value::SlotVector _fields;
 
+    // The operation context of consumer 0. Consumer 0 waits for all producers to finish before it
+    // closes, so it outlives them.
+    OperationContext* _consumerOpCtx{nullptr};
+
     // Partitioning function.
     const std::unique_ptr<EExpression> _partition;
 
@@ -325,6 +339,12 @@ private:
     void closePipes();
     bool appendData(size_t consumerId);
 
+    /**
+     * Periodically checks both this producer's and the consumer's operation contexts for
+     * interrupt.
+     */
+    void checkForInterrupt();
+
     std::shared_ptr<ExchangeState> _state;
     size_t _tid{0};
     size_t _roundRobinCounter{0};
@@ -335,5 +355,8 @@ private:
 
     // Current empty buffers that this producer is processing.
     std::vector<std::unique_ptr<ExchangeBuffer>> _emptyBuffers;
+
+    static const int kInterruptCheckPeriod = 128;
+    int _interruptCounter = kInterruptCheckPeriod;
 };
 }  // namespace mongo::sbe
@@ -40,6 +40,11 @@ namespace mongo::sbe {
  * evaluate it in the open() call and skip getNext() calls completely if the result is false.
  * The IsEof template parameter controls 'early out' behavior of the filter expression. Once the
  * filter evaluates to false then the getNext() call returns EOF.
+ *
+ * If the input can produce blocks of rows then the plain filter runs in the block mode: it pulls a
+ * whole block from the input, evaluates the predicate over the block (using a block kernel when the
+ * predicate has one, or the bytecode for every row otherwise) and compacts the input blocks so that
+ * only the qualifying rows are left in them.
  */
 template <bool IsConst, bool IsEof = false>
 class FilterStage final : public PlanStage {
@@ -58,14 +63,57 @@ public:
     void prepare(CompileCtx& ctx) final {
         _children[0]->prepare(ctx);
 
+        if constexpr (!IsConst && !IsEof) {
+            _blockMode = _children[0]->canProduceBlocks();
+        }
+
         ctx.root = this;
         _filterCode = _filter->compile(ctx);
+        if (_blockMode) {
+            _filterKernel = _filter->compileBlock(ctx);
+        }
     }
 
     value::SlotAccessor* getAccessor(CompileCtx& ctx, value::SlotId slot) final {
+        if (_blockMode) {
+            if (auto it = _blockAccessors.find(slot); it != _blockAccessors.end()) {
+                return it->second.get();
+            }
+            if (auto block = getBlock(ctx, slot)) {
+                auto [it, inserted] = _blockAccessors.emplace(
+                    slot, std::make_unique<value::ValueBlockAccessor>(block, _blockRow));
+                return it->second.get();
+            }
+        }
         return _children[0]->getAccessor(ctx, slot);
     }
 
+    bool canProduceBlocks() const final {
+        return _blockMode;
+    }
+
+    value::ValueBlock* getBlock(CompileCtx& ctx, value::SlotId slot) final {
+        if (!_blockMode) {
+            return nullptr;
+        }
+
+        // Every block handed out by this stage has to be compacted along with the others.
+        auto block = _children[0]->getBlock(ctx, slot);
+        if (block && std::find(_blocks.begin(), _blocks.end(), block) == _blocks.end()) {
+            _blocks.push_back(block);
+        }
+        return block;
+    }
+
+    size_t getNextBlock() final {
+        auto size = nextSelectedBlock();
+        if (size == 0) {
+            _commonStats.isEOF = true;
+        }
+        _commonStats.advances += size;
+        return size;
+    }
+
     void open(bool reOpen) final {
         _commonStats.opens++;
 
@@ -80,6 +128,8 @@ public:
         }
         _children[0]->open(reOpen);
         _childOpened = true;
+        _blockSize = 0;
+        _nextRow = 0;
     }
 
     PlanState getNext() final {
@@ -92,6 +142,18 @@ public:
             }
         }
 
+        if (_blockMode) {
+            if (_nextRow == _blockSize) {
+                _blockSize = nextSelectedBlock();
+                _nextRow = 0;
+                if (_blockSize == 0) {
+                    return trackPlanState(PlanState::IS_EOF);
+                }
+            }
+            _blockRow = _nextRow++;
+            return trackPlanState(PlanState::ADVANCED);
+        }
+
         auto state = PlanState::IS_EOF;
         bool pass = false;
 
@@ -156,6 +218,46 @@ public:
     }
 
 private:
+    /**
+     * Pulls the blocks from the input until one of them has a row passing the filter, and returns
+     * the number of the passing rows left in the compacted blocks, or zero if the input is
+     * exhausted.
+     */
+    size_t nextSelectedBlock() {
+        while (auto size = _children[0]->getNextBlock()) {
+            _specificStats.numTested += size;
+
+            size_t selected = 0;
+            _selection.assign(size, 0);
+
+            auto result = _filterKernel ? _filterKernel->eval(size) : nullptr;
+            if (result && result->commonTag(size) == value::TypeTags::Boolean) {
+                auto vals = result->vals();
+                for (size_t idx = 0; idx < size; ++idx) {
+                    _selection[idx] = (vals[idx] != 0);
+                    selected += _selection[idx];
+                }
+            } else {
+                for (_blockRow = 0; _blockRow < size; ++_blockRow) {
+                    auto pass = _bytecode.runPredicate(_filterCode.get());
+                    _selection[_blockRow] = pass;
+                    selected += pass;
+                }
+            }
+
+            if (selected > 0) {
+                if (selected < size) {
+                    for (auto block : _blocks) {
+                        block->compact(_selection);
+                    }
+                }
+                return selected;
+            }
+        }
+
+        return 0;
+    }
+
     const std::unique_ptr<EExpression> _filter;
     std::unique_ptr<vm::CodeFragment> _filterCode;
 
@@ -163,5 +265,16 @@ private:
 
     bool _childOpened{false};
     FilterStats _specificStats;
+
+    // The state of the block mode. The accessors handed out to the parent stages and used by the
+    // filter bytecode read the row '_blockRow' of the input blocks.
+    bool _blockMode{false};
+    std::unique_ptr<vm::BlockKernel> _filterKernel;
+    value::SlotMap<std::unique_ptr<value::ValueBlockAccessor>> _blockAccessors;
+    std::vector<value::ValueBlock*> _blocks;
+    std::vector<uint8_t> _selection;
+    size_t _blockRow{0};
+    size_t _blockSize{0};
+    size_t _nextRow{0};
 };
 }  // namespace mongo::sbe
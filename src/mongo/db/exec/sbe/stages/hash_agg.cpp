@@ -31,15 +31,71 @@
 
 #include "mongo/db/exec/sbe/stages/hash_agg.h"
 
+#include "mongo/util/destructor_guard.h"
 #include "mongo/util/str.h"
 
+namespace {
+std::string nextFileName() {
+    static mongo::AtomicWord<unsigned> hashAggFileCounter;
+    return "extsort-hash-agg-sbe." + std::to_string(hashAggFileCounter.fetchAndAdd(1));
+}
+}  // namespace
+
+#include "mongo/db/sorter/sorter.cpp"
+
 namespace mongo {
 namespace sbe {
-HashAggStage::HashAggStage(std::unique_ptr<PlanStage> input,
-                           value::SlotVector gbs,
-                           value::SlotMap<std::unique_ptr<EExpression>> aggs)
-    : PlanStage("group"_sd), _gbs(std::move(gbs)), _aggs(std::move(aggs)) {
+namespace {
+/**
+ * Compares two materialized group-by keys. Used to sort the partial aggregates before they are
+ * written to disk and to merge the spilled runs back.
+ */
+int compareKeys(const value::MaterializedRow& lhs, const value::MaterializedRow& rhs) {
+    for (size_t idx = 0; idx < lhs.size(); ++idx) {
+        auto [lhsTag, lhsVal] = lhs.getViewOfValue(idx);
+        auto [rhsTag, rhsVal] = rhs.getViewOfValue(idx);
+        auto [tag, val] = value::compareValue(lhsTag, lhsVal, rhsTag, rhsVal);
+
+        auto result = value::bitcastTo<int32_t>(val);
+        if (result) {
+            return result;
+        }
+    }
+
+    return 0;
+}
+}  // namespace
+
+HashAggStage::HashAggStage(
+    std::unique_ptr<PlanStage> input,
+    value::SlotVector gbs,
+    value::SlotMap<std::unique_ptr<EExpression>> aggs,
+    value::SlotMap<std::pair<value::SlotId, std::unique_ptr<EExpression>>> mergingExprs,
+    bool allowDiskUse,
+    size_t memoryLimit)
+    : PlanStage("group"_sd),
+      _gbs(std::move(gbs)),
+      _aggs(std::move(aggs)),
+      _mergingExprs(std::move(mergingExprs)),
+      _allowDiskUse(allowDiskUse),
+      _memoryLimit(memoryLimit),
+      _nextSpilledRow({0, 0}) {
     _children.emplace_back(std::move(input));
+
+    if (_allowDiskUse) {
+        for (auto& [slot, expr] : _aggs) {
+            const auto slotId = slot;
+            uassert(5072900,
+                    str::stream() << "hash aggregation cannot spill to disk without a merging "
+                                     "expression for aggregate: "
+                                  << slotId,
+                    _mergingExprs.count(slotId));
+        }
+    }
+}
+
+HashAggStage::~HashAggStage() {
+    DESTRUCTOR_GUARD(resetSpillState());
 }
 
 std::unique_ptr<PlanStage> HashAggStage::clone() const {
@@ -47,7 +103,16 @@ std::unique_ptr<PlanStage> HashAggStage::clone() const {
     for (auto& [k, v] : _aggs) {
         aggs.emplace(k, v->clone());
     }
-    return std::make_unique<HashAggStage>(_children[0]->clone(), _gbs, std::move(aggs));
+    value::SlotMap<std::pair<value::SlotId, std::unique_ptr<EExpression>>> mergingExprs;
+    for (auto& [k, v] : _mergingExprs) {
+        mergingExprs.emplace(k, std::make_pair(v.first, v.second->clone()));
+    }
+    return std::make_unique<HashAggStage>(_children[0]->clone(),
+                                          _gbs,
+                                          std::move(aggs),
+                                          std::move(mergingExprs),
+                                          _allowDiskUse,
+                                          _memoryLimit);
 }
 
 void HashAggStage::prepare(CompileCtx& ctx) {
@@ -74,7 +139,7 @@ void HashAggStage::prepare(CompileCtx& ctx) {
         const auto slotId = slot;
         uassert(4822828, str::stream() << "duplicate field: " << slotId, inserted);
 
-        _outAggAccessors.emplace_back(std::make_unique<HashAggAccessor>(_htIt, counter++));
+        _outAggAccessors.emplace_back(std::make_unique<HashAggAccessor>(_htIt, counter));
         _outAccessors[slot] = _outAggAccessors.back().get();
 
         ctx.root = this;
@@ -82,7 +147,23 @@ void HashAggStage::prepare(CompileCtx& ctx) {
         ctx.accumulator = _outAggAccessors.back().get();
 
         _aggCodes.emplace_back(expr->compile(ctx));
+
+        // The merging expression folds the partial aggregate read back from disk into the same
+        // accumulator. The partial aggregate is made visible through the spill slot. The
+        // constructor has already checked that every aggregate has one, so '_mergingCodes' is
+        // indexed the same way as '_aggCodes'.
+        if (_allowDiskUse) {
+            auto&& [spillSlot, mergingExpr] = _mergingExprs.at(slotId);
+            _spilledAggAccessors.emplace_back(
+                std::make_unique<SpilledAggAccessor>(_nextSpilledRowIt, counter));
+
+            ctx.pushCorrelated(spillSlot, _spilledAggAccessors.back().get());
+            _mergingCodes.emplace_back(mergingExpr->compile(ctx));
+            ctx.popCorrelated();
+        }
+
         ctx.aggExpression = false;
+        ++counter;
     }
     _compiled = true;
 }
@@ -99,10 +180,68 @@ value::SlotAccessor* HashAggStage::getAccessor(CompileCtx& ctx, value::SlotId sl
     return ctx.getAccessor(slot);
 }
 
+void HashAggStage::spill() {
+    uassert(ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed,
+            str::stream() << "Exceeded memory limit for hash aggregation of " << _memoryLimit
+                          << " bytes, but didn't allow external spilling",
+            _allowDiskUse);
+
+    if (_fileName.empty()) {
+        _fileName = storageGlobalParams.dbpath + "/_tmp/" + nextFileName();
+    }
+
+    // Sort pointers rather than the table entries themselves to avoid copying the rows.
+    std::vector<TableType::value_type*> ptrs;
+    ptrs.reserve(_ht.size());
+    for (auto& entry : _ht) {
+        ptrs.push_back(&entry);
+    }
+    std::sort(ptrs.begin(), ptrs.end(), [](const auto* lhs, const auto* rhs) {
+        return compareKeys(lhs->first, rhs->first) < 0;
+    });
+
+    SortedFileWriter<value::MaterializedRow, value::MaterializedRow> writer(
+        SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp"),
+        _fileName,
+        _nextSortedFileWriterOffset);
+    for (auto ptr : ptrs) {
+        writer.addAlreadySorted(ptr->first, ptr->second);
+    }
+
+    _sortedFiles.emplace_back(writer.done());
+    _nextSortedFileWriterOffset = writer.getFileEndOffset();
+
+    _specificStats.usedDisk = true;
+    ++_specificStats.spills;
+    _specificStats.spilledRecords += _ht.size();
+
+    _ht.clear();
+    _memoryUsage = 0;
+}
+
+void HashAggStage::resetSpillState() {
+    // Destroy the iterators first so that none of them holds the spill file open. Once the merge
+    // iterator has been created it is in charge of deleting the file.
+    _spilledIt.reset();
+    _sortedFiles.clear();
+    _hasNextSpilledRow = false;
+
+    if (_ownsFileDeletion && !_fileName.empty()) {
+        boost::filesystem::remove(_fileName);
+    }
+    _fileName.clear();
+    _nextSortedFileWriterOffset = 0;
+    _ownsFileDeletion = true;
+}
+
 void HashAggStage::open(bool reOpen) {
     _commonStats.opens++;
     _children[0]->open(reOpen);
 
+    _ht.clear();
+    _memoryUsage = 0;
+    resetSpillState();
+
     while (_children[0]->getNext() == PlanState::ADVANCED) {
         value::MaterializedRow key{_inKeyAccessors.size()};
         // Copy keys in order to do the lookup.
@@ -126,14 +265,73 @@ void HashAggStage::open(bool reOpen) {
             auto [owned, tag, val] = _bytecode.run(_aggCodes[idx].get());
             _outAggAccessors[idx]->reset(owned, tag, val);
         }
+
+        // The memory used by the accumulators is only sampled when a new group is created. This
+        // is precise for fixed size accumulators such as sum or min, and an underestimate for the
+        // growing ones such as addToArray.
+        if (inserted) {
+            _memoryUsage += it->first.memUsageForSorter() + it->second.memUsageForSorter();
+            if (_memoryUsage > _memoryLimit) {
+                spill();
+            }
+        }
     }
 
     _children[0]->close();
 
+    if (!_sortedFiles.empty()) {
+        if (!_ht.empty()) {
+            spill();
+        }
+
+        // The merge iterator takes over the deletion of the spill file.
+        _spilledIt.reset(SpilledIterator::merge(
+            _sortedFiles, _fileName, SortOptions(), [](const auto& lhs, const auto& rhs) {
+                return compareKeys(lhs.first, rhs.first);
+            }));
+        _sortedFiles.clear();
+        _ownsFileDeletion = false;
+
+        _hasNextSpilledRow = _spilledIt->more();
+        if (_hasNextSpilledRow) {
+            _nextSpilledRow = _spilledIt->next();
+        }
+    }
+
     _htIt = _ht.end();
 }
 
+PlanState HashAggStage::getNextSpilled() {
+    if (!_hasNextSpilledRow) {
+        return trackPlanState(PlanState::IS_EOF);
+    }
+
+    // The first partial aggregate becomes the initial state of the accumulators.
+    _ht.clear();
+    _htIt = _ht.emplace(std::move(_nextSpilledRow.first), std::move(_nextSpilledRow.second)).first;
+
+    _hasNextSpilledRow = false;
+    while (_spilledIt->more()) {
+        _nextSpilledRow = _spilledIt->next();
+        if (compareKeys(_htIt->first, _nextSpilledRow.first) != 0) {
+            _hasNextSpilledRow = true;
+            break;
+        }
+
+        for (size_t idx = 0; idx < _outAggAccessors.size(); ++idx) {
+            auto [owned, tag, val] = _bytecode.run(_mergingCodes[idx].get());
+            _outAggAccessors[idx]->reset(owned, tag, val);
+        }
+    }
+
+    return trackPlanState(PlanState::ADVANCED);
+}
+
 PlanState HashAggStage::getNext() {
+    if (_spilledIt) {
+        return getNextSpilled();
+    }
+
     if (_htIt == _ht.end()) {
         _htIt = _ht.begin();
     } else {
@@ -149,16 +347,20 @@ PlanState HashAggStage::getNext() {
 
 std::unique_ptr<PlanStageStats> HashAggStage::getStats() const {
     auto ret = std::make_unique<PlanStageStats>(_commonStats);
+    ret->specific = std::make_unique<HashAggStats>(_specificStats);
     ret->children.emplace_back(_children[0]->getStats());
     return ret;
 }
 
 const SpecificStats* HashAggStage::getSpecificStats() const {
-    return nullptr;
+    return &_specificStats;
 }
 
 void HashAggStage::close() {
     _commonStats.closes++;
+
+    _spilledIt.reset();
+    _hasNextSpilledRow = false;
 }
 
 std::vector<DebugPrinter::Block> HashAggStage::debugPrint() const {
@@ -36,13 +36,40 @@
 #include "mongo/db/exec/sbe/vm/vm.h"
 #include "mongo/stdx/unordered_map.h"
 
+namespace mongo {
+template <typename Key, typename Value>
+class SortIteratorInterface;
+}  // namespace mongo
+
 namespace mongo {
 namespace sbe {
+/**
+ * Groups the rows produced by its child by the values of the 'gbs' slots and evaluates the 'aggs'
+ * aggregate expressions for every group.
+ *
+ * The stage keeps track of the approximate amount of memory used by its hash table. Once it
+ * exceeds 'memoryLimit' the stage either fails the query with
+ * 'QueryExceededMemoryLimitNoDiskUseAllowed' or, if 'allowDiskUse' is true, sorts the partial
+ * aggregates by the group-by key, writes them to a temporary file and starts over with an empty
+ * hash table. When the input is exhausted, all of the spilled runs are merged back and partial
+ * aggregates for the same key are combined using 'mergingExprs'.
+ *
+ * The 'mergingExprs' map must have an entry for every aggregate slot in 'aggs' when spilling is
+ * allowed. Each entry holds a slot which is bound to the partial aggregate value being merged and
+ * an aggregate expression which folds that value into the accumulator, e.g. 's5 = sum(s2)' is
+ * merged with (s9, sum(s9)).
+ */
 class HashAggStage final : public PlanStage {
 public:
     HashAggStage(std::unique_ptr<PlanStage> input,
                  value::SlotVector gbs,
-                 value::SlotMap<std::unique_ptr<EExpression>> aggs);
+                 value::SlotMap<std::unique_ptr<EExpression>> aggs,
+                 value::SlotMap<std::pair<value::SlotId, std::unique_ptr<EExpression>>>
+                     mergingExprs = {},
+                 bool allowDiskUse = false,
+                 size_t memoryLimit = std::numeric_limits<size_t>::max());
+
+    ~HashAggStage();
 
     std::unique_ptr<PlanStage> clone() const final;
 
@@ -63,8 +90,34 @@ private:
     using HashKeyAccessor = value::MaterializedRowKeyAccessor<TableType::iterator>;
     using HashAggAccessor = value::MaterializedRowValueAccessor<TableType::iterator>;
 
+    using SpilledIterator = SortIteratorInterface<value::MaterializedRow, value::MaterializedRow>;
+    using SpilledData = std::pair<value::MaterializedRow, value::MaterializedRow>;
+    using SpilledAggAccessor = value::MaterializedRowValueAccessor<SpilledData*>;
+
+    /**
+     * Writes the content of the hash table sorted by the group-by key to the spill file and
+     * empties the hash table.
+     */
+    void spill();
+
+    /**
+     * Removes the spill file, if any, and forgets about all of the spilled runs so that the stage
+     * can be reopened.
+     */
+    void resetSpillState();
+
+    /**
+     * Produces the next group by merging all partial aggregates with the same key from the spilled
+     * runs. The merged group is placed as the sole entry of the hash table, so that the output
+     * accessors work the same way as if nothing had been spilled.
+     */
+    PlanState getNextSpilled();
+
     const value::SlotVector _gbs;
     const value::SlotMap<std::unique_ptr<EExpression>> _aggs;
+    const value::SlotMap<std::pair<value::SlotId, std::unique_ptr<EExpression>>> _mergingExprs;
+    const bool _allowDiskUse;
+    const size_t _memoryLimit;
 
     value::SlotAccessorMap _outAccessors;
     std::vector<value::SlotAccessor*> _inKeyAccessors;
@@ -76,9 +129,29 @@ private:
     TableType _ht;
     TableType::iterator _htIt;
 
+    // Approximate number of bytes held by the keys and the partial aggregates in '_ht'.
+    size_t _memoryUsage{0};
+
+    // Spilling state. The spilled runs are all written to the same file, one after another.
+    std::string _fileName;
+    std::streampos _nextSortedFileWriterOffset{0};
+    bool _ownsFileDeletion{true};
+    std::vector<std::shared_ptr<SpilledIterator>> _sortedFiles;
+    std::unique_ptr<SpilledIterator> _spilledIt;
+
+    // The first partial aggregate of the next group to be returned from the spilled runs.
+    SpilledData _nextSpilledRow;
+    SpilledData* _nextSpilledRowIt{&_nextSpilledRow};
+    bool _hasNextSpilledRow{false};
+
+    std::vector<std::unique_ptr<SpilledAggAccessor>> _spilledAggAccessors;
+    std::vector<std::unique_ptr<vm::CodeFragment>> _mergingCodes;
+
     vm::ByteCode _bytecode;
 
     bool _compiled{false};
+
+    HashAggStats _specificStats;
 };
 }  // namespace sbe
 }  // namespace mongo
@@ -32,22 +32,48 @@
 #include "mongo/db/exec/sbe/stages/hash_join.h"
 
 #include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/util/destructor_guard.h"
 #include "mongo/util/str.h"
 
+namespace {
+std::string nextFileName() {
+    static mongo::AtomicWord<unsigned> hashJoinFileCounter;
+    return "extsort-hash-join-sbe." + std::to_string(hashJoinFileCounter.fetchAndAdd(1));
+}
+}  // namespace
+
+#include "mongo/db/sorter/sorter.cpp"
+
 namespace mongo {
 namespace sbe {
+namespace {
+/**
+ * Picks the partition for the given join key. The hash is mixed before it is reduced, so that the
+ * choice of the partition is not correlated with the bucket the key falls into in the hash table.
+ */
+size_t partitionOf(const value::MaterializedRow& key, size_t numPartitions) {
+    uint64_t hash = value::MaterializedRowHasher()(key);
+    return ((hash * 0x9E3779B97F4A7C15ULL) >> 32) % numPartitions;
+}
+}  // namespace
+
 HashJoinStage::HashJoinStage(std::unique_ptr<PlanStage> outer,
                              std::unique_ptr<PlanStage> inner,
                              value::SlotVector outerCond,
                              value::SlotVector outerProjects,
                              value::SlotVector innerCond,
-                             value::SlotVector innerProjects)
+                             value::SlotVector innerProjects,
+                             bool allowDiskUse,
+                             size_t memoryLimit)
     : PlanStage("hj"_sd),
       _outerCond(std::move(outerCond)),
       _outerProjects(std::move(outerProjects)),
       _innerCond(std::move(innerCond)),
       _innerProjects(std::move(innerProjects)),
-      _probeKey(0) {
+      _allowDiskUse(allowDiskUse),
+      _memoryLimit(memoryLimit),
+      _probeKey(0),
+      _probeRow({0, 0}) {
     if (_outerCond.size() != _innerCond.size()) {
         uasserted(4822823, "left and right size do not match");
     }
@@ -56,13 +82,21 @@ HashJoinStage::HashJoinStage(std::unique_ptr<PlanStage> outer,
     _children.emplace_back(std::move(inner));
 }
 
+HashJoinStage::~HashJoinStage() {
+    if (!_fileName.empty()) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
+    }
+}
+
 std::unique_ptr<PlanStage> HashJoinStage::clone() const {
     return std::make_unique<HashJoinStage>(_children[0]->clone(),
                                            _children[1]->clone(),
                                            _outerCond,
                                            _outerProjects,
                                            _innerCond,
-                                           _innerProjects);
+                                           _innerProjects,
+                                           _allowDiskUse,
+                                           _memoryLimit);
 }
 
 void HashJoinStage::prepare(CompileCtx& ctx) {
@@ -99,6 +133,30 @@ void HashJoinStage::prepare(CompileCtx& ctx) {
         _outOuterAccessors[slot] = _outOuterProjectAccessors.back().get();
     }
 
+    // The inner side is only materialized when the join is performed partition by partition, in
+    // which case the inner slots are read from the spilled rows rather than from the child.
+    if (_allowDiskUse) {
+        counter = 0;
+        for (auto& slot : _innerCond) {
+            _outInnerAccessors[slot] = std::make_unique<InnerAccessor>(
+                _children[1]->getAccessor(ctx, slot),
+                std::make_unique<SpilledKeyAccessor>(_probeRowIt, counter++),
+                _partitioned);
+        }
+
+        counter = 0;
+        for (auto& slot : _innerProjects) {
+            auto [it, inserted] = dupCheck.emplace(slot);
+            uassert(5073100, str::stream() << "duplicate field: " << slot, inserted);
+
+            _inInnerProjectAccessors.emplace_back(_children[1]->getAccessor(ctx, slot));
+            _outInnerAccessors[slot] = std::make_unique<InnerAccessor>(
+                _inInnerProjectAccessors.back(),
+                std::make_unique<SpilledProjectAccessor>(_probeRowIt, counter++),
+                _partitioned);
+        }
+    }
+
     _probeKey.resize(_inInnerKeyAccessors.size());
 
     _compiled = true;
@@ -110,14 +168,154 @@ value::SlotAccessor* HashJoinStage::getAccessor(CompileCtx& ctx, value::SlotId s
             return it->second;
         }
 
+        if (auto it = _outInnerAccessors.find(slot); it != _outInnerAccessors.end()) {
+            return it->second.get();
+        }
+
         return _children[1]->getAccessor(ctx, slot);
     }
 
     return ctx.getAccessor(slot);
 }
 
+void HashJoinStage::spill() {
+    uassert(ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed,
+            str::stream() << "Exceeded memory limit for hash join of " << _memoryLimit
+                          << " bytes, but didn't allow external spilling",
+            _allowDiskUse);
+
+    if (_fileName.empty()) {
+        _fileName = storageGlobalParams.dbpath + "/_tmp/" + nextFileName();
+    }
+
+    _buildPartitions.resize(kNumPartitions);
+    _probePartitions.resize(kNumPartitions);
+
+    while (!_ht.empty()) {
+        auto node = _ht.extract(_ht.begin());
+        auto partition = partitionOf(node.key(), kNumPartitions);
+        addToPartition(_buildPartitions[partition],
+                       {std::move(node.key()), std::move(node.mapped())});
+    }
+
+    _memoryUsage = 0;
+    _partitioned = true;
+
+    _specificStats.usedDisk = true;
+    _specificStats.numPartitions = kNumPartitions;
+}
+
+void HashJoinStage::addToPartition(Partition& partition, SpilledData row) {
+    partition.bufferBytes += row.first.memUsageForSorter() + row.second.memUsageForSorter();
+    partition.buffer.emplace_back(std::move(row));
+    ++partition.records;
+
+    // All partitions of one input together may hold up to the memory limit. The build partitions
+    // are flushed before the probe side is partitioned, so only one input is buffered at a time.
+    if (partition.bufferBytes > _memoryLimit / kNumPartitions) {
+        flushPartition(partition);
+    }
+}
+
+void HashJoinStage::flushPartition(Partition& partition) {
+    if (partition.buffer.empty()) {
+        return;
+    }
+
+    // The rows within a partition are not ordered, the sorter file format is only used as a
+    // container for the serialized rows.
+    SortedFileWriter<value::MaterializedRow, value::MaterializedRow> writer(
+        SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp"),
+        _fileName,
+        _nextSortedFileWriterOffset);
+    for (auto& [key, project] : partition.buffer) {
+        writer.addAlreadySorted(key, project);
+    }
+
+    partition.runs.emplace_back(writer.done());
+    _nextSortedFileWriterOffset = writer.getFileEndOffset();
+
+    partition.buffer.clear();
+    partition.bufferBytes = 0;
+}
+
+bool HashJoinStage::loadNextPartition() {
+    _ht.clear();
+    _htIt = _ht.end();
+    _htItEnd = _ht.end();
+
+    for (; _currentPartition < kNumPartitions; ++_currentPartition) {
+        auto& build = _buildPartitions[_currentPartition];
+        auto& probe = _probePartitions[_currentPartition];
+
+        // Only the matching rows are returned, so a partition with either side empty produces
+        // nothing. Note that a single partition is not split any further, even if it does not fit
+        // within the memory limit.
+        if (build.records == 0 || probe.records == 0) {
+            continue;
+        }
+
+        for (auto& run : build.runs) {
+            run->openSource();
+            while (run->more()) {
+                _ht.emplace(run->next());
+            }
+            run->closeSource();
+        }
+
+        _currentProbeRun = 0;
+        probe.runs.front()->openSource();
+
+        return true;
+    }
+
+    return false;
+}
+
+bool HashJoinStage::nextProbeRow() {
+    auto& runs = _probePartitions[_currentPartition].runs;
+    while (_currentProbeRun < runs.size()) {
+        auto& run = runs[_currentProbeRun];
+        if (run->more()) {
+            _probeRow = run->next();
+            return true;
+        }
+
+        run->closeSource();
+        if (++_currentProbeRun < runs.size()) {
+            runs[_currentProbeRun]->openSource();
+        }
+    }
+
+    return false;
+}
+
+void HashJoinStage::resetSpillState() {
+    // Destroy the iterators first so that none of them holds the spill file open.
+    _buildPartitions.clear();
+    _probePartitions.clear();
+
+    if (!_fileName.empty()) {
+        boost::filesystem::remove(_fileName);
+        _fileName.clear();
+    }
+
+    _partitioned = false;
+    _nextSortedFileWriterOffset = 0;
+    _currentPartition = 0;
+    _currentProbeRun = 0;
+}
+
 void HashJoinStage::open(bool reOpen) {
     _commonStats.opens++;
+
+    _ht.clear();
+    _memoryUsage = 0;
+    resetSpillState();
+    // The spill statistics describe a single execution, so they start over when the stage is
+    // reopened.
+    _specificStats = HashJoinStats{};
+
     _children[0]->open(reOpen);
     // Insert the outer side into the hash table.
     while (_children[0]->getNext() == PlanState::ADVANCED) {
@@ -138,13 +336,66 @@ void HashJoinStage::open(bool reOpen) {
             project.reset(idx++, true, tag, val);
         }
 
+        if (_partitioned) {
+            auto partition = partitionOf(key, kNumPartitions);
+            addToPartition(_buildPartitions[partition], {std::move(key), std::move(project)});
+            continue;
+        }
+
+        _memoryUsage += key.memUsageForSorter() + project.memUsageForSorter();
         _ht.emplace(std::move(key), std::move(project));
+
+        if (_memoryUsage > _memoryLimit) {
+            spill();
+        }
     }
 
     _children[0]->close();
 
+    if (_partitioned) {
+        // Write out whatever is left of the build side, so that its buffers do not count against
+        // the memory limit together with the probe side's.
+        for (auto& partition : _buildPartitions) {
+            flushPartition(partition);
+        }
+    }
+
     _children[1]->open(reOpen);
 
+    if (_partitioned) {
+        // Partition the inner side the same way as the outer one, so that the matching rows end up
+        // in the partitions with the same index.
+        while (_children[1]->getNext() == PlanState::ADVANCED) {
+            value::MaterializedRow key{_inInnerKeyAccessors.size()};
+            value::MaterializedRow project{_inInnerProjectAccessors.size()};
+
+            size_t idx = 0;
+            for (auto& p : _inInnerKeyAccessors) {
+                auto [tag, val] = p->copyOrMoveValue();
+                key.reset(idx++, true, tag, val);
+            }
+
+            idx = 0;
+            for (auto& p : _inInnerProjectAccessors) {
+                auto [tag, val] = p->copyOrMoveValue();
+                project.reset(idx++, true, tag, val);
+            }
+
+            auto partition = partitionOf(key, kNumPartitions);
+            addToPartition(_probePartitions[partition], {std::move(key), std::move(project)});
+        }
+
+        for (size_t idx = 0; idx < kNumPartitions; ++idx) {
+            flushPartition(_probePartitions[idx]);
+
+            _specificStats.spilledBuildRecords += _buildPartitions[idx].records;
+            _specificStats.spilledProbeRecords += _probePartitions[idx].records;
+        }
+        _specificStats.spilledBytes += _nextSortedFileWriterOffset;
+
+        loadNextPartition();
+    }
+
     _htIt = _ht.end();
     _htItEnd = _ht.end();
 }
@@ -156,6 +407,23 @@ PlanState HashJoinStage::getNext() {
 
     if (_htIt == _htItEnd) {
         while (_htIt == _htItEnd) {
+            if (_partitioned) {
+                if (_currentPartition == kNumPartitions) {
+                    return trackPlanState(PlanState::IS_EOF);
+                }
+
+                if (!nextProbeRow()) {
+                    ++_currentPartition;
+                    loadNextPartition();
+                    continue;
+                }
+
+                auto [low, hi] = _ht.equal_range(_probeRow.first);
+                _htIt = low;
+                _htItEnd = hi;
+                continue;
+            }
+
             auto state = _children[1]->getNext();
             if (state == PlanState::IS_EOF) {
                 // LEFT and OUTER joins should enumerate "non-returned" rows here.
@@ -183,17 +451,21 @@ PlanState HashJoinStage::getNext() {
 void HashJoinStage::close() {
     _commonStats.closes++;
     _children[1]->close();
+
+    _ht.clear();
+    resetSpillState();
 }
 
 std::unique_ptr<PlanStageStats> HashJoinStage::getStats() const {
     auto ret = std::make_unique<PlanStageStats>(_commonStats);
+    ret->specific = std::make_unique<HashJoinStats>(_specificStats);
     ret->children.emplace_back(_children[0]->getStats());
     ret->children.emplace_back(_children[1]->getStats());
     return ret;
 }
 
 const SpecificStats* HashJoinStage::getSpecificStats() const {
-    return nullptr;
+    return &_specificStats;
 }
 
 std::vector<DebugPrinter::Block> HashJoinStage::debugPrint() const {
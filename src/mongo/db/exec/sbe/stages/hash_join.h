@@ -34,7 +34,25 @@
 #include "mongo/db/exec/sbe/stages/stages.h"
 #include "mongo/db/exec/sbe/vm/vm.h"
 
+namespace mongo {
+template <typename Key, typename Value>
+class SortIteratorInterface;
+}  // namespace mongo
+
 namespace mongo::sbe {
+/**
+ * Joins the rows of the 'outer' (build) child with the rows of the 'inner' (probe) child on the
+ * equality of the 'outerCond' and 'innerCond' slots. The outer side is loaded into a hash table
+ * together with the 'outerProjects' slots, and then every inner row is used to probe it.
+ *
+ * The stage keeps track of the approximate amount of memory used by the hash table. Once it
+ * exceeds 'memoryLimit' the stage either fails the query with
+ * 'QueryExceededMemoryLimitNoDiskUseAllowed' or, if 'allowDiskUse' is true, switches to a grace
+ * hash join: both inputs are partitioned by the hash of the join key into a temporary file and the
+ * join is then performed one partition at a time. Only the 'innerCond' and 'innerProjects' slots
+ * of the inner side are preserved in the spilled partitions, so any inner slot which is read above
+ * this stage must be listed in 'innerProjects' when spilling is allowed.
+ */
 class HashJoinStage final : public PlanStage {
 public:
     HashJoinStage(std::unique_ptr<PlanStage> outer,
@@ -42,7 +60,11 @@ public:
                   value::SlotVector outerCond,
                   value::SlotVector outerProjects,
                   value::SlotVector innerCond,
-                  value::SlotVector innerProjects);
+                  value::SlotVector innerProjects,
+                  bool allowDiskUse = false,
+                  size_t memoryLimit = std::numeric_limits<size_t>::max());
+
+    ~HashJoinStage();
 
     std::unique_ptr<PlanStage> clone() const final;
 
@@ -64,10 +86,89 @@ private:
     using HashKeyAccessor = value::MaterializedRowKeyAccessor<TableType::iterator>;
     using HashProjectAccessor = value::MaterializedRowValueAccessor<TableType::iterator>;
 
+    using SpilledIterator = SortIteratorInterface<value::MaterializedRow, value::MaterializedRow>;
+    using SpilledData = std::pair<value::MaterializedRow, value::MaterializedRow>;
+    using SpilledKeyAccessor = value::MaterializedRowKeyAccessor<SpilledData*>;
+    using SpilledProjectAccessor = value::MaterializedRowValueAccessor<SpilledData*>;
+
+    // The number of partitions each input is split into once the build side has spilled.
+    static constexpr size_t kNumPartitions = 16;
+
+    /**
+     * One partition of a spilled input. Rows are buffered in memory and appended to the spill file
+     * as a separate run whenever the buffer grows too large.
+     */
+    struct Partition {
+        std::vector<SpilledData> buffer;
+        size_t bufferBytes{0};
+        std::vector<std::shared_ptr<SpilledIterator>> runs;
+        size_t records{0};
+    };
+
+    /**
+     * Exposes an inner slot either directly from the inner child, or from the spilled probe row
+     * when the join is performed partition by partition.
+     */
+    class InnerAccessor final : public value::SlotAccessor {
+    public:
+        InnerAccessor(value::SlotAccessor* input,
+                      std::unique_ptr<value::SlotAccessor> spilled,
+                      const bool& partitioned)
+            : _input(input), _spilled(std::move(spilled)), _partitioned(partitioned) {}
+
+        std::pair<value::TypeTags, value::Value> getViewOfValue() const override {
+            return _partitioned ? _spilled->getViewOfValue() : _input->getViewOfValue();
+        }
+        std::pair<value::TypeTags, value::Value> copyOrMoveValue() override {
+            return _partitioned ? _spilled->copyOrMoveValue() : _input->copyOrMoveValue();
+        }
+
+    private:
+        value::SlotAccessor* _input;
+        std::unique_ptr<value::SlotAccessor> _spilled;
+        const bool& _partitioned;
+    };
+
+    /**
+     * Moves the content of the hash table into the build partitions and switches the stage into
+     * the partitioned mode.
+     */
+    void spill();
+
+    /**
+     * Adds a row to the given partition, writing out the partition buffer if it has become too
+     * large.
+     */
+    void addToPartition(Partition& partition, SpilledData row);
+
+    /**
+     * Appends the buffered rows of the partition to the spill file as a new run.
+     */
+    void flushPartition(Partition& partition);
+
+    /**
+     * Advances to the next partition for which both sides have rows and loads its build side into
+     * the hash table. Returns false if there are no partitions left.
+     */
+    bool loadNextPartition();
+
+    /**
+     * Reads the next row from the probe side of the current partition into '_probeRow'. Returns
+     * false if the partition is exhausted.
+     */
+    bool nextProbeRow();
+
+    /**
+     * Deletes the spill file and forgets all the partitions.
+     */
+    void resetSpillState();
+
     const value::SlotVector _outerCond;
     const value::SlotVector _outerProjects;
     const value::SlotVector _innerCond;
     const value::SlotVector _innerProjects;
+    const bool _allowDiskUse;
+    const size_t _memoryLimit;
 
     // All defined values from the outer side (i.e. they come from the hash table).
     value::SlotAccessorMap _outOuterAccessors;
@@ -90,12 +191,37 @@ private:
     // Key used to probe inside the hash table.
     value::MaterializedRow _probeKey;
 
+    // Accessors of input projection values from the inner side.
+    std::vector<value::SlotAccessor*> _inInnerProjectAccessors;
+
+    // Accessors of the inner slots exposed by this stage when spilling is allowed.
+    value::SlotMap<std::unique_ptr<InnerAccessor>> _outInnerAccessors;
+
     TableType _ht;
     TableType::iterator _htIt;
     TableType::iterator _htItEnd;
 
+    // Approximate number of bytes held by the keys and the projections in '_ht'.
+    size_t _memoryUsage{0};
+
+    // Spilling state. All partitions of both inputs are written to the same file as a sequence of
+    // runs.
+    bool _partitioned{false};
+    std::string _fileName;
+    std::streampos _nextSortedFileWriterOffset{0};
+    std::vector<Partition> _buildPartitions;
+    std::vector<Partition> _probePartitions;
+
+    // The partition currently being joined, and the position within its probe side.
+    size_t _currentPartition{0};
+    size_t _currentProbeRun{0};
+    SpilledData _probeRow;
+    SpilledData* _probeRowIt{&_probeRow};
+
     vm::ByteCode _bytecode;
 
     bool _compiled{false};
+
+    HashJoinStats _specificStats;
 };
 }  // namespace mongo::sbe
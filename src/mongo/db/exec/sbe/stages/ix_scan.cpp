@@ -81,6 +81,12 @@ std::unique_ptr<PlanStage> IndexScanStage::clone() const {
                                             _tracker);
 }
 
+void IndexScanStage::attachNewTrialRunTracker(TrialRunProgressTracker* tracker) {
+    if (_tracker) {
+        _tracker = tracker;
+    }
+}
+
 void IndexScanStage::prepare(CompileCtx& ctx) {
     if (_recordSlot) {
         _recordAccessor = std::make_unique<value::ViewOfValueAccessor>();
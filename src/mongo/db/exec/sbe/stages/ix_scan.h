@@ -74,6 +74,8 @@ public:
 
     std::unique_ptr<PlanStage> clone() const final;
 
+    void attachNewTrialRunTracker(TrialRunProgressTracker* tracker) final;
+
     void prepare(CompileCtx& ctx) final;
     value::SlotAccessor* getAccessor(CompileCtx& ctx, value::SlotId slot) final;
     void open(bool reOpen) final;
@@ -0,0 +1,274 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/stages/merge_join.h"
+
+#include "mongo/util/str.h"
+
+namespace mongo::sbe {
+namespace {
+/**
+ * Compares two key values, inverting the result for a descending sort direction.
+ */
+int compareKeyValues(std::pair<value::TypeTags, value::Value> lhs,
+                     std::pair<value::TypeTags, value::Value> rhs,
+                     value::SortDirection dir) {
+    auto [tag, val] = value::compareValue(lhs.first, lhs.second, rhs.first, rhs.second);
+    invariant(tag == value::TypeTags::NumberInt32);
+    auto result = value::bitcastTo<int32_t>(val);
+    return dir == value::SortDirection::Ascending ? result : -result;
+}
+}  // namespace
+
+MergeJoinStage::MergeJoinStage(std::unique_ptr<PlanStage> outer,
+                               std::unique_ptr<PlanStage> inner,
+                               value::SlotVector outerKeys,
+                               value::SlotVector outerProjects,
+                               value::SlotVector innerKeys,
+                               std::vector<value::SortDirection> dirs)
+    : PlanStage("mj"_sd),
+      _outerKeys(std::move(outerKeys)),
+      _outerProjects(std::move(outerProjects)),
+      _innerKeys(std::move(innerKeys)),
+      _dirs(std::move(dirs)) {
+    invariant(!_outerKeys.empty());
+    invariant(_outerKeys.size() == _innerKeys.size());
+    invariant(_outerKeys.size() == _dirs.size());
+
+    _children.emplace_back(std::move(outer));
+    _children.emplace_back(std::move(inner));
+}
+
+std::unique_ptr<PlanStage> MergeJoinStage::clone() const {
+    return std::make_unique<MergeJoinStage>(_children[0]->clone(),
+                                            _children[1]->clone(),
+                                            _outerKeys,
+                                            _outerProjects,
+                                            _innerKeys,
+                                            _dirs);
+}
+
+void MergeJoinStage::prepare(CompileCtx& ctx) {
+    _children[0]->prepare(ctx);
+    _children[1]->prepare(ctx);
+
+    size_t idx = 0;
+    for (auto slots : {&_outerKeys, &_outerProjects}) {
+        for (auto slot : *slots) {
+            auto [it, inserted] = _outOuterAccessors.emplace(
+                slot, std::make_unique<BufferAccessor>(_outerBuffer, _outerBufferIt, idx++));
+            uassert(5073300, str::stream() << "duplicate field: " << slot, inserted);
+
+            auto accessor = _children[0]->getAccessor(ctx, slot);
+            if (slots == &_outerKeys) {
+                _inOuterKeyAccessors.push_back(accessor);
+            } else {
+                _inOuterProjectAccessors.push_back(accessor);
+            }
+        }
+    }
+
+    for (auto slot : _innerKeys) {
+        _inInnerKeyAccessors.push_back(_children[1]->getAccessor(ctx, slot));
+    }
+}
+
+value::SlotAccessor* MergeJoinStage::getAccessor(CompileCtx& ctx, value::SlotId slot) {
+    if (auto it = _outOuterAccessors.find(slot); it != _outOuterAccessors.end()) {
+        return it->second.get();
+    }
+
+    return _children[1]->getAccessor(ctx, slot);
+}
+
+void MergeJoinStage::open(bool reOpen) {
+    _commonStats.opens++;
+    _children[0]->open(reOpen);
+    _children[1]->open(reOpen);
+
+    _outerBuffer.clear();
+    _outerBufferIt = 0;
+    _innerMatched = false;
+    _outerHasRow = _children[0]->getNext() == PlanState::ADVANCED;
+}
+
+int MergeJoinStage::compareWithBufferedKey(
+    const std::vector<value::SlotAccessor*>& keyAccessors) const {
+    invariant(!_outerBuffer.empty());
+    const auto& bufferedRow = _outerBuffer.front();
+
+    for (size_t idx = 0; idx < keyAccessors.size(); ++idx) {
+        if (auto result = compareKeyValues(keyAccessors[idx]->getViewOfValue(),
+                                           bufferedRow.getViewOfValue(idx),
+                                           _dirs[idx]);
+            result != 0) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+int MergeJoinStage::compareOuterWithInner() const {
+    for (size_t idx = 0; idx < _inOuterKeyAccessors.size(); ++idx) {
+        if (auto result = compareKeyValues(_inOuterKeyAccessors[idx]->getViewOfValue(),
+                                           _inInnerKeyAccessors[idx]->getViewOfValue(),
+                                           _dirs[idx]);
+            result != 0) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+bool MergeJoinStage::bufferNextOuterGroup() {
+    _outerBuffer.clear();
+
+    // Skip the outer rows which cannot match the current inner row or any inner row after it.
+    while (_outerHasRow && compareOuterWithInner() < 0) {
+        _outerHasRow = _children[0]->getNext() == PlanState::ADVANCED;
+    }
+
+    if (!_outerHasRow) {
+        return false;
+    }
+
+    do {
+        value::MaterializedRow row{_outerKeys.size() + _outerProjects.size()};
+        size_t idx = 0;
+        for (auto accessors : {&_inOuterKeyAccessors, &_inOuterProjectAccessors}) {
+            for (auto accessor : *accessors) {
+                auto [tag, val] = accessor->getViewOfValue();
+                auto [copyTag, copyVal] = value::copyValue(tag, val);
+                row.reset(idx++, true, copyTag, copyVal);
+            }
+        }
+        _outerBuffer.push_back(std::move(row));
+
+        _outerHasRow = _children[0]->getNext() == PlanState::ADVANCED;
+    } while (_outerHasRow && compareWithBufferedKey(_inOuterKeyAccessors) == 0);
+
+    return true;
+}
+
+PlanState MergeJoinStage::getNext() {
+    // Return the remaining buffered outer rows which match the current inner row.
+    if (_innerMatched && ++_outerBufferIt < _outerBuffer.size()) {
+        return trackPlanState(PlanState::ADVANCED);
+    }
+    _innerMatched = false;
+
+    for (;;) {
+        auto state = _children[1]->getNext();
+        if (state != PlanState::ADVANCED) {
+            return trackPlanState(state);
+        }
+
+        auto result = _outerBuffer.empty() ? 1 : compareWithBufferedKey(_inInnerKeyAccessors);
+        if (result > 0) {
+            // The inner side has moved past the buffered outer rows, so they cannot match any
+            // more inner rows.
+            if (!bufferNextOuterGroup()) {
+                return trackPlanState(PlanState::IS_EOF);
+            }
+            result = compareWithBufferedKey(_inInnerKeyAccessors);
+        }
+
+        if (result == 0) {
+            _outerBufferIt = 0;
+            _innerMatched = true;
+            return trackPlanState(PlanState::ADVANCED);
+        }
+
+        // Otherwise the inner row has no match on the outer side.
+    }
+}
+
+void MergeJoinStage::close() {
+    _commonStats.closes++;
+    _children[1]->close();
+    _children[0]->close();
+    _outerBuffer.clear();
+}
+
+std::unique_ptr<PlanStageStats> MergeJoinStage::getStats() const {
+    auto ret = std::make_unique<PlanStageStats>(_commonStats);
+    ret->children.emplace_back(_children[0]->getStats());
+    ret->children.emplace_back(_children[1]->getStats());
+    return ret;
+}
+
+const SpecificStats* MergeJoinStage::getSpecificStats() const {
+    return nullptr;
+}
+
+std::vector<DebugPrinter::Block> MergeJoinStage::debugPrint() const {
+    std::vector<DebugPrinter::Block> ret;
+    DebugPrinter::addKeyword(ret, "mj");
+
+    for (auto slots : {&_outerKeys, &_outerProjects, &_innerKeys}) {
+        ret.emplace_back(DebugPrinter::Block("[`"));
+        for (size_t idx = 0; idx < slots->size(); ++idx) {
+            if (idx) {
+                ret.emplace_back(DebugPrinter::Block("`,"));
+            }
+
+            DebugPrinter::addIdentifier(ret, (*slots)[idx]);
+        }
+        ret.emplace_back(DebugPrinter::Block("`]"));
+    }
+
+    ret.emplace_back(DebugPrinter::Block("[`"));
+    for (size_t idx = 0; idx < _dirs.size(); ++idx) {
+        if (idx) {
+            ret.emplace_back(DebugPrinter::Block("`,"));
+        }
+
+        ret.emplace_back(_dirs[idx] == value::SortDirection::Ascending ? "asc" : "desc");
+    }
+    ret.emplace_back(DebugPrinter::Block("`]"));
+
+    ret.emplace_back(DebugPrinter::Block::cmdIncIndent);
+
+    DebugPrinter::addKeyword(ret, "left");
+    ret.emplace_back(DebugPrinter::Block::cmdIncIndent);
+    DebugPrinter::addBlocks(ret, _children[0]->debugPrint());
+    ret.emplace_back(DebugPrinter::Block::cmdDecIndent);
+
+    DebugPrinter::addKeyword(ret, "right");
+    ret.emplace_back(DebugPrinter::Block::cmdIncIndent);
+    DebugPrinter::addBlocks(ret, _children[1]->debugPrint());
+    ret.emplace_back(DebugPrinter::Block::cmdDecIndent);
+
+    ret.emplace_back(DebugPrinter::Block::cmdDecIndent);
+
+    return ret;
+}
+}  // namespace mongo::sbe
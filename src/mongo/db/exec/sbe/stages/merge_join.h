@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/db/exec/sbe/stages/stages.h"
+
+namespace mongo::sbe {
+/**
+ * Joins the rows of the 'outer' and 'inner' children on the equality of the 'outerKeys' and
+ * 'innerKeys' slots. Both children must produce their rows sorted on the key slots in the order
+ * given by 'dirs', e.g. index scans over point intervals produce their record ids in ascending
+ * order.
+ *
+ * The two inputs are advanced in lockstep and only the outer rows which share the current key are
+ * buffered, together with the 'outerProjects' slots, so the memory use is bounded by the largest
+ * group of outer duplicates rather than by the size of either input. Every outer row in the group
+ * is returned once for each matching inner row. Only the 'outerKeys' and 'outerProjects' slots are
+ * visible from the outer side, whereas all slots of the inner side are visible directly.
+ */
+class MergeJoinStage final : public PlanStage {
+public:
+    MergeJoinStage(std::unique_ptr<PlanStage> outer,
+                   std::unique_ptr<PlanStage> inner,
+                   value::SlotVector outerKeys,
+                   value::SlotVector outerProjects,
+                   value::SlotVector innerKeys,
+                   std::vector<value::SortDirection> dirs);
+
+    std::unique_ptr<PlanStage> clone() const final;
+
+    void prepare(CompileCtx& ctx) final;
+    value::SlotAccessor* getAccessor(CompileCtx& ctx, value::SlotId slot) final;
+    void open(bool reOpen) final;
+    PlanState getNext() final;
+    void close() final;
+
+    std::unique_ptr<PlanStageStats> getStats() const final;
+    const SpecificStats* getSpecificStats() const final;
+    std::vector<DebugPrinter::Block> debugPrint() const final;
+
+private:
+    using BufferAccessor = value::MaterializedRowAccessor<std::vector<value::MaterializedRow>>;
+
+    /**
+     * Compares the key of the current row of the given child with the key of the buffered outer
+     * rows, taking into account the sort directions. Returns a negative value if the row comes
+     * before the buffered key in the sort order, zero if the keys are equal, and a positive value
+     * otherwise.
+     */
+    int compareWithBufferedKey(const std::vector<value::SlotAccessor*>& keyAccessors) const;
+
+    /**
+     * Compares the key of the current outer row with the key of the current inner row, with the
+     * same result convention as compareWithBufferedKey().
+     */
+    int compareOuterWithInner() const;
+
+    /**
+     * Discards the buffered outer rows and buffers the next group of outer rows whose key is equal
+     * to or greater (in the sort order) than the key of the current inner row. Returns false if the
+     * outer side has been exhausted.
+     */
+    bool bufferNextOuterGroup();
+
+    const value::SlotVector _outerKeys;
+    const value::SlotVector _outerProjects;
+    const value::SlotVector _innerKeys;
+    const std::vector<value::SortDirection> _dirs;
+
+    std::vector<value::SlotAccessor*> _inOuterKeyAccessors;
+    std::vector<value::SlotAccessor*> _inOuterProjectAccessors;
+    std::vector<value::SlotAccessor*> _inInnerKeyAccessors;
+
+    // Accessors of the outer slots exposed by this stage, reading from the current buffered row.
+    value::SlotMap<std::unique_ptr<BufferAccessor>> _outOuterAccessors;
+
+    // The group of outer rows sharing the same key, each row holding the key slots followed by the
+    // projected slots.
+    std::vector<value::MaterializedRow> _outerBuffer;
+    size_t _outerBufferIt{0};
+
+    // True if the outer child is positioned on a row which has not been buffered yet.
+    bool _outerHasRow{false};
+    // True if the current inner row matches the buffered outer rows, that is, if there are more
+    // buffered rows to be returned for it.
+    bool _innerMatched{false};
+};
+}  // namespace mongo::sbe
@@ -99,6 +99,59 @@ struct LimitSkipStats : public SpecificStats {
     boost::optional<long long> skip;
 };
 
+struct HashAggStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new HashAggStats(*this);
+    }
+
+    uint64_t estimateObjectSizeInBytes() const {
+        return sizeof(*this);
+    }
+
+    bool usedDisk{false};
+    // The number of times the hash table was written out to disk.
+    size_t spills{0};
+    // The number of partial aggregates (one per group) written out to disk.
+    size_t spilledRecords{0};
+};
+
+struct SortStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new SortStats(*this);
+    }
+
+    uint64_t estimateObjectSizeInBytes() const {
+        return sizeof(*this);
+    }
+
+    bool usedDisk{false};
+    // The number of input rows, and the number of them dropped by the limit without materializing
+    // their values.
+    size_t keysSorted{0};
+    size_t keysSkippedByLimit{0};
+    // The total size in bytes of the sort keys and values of the rows fed into the sort.
+    size_t totalDataSizeBytes{0};
+};
+
+struct HashJoinStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new HashJoinStats(*this);
+    }
+
+    uint64_t estimateObjectSizeInBytes() const {
+        return sizeof(*this);
+    }
+
+    bool usedDisk{false};
+    // The number of partitions each input was split into, zero if nothing was spilled.
+    size_t numPartitions{0};
+    // The number of rows from the build (outer) and probe (inner) sides written out to disk.
+    size_t spilledBuildRecords{0};
+    size_t spilledProbeRecords{0};
+    // The total size of the spilled partitions in bytes.
+    size_t spilledBytes{0};
+};
+
 /**
  * Calculates the total number of physical reads in the given plan stats tree. If a stage can do
  * a physical read (e.g. COLLSCAN or IXSCAN), then its 'numReads' stats is added to the total.
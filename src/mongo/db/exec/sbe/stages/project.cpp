@@ -49,29 +49,110 @@ std::unique_ptr<PlanStage> ProjectStage::clone() const {
 
 void ProjectStage::prepare(CompileCtx& ctx) {
     _children[0]->prepare(ctx);
+    _blockMode = _children[0]->canProduceBlocks();
 
     // Compile project expressions here.
     for (auto& [slot, expr] : _projects) {
         ctx.root = this;
         auto code = expr->compile(ctx);
         _fields[slot] = {std::move(code), value::OwnedValueAccessor{}};
+
+        if (_blockMode) {
+            _blockFields[slot] = {expr->compileBlock(ctx), std::make_unique<value::ValueBlock>()};
+        }
     }
     _compiled = true;
 }
 
 value::SlotAccessor* ProjectStage::getAccessor(CompileCtx& ctx, value::SlotId slot) {
+    if (_blockMode) {
+        if (auto it = _blockAccessors.find(slot); it != _blockAccessors.end()) {
+            return it->second.get();
+        }
+        if (auto block = getBlock(ctx, slot)) {
+            auto [it, inserted] = _blockAccessors.emplace(
+                slot, std::make_unique<value::ValueBlockAccessor>(block, _blockRow));
+            return it->second.get();
+        }
+        return _children[0]->getAccessor(ctx, slot);
+    }
+
     if (auto it = _fields.find(slot); _compiled && it != _fields.end()) {
         return &it->second.second;
     } else {
         return _children[0]->getAccessor(ctx, slot);
     }
 }
+
+bool ProjectStage::canProduceBlocks() const {
+    return _blockMode;
+}
+
+value::ValueBlock* ProjectStage::getBlock(CompileCtx& ctx, value::SlotId slot) {
+    if (!_blockMode) {
+        return nullptr;
+    }
+
+    if (auto it = _blockFields.find(slot); _compiled && it != _blockFields.end()) {
+        return it->second.second.get();
+    } else {
+        return _children[0]->getBlock(ctx, slot);
+    }
+}
+
 void ProjectStage::open(bool reOpen) {
     _commonStats.opens++;
     _children[0]->open(reOpen);
+    _blockSize = 0;
+    _nextRow = 0;
+}
+
+size_t ProjectStage::projectNextBlock() {
+    auto size = _children[0]->getNextBlock();
+
+    for (auto& [slot, field] : _blockFields) {
+        auto& [kernel, block] = field;
+
+        if (auto result = kernel ? kernel->eval(size) : nullptr) {
+            block->assignViews(*result, size);
+            continue;
+        }
+
+        // Fall back to the bytecode if there is no kernel for the expression or it cannot deal
+        // with the values in this block.
+        block->clear();
+        auto code = _fields[slot].first.get();
+        for (_blockRow = 0; _blockRow < size; ++_blockRow) {
+            auto [owned, tag, val] = _bytecode.run(code);
+            block->push_back(owned, tag, val);
+        }
+    }
+
+    return size;
+}
+
+size_t ProjectStage::getNextBlock() {
+    auto size = projectNextBlock();
+    if (size == 0) {
+        _commonStats.isEOF = true;
+    }
+    _commonStats.advances += size;
+    return size;
 }
 
 PlanState ProjectStage::getNext() {
+    if (_blockMode) {
+        if (_nextRow == _blockSize) {
+            _blockSize = projectNextBlock();
+            _nextRow = 0;
+            if (_blockSize == 0) {
+                return trackPlanState(PlanState::IS_EOF);
+            }
+        }
+        _blockRow = _nextRow++;
+        return trackPlanState(PlanState::ADVANCED);
+    }
+
     auto state = _children[0]->getNext();
 
     if (state == PlanState::ADVANCED) {
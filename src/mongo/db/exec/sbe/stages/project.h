@@ -34,6 +34,11 @@
 #include "mongo/db/exec/sbe/vm/vm.h"
 
 namespace mongo::sbe {
+/**
+ * This is a project plan stage. If the input can produce blocks of rows then the project runs in
+ * the block mode and computes every projected slot for the whole block at once, using a block
+ * kernel when the expression has one, or the bytecode for every row otherwise.
+ */
 class ProjectStage final : public PlanStage {
 public:
     ProjectStage(std::unique_ptr<PlanStage> input,
@@ -47,17 +52,33 @@ public:
     PlanState getNext() final;
     void close() final;
 
+    bool canProduceBlocks() const final;
+    value::ValueBlock* getBlock(CompileCtx& ctx, value::SlotId slot) final;
+    size_t getNextBlock() final;
+
     std::unique_ptr<PlanStageStats> getStats() const final;
     const SpecificStats* getSpecificStats() const final;
     std::vector<DebugPrinter::Block> debugPrint() const final;
 
 private:
+    size_t projectNextBlock();
+
     const value::SlotMap<std::unique_ptr<EExpression>> _projects;
     value::SlotMap<std::pair<std::unique_ptr<vm::CodeFragment>, value::OwnedValueAccessor>> _fields;
 
     vm::ByteCode _bytecode;
 
     bool _compiled{false};
+
+    // The state of the block mode. The accessors handed out to the parent stages and used by the
+    // project bytecode read the row '_blockRow' of the blocks.
+    bool _blockMode{false};
+    value::SlotMap<std::pair<std::unique_ptr<vm::BlockKernel>, std::unique_ptr<value::ValueBlock>>>
+        _blockFields;
+    value::SlotMap<std::unique_ptr<value::ValueBlockAccessor>> _blockAccessors;
+    size_t _blockRow{0};
+    size_t _blockSize{0};
+    size_t _nextRow{0};
 };
 
 template <typename... Ts>
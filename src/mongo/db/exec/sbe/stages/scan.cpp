@@ -46,7 +46,8 @@ ScanStage::ScanStage(const NamespaceStringOrUUID& name,
                      bool forward,
                      PlanYieldPolicy* yieldPolicy,
                      TrialRunProgressTracker* tracker,
-                     ScanOpenCallback openCallback)
+                     ScanOpenCallback openCallback,
+                     bool blockMode)
     : PlanStage(seekKeySlot ? "seek"_sd : "scan"_sd, yieldPolicy),
       _name(name),
       _recordSlot(recordSlot),
@@ -56,7 +57,8 @@ ScanStage::ScanStage(const NamespaceStringOrUUID& name,
       _seekKeySlot(seekKeySlot),
       _forward(forward),
       _tracker(tracker),
-      _openCallback(openCallback) {
+      _openCallback(openCallback),
+      _blockMode(blockMode) {
     invariant(_fields.size() == _vars.size());
     invariant(!_seekKeySlot || _forward);
 }
@@ -71,7 +73,14 @@ std::unique_ptr<PlanStage> ScanStage::clone() const {
                                        _forward,
                                        _yieldPolicy,
                                        _tracker,
-                                       _openCallback);
+                                       _openCallback,
+                                       _blockMode);
+}
+
+void ScanStage::attachNewTrialRunTracker(TrialRunProgressTracker* tracker) {
+    if (_tracker) {
+        _tracker = tracker;
+    }
 }
 
 void ScanStage::prepare(CompileCtx& ctx) {
@@ -94,6 +103,16 @@ void ScanStage::prepare(CompileCtx& ctx) {
     if (_seekKeySlot) {
         _seekKeyAccessor = ctx.getAccessor(*_seekKeySlot);
     }
+
+    if (canProduceBlocks()) {
+        _recordBlock = std::make_unique<value::ValueBlock>();
+        _recordIdBlock = std::make_unique<value::ValueBlock>();
+        for (size_t idx = 0; idx < _fields.size(); ++idx) {
+            auto [it, inserted] =
+                _fieldBlocks.emplace(_fields[idx], std::make_unique<value::ValueBlock>());
+            _varBlocks.emplace(_vars[idx], it->second.get());
+        }
+    }
 }
 
 value::SlotAccessor* ScanStage::getAccessor(CompileCtx& ctx, value::SlotId slot) {
@@ -112,6 +131,29 @@ value::SlotAccessor* ScanStage::getAccessor(CompileCtx& ctx, value::SlotId slot)
     return ctx.getAccessor(slot);
 }
 
+bool ScanStage::canProduceBlocks() const {
+    // The seek and the trial runs need to observe every row as it is produced.
+    return _blockMode && !_seekKeySlot && !_tracker;
+}
+
+value::ValueBlock* ScanStage::getBlock(CompileCtx& ctx, value::SlotId slot) {
+    invariant(canProduceBlocks());
+
+    if (_recordSlot && *_recordSlot == slot) {
+        return _recordBlock.get();
+    }
+
+    if (_recordIdSlot && *_recordIdSlot == slot) {
+        return _recordIdBlock.get();
+    }
+
+    if (auto it = _varBlocks.find(slot); it != _varBlocks.end()) {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
 void ScanStage::doSaveState() {
     if (_cursor) {
         _cursor->save();
@@ -260,6 +302,57 @@ PlanState ScanStage::getNext() {
     return trackPlanState(PlanState::ADVANCED);
 }
 
+size_t ScanStage::getNextBlock() {
+    invariant(canProduceBlocks());
+
+    _recordBlock->clear();
+    _recordIdBlock->clear();
+    for (auto& [name, block] : _fieldBlocks) {
+        block->clear();
+    }
+
+    if (!_cursor) {
+        _commonStats.isEOF = true;
+        return 0;
+    }
+
+    // Copy the records of the next block out of the cursor first, as the arena may be reallocated
+    // while it grows and the views into it can only be taken once it is filled. The last record
+    // may take the arena past the byte budget, so it is shrunk back if it has grown beyond it.
+    _blockArena.reset(value::kBlockMaxSizeBytes);
+    _blockOffsets.clear();
+    while (_blockOffsets.size() < value::kBlockSize &&
+           static_cast<size_t>(_blockArena.len()) < value::kBlockMaxSizeBytes) {
+        checkForInterrupt(_opCtx);
+
+        auto nextRecord = _cursor->next();
+        if (!nextRecord) {
+            break;
+        }
+
+        _blockOffsets.push_back(_blockArena.len());
+        _blockArena.appendBuf(nextRecord->data.data(), nextRecord->data.size());
+        _recordIdBlock->push_back(false,
+                                  value::TypeTags::NumberInt64,
+                                  value::bitcastFrom<int64_t>(nextRecord->id.repr()));
+    }
+
+    for (auto offset : _blockOffsets) {
+        auto rawBson = _blockArena.buf() + offset;
+        _recordBlock->push_back(
+            false, value::TypeTags::bsonObject, value::bitcastFrom<const char*>(rawBson));
+        value::appendFieldsToBlocks(rawBson, _fieldBlocks);
+    }
+
+    auto size = _blockOffsets.size();
+    if (size == 0) {
+        _commonStats.isEOF = true;
+    }
+    _commonStats.advances += size;
+    _specificStats.numReads += size;
+    return size;
+}
+
 void ScanStage::close() {
     _commonStats.closes++;
     _cursor.reset();
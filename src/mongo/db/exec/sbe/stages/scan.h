@@ -50,16 +50,23 @@ public:
               bool forward,
               PlanYieldPolicy* yieldPolicy,
               TrialRunProgressTracker* tracker,
-              ScanOpenCallback openCallback = {});
+              ScanOpenCallback openCallback = {},
+              bool blockMode = false);
 
     std::unique_ptr<PlanStage> clone() const final;
 
+    void attachNewTrialRunTracker(TrialRunProgressTracker* tracker) final;
+
     void prepare(CompileCtx& ctx) final;
     value::SlotAccessor* getAccessor(CompileCtx& ctx, value::SlotId slot) final;
     void open(bool reOpen) final;
     PlanState getNext() final;
     void close() final;
 
+    bool canProduceBlocks() const final;
+    value::ValueBlock* getBlock(CompileCtx& ctx, value::SlotId slot) final;
+    size_t getNextBlock() final;
+
     std::unique_ptr<PlanStageStats> getStats() const final;
     const SpecificStats* getSpecificStats() const final;
     std::vector<DebugPrinter::Block> debugPrint() const final;
@@ -85,6 +92,9 @@ private:
 
     ScanOpenCallback _openCallback;
 
+    // If true, this stage can produce its results in blocks of rows when its parent asks for them.
+    const bool _blockMode;
+
     std::unique_ptr<value::ViewOfValueAccessor> _recordAccessor;
     std::unique_ptr<value::ViewOfValueAccessor> _recordIdAccessor;
 
@@ -92,6 +102,16 @@ private:
     value::SlotAccessorMap _varAccessors;
     value::SlotAccessor* _seekKeyAccessor{nullptr};
 
+    // The blocks filled by getNextBlock(). The records returned by the cursor are only valid until
+    // the cursor moves, so the records of the current block are copied into '_blockArena' and the
+    // blocks hold views into it.
+    std::unique_ptr<value::ValueBlock> _recordBlock;
+    std::unique_ptr<value::ValueBlock> _recordIdBlock;
+    value::FieldBlockMap _fieldBlocks;
+    value::SlotMap<value::ValueBlock*> _varBlocks;
+    BufBuilder _blockArena;
+    std::vector<size_t> _blockOffsets;
+
     bool _open{false};
 
     std::unique_ptr<SeekableRecordCursor> _cursor;
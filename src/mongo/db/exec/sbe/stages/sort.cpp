@@ -32,6 +32,7 @@
 #include "mongo/db/exec/sbe/stages/sort.h"
 
 #include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/exec/sbe/values/bson.h"
 #include "mongo/util/str.h"
 
 namespace {
@@ -45,6 +46,20 @@ std::string nextFileName() {
 
 namespace mongo {
 namespace sbe {
+namespace {
+Ordering makeOrdering(const std::vector<value::SortDirection>& dirs) {
+    BSONObjBuilder builder;
+    for (auto dir : dirs) {
+        builder.append(""_sd, dir == value::SortDirection::Ascending ? 1 : -1);
+    }
+    return Ordering::make(builder.done());
+}
+
+size_t memUsage(const std::pair<KeyString::Value, value::MaterializedRow>& data) {
+    return data.first.memUsageForSorter() + data.second.memUsageForSorter();
+}
+}  // namespace
+
 SortStage::SortStage(std::unique_ptr<PlanStage> input,
                      value::SlotVector obs,
                      std::vector<value::SortDirection> dirs,
@@ -60,7 +75,8 @@ SortStage::SortStage(std::unique_ptr<PlanStage> input,
       _limit(limit),
       _memoryLimit(memoryLimit),
       _allowDiskUse(allowDiskUse),
-      _mergeData({0, 0}),
+      _ordering(makeOrdering(_dirs)),
+      _keyBuilder(KeyString::Version::kLatestVersion),
       _tracker(tracker) {
     _children.emplace_back(std::move(input));
 
@@ -74,22 +90,30 @@ std::unique_ptr<PlanStage> SortStage::clone() const {
         _children[0]->clone(), _obs, _dirs, _vals, _limit, _memoryLimit, _allowDiskUse, _tracker);
 }
 
+void SortStage::attachNewTrialRunTracker(TrialRunProgressTracker* tracker) {
+    PlanStage::attachNewTrialRunTracker(tracker);
+    if (_tracker) {
+        _tracker = tracker;
+    }
+}
+
 void SortStage::prepare(CompileCtx& ctx) {
     _children[0]->prepare(ctx);
 
+    // The values of both the order by and the value fields are held in the sorted row, the key
+    // only holds their KeyString encoding.
     size_t counter = 0;
     // Process order by fields.
     for (auto& slot : _obs) {
         _inKeyAccessors.emplace_back(_children[0]->getAccessor(ctx, slot));
-        auto [it, inserted] =
-            _outAccessors.emplace(slot,
-                                  std::make_unique<value::MaterializedRowKeyAccessor<SorterData*>>(
-                                      _mergeDataIt, counter));
+        auto [it, inserted] = _outAccessors.emplace(
+            slot,
+            std::make_unique<value::MaterializedRowValueAccessor<SorterData*>>(_mergeDataIt,
+                                                                               counter));
         ++counter;
         uassert(4822812, str::stream() << "duplicate field: " << slot, inserted);
     }
 
-    counter = 0;
     // Process value fields.
     for (auto& slot : _vals) {
         _inValueAccessors.emplace_back(_children[0]->getAccessor(ctx, slot));
@@ -117,52 +141,156 @@ void SortStage::makeSorter() {
     opts.extSortAllowed = _allowDiskUse;
     opts.limit = _limit != std::numeric_limits<size_t>::max() ? _limit : 0;
 
-    auto comp = [&](const SorterData& lhs, const SorterData& rhs) {
-        auto size = lhs.first.size();
-        auto& left = lhs.first;
-        auto& right = rhs.first;
-        for (size_t idx = 0; idx < size; ++idx) {
-            auto [lhsTag, lhsVal] = left.getViewOfValue(idx);
-            auto [rhsTag, rhsVal] = right.getViewOfValue(idx);
-            auto [tag, val] = value::compareValue(lhsTag, lhsVal, rhsTag, rhsVal);
-
-            auto result = value::bitcastTo<int32_t>(val);
-            if (result) {
-                return _dirs[idx] == value::SortDirection::Descending ? -result : result;
+    auto comp = [](const SorterData& lhs, const SorterData& rhs) {
+        return lhs.first.compare(rhs.first);
+    };
+
+    _sorter.reset(Sorter<KeyString::Value, value::MaterializedRow>::make(
+        opts,
+        comp,
+        {KeyString::Value::SorterDeserializeSettings{KeyString::Version::kLatestVersion}, {}}));
+    _mergeIt.reset();
+}
+
+KeyString::Value SortStage::makeSortKey() {
+    _keyBuilder.resetToEmpty(_ordering);
+    for (auto accessor : _inKeyAccessors) {
+        // The key is only used for comparisons, the values themselves are returned from the sorted
+        // row. So the numbers can be encoded without regard to their exact type, since KeyString
+        // compares them by value.
+        auto [tag, val] = accessor->getViewOfValue();
+        switch (tag) {
+            case value::TypeTags::NumberInt32:
+                _keyBuilder.appendNumberLong(value::bitcastTo<int32_t>(val));
+                break;
+            case value::TypeTags::NumberInt64:
+                _keyBuilder.appendNumberLong(value::bitcastTo<int64_t>(val));
+                break;
+            case value::TypeTags::NumberDouble:
+                _keyBuilder.appendNumberDouble(value::bitcastTo<double>(val));
+                break;
+            case value::TypeTags::Null:
+                _keyBuilder.appendNull();
+                break;
+            case value::TypeTags::StringSmall:
+            case value::TypeTags::StringBig:
+            case value::TypeTags::bsonString: {
+                auto str = value::getStringView(tag, val);
+                _keyBuilder.appendString(StringData{str.data(), str.size()});
+                break;
+            }
+            case value::TypeTags::ksValue: {
+                // KeyStrings compare by their bytes, and so do strings.
+                auto ks = value::getKeyStringView(val);
+                _keyBuilder.appendString(StringData{ks->getBuffer(), ks->getSize()});
+                break;
+            }
+            case value::TypeTags::pcreRegex:
+            case value::TypeTags::timeZoneDB:
+                uasserted(5073339,
+                          str::stream() << "cannot sort by an internal value of type " << tag);
+            default: {
+                // The remaining types go through a single element BSON object.
+                BSONObjBuilder builder;
+                if (tag == value::TypeTags::Nothing) {
+                    // Nothing sorts before any other value, and so does MinKey.
+                    builder.appendMinKey(""_sd);
+                } else {
+                    bson::appendValueToBsonObj(builder, ""_sd, tag, val);
+                }
+                _keyBuilder.appendBSONElement(builder.done().firstElement());
+                break;
             }
         }
+    }
+
+    return _keyBuilder.getValueCopy();
+}
+
+value::MaterializedRow SortStage::makeSortValue() {
+    value::MaterializedRow row{_inKeyAccessors.size() + _inValueAccessors.size()};
+
+    size_t idx = 0;
+    for (auto accessors : {&_inKeyAccessors, &_inValueAccessors}) {
+        for (auto accessor : *accessors) {
+            auto [tag, val] = accessor->copyOrMoveValue();
+            row.reset(idx++, true, tag, val);
+        }
+    }
+
+    return row;
+}
 
-        return 0;
+void SortStage::addToTopK() {
+    auto less = [](const SorterData& lhs, const SorterData& rhs) {
+        return lhs.first.compare(rhs.first) < 0;
     };
 
-    _sorter.reset(Sorter<value::MaterializedRow, value::MaterializedRow>::make(opts, comp, {}));
-    _mergeIt.reset();
+    if (_limit == 0) {
+        ++_specificStats.keysSkippedByLimit;
+        return;
+    }
+
+    auto key = makeSortKey();
+    if (_topK.size() == _limit) {
+        // The heap is full, so the row can only make it in if it is better than the worst row
+        // held, in which case the worst row is dropped.
+        if (key.compare(_topK.front().first) >= 0) {
+            ++_specificStats.keysSkippedByLimit;
+            return;
+        }
+
+        std::pop_heap(_topK.begin(), _topK.end(), less);
+        _topKMemUsage -= memUsage(_topK.back());
+        _topK.pop_back();
+    }
+
+    SorterData data{std::move(key), makeSortValue()};
+    const auto dataSize = memUsage(data);
+    _topKMemUsage += dataSize;
+    _specificStats.totalDataSizeBytes += dataSize;
+    _topK.push_back(std::move(data));
+    std::push_heap(_topK.begin(), _topK.end(), less);
+
+    if (_topKMemUsage > _memoryLimit) {
+        // Let the sorter deal with the rows from now on, spilling them to disk or failing the
+        // query if that is not allowed.
+        makeSorter();
+        for (auto&& [heapKey, heapValue] : _topK) {
+            _sorter->emplace(std::move(heapKey), std::move(heapValue));
+        }
+        _topK.clear();
+        _topKMemUsage = 0;
+    }
 }
 
 void SortStage::open(bool reOpen) {
     _commonStats.opens++;
     _children[0]->open(reOpen);
 
-    makeSorter();
+    _sorter.reset();
+    _mergeIt.reset();
+    _topK.clear();
+    _topKMemUsage = 0;
+    _topKIt = 0;
+    _specificStats = SortStats{};
+
+    // Without a limit all rows are fed to the sorter straight away.
+    if (_limit == std::numeric_limits<size_t>::max()) {
+        makeSorter();
+    }
 
     while (_children[0]->getNext() == PlanState::ADVANCED) {
-        value::MaterializedRow keys{_inKeyAccessors.size()};
-        value::MaterializedRow vals{_inValueAccessors.size()};
-
-        size_t idx = 0;
-        for (auto accesor : _inKeyAccessors) {
-            auto [tag, val] = accesor->copyOrMoveValue();
-            keys.reset(idx++, true, tag, val);
-        }
-
-        idx = 0;
-        for (auto accesor : _inValueAccessors) {
-            auto [tag, val] = accesor->copyOrMoveValue();
-            vals.reset(idx++, true, tag, val);
+        ++_specificStats.keysSorted;
+
+        if (_sorter) {
+            SorterData data{makeSortKey(), makeSortValue()};
+            _specificStats.totalDataSizeBytes += memUsage(data);
+            _sorter->emplace(std::move(data.first), std::move(data.second));
+        } else {
+            addToTopK();
         }
 
-        _sorter->emplace(std::move(keys), std::move(vals));
-
         if (_tracker && _tracker->trackProgress<TrialRunProgressTracker::kNumResults>(1)) {
             // If we either hit the maximum number of document to return during the trial run, or
             // if we've performed enough physical reads, stop populating the sort heap and bail out
@@ -178,36 +306,56 @@ void SortStage::open(bool reOpen) {
         }
     }
 
-    _mergeIt.reset(_sorter->done());
+    if (_sorter) {
+        _mergeIt.reset(_sorter->done());
+        _specificStats.usedDisk = _specificStats.usedDisk || _sorter->usedDisk();
+    } else {
+        std::sort_heap(_topK.begin(), _topK.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first.compare(rhs.first) < 0;
+        });
+    }
 
     _children[0]->close();
 }
 
 PlanState SortStage::getNext() {
-    // When the sort spilled data to disk then read back the sorted runs.
-    if (_mergeIt && _mergeIt->more()) {
+    // When the sorter was used then read back the sorted data from it, which might have been
+    // spilled to disk.
+    if (_mergeIt) {
+        if (!_mergeIt->more()) {
+            return trackPlanState(PlanState::IS_EOF);
+        }
+
         _mergeData = _mergeIt->next();
+        _mergeDataIt = &_mergeData;
+        return trackPlanState(PlanState::ADVANCED);
+    }
 
+    if (_topKIt < _topK.size()) {
+        _mergeDataIt = &_topK[_topKIt++];
         return trackPlanState(PlanState::ADVANCED);
-    } else {
-        return trackPlanState(PlanState::IS_EOF);
     }
+
+    return trackPlanState(PlanState::IS_EOF);
 }
 
 void SortStage::close() {
     _commonStats.closes++;
     _mergeIt.reset();
     _sorter.reset();
+    _topK.clear();
+    _topKMemUsage = 0;
 }
 
 std::unique_ptr<PlanStageStats> SortStage::getStats() const {
     auto ret = std::make_unique<PlanStageStats>(_commonStats);
+    ret->specific = std::make_unique<SortStats>(_specificStats);
     ret->children.emplace_back(_children[0]->getStats());
     return ret;
 }
 
 const SpecificStats* SortStage::getSpecificStats() const {
-    return nullptr;
+    return &_specificStats;
 }
 
 std::vector<DebugPrinter::Block> SortStage::debugPrint() const {
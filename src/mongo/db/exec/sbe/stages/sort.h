@@ -29,8 +29,10 @@
 
 #pragma once
 
+#include "mongo/db/exec/sbe/stages/plan_stats.h"
 #include "mongo/db/exec/sbe/stages/stages.h"
 #include "mongo/db/exec/trial_run_progress_tracker.h"
+#include "mongo/db/storage/key_string.h"
 
 namespace mongo {
 template <typename Key, typename Value>
@@ -40,6 +42,16 @@ class Sorter;
 }  // namespace mongo
 
 namespace mongo::sbe {
+/**
+ * Sorts the rows of its input by the 'obs' slots in the 'dirs' directions, and returns them along
+ * with the 'vals' slots. The sort key of every row is encoded once into a KeyString, so that the
+ * rows are compared with a plain memory comparison.
+ *
+ * If a 'limit' is given, only the best 'limit' rows are kept in a bounded heap, and the value slots
+ * of a row are only materialized if its key can make it into the heap. Once the memory used by the
+ * rows held exceeds 'memoryLimit', the stage either fails the query with
+ * 'QueryExceededMemoryLimitNoDiskUseAllowed' or, if 'allowDiskUse' is true, spills them to disk.
+ */
 class SortStage final : public PlanStage {
 public:
     SortStage(std::unique_ptr<PlanStage> input,
@@ -55,6 +67,8 @@ public:
 
     std::unique_ptr<PlanStage> clone() const final;
 
+    void attachNewTrialRunTracker(TrialRunProgressTracker* tracker) final;
+
     void prepare(CompileCtx& ctx) final;
     value::SlotAccessor* getAccessor(CompileCtx& ctx, value::SlotId slot) final;
     void open(bool reOpen) final;
@@ -66,10 +80,27 @@ public:
     std::vector<DebugPrinter::Block> debugPrint() const final;
 
 private:
+    using SorterIterator = SortIteratorInterface<KeyString::Value, value::MaterializedRow>;
+    using SorterData = std::pair<KeyString::Value, value::MaterializedRow>;
+
     void makeSorter();
 
-    using SorterIterator = SortIteratorInterface<value::MaterializedRow, value::MaterializedRow>;
-    using SorterData = std::pair<value::MaterializedRow, value::MaterializedRow>;
+    /**
+     * Encodes the values of the 'obs' slots of the current input row into a KeyString.
+     */
+    KeyString::Value makeSortKey();
+
+    /**
+     * Copies the values of the 'obs' and 'vals' slots of the current input row into a row which is
+     * returned by this stage once sorted.
+     */
+    value::MaterializedRow makeSortValue();
+
+    /**
+     * Adds the current input row to the bounded heap used when there is a limit. Hands the content
+     * of the heap over to a sorter if it grows beyond the memory limit.
+     */
+    void addToTopK();
 
     const value::SlotVector _obs;
     const std::vector<value::SortDirection> _dirs;
@@ -78,15 +109,29 @@ private:
     const size_t _memoryLimit;
     const bool _allowDiskUse;
 
+    const Ordering _ordering;
+
     std::vector<value::SlotAccessor*> _inKeyAccessors;
     std::vector<value::SlotAccessor*> _inValueAccessors;
 
     value::SlotMap<std::unique_ptr<value::SlotAccessor>> _outAccessors;
 
+    // Reused to encode the sort key of every input row.
+    KeyString::Builder _keyBuilder;
+
+    // The best rows seen so far when there is a limit, kept as a max-heap on the sort key, or,
+    // after the input has been consumed, in the sorted order. Only used until the rows held grow
+    // beyond the memory limit, after which all rows are fed to the '_sorter'.
+    std::vector<SorterData> _topK;
+    size_t _topKMemUsage{0};
+    size_t _topKIt{0};
+
     std::unique_ptr<SorterIterator> _mergeIt;
     SorterData _mergeData;
     SorterData* _mergeDataIt{&_mergeData};
-    std::unique_ptr<Sorter<value::MaterializedRow, value::MaterializedRow>> _sorter;
+    std::unique_ptr<Sorter<KeyString::Value, value::MaterializedRow>> _sorter;
+
+    SortStats _specificStats;
 
     // If provided, used during a trial run to accumulate certain execution stats. Once the trial
     // run is complete, this pointer is reset to nullptr.
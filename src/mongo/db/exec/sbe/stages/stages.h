@@ -31,6 +31,7 @@
 
 #include "mongo/db/exec/sbe/stages/plan_stats.h"
 #include "mongo/db/exec/sbe/util/debug_print.h"
+#include "mongo/db/exec/sbe/values/block.h"
 #include "mongo/db/exec/sbe/values/slot.h"
 #include "mongo/db/exec/sbe/values/value.h"
 #include "mongo/db/exec/scoped_timer.h"
@@ -38,6 +39,8 @@
 #include "mongo/db/query/plan_yield_policy.h"
 
 namespace mongo {
+class TrialRunProgressTracker;
+
 namespace sbe {
 
 struct CompileCtx;
@@ -208,7 +211,7 @@ public:
     }
 
 protected:
-    PlanYieldPolicy* const _yieldPolicy{nullptr};
+    PlanYieldPolicy* _yieldPolicy{nullptr};
 
 private:
     static const int kInterruptCheckPeriod = 128;
@@ -239,6 +242,31 @@ public:
      */
     virtual std::unique_ptr<PlanStage> clone() const = 0;
 
+    /**
+     * Replaces the yield policy of every stage in this tree which was constructed with yielding
+     * enabled. Used to hand a tree cloned from a cached plan over to a new plan executor. Must be
+     * called before prepare().
+     */
+    void attachNewYieldPolicy(PlanYieldPolicy* yieldPolicy) {
+        for (auto&& child : _children) {
+            child->attachNewYieldPolicy(yieldPolicy);
+        }
+        if (_yieldPolicy) {
+            _yieldPolicy = yieldPolicy;
+        }
+    }
+
+    /**
+     * Points every stage in this tree which tracks the progress of a trial run to the given
+     * 'tracker'. Used alongside attachNewYieldPolicy() when a tree cloned from a cached plan is
+     * handed over to a new plan executor.
+     */
+    virtual void attachNewTrialRunTracker(TrialRunProgressTracker* tracker) {
+        for (auto&& child : _children) {
+            child->attachNewTrialRunTracker(tracker);
+        }
+    }
+
     /**
      * Prepare this SBE PlanStage tree for execution. Must be called once, and must be called
      * prior to open(), getNext(), close(), saveState(), or restoreState(),
@@ -273,6 +301,34 @@ public:
      */
     virtual void close() = 0;
 
+    /**
+     * Returns true if this stage can produce its results a block of rows at a time through the
+     * getBlock() and getNextBlock() methods. This method is only called during the prepare phase
+     * after this stage has been prepared.
+     */
+    virtual bool canProduceBlocks() const {
+        return false;
+    }
+
+    /**
+     * Returns a block holding the values of a given slot for all rows of the current block, or
+     * nullptr if the slot is not produced in blocks by this stage (e.g., it is defined outside of
+     * the subtree rooted at this stage). This method is only called during the prepare phase, and
+     * only if canProduceBlocks() returned true.
+     */
+    virtual value::ValueBlock* getBlock(CompileCtx& ctx, value::SlotId slot) {
+        return nullptr;
+    }
+
+    /**
+     * Fills the blocks returned by getBlock() with the next block of rows and returns the number of
+     * rows in it, or zero if the end is reached. A parent calling getBlock() must drive this stage
+     * solely with getNextBlock() in place of getNext() between the calls to open() and close().
+     */
+    virtual size_t getNextBlock() {
+        MONGO_UNREACHABLE;
+    }
+
     virtual std::vector<DebugPrinter::Block> debugPrint() const = 0;
 
     friend class CanSwitchOperationContext;
@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/values/block.h"
+
+#include "mongo/db/exec/sbe/values/bson.h"
+
+namespace mongo::sbe::value {
+TypeTags ValueBlock::commonTag(size_t size) const {
+    if (size == 0) {
+        return TypeTags::Nothing;
+    }
+
+    const auto tag = _tags[0];
+    bool same = true;
+    for (size_t idx = 1; idx < size; ++idx) {
+        same &= (_tags[idx] == tag);
+    }
+    return same ? tag : TypeTags::Nothing;
+}
+
+void ValueBlock::assignViews(const ValueBlock& other, size_t size) {
+    clear();
+    _tags.assign(other._tags.begin(), other._tags.begin() + size);
+    _vals.assign(other._vals.begin(), other._vals.begin() + size);
+    _owned.assign(size, false);
+}
+
+void ValueBlock::compact(const std::vector<uint8_t>& selection) {
+    size_t out = 0;
+    for (size_t idx = 0; idx < _tags.size(); ++idx) {
+        if (selection[idx]) {
+            _tags[out] = _tags[idx];
+            _vals[out] = _vals[idx];
+            _owned[out] = _owned[idx];
+            ++out;
+        } else if (_owned[idx]) {
+            releaseValue(_tags[idx], _vals[idx]);
+        }
+    }
+
+    _tags.resize(out);
+    _vals.resize(out);
+    _owned.resize(out);
+}
+
+void appendFieldsToBlocks(const char* bson, FieldBlockMap& fieldBlocks) {
+    if (fieldBlocks.empty()) {
+        return;
+    }
+
+    auto fieldsToMatch = fieldBlocks.size();
+    auto row = fieldBlocks.begin()->second->size();
+    auto be = bson + 4;
+    auto end = bson + readFromMemory<uint32_t>(bson);
+    while (*be != 0) {
+        auto sv = bson::fieldNameView(be);
+        if (auto it = fieldBlocks.find(sv); it != fieldBlocks.end() && it->second->size() == row) {
+            // Found the field so convert it to Value.
+            auto [tag, val] = bson::convertFrom(true, be, end, sv.size());
+            it->second->push_back(false, tag, val);
+
+            if ((--fieldsToMatch) == 0) {
+                // No need to scan any further so bail out early.
+                return;
+            }
+        }
+
+        be = bson::advance(be, sv.size());
+    }
+
+    for (auto& [name, block] : fieldBlocks) {
+        if (block->size() == row) {
+            block->push_back(false, TypeTags::Nothing, 0);
+        }
+    }
+}
+}  // namespace mongo::sbe::value
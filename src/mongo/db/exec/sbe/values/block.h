@@ -0,0 +1,203 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/db/exec/sbe/values/slot.h"
+#include "mongo/db/exec/sbe/values/value.h"
+
+namespace mongo::sbe::value {
+/**
+ * The maximum number of rows a plan stage produces at a time in the block mode.
+ */
+static constexpr size_t kBlockSize = 1024;
+
+/**
+ * The maximum number of bytes of records a scan copies into a single block. Once it is reached the
+ * block is cut short, so that a block of large documents does not hold up to 'kBlockSize' times
+ * the maximum document size. A block always holds at least one record.
+ */
+static constexpr size_t kBlockMaxSizeBytes = 4 * 1024 * 1024;
+
+/**
+ * A column of values of a single slot for a block of rows. The tags and the values are kept in
+ * separate arrays, so that the kernels working on the blocks of numbers can run tight loops over
+ * them. A block may hold both owned and unowned values, the owned ones are released when the block
+ * is cleared.
+ */
+class ValueBlock {
+public:
+    ValueBlock() {
+        _tags.reserve(kBlockSize);
+        _vals.reserve(kBlockSize);
+        _owned.reserve(kBlockSize);
+    }
+
+    ValueBlock(const ValueBlock&) = delete;
+    ValueBlock& operator=(const ValueBlock&) = delete;
+
+    ~ValueBlock() {
+        clear();
+    }
+
+    void clear() {
+        if (_hasOwned) {
+            for (size_t idx = 0; idx < _tags.size(); ++idx) {
+                if (_owned[idx]) {
+                    releaseValue(_tags[idx], _vals[idx]);
+                }
+            }
+            _hasOwned = false;
+        }
+        _tags.clear();
+        _vals.clear();
+        _owned.clear();
+    }
+
+    size_t size() const {
+        return _tags.size();
+    }
+
+    void push_back(bool owned, TypeTags tag, Value val) {
+        _tags.push_back(tag);
+        _vals.push_back(val);
+        _owned.push_back(owned);
+        _hasOwned = _hasOwned || owned;
+    }
+
+    /**
+     * Replaces the value of the given row, releasing the old value if it was owned.
+     */
+    void reset(size_t idx, bool owned, TypeTags tag, Value val) {
+        if (_owned[idx]) {
+            releaseValue(_tags[idx], _vals[idx]);
+        }
+        _tags[idx] = tag;
+        _vals[idx] = val;
+        _owned[idx] = owned;
+        _hasOwned = _hasOwned || owned;
+    }
+
+    std::pair<TypeTags, Value> getViewOfValue(size_t idx) const {
+        return {_tags[idx], _vals[idx]};
+    }
+
+    std::pair<TypeTags, Value> copyOrMoveValue(size_t idx) {
+        if (_owned[idx]) {
+            _owned[idx] = false;
+            return {_tags[idx], _vals[idx]};
+        }
+        return copyValue(_tags[idx], _vals[idx]);
+    }
+
+    const TypeTags* tags() const {
+        return _tags.data();
+    }
+    TypeTags* tags() {
+        return _tags.data();
+    }
+
+    const Value* vals() const {
+        return _vals.data();
+    }
+    Value* vals() {
+        return _vals.data();
+    }
+
+    /**
+     * Clears the block and resizes it to hold 'size' unowned Nothing values. The caller is then
+     * expected to overwrite them in place through 'tags()' and 'vals()'. Only the shallow values
+     * may be written this way as the block will never release them.
+     */
+    void resizeShallow(size_t size) {
+        clear();
+        _tags.resize(size, TypeTags::Nothing);
+        _vals.resize(size, 0);
+        _owned.resize(size, false);
+    }
+
+    /**
+     * Returns the tag of the first 'size' values if they all have the same one, or 'Nothing'
+     * otherwise.
+     */
+    TypeTags commonTag(size_t size) const;
+
+    /**
+     * Replaces the content of this block with unowned views of the first 'size' values of the
+     * 'other' block.
+     */
+    void assignViews(const ValueBlock& other, size_t size);
+
+    /**
+     * Keeps only the rows for which 'selection' is set, preserving their order. The 'selection'
+     * must have an entry for every row in the block.
+     */
+    void compact(const std::vector<uint8_t>& selection);
+
+private:
+    std::vector<TypeTags> _tags;
+    std::vector<Value> _vals;
+    std::vector<uint8_t> _owned;
+    bool _hasOwned{false};
+};
+
+/**
+ * Provides a view of the current row of a value block. This is how the slots of a stage running
+ * in the block mode are exposed to the bytecode and to the parent stages consuming rows one at a
+ * time.
+ */
+class ValueBlockAccessor final : public SlotAccessor {
+public:
+    ValueBlockAccessor(ValueBlock* block, const size_t& row) : _block(block), _row(row) {}
+
+    std::pair<TypeTags, Value> getViewOfValue() const override {
+        return _block->getViewOfValue(_row);
+    }
+    std::pair<TypeTags, Value> copyOrMoveValue() override {
+        return _block->copyOrMoveValue(_row);
+    }
+
+private:
+    ValueBlock* const _block;
+    const size_t& _row;
+};
+
+using FieldBlockMap = absl::flat_hash_map<std::string, std::unique_ptr<ValueBlock>>;
+
+/**
+ * Appends the values of the top level fields of the BSON object 'bson' to their blocks in
+ * 'fieldBlocks', or Nothing if the object does not have the field. The appended values are views
+ * into the object so it must outlive the blocks.
+ */
+void appendFieldsToBlocks(const char* bson, FieldBlockMap& fieldBlocks);
+}  // namespace mongo::sbe::value
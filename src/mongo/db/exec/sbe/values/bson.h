@@ -45,6 +45,15 @@ inline auto fieldNameView(const char* be) noexcept {
     return std::string_view{be + 1};
 }
 
+/**
+ * Appends the value (tag, val) to 'builder' as a field with the given 'name'. Nothing is appended
+ * if the value is Nothing.
+ */
+void appendValueToBsonObj(BSONObjBuilder& builder,
+                          StringData name,
+                          value::TypeTags tag,
+                          value::Value val);
+
 void convertToBsonObj(BSONArrayBuilder& builder, value::Array* arr);
 void convertToBsonObj(BSONObjBuilder& builder, value::Object* obj);
 }  // namespace bson
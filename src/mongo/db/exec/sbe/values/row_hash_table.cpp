@@ -0,0 +1,187 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/values/row_hash_table.h"
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo::sbe::value {
+RowHashTable::RowHashTable(size_t keyWidth, size_t valueWidth)
+    : _keyWidth(keyWidth), _width(keyWidth + valueWidth), _buckets(kInitialCapacity) {}
+
+RowHashTable::~RowHashTable() {
+    clear();
+}
+
+void RowHashTable::clear() {
+    for (size_t pos = 0; pos < _owned.size(); ++pos) {
+        if (_owned[pos]) {
+            releaseValue(_tags[pos], _vals[pos]);
+        }
+    }
+    _tags.clear();
+    _vals.clear();
+    _owned.clear();
+    _hashes.clear();
+    _next.clear();
+    std::fill(_buckets.begin(), _buckets.end(), Bucket{});
+}
+
+size_t RowHashTable::memUsage() const {
+    return sizeof(*this) + _tags.capacity() * sizeof(TypeTags) +
+        _vals.capacity() * sizeof(Value) + _owned.capacity() * sizeof(uint8_t) +
+        _hashes.capacity() * sizeof(size_t) + _next.capacity() * sizeof(uint32_t) +
+        _buckets.capacity() * sizeof(Bucket);
+}
+
+size_t RowHashTable::computeHash(const std::vector<SlotAccessor*>& keys) {
+    // Must stay in sync with 'MaterializedRowHasher'.
+    size_t res = 17;
+    for (auto accessor : keys) {
+        auto [tag, val] = accessor->getViewOfValue();
+        res = res * 31 + hashValue(tag, val);
+    }
+    return res;
+}
+
+bool RowHashTable::keyEquals(size_t row, const std::vector<SlotAccessor*>& keys) const {
+    auto pos = cellPos(row, 0);
+    for (auto accessor : keys) {
+        auto [lhsTag, lhsVal] = accessor->getViewOfValue();
+        auto [tag, val] = compareValue(lhsTag, lhsVal, _tags[pos], _vals[pos]);
+        if (tag != TypeTags::NumberInt32 || val != 0) {
+            return false;
+        }
+        ++pos;
+    }
+    return true;
+}
+
+size_t RowHashTable::probe(size_t hash, const std::vector<SlotAccessor*>& keys) const {
+    const size_t mask = _buckets.size() - 1;
+    const auto shortHash = static_cast<uint32_t>(hash);
+
+    for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+        auto& bucket = _buckets[idx];
+        if (bucket.row == kNoRow ||
+            (bucket.hash == shortHash && _hashes[bucket.row] == hash &&
+             keyEquals(bucket.row, keys))) {
+            return idx;
+        }
+    }
+}
+
+void RowHashTable::growIfNeeded() {
+    // Keep the load factor at or below 1/2 so that the probe sequences stay short.
+    if ((_hashes.size() + 1) * 2 <= _buckets.size()) {
+        return;
+    }
+
+    std::vector<Bucket> buckets(_buckets.size() * 2);
+    const size_t mask = buckets.size() - 1;
+    for (auto& bucket : _buckets) {
+        if (bucket.row == kNoRow) {
+            continue;
+        }
+
+        // Only the heads of the duplicate chains are stored in the buckets, so every one of them
+        // has a distinct key and we only need to find an empty bucket.
+        auto idx = _hashes[bucket.row] & mask;
+        while (buckets[idx].row != kNoRow) {
+            idx = (idx + 1) & mask;
+        }
+        buckets[idx] = bucket;
+    }
+    _buckets = std::move(buckets);
+}
+
+size_t RowHashTable::appendRow(size_t hash, const std::vector<SlotAccessor*>& keys) {
+    invariant(keys.size() == _keyWidth);
+    uassert(5073000, "too many rows in the hash table", _hashes.size() < kNoRow);
+
+    const auto row = _hashes.size();
+    _hashes.push_back(hash);
+    _next.push_back(static_cast<uint32_t>(kNoRow));
+
+    _tags.resize(_tags.size() + _width, TypeTags::Nothing);
+    _vals.resize(_vals.size() + _width, 0);
+    _owned.resize(_owned.size() + _width, false);
+
+    auto pos = cellPos(row, 0);
+    for (auto accessor : keys) {
+        auto [tag, val] = accessor->getViewOfValue();
+        auto [copyTag, copyVal] = copyValue(tag, val);
+        _tags[pos] = copyTag;
+        _vals[pos] = copyVal;
+        _owned[pos] = true;
+        ++pos;
+    }
+
+    return row;
+}
+
+std::pair<size_t, bool> RowHashTable::findOrInsert(const std::vector<SlotAccessor*>& keys) {
+    growIfNeeded();
+
+    const auto hash = computeHash(keys);
+    auto& bucket = _buckets[probe(hash, keys)];
+    if (bucket.row != kNoRow) {
+        return {bucket.row, false};
+    }
+
+    auto row = appendRow(hash, keys);
+    bucket.row = static_cast<uint32_t>(row);
+    bucket.hash = static_cast<uint32_t>(hash);
+    return {row, true};
+}
+
+size_t RowHashTable::insert(const std::vector<SlotAccessor*>& keys) {
+    growIfNeeded();
+
+    const auto hash = computeHash(keys);
+    auto& bucket = _buckets[probe(hash, keys)];
+    auto row = appendRow(hash, keys);
+    if (bucket.row != kNoRow) {
+        // Link the new row right after the head of the chain.
+        _next[row] = _next[bucket.row];
+        _next[bucket.row] = static_cast<uint32_t>(row);
+    } else {
+        bucket.row = static_cast<uint32_t>(row);
+        bucket.hash = static_cast<uint32_t>(hash);
+    }
+    return row;
+}
+
+size_t RowHashTable::find(const std::vector<SlotAccessor*>& keys) const {
+    return _buckets[probe(computeHash(keys), keys)].row;
+}
+}  // namespace mongo::sbe::value
@@ -0,0 +1,218 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "mongo/db/exec/sbe/values/slot.h"
+#include "mongo/db/exec/sbe/values/value.h"
+
+namespace mongo::sbe::value {
+/**
+ * A hash table of materialized rows which uses open addressing with linear probing instead of
+ * the node based containers. Every row consists of 'keyWidth' key columns followed by
+ * 'valueWidth' value columns, and all of the rows live inline in a single row arena, so inserting
+ * a new group or build-side row does not allocate per row. The hash of every key is computed once
+ * on insertion and stored alongside the row, such that neither probing nor growing the table has
+ * to rehash the key values.
+ *
+ * Rows are addressed by their index in the arena, which stays stable for the lifetime of the
+ * table (until clear()). Views returned by the accessors are only valid until the next insertion
+ * as the arena may be reallocated.
+ *
+ * The table supports both unique keys (findOrInsert) and duplicate keys (insert). In the latter
+ * case all rows with the same key form a chain which can be walked with find() and next().
+ */
+class RowHashTable {
+public:
+    static constexpr size_t kNoRow = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * A view of a single row in the table. It provides the same interface as a 'MaterializedRow'
+     * so that 'MaterializedRowAccessor<RowHashTable>' can be used to expose the table columns as
+     * slots. Column indexes [0, keyWidth) address the key and the rest address the value.
+     */
+    class RowView {
+    public:
+        RowView(RowHashTable* table, size_t row) : _table(table), _row(row) {}
+
+        std::pair<TypeTags, Value> getViewOfValue(size_t idx) const {
+            auto pos = _table->cellPos(_row, idx);
+            return {_table->_tags[pos], _table->_vals[pos]};
+        }
+
+        std::pair<TypeTags, Value> copyOrMoveValue(size_t idx) {
+            auto pos = _table->cellPos(_row, idx);
+            if (_table->_owned[pos]) {
+                _table->_owned[pos] = false;
+                return {_table->_tags[pos], _table->_vals[pos]};
+            }
+            return copyValue(_table->_tags[pos], _table->_vals[pos]);
+        }
+
+        void reset(size_t idx, bool owned, TypeTags tag, Value val) {
+            _table->resetCell(_table->cellPos(_row, idx), owned, tag, val);
+        }
+
+    private:
+        RowHashTable* _table;
+        size_t _row;
+    };
+
+    RowHashTable(size_t keyWidth, size_t valueWidth);
+    RowHashTable(const RowHashTable&) = delete;
+    RowHashTable& operator=(const RowHashTable&) = delete;
+    ~RowHashTable();
+
+    /**
+     * Looks up the key formed by the current values of 'keys' and returns the index of the row
+     * holding it. If the key is not present, a new row is appended with a deep copy of the key and
+     * all of its value columns set to Nothing. The second member of the result tells whether the
+     * row has been inserted.
+     */
+    std::pair<size_t, bool> findOrInsert(const std::vector<SlotAccessor*>& keys);
+
+    /**
+     * Unconditionally appends a new row with a deep copy of the key formed by 'keys' and returns
+     * its index. Rows with equal keys are chained together.
+     */
+    size_t insert(const std::vector<SlotAccessor*>& keys);
+
+    /**
+     * Returns the index of the first row whose key is equal to the one formed by 'keys', or kNoRow
+     * if there is none.
+     */
+    size_t find(const std::vector<SlotAccessor*>& keys) const;
+
+    /**
+     * Returns the index of the next row with the same key as 'row', or kNoRow at the end of the
+     * chain. Only rows added with insert() can have duplicates.
+     */
+    size_t next(size_t row) const {
+        return _next[row];
+    }
+
+    RowView operator[](size_t row) {
+        return {this, row};
+    }
+
+    std::pair<TypeTags, Value> getKey(size_t row, size_t idx) const {
+        auto pos = cellPos(row, idx);
+        return {_tags[pos], _vals[pos]};
+    }
+
+    std::pair<TypeTags, Value> getValue(size_t row, size_t idx) const {
+        return getKey(row, _keyWidth + idx);
+    }
+
+    void resetValue(size_t row, size_t idx, bool owned, TypeTags tag, Value val) {
+        resetCell(cellPos(row, _keyWidth + idx), owned, tag, val);
+    }
+
+    size_t size() const {
+        return _hashes.size();
+    }
+
+    bool empty() const {
+        return _hashes.empty();
+    }
+
+    size_t keyWidth() const {
+        return _keyWidth;
+    }
+
+    size_t valueWidth() const {
+        return _width - _keyWidth;
+    }
+
+    /**
+     * Releases all rows. The bucket array keeps its capacity.
+     */
+    void clear();
+
+    /**
+     * Returns the number of bytes used by the row arena and the bucket array. The values owned by
+     * the rows which live outside of the arena (e.g. big strings or arrays) are not accounted for.
+     */
+    size_t memUsage() const;
+
+private:
+    // An entry in the open addressing array. The low bits of the hash are kept next to the row
+    // index, so that most of the mismatching rows are skipped without touching the row arena.
+    struct Bucket {
+        uint32_t row{static_cast<uint32_t>(kNoRow)};
+        uint32_t hash{0};
+    };
+
+    static constexpr size_t kInitialCapacity = 16;
+
+    size_t cellPos(size_t row, size_t idx) const {
+        return row * _width + idx;
+    }
+
+    void resetCell(size_t pos, bool owned, TypeTags tag, Value val) {
+        if (_owned[pos]) {
+            releaseValue(_tags[pos], _vals[pos]);
+        }
+        _tags[pos] = tag;
+        _vals[pos] = val;
+        _owned[pos] = owned;
+    }
+
+    static size_t computeHash(const std::vector<SlotAccessor*>& keys);
+    bool keyEquals(size_t row, const std::vector<SlotAccessor*>& keys) const;
+
+    /**
+     * Returns the bucket index holding the key, or the index of the empty bucket where the key
+     * would be inserted.
+     */
+    size_t probe(size_t hash, const std::vector<SlotAccessor*>& keys) const;
+
+    size_t appendRow(size_t hash, const std::vector<SlotAccessor*>& keys);
+    void growIfNeeded();
+
+    const size_t _keyWidth;
+    const size_t _width;
+
+    // Row arena. Cell (row, idx) is stored at position row * _width + idx.
+    std::vector<TypeTags> _tags;
+    std::vector<Value> _vals;
+    std::vector<uint8_t> _owned;
+
+    // Per row precomputed hashes and the duplicate chains.
+    std::vector<size_t> _hashes;
+    std::vector<uint32_t> _next;
+
+    // Open addressing array, its size is always a power of two.
+    std::vector<Bucket> _buckets;
+};
+}  // namespace mongo::sbe::value
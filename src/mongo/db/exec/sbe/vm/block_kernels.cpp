@@ -0,0 +1,338 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/vm/block_kernels.h"
+
+#include <functional>
+
+#include "mongo/platform/overflow_arithmetic.h"
+
+namespace mongo {
+namespace sbe {
+namespace vm {
+namespace {
+bool isBlockNumber(value::TypeTags tag) {
+    return tag == value::TypeTags::NumberInt32 || tag == value::TypeTags::NumberInt64 ||
+        tag == value::TypeTags::NumberDouble;
+}
+
+/**
+ * Calls 'fn' with a default constructed value of the C++ type corresponding to the numeric 'tag'.
+ * This lets the kernels pick the right instantiation of a typed loop once per block rather than
+ * once per value.
+ */
+template <typename F>
+auto withNumericType(value::TypeTags tag, F&& fn) {
+    switch (tag) {
+        case value::TypeTags::NumberInt32:
+            return fn(int32_t{});
+        case value::TypeTags::NumberInt64:
+            return fn(int64_t{});
+        case value::TypeTags::NumberDouble:
+            return fn(double{});
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+/**
+ * The type the values of types 'L' and 'R' are converted to before they are compared or combined,
+ * which mirrors getWidestNumericalType().
+ */
+template <typename L, typename R>
+using WidestType = std::conditional_t<
+    std::is_same_v<L, double> || std::is_same_v<R, double>,
+    double,
+    std::conditional_t<std::is_same_v<L, int64_t> || std::is_same_v<R, int64_t>, int64_t, int32_t>>;
+
+/**
+ * The arithmetic operations used by the kernels. The doOperation() returns true if the operation
+ * overflowed, the doubles are never checked for overflow.
+ */
+struct Addition {
+    template <typename T>
+    static bool doOperation(T lhs, T rhs, T* result) {
+        if constexpr (std::is_same_v<T, double>) {
+            *result = lhs + rhs;
+            return false;
+        } else {
+            return overflow::add(lhs, rhs, result);
+        }
+    }
+};
+
+struct Subtraction {
+    template <typename T>
+    static bool doOperation(T lhs, T rhs, T* result) {
+        if constexpr (std::is_same_v<T, double>) {
+            *result = lhs - rhs;
+            return false;
+        } else {
+            return overflow::sub(lhs, rhs, result);
+        }
+    }
+};
+
+struct Multiplication {
+    template <typename T>
+    static bool doOperation(T lhs, T rhs, T* result) {
+        if constexpr (std::is_same_v<T, double>) {
+            *result = lhs * rhs;
+            return false;
+        } else {
+            return overflow::mul(lhs, rhs, result);
+        }
+    }
+};
+
+class ConstantKernel final : public BlockKernel {
+public:
+    ConstantKernel(value::TypeTags tag, value::Value val) : _tag(tag), _val(val) {}
+
+    const value::ValueBlock* eval(size_t size) override {
+        if (_block.size() != size) {
+            _block.clear();
+            for (size_t idx = 0; idx < size; ++idx) {
+                _block.push_back(false, _tag, _val);
+            }
+        }
+        return &_block;
+    }
+
+private:
+    const value::TypeTags _tag;
+    const value::Value _val;
+    value::ValueBlock _block;
+};
+
+class VariableKernel final : public BlockKernel {
+public:
+    VariableKernel(const value::ValueBlock* block) : _block(block) {}
+
+    const value::ValueBlock* eval(size_t size) override {
+        return _block;
+    }
+
+private:
+    const value::ValueBlock* const _block;
+};
+
+class BinaryKernel final : public BlockKernel {
+public:
+    BinaryKernel(BlockOp op, std::unique_ptr<BlockKernel> lhs, std::unique_ptr<BlockKernel> rhs)
+        : _op(op), _lhs(std::move(lhs)), _rhs(std::move(rhs)) {}
+
+    const value::ValueBlock* eval(size_t size) override {
+        auto lhs = _lhs->eval(size);
+        if (!lhs) {
+            return nullptr;
+        }
+        auto rhs = _rhs->eval(size);
+        if (!rhs) {
+            return nullptr;
+        }
+
+        auto lhsTag = lhs->commonTag(size);
+        auto rhsTag = rhs->commonTag(size);
+
+        if (_op == BlockOp::logicAnd || _op == BlockOp::logicOr) {
+            if (lhsTag != value::TypeTags::Boolean || rhsTag != value::TypeTags::Boolean) {
+                return nullptr;
+            }
+            return evalLogic(lhs->vals(), rhs->vals(), size);
+        }
+
+        if (!isBlockNumber(lhsTag) || !isBlockNumber(rhsTag)) {
+            return nullptr;
+        }
+
+        return withNumericType(lhsTag, [&](auto l) {
+            return withNumericType(rhsTag, [&](auto r) {
+                return evalNumeric<decltype(l), decltype(r)>(lhs->vals(), rhs->vals(), size);
+            });
+        });
+    }
+
+private:
+    const value::ValueBlock* evalLogic(const value::Value* lhs,
+                                       const value::Value* rhs,
+                                       size_t size) {
+        _out.resizeShallow(size);
+        auto tags = _out.tags();
+        auto vals = _out.vals();
+        for (size_t idx = 0; idx < size; ++idx) {
+            tags[idx] = value::TypeTags::Boolean;
+        }
+
+        // The logical operations are short-circuiting in the bytecode, but the operands evaluated
+        // by the kernels have no side effects so it is safe to evaluate both sides eagerly.
+        if (_op == BlockOp::logicAnd) {
+            for (size_t idx = 0; idx < size; ++idx) {
+                vals[idx] = value::bitcastFrom((lhs[idx] != 0) & (rhs[idx] != 0));
+            }
+        } else {
+            for (size_t idx = 0; idx < size; ++idx) {
+                vals[idx] = value::bitcastFrom((lhs[idx] != 0) | (rhs[idx] != 0));
+            }
+        }
+        return &_out;
+    }
+
+    template <typename L, typename R>
+    const value::ValueBlock* evalNumeric(const value::Value* lhs,
+                                         const value::Value* rhs,
+                                         size_t size) {
+        switch (_op) {
+            case BlockOp::add:
+                return evalArith<L, R, Addition>(lhs, rhs, size);
+            case BlockOp::sub:
+                return evalArith<L, R, Subtraction>(lhs, rhs, size);
+            case BlockOp::mul:
+                return evalArith<L, R, Multiplication>(lhs, rhs, size);
+            case BlockOp::lessEq:
+                return evalCompare<L, R>(lhs, rhs, size, std::less_equal<>{});
+            case BlockOp::less:
+                return evalCompare<L, R>(lhs, rhs, size, std::less<>{});
+            case BlockOp::greater:
+                return evalCompare<L, R>(lhs, rhs, size, std::greater<>{});
+            case BlockOp::greaterEq:
+                return evalCompare<L, R>(lhs, rhs, size, std::greater_equal<>{});
+            case BlockOp::eq:
+                return evalCompare<L, R>(lhs, rhs, size, std::equal_to<>{});
+            case BlockOp::neq:
+                return evalCompare<L, R>(lhs, rhs, size, std::not_equal_to<>{});
+            default:
+                MONGO_UNREACHABLE;
+        }
+    }
+
+    template <typename L, typename R, typename Op>
+    const value::ValueBlock* evalCompare(const value::Value* lhs,
+                                         const value::Value* rhs,
+                                         size_t size,
+                                         Op op) {
+        using W = WidestType<L, R>;
+
+        _out.resizeShallow(size);
+        auto tags = _out.tags();
+        auto vals = _out.vals();
+        for (size_t idx = 0; idx < size; ++idx) {
+            tags[idx] = value::TypeTags::Boolean;
+        }
+        for (size_t idx = 0; idx < size; ++idx) {
+            vals[idx] = value::bitcastFrom(op(static_cast<W>(value::bitcastTo<L>(lhs[idx])),
+                                              static_cast<W>(value::bitcastTo<R>(rhs[idx]))));
+        }
+        return &_out;
+    }
+
+    /**
+     * The arithmetic follows genericArithmeticOp(): the int32 results that do not fit into int32
+     * are widened to int64 and the doubles are never checked for overflow. An overflow of int64
+     * would require a Decimal128 result, which the kernels do not produce, so the whole block is
+     * handed back to the bytecode instead.
+     */
+    template <typename L, typename R, typename Op>
+    const value::ValueBlock* evalArith(const value::Value* lhs,
+                                       const value::Value* rhs,
+                                       size_t size) {
+        using W = WidestType<L, R>;
+
+        _out.resizeShallow(size);
+        auto tags = _out.tags();
+        auto vals = _out.vals();
+
+        if constexpr (std::is_same_v<W, double>) {
+            for (size_t idx = 0; idx < size; ++idx) {
+                double result;
+                Op::doOperation(static_cast<double>(value::bitcastTo<L>(lhs[idx])),
+                                static_cast<double>(value::bitcastTo<R>(rhs[idx])),
+                                &result);
+                tags[idx] = value::TypeTags::NumberDouble;
+                vals[idx] = value::bitcastFrom(result);
+            }
+        } else if constexpr (std::is_same_v<W, int64_t>) {
+            bool overflowed = false;
+            for (size_t idx = 0; idx < size; ++idx) {
+                int64_t result;
+                overflowed |=
+                    Op::doOperation(static_cast<int64_t>(value::bitcastTo<L>(lhs[idx])),
+                                    static_cast<int64_t>(value::bitcastTo<R>(rhs[idx])),
+                                    &result);
+                tags[idx] = value::TypeTags::NumberInt64;
+                vals[idx] = value::bitcastFrom(result);
+            }
+            if (overflowed) {
+                return nullptr;
+            }
+        } else {
+            // Two int32 operands can never overflow int64.
+            for (size_t idx = 0; idx < size; ++idx) {
+                int64_t result;
+                Op::doOperation(static_cast<int64_t>(value::bitcastTo<L>(lhs[idx])),
+                                static_cast<int64_t>(value::bitcastTo<R>(rhs[idx])),
+                                &result);
+                auto narrow = static_cast<int32_t>(result);
+                if (narrow == result) {
+                    tags[idx] = value::TypeTags::NumberInt32;
+                    vals[idx] = value::bitcastFrom(narrow);
+                } else {
+                    tags[idx] = value::TypeTags::NumberInt64;
+                    vals[idx] = value::bitcastFrom(result);
+                }
+            }
+        }
+        return &_out;
+    }
+
+    const BlockOp _op;
+    const std::unique_ptr<BlockKernel> _lhs;
+    const std::unique_ptr<BlockKernel> _rhs;
+    value::ValueBlock _out;
+};
+}  // namespace
+
+std::unique_ptr<BlockKernel> makeConstantKernel(value::TypeTags tag, value::Value val) {
+    return std::make_unique<ConstantKernel>(tag, val);
+}
+
+std::unique_ptr<BlockKernel> makeVariableKernel(const value::ValueBlock* block) {
+    return std::make_unique<VariableKernel>(block);
+}
+
+std::unique_ptr<BlockKernel> makeBinaryKernel(BlockOp op,
+                                              std::unique_ptr<BlockKernel> lhs,
+                                              std::unique_ptr<BlockKernel> rhs) {
+    return std::make_unique<BinaryKernel>(op, std::move(lhs), std::move(rhs));
+}
+}  // namespace vm
+}  // namespace sbe
+}  // namespace mongo
@@ -0,0 +1,83 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "mongo/db/exec/sbe/values/block.h"
+
+namespace mongo {
+namespace sbe {
+namespace vm {
+/**
+ * A kernel evaluates an expression over a whole block of rows at once. The kernels are used by
+ * the plan stages running in the block mode in place of the bytecode for the simple comparisons
+ * and arithmetic over numbers, which can be computed by tight loops over the typed arrays of
+ * values instead of dispatching on every instruction and every value.
+ */
+class BlockKernel {
+public:
+    virtual ~BlockKernel() = default;
+
+    /**
+     * Evaluates the expression over the first 'size' rows of the input blocks. Returns nullptr if
+     * the kernel cannot handle the values it has been given (e.g., mixed types or an overflow), in
+     * which case the caller must fall back to running the bytecode row by row. The returned block
+     * is owned by the kernel and stays valid until the next call to this method.
+     */
+    virtual const value::ValueBlock* eval(size_t size) = 0;
+};
+
+std::unique_ptr<BlockKernel> makeConstantKernel(value::TypeTags tag, value::Value val);
+
+std::unique_ptr<BlockKernel> makeVariableKernel(const value::ValueBlock* block);
+
+enum class BlockOp {
+    add,
+    sub,
+    mul,
+
+    lessEq,
+    less,
+    greater,
+    greaterEq,
+    eq,
+    neq,
+
+    logicAnd,
+    logicOr,
+};
+
+std::unique_ptr<BlockKernel> makeBinaryKernel(BlockOp op,
+                                              std::unique_ptr<BlockKernel> lhs,
+                                              std::unique_ptr<BlockKernel> rhs);
+}  // namespace vm
+}  // namespace sbe
+}  // namespace mongo
@@ -31,17 +31,32 @@
 
 #include "mongo/db/exec/sbe/vm/vm.h"
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <pcrecpp.h>
 
+#include "mongo/base/parse_number.h"
+#include "mongo/bson/oid.h"
 #include "mongo/db/exec/sbe/values/bson.h"
 #include "mongo/db/exec/sbe/values/value.h"
 #include "mongo/db/query/datetime/date_time_support.h"
 #include "mongo/db/storage/key_string.h"
+#include "mongo/platform/bits.h"
 #include "mongo/util/fail_point.h"
+#include "mongo/util/str.h"
+#include "mongo/util/string_map.h"
 #include "mongo/util/summation.h"
 
 MONGO_FAIL_POINT_DEFINE(failOnPoisonedFieldLookup);
 
+// Use the threaded code (computed goto) dispatch in the interpreter loop when the compiler supports
+// it. Every instruction then ends with its own indirect jump to the next one, which is predicted
+// much better than the single shared jump of a switch statement.
+#if defined(__GNUC__)
+#define MONGO_SBE_VM_THREADED_DISPATCH 1
+#else
+#define MONGO_SBE_VM_THREADED_DISPATCH 0
+#endif
+
 namespace mongo {
 namespace sbe {
 namespace vm {
@@ -103,6 +118,14 @@ int Instruction::stackOffset[Instruction::Tags::lastInstruction] = {
     0,   // jmpNothing
 
     -1,  // fail
+
+    0,  // getFieldImm
+    0,  // lessImm
+    0,  // lessEqImm
+    0,  // greaterImm
+    0,  // greaterEqImm
+    0,  // eqImm
+    0,  // neqImm
 };
 
 void CodeFragment::adjustStackSimple(const Instruction& i) {
@@ -125,12 +148,18 @@ void CodeFragment::removeFixup(FrameId frameId) {
 }
 
 void CodeFragment::copyCodeAndFixup(const CodeFragment& from) {
+    auto base = _instrs.size();
     for (auto fixUp : from._fixUps) {
-        fixUp.offset += _instrs.size();
+        fixUp.offset += base;
         _fixUps.push_back(fixUp);
     }
 
     _instrs.insert(_instrs.end(), from._instrs.begin(), from._instrs.end());
+
+    _maxJumpTarget = std::max(_maxJumpTarget, base + from._maxJumpTarget);
+    _lastConstValOffset = from._lastConstValOffset
+        ? boost::make_optional(base + *from._lastConstValOffset)
+        : boost::none;
 }
 
 void CodeFragment::append(std::unique_ptr<CodeFragment> code) {
@@ -161,6 +190,7 @@ void CodeFragment::appendConstVal(value::TypeTags tag, value::Value val) {
     adjustStackSimple(i);
 
     auto offset = allocateSpace(sizeof(Instruction) + sizeof(tag) + sizeof(val));
+    _lastConstValOffset = offset - _instrs.data();
 
     offset += value::writeToMemory(offset, i);
     offset += value::writeToMemory(offset, tag);
@@ -256,8 +286,26 @@ void CodeFragment::appendSimpleInstruction(Instruction::Tags tag) {
     offset += value::writeToMemory(offset, i);
 }
 
+void CodeFragment::appendSimpleInstructionOrFuse(Instruction::Tags tag,
+                                                 Instruction::Tags fusedTag) {
+    if (!_lastConstValOffset || _maxJumpTarget > *_lastConstValOffset) {
+        appendSimpleInstruction(tag);
+        return;
+    }
+
+    // The superinstruction has the same encoding as the pushConstVal, so just patch the opcode.
+    Instruction i;
+    i.tag = fusedTag;
+    value::writeToMemory(_instrs.data() + *_lastConstValOffset, i);
+    _lastConstValOffset = boost::none;
+
+    // The constant is no longer pushed, and the superinstruction consumes one value from the stack
+    // and pushes the result back.
+    _stackSize -= 1;
+}
+
 void CodeFragment::appendGetField() {
-    appendSimpleInstruction(Instruction::getField);
+    appendSimpleInstructionOrFuse(Instruction::getField, Instruction::getFieldImm);
 }
 
 void CodeFragment::appendGetElement() {
@@ -344,6 +392,8 @@ void CodeFragment::appendJump(int jumpOffset) {
 
     offset += value::writeToMemory(offset, i);
     offset += value::writeToMemory(offset, jumpOffset);
+
+    _maxJumpTarget = std::max(_maxJumpTarget, _instrs.size() + jumpOffset);
 }
 
 void CodeFragment::appendJumpTrue(int jumpOffset) {
@@ -355,6 +405,8 @@ void CodeFragment::appendJumpTrue(int jumpOffset) {
 
     offset += value::writeToMemory(offset, i);
     offset += value::writeToMemory(offset, jumpOffset);
+
+    _maxJumpTarget = std::max(_maxJumpTarget, _instrs.size() + jumpOffset);
 }
 
 void CodeFragment::appendJumpNothing(int jumpOffset) {
@@ -366,6 +418,8 @@ void CodeFragment::appendJumpNothing(int jumpOffset) {
 
     offset += value::writeToMemory(offset, i);
     offset += value::writeToMemory(offset, jumpOffset);
+
+    _maxJumpTarget = std::max(_maxJumpTarget, _instrs.size() + jumpOffset);
 }
 
 ByteCode::~ByteCode() {
@@ -1077,677 +1131,1723 @@ std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinDateWeekYear(ui
         timezoneTuple);
 }
 
-std::tuple<bool, value::TypeTags, value::Value> ByteCode::dispatchBuiltin(Builtin f,
-                                                                          uint8_t arity) {
-    switch (f) {
-        case Builtin::dateParts:
-            return builtinDate(arity);
-        case Builtin::datePartsWeekYear:
-            return builtinDateWeekYear(arity);
-        case Builtin::split:
-            return builtinSplit(arity);
-        case Builtin::regexMatch:
-            return builtinRegexMatch(arity);
-        case Builtin::dropFields:
-            return builtinDropFields(arity);
-        case Builtin::newObj:
-            return builtinNewObj(arity);
-        case Builtin::ksToString:
-            return builtinKeyStringToString(arity);
-        case Builtin::newKs:
-            return builtinNewKeyString(arity);
-        case Builtin::abs:
-            return builtinAbs(arity);
-        case Builtin::addToArray:
-            return builtinAddToArray(arity);
-        case Builtin::addToSet:
-            return builtinAddToSet(arity);
-        case Builtin::doubleDoubleSum:
-            return builtinDoubleDoubleSum(arity);
-    }
+namespace {
+constexpr auto kISOFormatString = "%Y-%m-%dT%H:%M:%S.%LZ"_sd;
 
-    MONGO_UNREACHABLE;
+Date_t toDate(value::Value val) {
+    return Date_t::fromMillisSinceEpoch(value::bitcastTo<int64_t>(val));
 }
 
-std::tuple<uint8_t, value::TypeTags, value::Value> ByteCode::run(const CodeFragment* code) {
-    auto pcPointer = code->instrs().data();
-    auto pcEnd = pcPointer + code->instrs().size();
-
-    for (;;) {
-        if (pcPointer == pcEnd) {
-            break;
-        } else {
-            Instruction i = value::readFromMemory<Instruction>(pcPointer);
-            pcPointer += sizeof(i);
-            switch (i.tag) {
-                case Instruction::pushConstVal: {
-                    auto tag = value::readFromMemory<value::TypeTags>(pcPointer);
-                    pcPointer += sizeof(tag);
-                    auto val = value::readFromMemory<value::Value>(pcPointer);
-                    pcPointer += sizeof(val);
-
-                    pushStack(false, tag, val);
+OID toOID(value::TypeTags tag, value::Value val) {
+    return OID::from(tag == value::TypeTags::ObjectId ? value::getObjectIdView(val)->data()
+                                                      : value::bitcastTo<uint8_t*>(val));
+}
 
-                    break;
-                }
-                case Instruction::pushAccessVal: {
-                    auto accessor = value::readFromMemory<value::SlotAccessor*>(pcPointer);
-                    pcPointer += sizeof(accessor);
+std::string formatDouble(double d) {
+    if (std::isinf(d)) {
+        return std::signbit(d) ? "-Infinity" : "Infinity";
+    } else if (std::isnan(d)) {
+        return "NaN";
+    } else if (d == 0.0 && std::signbit(d)) {
+        return "-0";
+    }
+    return str::stream() << d;
+}
 
-                    auto [tag, val] = accessor->getViewOfValue();
-                    pushStack(false, tag, val);
+/**
+ * Coerces a value to a string the same way as Value::coerceToString() does. Nothing and Null
+ * coerce to the empty string, types without a string representation throw.
+ */
+std::string coerceToStringHelper(value::TypeTags tag, value::Value val) {
+    switch (tag) {
+        case value::TypeTags::NumberInt32:
+            return str::stream() << value::bitcastTo<int32_t>(val);
+        case value::TypeTags::NumberInt64:
+            return str::stream() << value::bitcastTo<int64_t>(val);
+        case value::TypeTags::NumberDouble:
+            return str::stream() << value::bitcastTo<double>(val);
+        case value::TypeTags::NumberDecimal:
+            return value::bitcastTo<Decimal128>(val).toString();
+        case value::TypeTags::StringSmall:
+        case value::TypeTags::StringBig:
+        case value::TypeTags::bsonString:
+            return std::string{value::getStringView(tag, val)};
+        case value::TypeTags::Timestamp:
+            return Timestamp(value::bitcastTo<uint64_t>(val)).toStringPretty();
+        case value::TypeTags::Date:
+            return uassertStatusOKWithContext(
+                TimeZoneDatabase::utcZone().formatDate(kISOFormatString, toDate(val)),
+                "failed while coercing date to string");
+        case value::TypeTags::Nothing:
+        case value::TypeTags::Null:
+            return "";
+        default:
+            uasserted(5073319,
+                      str::stream() << "can't convert from BSON type "
+                                    << typeName(value::tagToType(tag)) << " to String");
+    }
+}
 
-                    break;
-                }
-                case Instruction::pushMoveVal: {
-                    auto accessor = value::readFromMemory<value::SlotAccessor*>(pcPointer);
-                    pcPointer += sizeof(accessor);
+/**
+ * Coerces a value to a date the same way as Value::coerceToDate() does.
+ */
+Date_t coerceToDateHelper(value::TypeTags tag, value::Value val) {
+    switch (tag) {
+        case value::TypeTags::Date:
+            return toDate(val);
+        case value::TypeTags::Timestamp:
+            return Date_t::fromMillisSinceEpoch(
+                Timestamp(value::bitcastTo<uint64_t>(val)).getSecs() * 1000LL);
+        case value::TypeTags::ObjectId:
+        case value::TypeTags::bsonObjectId:
+            return toOID(tag, val).asDateT();
+        default:
+            uasserted(5073320,
+                      str::stream() << "can't convert from BSON type "
+                                    << typeName(value::tagToType(tag)) << " to Date");
+    }
+}
 
-                    auto [tag, val] = accessor->copyOrMoveValue();
-                    pushStack(true, tag, val);
+/**
+ * Returns true if the value is a number that can be represented as a 32-bit integer without loss.
+ */
+bool isIntegral32(value::TypeTags tag, value::Value val) {
+    switch (tag) {
+        case value::TypeTags::NumberInt32:
+            return true;
+        case value::TypeTags::NumberInt64: {
+            auto i = value::bitcastTo<int64_t>(val);
+            return i >= std::numeric_limits<int32_t>::min() &&
+                i <= std::numeric_limits<int32_t>::max();
+        }
+        case value::TypeTags::NumberDouble:
+        case value::TypeTags::NumberDecimal: {
+            auto d = value::numericCast<double>(tag, val);
+            return d == std::trunc(d) && d >= std::numeric_limits<int32_t>::min() &&
+                d <= std::numeric_limits<int32_t>::max();
+        }
+        default:
+            return false;
+    }
+}
 
-                    break;
-                }
-                case Instruction::pushLocalVal: {
-                    auto stackOffset = value::readFromMemory<int>(pcPointer);
-                    pcPointer += sizeof(stackOffset);
+size_t getCodePointLength(char charByte) {
+    if ((charByte & 0x80) == 0) {
+        return 1;
+    }
 
-                    auto [owned, tag, val] = getFromStack(stackOffset);
+    // In UTF-8, the number of leading ones is the number of bytes the code point takes up.
+    return countLeadingZeros64(~(uint64_t(charByte) << (64 - 8)));
+}
 
-                    pushStack(false, tag, val);
+template <typename T, int base>
+std::pair<value::TypeTags, value::Value> parseNumber(std::string_view str,
+                                                     value::TypeTags resultTag) {
+    StringData input{str.data(), str.size()};
+    T result;
+    // Hex strings are rejected even though NumberParser accepts them when parsing doubles.
+    if (input.startsWith("0x") || !NumberParser().base(base)(input, &result).isOK()) {
+        return {value::TypeTags::Nothing, 0};
+    }
+    if constexpr (std::is_same_v<T, Decimal128>) {
+        return value::makeCopyDecimal(result);
+    } else {
+        return {resultTag, value::bitcastFrom(result)};
+    }
+}
 
-                    break;
+/**
+ * Converts a value to the given BSON type following the conversion rules of $convert. Returns
+ * Nothing when the conversion is not supported or fails, the caller decides what to do then.
+ * Only numeric, string and boolean targets are supported.
+ */
+std::pair<value::TypeTags, value::Value> convertHelper(value::TypeTags tag,
+                                                       value::Value val,
+                                                       BSONType targetType) {
+    using value::TypeTags;
+    constexpr std::pair<TypeTags, value::Value> kFailure{TypeTags::Nothing, 0};
+
+    switch (targetType) {
+        case BSONType::NumberDouble:
+            switch (tag) {
+                case TypeTags::NumberInt32:
+                case TypeTags::NumberInt64:
+                case TypeTags::NumberDouble:
+                    return {TypeTags::NumberDouble,
+                            value::bitcastFrom(value::numericCast<double>(tag, val))};
+                case TypeTags::NumberDecimal: {
+                    std::uint32_t flags = Decimal128::SignalingFlag::kNoFlag;
+                    auto result = value::bitcastTo<Decimal128>(val).toDouble(
+                        &flags, Decimal128::RoundingMode::kRoundTiesToEven);
+                    if (flags != Decimal128::SignalingFlag::kNoFlag &&
+                        flags != Decimal128::SignalingFlag::kInexact) {
+                        return kFailure;
+                    }
+                    return {TypeTags::NumberDouble, value::bitcastFrom(result)};
                 }
-                case Instruction::pop: {
-                    auto [owned, tag, val] = getFromStack(0);
-                    popStack();
-
-                    if (owned) {
-                        value::releaseValue(tag, val);
+                case TypeTags::Boolean:
+                    return {TypeTags::NumberDouble,
+                            value::bitcastFrom(value::bitcastTo<bool>(val) ? 1.0 : 0.0)};
+                case TypeTags::Date: {
+                    auto millis = static_cast<double>(value::bitcastTo<int64_t>(val));
+                    return {TypeTags::NumberDouble, value::bitcastFrom(millis)};
+                }
+                case TypeTags::StringSmall:
+                case TypeTags::StringBig:
+                case TypeTags::bsonString:
+                    return parseNumber<double, 0>(value::getStringView(tag, val),
+                                                  TypeTags::NumberDouble);
+                default:
+                    return kFailure;
+            }
+        case BSONType::NumberInt:
+        case BSONType::NumberLong: {
+            const bool toInt = targetType == BSONType::NumberInt;
+            const auto resultTag = toInt ? TypeTags::NumberInt32 : TypeTags::NumberInt64;
+            auto makeResult = [&](int64_t result) -> std::pair<TypeTags, value::Value> {
+                if (toInt) {
+                    if (result < std::numeric_limits<int32_t>::min() ||
+                        result > std::numeric_limits<int32_t>::max()) {
+                        return kFailure;
+                    }
+                    return {resultTag, value::bitcastFrom(static_cast<int32_t>(result))};
+                }
+                return {resultTag, value::bitcastFrom(result)};
+            };
+
+            switch (tag) {
+                case TypeTags::NumberInt32:
+                case TypeTags::NumberInt64:
+                    return makeResult(value::numericCast<int64_t>(tag, val));
+                case TypeTags::NumberDouble: {
+                    auto d = value::bitcastTo<double>(val);
+                    if (!std::isfinite(d) || d < std::numeric_limits<int64_t>::lowest() ||
+                        !(d < BSONElement::kLongLongMaxPlusOneAsDouble)) {
+                        return kFailure;
+                    }
+                    return makeResult(static_cast<int64_t>(d));
+                }
+                case TypeTags::NumberDecimal: {
+                    auto dec = value::bitcastTo<Decimal128>(val);
+                    if (dec.isNaN() || dec.isInfinite()) {
+                        return kFailure;
                     }
-
-                    break;
-                }
-                case Instruction::swap: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(1);
-
-                    // Swap values only if they are not physically same.
-                    // Note - this has huge consequences for the memory management, it allows to
-                    // return owned values from the let expressions.
-                    if (!(rhsTag == lhsTag && rhsVal == lhsVal)) {
-                        setStack(0, lhsOwned, lhsTag, lhsVal);
-                        setStack(1, rhsOwned, rhsTag, rhsVal);
-                    } else {
-                        // The values are physically same then the top of the stack must never ever
-                        // be owned.
-                        invariant(!rhsOwned);
+                    std::uint32_t flags = Decimal128::SignalingFlag::kNoFlag;
+                    auto result = dec.toLong(&flags, Decimal128::RoundingMode::kRoundTowardZero);
+                    if (flags & Decimal128::SignalingFlag::kInvalid) {
+                        return kFailure;
                     }
-
-                    break;
+                    return makeResult(result);
                 }
-                case Instruction::add: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                case TypeTags::Boolean:
+                    return makeResult(value::bitcastTo<bool>(val) ? 1 : 0);
+                case TypeTags::Date:
+                    // Dates only convert to longs.
+                    return toInt ? kFailure : makeResult(value::bitcastTo<int64_t>(val));
+                case TypeTags::StringSmall:
+                case TypeTags::StringBig:
+                case TypeTags::bsonString:
+                    return toInt ? parseNumber<int32_t, 10>(value::getStringView(tag, val),
+                                                            resultTag)
+                                 : parseNumber<int64_t, 10>(value::getStringView(tag, val),
+                                                            resultTag);
+                default:
+                    return kFailure;
+            }
+        }
+        case BSONType::NumberDecimal:
+            switch (tag) {
+                case TypeTags::NumberInt32:
+                case TypeTags::NumberInt64:
+                case TypeTags::NumberDecimal:
+                    return value::makeCopyDecimal(value::numericCast<Decimal128>(tag, val));
+                case TypeTags::NumberDouble:
+                    return value::makeCopyDecimal(
+                        Decimal128(value::bitcastTo<double>(val), Decimal128::kRoundTo34Digits));
+                case TypeTags::Boolean:
+                    return value::makeCopyDecimal(Decimal128(value::bitcastTo<bool>(val) ? 1 : 0));
+                case TypeTags::Date:
+                    return value::makeCopyDecimal(Decimal128(value::bitcastTo<int64_t>(val)));
+                case TypeTags::StringSmall:
+                case TypeTags::StringBig:
+                case TypeTags::bsonString:
+                    return parseNumber<Decimal128, 0>(value::getStringView(tag, val),
+                                                      TypeTags::NumberDecimal);
+                default:
+                    return kFailure;
+            }
+        case BSONType::String:
+            switch (tag) {
+                case TypeTags::NumberDouble:
+                    return value::makeNewString(formatDouble(value::bitcastTo<double>(val)));
+                case TypeTags::NumberInt32:
+                case TypeTags::NumberInt64:
+                case TypeTags::NumberDecimal:
+                case TypeTags::StringSmall:
+                case TypeTags::StringBig:
+                case TypeTags::bsonString:
+                case TypeTags::Date:
+                    return value::makeNewString(coerceToStringHelper(tag, val));
+                case TypeTags::Boolean:
+                    return value::makeNewString(value::bitcastTo<bool>(val) ? "true" : "false");
+                case TypeTags::ObjectId:
+                case TypeTags::bsonObjectId:
+                    return value::makeNewString(toOID(tag, val).toString());
+                default:
+                    return kFailure;
+            }
+        case BSONType::Bool:
+            switch (tag) {
+                case TypeTags::Nothing:
+                case TypeTags::Null:
+                    return kFailure;
+                case TypeTags::NumberInt32:
+                case TypeTags::NumberInt64:
+                case TypeTags::NumberDouble:
+                    return {TypeTags::Boolean,
+                            value::bitcastFrom(value::numericCast<double>(tag, val) != 0)};
+                case TypeTags::NumberDecimal:
+                    return {TypeTags::Boolean,
+                            value::bitcastFrom(!value::bitcastTo<Decimal128>(val).isZero())};
+                case TypeTags::Boolean:
+                    return {TypeTags::Boolean, val};
+                default:
+                    // Every other type converts to true.
+                    return {TypeTags::Boolean, value::bitcastFrom(true)};
+            }
+        default:
+            return kFailure;
+    }
+}
 
-                    auto [owned, tag, val] = genericAdd(lhsTag, lhsVal, rhsTag, rhsVal);
+/**
+ * The running state of an average, kept the same way as AccumulatorAvg does it: a compensated
+ * double-double sum of the non-decimal inputs, a decimal sum of the decimal inputs and a count of
+ * the numeric inputs. Non-numeric inputs are ignored.
+ */
+struct AvgState {
+    void add(value::TypeTags tag, value::Value val) {
+        switch (tag) {
+            case value::TypeTags::NumberDecimal:
+                isDecimal = true;
+                decimalSum = decimalSum.add(value::bitcastTo<Decimal128>(val));
+                break;
+            case value::TypeTags::NumberInt64:
+                // Avoid summation using double as that loses precision.
+                nonDecimalSum.addLong(value::bitcastTo<int64_t>(val));
+                break;
+            case value::TypeTags::NumberInt32:
+            case value::TypeTags::NumberDouble:
+                nonDecimalSum.addDouble(value::numericCast<double>(tag, val));
+                break;
+            default:
+                return;
+        }
+        ++count;
+    }
 
-                    topStack(owned, tag, val);
+    std::tuple<bool, value::TypeTags, value::Value> result() const {
+        if (count == 0) {
+            return {false, value::TypeTags::Null, 0};
+        }
+        if (isDecimal) {
+            auto [tag, val] = value::makeCopyDecimal(
+                decimalSum.add(nonDecimalSum.getDecimal()).divide(Decimal128(count)));
+            return {true, tag, val};
+        }
+        return {false,
+                value::TypeTags::NumberDouble,
+                value::bitcastFrom(nonDecimalSum.getDouble() / static_cast<double>(count))};
+    }
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
-                }
-                case Instruction::sub: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    /**
+     * The partial state is stored in an array [sum, count, addend], where 'sum' and 'addend' are
+     * the two halves of the double-double sum of the non-decimal inputs. Once a decimal input has
+     * been seen, the decimal sum is appended as a fourth element.
+     */
+    static AvgState decode(value::TypeTags tag, value::Value val) {
+        AvgState state;
+        if (tag != value::TypeTags::Array) {
+            return state;
+        }
+        auto arr = value::getArrayView(val);
+        invariant(arr->size() == 3 || arr->size() == 4);
+        auto [sumTag, sumVal] = arr->getAt(0);
+        auto [countTag, countVal] = arr->getAt(1);
+        auto [addendTag, addendVal] = arr->getAt(2);
+        // Adding the nearest double first and then the remainder restores the exact sum.
+        state.nonDecimalSum.addDouble(value::bitcastTo<double>(sumVal));
+        state.nonDecimalSum.addDouble(value::bitcastTo<double>(addendVal));
+        state.count = value::bitcastTo<int64_t>(countVal);
+        if (arr->size() == 4) {
+            auto [decimalTag, decimalVal] = arr->getAt(3);
+            state.isDecimal = true;
+            state.decimalSum = value::bitcastTo<Decimal128>(decimalVal);
+        }
+        return state;
+    }
 
-                    auto [owned, tag, val] = genericSub(lhsTag, lhsVal, rhsTag, rhsVal);
+    std::pair<value::TypeTags, value::Value> encode() const {
+        auto [tag, val] = value::makeNewArray();
+        value::ValueGuard guard{tag, val};
+        auto arr = value::getArrayView(val);
+        auto [sum, addend] = nonDecimalSum.getDoubleDouble();
+        arr->push_back(value::TypeTags::NumberDouble, value::bitcastFrom(sum));
+        arr->push_back(value::TypeTags::NumberInt64, value::bitcastFrom(count));
+        arr->push_back(value::TypeTags::NumberDouble, value::bitcastFrom(addend));
+        if (isDecimal) {
+            auto [decimalTag, decimalVal] = value::makeCopyDecimal(decimalSum);
+            arr->push_back(decimalTag, decimalVal);
+        }
+        guard.reset();
+        return {tag, val};
+    }
 
-                    topStack(owned, tag, val);
+    bool isDecimal{false};
+    DoubleDoubleSummation nonDecimalSum;
+    Decimal128 decimalSum;
+    int64_t count{0};
+};
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
-                }
-                case Instruction::mul: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+/**
+ * The running state of a standard deviation computed with Welford's online algorithm, the same
+ * way as AccumulatorStdDev does it. Non-numeric inputs are ignored.
+ */
+struct StdDevState {
+    void add(value::TypeTags tag, value::Value val) {
+        if (!value::isNumber(tag)) {
+            return;
+        }
+        const double x = value::numericCast<double>(tag, val);
+        ++count;
+        const double delta = x - mean;
+        if (delta != 0.0) {
+            mean += delta / count;
+            m2 += delta * (x - mean);
+        }
+    }
 
-                    auto [owned, tag, val] = genericMul(lhsTag, lhsVal, rhsTag, rhsVal);
+    std::tuple<bool, value::TypeTags, value::Value> result(bool isSamp) const {
+        const int64_t adjustedCount = isSamp ? count - 1 : count;
+        if (adjustedCount <= 0) {
+            return {false, value::TypeTags::Null, 0};
+        }
+        return {false, value::TypeTags::NumberDouble, value::bitcastFrom(sqrt(m2 / adjustedCount))};
+    }
 
-                    topStack(owned, tag, val);
+    /**
+     * The partial state is stored in an array [count, mean, m2].
+     */
+    static StdDevState decode(value::TypeTags tag, value::Value val) {
+        StdDevState state;
+        if (tag != value::TypeTags::Array) {
+            return state;
+        }
+        auto arr = value::getArrayView(val);
+        invariant(arr->size() == 3);
+        state.count = value::bitcastTo<int64_t>(arr->getAt(0).second);
+        state.mean = value::bitcastTo<double>(arr->getAt(1).second);
+        state.m2 = value::bitcastTo<double>(arr->getAt(2).second);
+        return state;
+    }
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
-                }
-                case Instruction::div: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    std::pair<value::TypeTags, value::Value> encode() const {
+        auto [tag, val] = value::makeNewArray();
+        value::ValueGuard guard{tag, val};
+        auto arr = value::getArrayView(val);
+        arr->push_back(value::TypeTags::NumberInt64, value::bitcastFrom(count));
+        arr->push_back(value::TypeTags::NumberDouble, value::bitcastFrom(mean));
+        arr->push_back(value::TypeTags::NumberDouble, value::bitcastFrom(m2));
+        guard.reset();
+        return {tag, val};
+    }
 
-                    auto [owned, tag, val] = genericDiv(lhsTag, lhsVal, rhsTag, rhsVal);
+    int64_t count{0};
+    double mean{0};
+    double m2{0};
+};
 
-                    topStack(owned, tag, val);
+/**
+ * Merges objects the same way as AccumulatorMergeObjects does: fields of later objects overwrite
+ * fields of earlier ones but keep their original position. Null and missing inputs are ignored.
+ * Values are held as views, the inputs must outlive the merger.
+ */
+class ObjectMerger {
+public:
+    void merge(value::TypeTags tag, value::Value val) {
+        if (tag == value::TypeTags::Nothing || tag == value::TypeTags::Null) {
+            return;
+        }
+        uassert(5073337,
+                str::stream() << "$mergeObjects requires object inputs, but input is of type "
+                              << typeName(value::tagToType(tag)),
+                value::isObject(tag));
+
+        for (value::ObjectEnumerator enumerator{tag, val}; !enumerator.atEnd();
+             enumerator.advance()) {
+            auto name = enumerator.getFieldName();
+            auto value = enumerator.getViewOfValue();
+            auto [it, inserted] = _index.try_emplace(StringData{name.data(), name.size()},
+                                                     _names.size());
+            if (inserted) {
+                _names.emplace_back(name);
+                _values.push_back(value);
+            } else {
+                _values[it->second] = value;
+            }
+        }
+    }
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
-                }
-                case Instruction::idiv: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    std::tuple<bool, value::TypeTags, value::Value> result() const {
+        auto [tag, val] = value::makeNewObject();
+        auto obj = value::getObjectView(val);
+        value::ValueGuard guard{tag, val};
+        obj->reserve(_names.size());
+        for (size_t idx = 0; idx < _names.size(); ++idx) {
+            auto [copyTag, copyVal] = value::copyValue(_values[idx].first, _values[idx].second);
+            obj->push_back(_names[idx], copyTag, copyVal);
+        }
+        guard.reset();
+        return {true, tag, val};
+    }
 
-                    auto [owned, tag, val] = genericIDiv(lhsTag, lhsVal, rhsTag, rhsVal);
+private:
+    std::vector<std::string> _names;
+    std::vector<std::pair<value::TypeTags, value::Value>> _values;
+    StringMap<size_t> _index;
+};
+}  // namespace
+
+template <typename Fn>
+void ByteCode::forEachArgument(uint8_t arity, uint8_t first, Fn&& fn) {
+    if (arity == first + 1) {
+        auto [_, tag, val] = getFromStack(first);
+        if (value::isArray(tag)) {
+            for (value::ArrayEnumerator enumerator{tag, val}; !enumerator.atEnd();
+                 enumerator.advance()) {
+                auto [elemTag, elemVal] = enumerator.getViewOfValue();
+                fn(elemTag, elemVal);
+            }
+            return;
+        }
+    }
 
-                    topStack(owned, tag, val);
+    for (uint8_t idx = first; idx < arity; ++idx) {
+        auto [_, tag, val] = getFromStack(idx);
+        fn(tag, val);
+    }
+}
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
-                }
-                case Instruction::mod: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinConcat(uint8_t arity) {
+    std::string result;
+    for (uint8_t idx = 0; idx < arity; ++idx) {
+        auto [_, tag, val] = getFromStack(idx);
+        if (tag == value::TypeTags::Nothing || tag == value::TypeTags::Null) {
+            return {false, value::TypeTags::Null, 0};
+        }
+        uassert(5073321,
+                str::stream() << "$concat only supports strings, not "
+                              << typeName(value::tagToType(tag)),
+                value::isString(tag));
+        result.append(value::getStringView(tag, val));
+    }
 
-                    auto [owned, tag, val] = genericMod(lhsTag, lhsVal, rhsTag, rhsVal);
+    auto [tag, val] = value::makeNewString(result);
+    return {true, tag, val};
+}
 
-                    topStack(owned, tag, val);
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinSubstrBytes(uint8_t arity) {
+    invariant(arity == 3);
+
+    auto [ownedStr, tagStr, valStr] = getFromStack(0);
+    auto [ownedLower, tagLower, valLower] = getFromStack(1);
+    auto [ownedLength, tagLength, valLength] = getFromStack(2);
+
+    auto str = coerceToStringHelper(tagStr, valStr);
+    uassert(5073322,
+            str::stream() << "$substrBytes:  starting index must be a numeric type (is BSON type "
+                          << typeName(value::tagToType(tagLower)) << ")",
+            value::isNumber(tagLower));
+    uassert(5073323,
+            str::stream() << "$substrBytes:  length must be a numeric type (is BSON type "
+                          << typeName(value::tagToType(tagLength)) << ")",
+            value::isNumber(tagLength));
+
+    const auto signedLower = value::numericCast<int64_t>(tagLower, valLower);
+    uassert(5073324,
+            str::stream() << "$substrBytes:  starting index must be non-negative (got: "
+                          << signedLower << ")",
+            signedLower >= 0);
+    const size_t lower = static_cast<size_t>(signedLower);
+
+    // A negative length means the rest of the string.
+    const auto signedLength = value::numericCast<int64_t>(tagLength, valLength);
+    const size_t length = signedLength < 0 ? str.length() : static_cast<size_t>(signedLength);
+
+    uassert(5073325,
+            "$substrBytes:  Invalid range, starting index is a UTF-8 continuation byte.",
+            lower >= str.length() || !str::isUTF8ContinuationByte(str[lower]));
+    uassert(5073326,
+            "$substrBytes:  Invalid range, ending index is in the middle of a UTF-8 character.",
+            lower + length >= str.length() || !str::isUTF8ContinuationByte(str[lower + length]));
+
+    auto [tag, val] =
+        value::makeNewString(lower >= str.length() ? std::string_view{}
+                                                   : std::string_view{str}.substr(lower, length));
+    return {true, tag, val};
+}
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
-                }
-                case Instruction::negate: {
-                    auto [owned, tag, val] = getFromStack(0);
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinSubstrCP(uint8_t arity) {
+    invariant(arity == 3);
+
+    auto [ownedStr, tagStr, valStr] = getFromStack(0);
+    auto [ownedLower, tagLower, valLower] = getFromStack(1);
+    auto [ownedLength, tagLength, valLength] = getFromStack(2);
+
+    auto str = coerceToStringHelper(tagStr, valStr);
+    uassert(5073327,
+            str::stream() << "$substrCP: starting index must be a numeric type (is BSON type "
+                          << typeName(value::tagToType(tagLower)) << ")",
+            value::isNumber(tagLower));
+    uassert(5073328,
+            "$substrCP: starting index cannot be represented as a 32-bit integral value",
+            isIntegral32(tagLower, valLower));
+    uassert(5073329,
+            str::stream() << "$substrCP: length must be a numeric type (is BSON type "
+                          << typeName(value::tagToType(tagLength)) << ")",
+            value::isNumber(tagLength));
+    uassert(5073330,
+            "$substrCP: length cannot be represented as a 32-bit integral value",
+            isIntegral32(tagLength, valLength));
+
+    const auto startIndexCodePoints = value::numericCast<int32_t>(tagLower, valLower);
+    const auto length = value::numericCast<int32_t>(tagLength, valLength);
+    uassert(5073331, "$substrCP: length must be a nonnegative integer.", length >= 0);
+    uassert(5073332,
+            "$substrCP: the starting index must be nonnegative integer.",
+            startIndexCodePoints >= 0);
+
+    size_t startIndexBytes = 0;
+    for (int32_t i = 0; i < startIndexCodePoints; ++i) {
+        if (startIndexBytes >= str.size()) {
+            auto [tag, val] = value::makeNewString(std::string_view{});
+            return {true, tag, val};
+        }
+        uassert(5073333,
+                "$substrCP: invalid UTF-8 string",
+                !str::isUTF8ContinuationByte(str[startIndexBytes]));
+        auto codePointLength = getCodePointLength(str[startIndexBytes]);
+        uassert(5073334, "$substrCP: invalid UTF-8 string", codePointLength <= 4);
+        startIndexBytes += codePointLength;
+    }
 
-                    auto [resultOwned, resultTag, resultVal] =
-                        genericSub(value::TypeTags::NumberInt32, 0, tag, val);
+    size_t endIndexBytes = startIndexBytes;
+    for (int32_t i = 0; i < length && endIndexBytes < str.size(); ++i) {
+        uassert(5073335,
+                "$substrCP: invalid UTF-8 string",
+                !str::isUTF8ContinuationByte(str[endIndexBytes]));
+        auto codePointLength = getCodePointLength(str[endIndexBytes]);
+        uassert(5073336, "$substrCP: invalid UTF-8 string", codePointLength <= 4);
+        endIndexBytes += codePointLength;
+    }
 
-                    topStack(resultOwned, resultTag, resultVal);
+    auto [tag, val] = value::makeNewString(
+        std::string_view{str}.substr(startIndexBytes, endIndexBytes - startIndexBytes));
+    return {true, tag, val};
+}
 
-                    if (owned) {
-                        value::releaseValue(resultTag, resultVal);
-                    }
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinToLower(uint8_t arity) {
+    invariant(arity == 1);
 
-                    break;
-                }
-                case Instruction::numConvert: {
-                    auto tag = value::readFromMemory<value::TypeTags>(pcPointer);
-                    pcPointer += sizeof(tag);
+    auto [_, tagInput, valInput] = getFromStack(0);
+    auto str = coerceToStringHelper(tagInput, valInput);
+    boost::to_lower(str);
 
-                    auto [owned, lhsTag, lhsVal] = getFromStack(0);
+    auto [tag, val] = value::makeNewString(str);
+    return {true, tag, val};
+}
 
-                    auto [rhsOwned, rhsTag, rhsVal] = genericNumConvert(lhsTag, lhsVal, tag);
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinToUpper(uint8_t arity) {
+    invariant(arity == 1);
 
-                    topStack(rhsOwned, rhsTag, rhsVal);
+    auto [_, tagInput, valInput] = getFromStack(0);
+    auto str = coerceToStringHelper(tagInput, valInput);
+    boost::to_upper(str);
 
-                    if (owned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
+    auto [tag, val] = value::makeNewString(str);
+    return {true, tag, val};
+}
 
-                    break;
-                }
-                case Instruction::logicNot: {
-                    auto [owned, tag, val] = getFromStack(0);
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinCoerceToString(uint8_t arity) {
+    invariant(arity == 1);
 
-                    auto [resultOwned, resultTag, resultVal] = genericNot(tag, val);
+    auto [_, tagInput, valInput] = getFromStack(0);
+    auto [tag, val] = value::makeNewString(coerceToStringHelper(tagInput, valInput));
+    return {true, tag, val};
+}
 
-                    topStack(resultOwned, resultTag, resultVal);
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinDateToString(uint8_t arity) {
+    invariant(arity == 4);
 
-                    if (owned) {
-                        value::releaseValue(tag, val);
-                    }
-                    break;
-                }
-                case Instruction::less: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [ownedTzdb, tagTzdb, valTzdb] = getFromStack(0);
+    auto [ownedDate, tagDate, valDate] = getFromStack(1);
+    auto [ownedFormat, tagFormat, valFormat] = getFromStack(2);
+    auto [ownedTz, tagTz, valTz] = getFromStack(3);
 
-                    auto [tag, val] = genericCompare<std::less<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+    if (tagTzdb != value::TypeTags::timeZoneDB || tagDate == value::TypeTags::Nothing ||
+        !value::isString(tagFormat) || !value::isString(tagTz)) {
+        return {false, value::TypeTags::Nothing, 0};
+    }
 
-                    topStack(false, tag, val);
+    auto formatView = value::getStringView(tagFormat, valFormat);
+    StringData format{formatView.data(), formatView.size()};
+    TimeZone::validateToStringFormat(format);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
-                }
-                case Instruction::lessEq: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto timeZoneDB = value::getTimeZoneDBView(valTzdb);
+    auto tzString = value::getStringView(tagTz, valTz);
+    const auto tz = tzString == ""
+        ? timeZoneDB->utcZone()
+        : timeZoneDB->getTimeZone(StringData{tzString.data(), tzString.size()});
 
-                    auto [tag, val] =
-                        genericCompare<std::less_equal<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+    auto str = uassertStatusOK(tz.formatDate(format, coerceToDateHelper(tagDate, valDate)));
+    auto [tag, val] = value::makeNewString(str);
+    return {true, tag, val};
+}
 
-                    topStack(false, tag, val);
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinConvert(uint8_t arity) {
+    invariant(arity == 2);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
-                }
-                case Instruction::greater: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [ownedInput, tagInput, valInput] = getFromStack(0);
+    auto [ownedType, tagType, valType] = getFromStack(1);
 
-                    auto [tag, val] =
-                        genericCompare<std::greater<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+    if (!value::isNumber(tagType)) {
+        return {false, value::TypeTags::Nothing, 0};
+    }
 
-                    topStack(false, tag, val);
+    auto targetType = static_cast<BSONType>(value::numericCast<int32_t>(tagType, valType));
+    auto [tag, val] = convertHelper(tagInput, valInput, targetType);
+    return {true, tag, val};
+}
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinMergeObjects(uint8_t arity) {
+    ObjectMerger merger;
+    forEachArgument(
+        arity, 0, [&](value::TypeTags tag, value::Value val) { merger.merge(tag, val); });
+    return merger.result();
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinAggMergeObjects(uint8_t arity) {
+    auto [ownAgg, tagAgg, valAgg] = getFromStack(0);
+    auto [_, tagField, valField] = getFromStack(1);
+
+    ObjectMerger merger;
+    merger.merge(tagAgg, valAgg);
+    merger.merge(tagField, valField);
+    return merger.result();
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinMinMaxOf(uint8_t arity,
+                                                                          bool isMin) {
+    auto resultTag = value::TypeTags::Nothing;
+    value::Value resultVal = 0;
+
+    forEachArgument(arity, 0, [&](value::TypeTags tag, value::Value val) {
+        // Nullish values are ignored, like the classic $min and $max do. BSON undefined is read
+        // into the VM as Nothing, so this covers null, undefined and missing values.
+        if (tag == value::TypeTags::Nothing || tag == value::TypeTags::Null) {
+            return;
+        }
+        if (resultTag == value::TypeTags::Nothing) {
+            resultTag = tag;
+            resultVal = val;
+            return;
+        }
+
+        // Values of different types are ordered by their canonical BSON type.
+        int cmp = canonicalizeBSONType(value::tagToType(tag)) -
+            canonicalizeBSONType(value::tagToType(resultTag));
+        if (cmp == 0) {
+            auto [cmpTag, cmpVal] = value::compareValue(tag, val, resultTag, resultVal);
+            if (cmpTag != value::TypeTags::NumberInt32) {
+                return;
+            }
+            cmp = value::bitcastTo<int32_t>(cmpVal);
+        }
+        if (isMin ? cmp < 0 : cmp > 0) {
+            resultTag = tag;
+            resultVal = val;
+        }
+    });
+
+    if (resultTag == value::TypeTags::Nothing) {
+        return {false, value::TypeTags::Null, 0};
+    }
+
+    auto [tag, val] = value::copyValue(resultTag, resultVal);
+    return {true, tag, val};
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinAvgOf(uint8_t arity) {
+    AvgState state;
+    forEachArgument(arity, 0, [&](value::TypeTags tag, value::Value val) { state.add(tag, val); });
+    return state.result();
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinStdDevOf(uint8_t arity,
+                                                                          bool isSamp) {
+    StdDevState state;
+    forEachArgument(arity, 0, [&](value::TypeTags tag, value::Value val) { state.add(tag, val); });
+    return state.result(isSamp);
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinAggAvg(uint8_t arity) {
+    auto [ownAgg, tagAgg, valAgg] = getFromStack(0);
+    auto [_, tagField, valField] = getFromStack(1);
+
+    auto state = AvgState::decode(tagAgg, valAgg);
+    state.add(tagField, valField);
+
+    auto [tag, val] = state.encode();
+    return {true, tag, val};
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinAvgFinalize(uint8_t arity) {
+    invariant(arity == 1);
+
+    auto [_, tagAgg, valAgg] = getFromStack(0);
+    return AvgState::decode(tagAgg, valAgg).result();
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinAggStdDev(uint8_t arity) {
+    auto [ownAgg, tagAgg, valAgg] = getFromStack(0);
+    auto [_, tagField, valField] = getFromStack(1);
+
+    auto state = StdDevState::decode(tagAgg, valAgg);
+    state.add(tagField, valField);
+
+    auto [tag, val] = state.encode();
+    return {true, tag, val};
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::builtinStdDevFinalize(uint8_t arity,
+                                                                                bool isSamp) {
+    invariant(arity == 1);
+
+    auto [_, tagAgg, valAgg] = getFromStack(0);
+    return StdDevState::decode(tagAgg, valAgg).result(isSamp);
+}
+
+std::tuple<bool, value::TypeTags, value::Value> ByteCode::dispatchBuiltin(Builtin f,
+                                                                          uint8_t arity) {
+    switch (f) {
+        case Builtin::dateParts:
+            return builtinDate(arity);
+        case Builtin::datePartsWeekYear:
+            return builtinDateWeekYear(arity);
+        case Builtin::split:
+            return builtinSplit(arity);
+        case Builtin::regexMatch:
+            return builtinRegexMatch(arity);
+        case Builtin::dropFields:
+            return builtinDropFields(arity);
+        case Builtin::newObj:
+            return builtinNewObj(arity);
+        case Builtin::ksToString:
+            return builtinKeyStringToString(arity);
+        case Builtin::newKs:
+            return builtinNewKeyString(arity);
+        case Builtin::abs:
+            return builtinAbs(arity);
+        case Builtin::addToArray:
+            return builtinAddToArray(arity);
+        case Builtin::addToSet:
+            return builtinAddToSet(arity);
+        case Builtin::doubleDoubleSum:
+            return builtinDoubleDoubleSum(arity);
+        case Builtin::concat:
+            return builtinConcat(arity);
+        case Builtin::substrBytes:
+            return builtinSubstrBytes(arity);
+        case Builtin::substrCP:
+            return builtinSubstrCP(arity);
+        case Builtin::toLower:
+            return builtinToLower(arity);
+        case Builtin::toUpper:
+            return builtinToUpper(arity);
+        case Builtin::coerceToString:
+            return builtinCoerceToString(arity);
+        case Builtin::dateToString:
+            return builtinDateToString(arity);
+        case Builtin::convert:
+            return builtinConvert(arity);
+        case Builtin::mergeObjects:
+            return builtinMergeObjects(arity);
+        case Builtin::aggMergeObjects:
+            return builtinAggMergeObjects(arity);
+        case Builtin::minOf:
+            return builtinMinMaxOf(arity, true);
+        case Builtin::maxOf:
+            return builtinMinMaxOf(arity, false);
+        case Builtin::avgOf:
+            return builtinAvgOf(arity);
+        case Builtin::stdDevPopOf:
+            return builtinStdDevOf(arity, false);
+        case Builtin::stdDevSampOf:
+            return builtinStdDevOf(arity, true);
+        case Builtin::aggAvg:
+            return builtinAggAvg(arity);
+        case Builtin::avgFinalize:
+            return builtinAvgFinalize(arity);
+        case Builtin::aggStdDev:
+            return builtinAggStdDev(arity);
+        case Builtin::stdDevPopFinalize:
+            return builtinStdDevFinalize(arity, false);
+        case Builtin::stdDevSampFinalize:
+            return builtinStdDevFinalize(arity, true);
+    }
+
+    MONGO_UNREACHABLE;
+}
+
+std::tuple<uint8_t, value::TypeTags, value::Value> ByteCode::run(const CodeFragment* code) {
+    auto pcPointer = code->instrs().data();
+    auto pcEnd = pcPointer + code->instrs().size();
+    Instruction i;
+
+#if MONGO_SBE_VM_THREADED_DISPATCH
+    // Must be kept in sync with Instruction::Tags.
+    static const void* const kDispatchTable[] = {
+        &&pushConstValLabel,
+        &&pushAccessValLabel,
+        &&pushMoveValLabel,
+        &&pushLocalValLabel,
+        &&popLabel,
+        &&swapLabel,
+        &&addLabel,
+        &&subLabel,
+        &&mulLabel,
+        &&divLabel,
+        &&idivLabel,
+        &&modLabel,
+        &&negateLabel,
+        &&numConvertLabel,
+        &&logicNotLabel,
+        &&lessLabel,
+        &&lessEqLabel,
+        &&greaterLabel,
+        &&greaterEqLabel,
+        &&eqLabel,
+        &&neqLabel,
+        &&cmp3wLabel,
+        &&fillEmptyLabel,
+        &&getFieldLabel,
+        &&getElementLabel,
+        &&aggSumLabel,
+        &&aggMinLabel,
+        &&aggMaxLabel,
+        &&aggFirstLabel,
+        &&aggLastLabel,
+        &&existsLabel,
+        &&isNullLabel,
+        &&isObjectLabel,
+        &&isArrayLabel,
+        &&isStringLabel,
+        &&isNumberLabel,
+        &&typeMatchLabel,
+        &&functionLabel,
+        &&jmpLabel,
+        &&jmpTrueLabel,
+        &&jmpNothingLabel,
+        &&failLabel,
+        &&getFieldImmLabel,
+        &&lessImmLabel,
+        &&lessEqImmLabel,
+        &&greaterImmLabel,
+        &&greaterEqImmLabel,
+        &&eqImmLabel,
+        &&neqImmLabel,
+    };
+    static_assert(sizeof(kDispatchTable) / sizeof(kDispatchTable[0]) ==
+                  Instruction::Tags::lastInstruction);
+
+#define INSTRUCTION(name) name##Label:
+#define NEXT_INSTRUCTION()                             \
+    if (pcPointer == pcEnd) {                          \
+        goto endOfCode;                                \
+    }                                                  \
+    i = value::readFromMemory<Instruction>(pcPointer); \
+    pcPointer += sizeof(i);                            \
+    goto* kDispatchTable[i.tag]
+#define DISPATCH(tag) goto* kDispatchTable[tag];
+#else
+#define INSTRUCTION(name) case Instruction::name:
+#define NEXT_INSTRUCTION() continue
+#define DISPATCH(tag) switch (tag)
+#endif
+
+    for (;;) {
+        if (pcPointer == pcEnd) {
+            goto endOfCode;
+        }
+        i = value::readFromMemory<Instruction>(pcPointer);
+        pcPointer += sizeof(i);
+
+        DISPATCH(i.tag) {
+            INSTRUCTION(pushConstVal) {
+                auto tag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(tag);
+                auto val = value::readFromMemory<value::Value>(pcPointer);
+                pcPointer += sizeof(val);
+
+                pushStack(false, tag, val);
+
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(pushAccessVal) {
+                auto accessor = value::readFromMemory<value::SlotAccessor*>(pcPointer);
+                pcPointer += sizeof(accessor);
+
+                auto [tag, val] = accessor->getViewOfValue();
+                pushStack(false, tag, val);
+
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(pushMoveVal) {
+                auto accessor = value::readFromMemory<value::SlotAccessor*>(pcPointer);
+                pcPointer += sizeof(accessor);
+
+                auto [tag, val] = accessor->copyOrMoveValue();
+                pushStack(true, tag, val);
+
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(pushLocalVal) {
+                auto stackOffset = value::readFromMemory<int>(pcPointer);
+                pcPointer += sizeof(stackOffset);
+
+                auto [owned, tag, val] = getFromStack(stackOffset);
+
+                pushStack(false, tag, val);
+
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(pop) {
+                auto [owned, tag, val] = getFromStack(0);
+                popStack();
+
+                if (owned) {
+                    value::releaseValue(tag, val);
                 }
-                case Instruction::greaterEq: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [tag, val] =
-                        genericCompare<std::greater_equal<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(swap) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(1);
+
+                // Swap values only if they are not physically same.
+                // Note - this has huge consequences for the memory management, it allows to
+                // return owned values from the let expressions.
+                if (!(rhsTag == lhsTag && rhsVal == lhsVal)) {
+                    setStack(0, lhsOwned, lhsTag, lhsVal);
+                    setStack(1, rhsOwned, rhsTag, rhsVal);
+                } else {
+                    // The values are physically same then the top of the stack must never ever
+                    // be owned.
+                    invariant(!rhsOwned);
+                }
 
-                    topStack(false, tag, val);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(add) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                auto [owned, tag, val] = genericAdd(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(owned, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::eq: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(sub) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [tag, val] = genericCompareEq(lhsTag, lhsVal, rhsTag, rhsVal);
+                auto [owned, tag, val] = genericSub(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    topStack(false, tag, val);
+                topStack(owned, tag, val);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::neq: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(mul) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [tag, val] = genericCompareNeq(lhsTag, lhsVal, rhsTag, rhsVal);
+                auto [owned, tag, val] = genericMul(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    topStack(false, tag, val);
+                topStack(owned, tag, val);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::cmp3w: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(div) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [tag, val] = compare3way(lhsTag, lhsVal, rhsTag, rhsVal);
+                auto [owned, tag, val] = genericDiv(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    topStack(false, tag, val);
+                topStack(owned, tag, val);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::fillEmpty: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
-
-                    if (lhsTag == value::TypeTags::Nothing) {
-                        topStack(rhsOwned, rhsTag, rhsVal);
-
-                        if (lhsOwned) {
-                            value::releaseValue(lhsTag, lhsVal);
-                        }
-                    } else {
-                        if (rhsOwned) {
-                            value::releaseValue(rhsTag, rhsVal);
-                        }
-                    }
-                    break;
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
                 }
-                case Instruction::getField: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(idiv) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [owned, tag, val] = getField(lhsTag, lhsVal, rhsTag, rhsVal);
+                auto [owned, tag, val] = genericIDiv(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    topStack(owned, tag, val);
+                topStack(owned, tag, val);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::getElement: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(mod) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [owned, tag, val] = getElement(lhsTag, lhsVal, rhsTag, rhsVal);
+                auto [owned, tag, val] = genericMod(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    topStack(owned, tag, val);
+                topStack(owned, tag, val);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::aggSum: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(negate) {
+                auto [owned, tag, val] = getFromStack(0);
 
-                    auto [owned, tag, val] = aggSum(lhsTag, lhsVal, rhsTag, rhsVal);
+                auto [resultOwned, resultTag, resultVal] =
+                    genericSub(value::TypeTags::NumberInt32, 0, tag, val);
 
-                    topStack(owned, tag, val);
+                topStack(resultOwned, resultTag, resultVal);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                if (owned) {
+                    value::releaseValue(resultTag, resultVal);
                 }
-                case Instruction::aggMin: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [owned, tag, val] = aggMin(lhsTag, lhsVal, rhsTag, rhsVal);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(numConvert) {
+                auto tag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(tag);
 
-                    topStack(owned, tag, val);
+                auto [owned, lhsTag, lhsVal] = getFromStack(0);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                auto [rhsOwned, rhsTag, rhsVal] = genericNumConvert(lhsTag, lhsVal, tag);
+
+                topStack(rhsOwned, rhsTag, rhsVal);
+
+                if (owned) {
+                    value::releaseValue(lhsTag, lhsVal);
                 }
-                case Instruction::aggMax: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [owned, tag, val] = aggMax(lhsTag, lhsVal, rhsTag, rhsVal);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(logicNot) {
+                auto [owned, tag, val] = getFromStack(0);
+
+                auto [resultOwned, resultTag, resultVal] = genericNot(tag, val);
 
-                    topStack(owned, tag, val);
+                topStack(resultOwned, resultTag, resultVal);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                if (owned) {
+                    value::releaseValue(tag, val);
                 }
-                case Instruction::aggFirst: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(less) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [owned, tag, val] = aggFirst(lhsTag, lhsVal, rhsTag, rhsVal);
+                auto [tag, val] = genericCompare<std::less<>>(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    topStack(owned, tag, val);
+                topStack(false, tag, val);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
-                    if (lhsOwned) {
-                        value::releaseValue(lhsTag, lhsVal);
-                    }
-                    break;
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::aggLast: {
-                    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
-                    popStack();
-                    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(lessEq) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [owned, tag, val] = aggLast(lhsTag, lhsVal, rhsTag, rhsVal);
+                auto [tag, val] =
+                    genericCompare<std::less_equal<>>(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    topStack(owned, tag, val);
+                topStack(false, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
+                }
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(greater) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] =
+                    genericCompare<std::greater<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
+                }
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(greaterEq) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] =
+                    genericCompare<std::greater_equal<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
+                }
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(eq) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] = genericCompareEq(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
+                }
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(neq) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] = genericCompareNeq(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
+                }
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(cmp3w) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] = compare3way(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
+                }
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(fillEmpty) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                if (lhsTag == value::TypeTags::Nothing) {
+                    topStack(rhsOwned, rhsTag, rhsVal);
 
-                    if (rhsOwned) {
-                        value::releaseValue(rhsTag, rhsVal);
-                    }
                     if (lhsOwned) {
                         value::releaseValue(lhsTag, lhsVal);
                     }
-                    break;
+                } else {
+                    if (rhsOwned) {
+                        value::releaseValue(rhsTag, rhsVal);
+                    }
                 }
-                case Instruction::exists: {
-                    auto [owned, tag, val] = getFromStack(0);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(getField) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    topStack(false, value::TypeTags::Boolean, tag != value::TypeTags::Nothing);
+                auto [owned, tag, val] = getField(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    if (owned) {
-                        value::releaseValue(tag, val);
-                    }
-                    break;
+                topStack(owned, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::isNull: {
-                    auto [owned, tag, val] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(getElement) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    if (tag != value::TypeTags::Nothing) {
-                        topStack(false, value::TypeTags::Boolean, tag == value::TypeTags::Null);
-                    }
+                auto [owned, tag, val] = getElement(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    if (owned) {
-                        value::releaseValue(tag, val);
-                    }
-                    break;
+                topStack(owned, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::isObject: {
-                    auto [owned, tag, val] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(aggSum) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    if (tag != value::TypeTags::Nothing) {
-                        topStack(false, value::TypeTags::Boolean, value::isObject(tag));
-                    }
+                auto [owned, tag, val] = aggSum(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    if (owned) {
-                        value::releaseValue(tag, val);
-                    }
-                    break;
+                topStack(owned, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::isArray: {
-                    auto [owned, tag, val] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(aggMin) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    if (tag != value::TypeTags::Nothing) {
-                        topStack(false, value::TypeTags::Boolean, value::isArray(tag));
-                    }
+                auto [owned, tag, val] = aggMin(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    if (owned) {
-                        value::releaseValue(tag, val);
-                    }
-                    break;
+                topStack(owned, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::isString: {
-                    auto [owned, tag, val] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(aggMax) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    if (tag != value::TypeTags::Nothing) {
-                        topStack(false, value::TypeTags::Boolean, value::isString(tag));
-                    }
+                auto [owned, tag, val] = aggMax(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    if (owned) {
-                        value::releaseValue(tag, val);
-                    }
-                    break;
+                topStack(owned, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::isNumber: {
-                    auto [owned, tag, val] = getFromStack(0);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(aggFirst) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    if (tag != value::TypeTags::Nothing) {
-                        topStack(false, value::TypeTags::Boolean, value::isNumber(tag));
-                    }
+                auto [owned, tag, val] = aggFirst(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    if (owned) {
-                        value::releaseValue(tag, val);
-                    }
-                    break;
+                topStack(owned, tag, val);
+
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
                 }
-                case Instruction::typeMatch: {
-                    auto typeMask = value::readFromMemory<uint32_t>(pcPointer);
-                    pcPointer += sizeof(typeMask);
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(aggLast) {
+                auto [rhsOwned, rhsTag, rhsVal] = getFromStack(0);
+                popStack();
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    auto [owned, tag, val] = getFromStack(0);
+                auto [owned, tag, val] = aggLast(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    if (tag != value::TypeTags::Nothing) {
-                        bool matches = static_cast<bool>(getBSONTypeMask(tag) & typeMask);
-                        topStack(false, value::TypeTags::Boolean, matches);
-                    }
+                topStack(owned, tag, val);
 
+                if (rhsOwned) {
+                    value::releaseValue(rhsTag, rhsVal);
+                }
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(exists) {
+                auto [owned, tag, val] = getFromStack(0);
+
+                topStack(false, value::TypeTags::Boolean, tag != value::TypeTags::Nothing);
+
+                if (owned) {
+                    value::releaseValue(tag, val);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(isNull) {
+                auto [owned, tag, val] = getFromStack(0);
+
+                if (tag != value::TypeTags::Nothing) {
+                    topStack(false, value::TypeTags::Boolean, tag == value::TypeTags::Null);
+                }
+
+                if (owned) {
+                    value::releaseValue(tag, val);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(isObject) {
+                auto [owned, tag, val] = getFromStack(0);
+
+                if (tag != value::TypeTags::Nothing) {
+                    topStack(false, value::TypeTags::Boolean, value::isObject(tag));
+                }
+
+                if (owned) {
+                    value::releaseValue(tag, val);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(isArray) {
+                auto [owned, tag, val] = getFromStack(0);
+
+                if (tag != value::TypeTags::Nothing) {
+                    topStack(false, value::TypeTags::Boolean, value::isArray(tag));
+                }
+
+                if (owned) {
+                    value::releaseValue(tag, val);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(isString) {
+                auto [owned, tag, val] = getFromStack(0);
+
+                if (tag != value::TypeTags::Nothing) {
+                    topStack(false, value::TypeTags::Boolean, value::isString(tag));
+                }
+
+                if (owned) {
+                    value::releaseValue(tag, val);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(isNumber) {
+                auto [owned, tag, val] = getFromStack(0);
+
+                if (tag != value::TypeTags::Nothing) {
+                    topStack(false, value::TypeTags::Boolean, value::isNumber(tag));
+                }
+
+                if (owned) {
+                    value::releaseValue(tag, val);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(typeMatch) {
+                auto typeMask = value::readFromMemory<uint32_t>(pcPointer);
+                pcPointer += sizeof(typeMask);
+
+                auto [owned, tag, val] = getFromStack(0);
+
+                if (tag != value::TypeTags::Nothing) {
+                    bool matches = static_cast<bool>(getBSONTypeMask(tag) & typeMask);
+                    topStack(false, value::TypeTags::Boolean, matches);
+                }
+
+                if (owned) {
+                    value::releaseValue(tag, val);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(function) {
+                auto f = value::readFromMemory<Builtin>(pcPointer);
+                pcPointer += sizeof(f);
+                auto arity = value::readFromMemory<uint8_t>(pcPointer);
+                pcPointer += sizeof(arity);
+
+                auto [owned, tag, val] = dispatchBuiltin(f, arity);
+
+                for (uint8_t cnt = 0; cnt < arity; ++cnt) {
+                    auto [owned, tag, val] = getFromStack(0);
+                    popStack();
                     if (owned) {
                         value::releaseValue(tag, val);
                     }
-                    break;
-                }
-                case Instruction::function: {
-                    auto f = value::readFromMemory<Builtin>(pcPointer);
-                    pcPointer += sizeof(f);
-                    auto arity = value::readFromMemory<uint8_t>(pcPointer);
-                    pcPointer += sizeof(arity);
-
-                    auto [owned, tag, val] = dispatchBuiltin(f, arity);
-
-                    for (uint8_t cnt = 0; cnt < arity; ++cnt) {
-                        auto [owned, tag, val] = getFromStack(0);
-                        popStack();
-                        if (owned) {
-                            value::releaseValue(tag, val);
-                        }
-                    }
+                }
+
+                pushStack(owned, tag, val);
+
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(jmp) {
+                auto jumpOffset = value::readFromMemory<int>(pcPointer);
+                pcPointer += sizeof(jumpOffset);
+
+                pcPointer += jumpOffset;
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(jmpTrue) {
+                auto jumpOffset = value::readFromMemory<int>(pcPointer);
+                pcPointer += sizeof(jumpOffset);
 
-                    pushStack(owned, tag, val);
+                auto [owned, tag, val] = getFromStack(0);
+                popStack();
 
-                    break;
+                if (tag == value::TypeTags::Boolean && val) {
+                    pcPointer += jumpOffset;
                 }
-                case Instruction::jmp: {
-                    auto jumpOffset = value::readFromMemory<int>(pcPointer);
-                    pcPointer += sizeof(jumpOffset);
 
+                if (owned) {
+                    value::releaseValue(tag, val);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(jmpNothing) {
+                auto jumpOffset = value::readFromMemory<int>(pcPointer);
+                pcPointer += sizeof(jumpOffset);
+
+                auto [owned, tag, val] = getFromStack(0);
+                if (tag == value::TypeTags::Nothing) {
                     pcPointer += jumpOffset;
-                    break;
                 }
-                case Instruction::jmpTrue: {
-                    auto jumpOffset = value::readFromMemory<int>(pcPointer);
-                    pcPointer += sizeof(jumpOffset);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(fail) {
+                auto [ownedCode, tagCode, valCode] = getFromStack(1);
+                invariant(tagCode == value::TypeTags::NumberInt64);
 
-                    auto [owned, tag, val] = getFromStack(0);
-                    popStack();
+                auto [ownedMsg, tagMsg, valMsg] = getFromStack(0);
+                invariant(value::isString(tagMsg));
 
-                    if (tag == value::TypeTags::Boolean && val) {
-                        pcPointer += jumpOffset;
-                    }
+                ErrorCodes::Error code{
+                    static_cast<ErrorCodes::Error>(value::bitcastTo<int64_t>(valCode))};
+                std::string message{value::getStringView(tagMsg, valMsg)};
 
-                    if (owned) {
-                        value::releaseValue(tag, val);
-                    }
-                    break;
+                uasserted(code, message);
+
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(getFieldImm) {
+                auto rhsTag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(rhsTag);
+                auto rhsVal = value::readFromMemory<value::Value>(pcPointer);
+                pcPointer += sizeof(rhsVal);
+
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [owned, tag, val] = getField(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(owned, tag, val);
+
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
                 }
-                case Instruction::jmpNothing: {
-                    auto jumpOffset = value::readFromMemory<int>(pcPointer);
-                    pcPointer += sizeof(jumpOffset);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(lessImm) {
+                auto rhsTag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(rhsTag);
+                auto rhsVal = value::readFromMemory<value::Value>(pcPointer);
+                pcPointer += sizeof(rhsVal);
 
-                    auto [owned, tag, val] = getFromStack(0);
-                    if (tag == value::TypeTags::Nothing) {
-                        pcPointer += jumpOffset;
-                    }
-                    break;
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] = genericCompare<std::less<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
                 }
-                case Instruction::fail: {
-                    auto [ownedCode, tagCode, valCode] = getFromStack(1);
-                    invariant(tagCode == value::TypeTags::NumberInt64);
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(lessEqImm) {
+                auto rhsTag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(rhsTag);
+                auto rhsVal = value::readFromMemory<value::Value>(pcPointer);
+                pcPointer += sizeof(rhsVal);
 
-                    auto [ownedMsg, tagMsg, valMsg] = getFromStack(0);
-                    invariant(value::isString(tagMsg));
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
 
-                    ErrorCodes::Error code{
-                        static_cast<ErrorCodes::Error>(value::bitcastTo<int64_t>(valCode))};
-                    std::string message{value::getStringView(tagMsg, valMsg)};
+                auto [tag, val] = genericCompare<std::less_equal<>>(lhsTag, lhsVal, rhsTag, rhsVal);
 
-                    uasserted(code, message);
+                topStack(false, tag, val);
 
-                    break;
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
                 }
-                default:
-                    MONGO_UNREACHABLE;
+                NEXT_INSTRUCTION();
             }
+            INSTRUCTION(greaterImm) {
+                auto rhsTag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(rhsTag);
+                auto rhsVal = value::readFromMemory<value::Value>(pcPointer);
+                pcPointer += sizeof(rhsVal);
+
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] = genericCompare<std::greater<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(greaterEqImm) {
+                auto rhsTag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(rhsTag);
+                auto rhsVal = value::readFromMemory<value::Value>(pcPointer);
+                pcPointer += sizeof(rhsVal);
+
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] =
+                    genericCompare<std::greater_equal<>>(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(eqImm) {
+                auto rhsTag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(rhsTag);
+                auto rhsVal = value::readFromMemory<value::Value>(pcPointer);
+                pcPointer += sizeof(rhsVal);
+
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] = genericCompareEq(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+            INSTRUCTION(neqImm) {
+                auto rhsTag = value::readFromMemory<value::TypeTags>(pcPointer);
+                pcPointer += sizeof(rhsTag);
+                auto rhsVal = value::readFromMemory<value::Value>(pcPointer);
+                pcPointer += sizeof(rhsVal);
+
+                auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+
+                auto [tag, val] = genericCompareNeq(lhsTag, lhsVal, rhsTag, rhsVal);
+
+                topStack(false, tag, val);
+
+                if (lhsOwned) {
+                    value::releaseValue(lhsTag, lhsVal);
+                }
+                NEXT_INSTRUCTION();
+            }
+#if !MONGO_SBE_VM_THREADED_DISPATCH
+            default:
+                MONGO_UNREACHABLE;
+#endif
         }
     }
+
+#undef DISPATCH
+#undef NEXT_INSTRUCTION
+#undef INSTRUCTION
+
+endOfCode:
     uassert(
         4822801, "The evaluation stack must hold only a single value", _argStackOwned.size() == 1);
 
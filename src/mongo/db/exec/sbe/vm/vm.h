@@ -31,6 +31,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <boost/optional.hpp>
 #include <vector>
 
 #include "mongo/db/exec/sbe/values/slot.h"
@@ -158,6 +159,16 @@ struct Instruction {
 
         fail,
 
+        // Superinstructions replacing a pushConstVal followed by an instruction consuming the
+        // constant as its right hand side. The constant is encoded inline as in pushConstVal.
+        getFieldImm,
+        lessImm,
+        lessEqImm,
+        greaterImm,
+        greaterEqImm,
+        eqImm,
+        neqImm,
+
         lastInstruction  // this is just a marker used to calculate number of instructions
     };
 
@@ -175,12 +186,32 @@ enum class Builtin : uint8_t {
     datePartsWeekYear,
     dropFields,
     newObj,
-    ksToString,       // KeyString to string
-    newKs,            // new KeyString
-    abs,              // absolute value
-    addToArray,       // agg function to append to an array
-    addToSet,         // agg function to append to a set
-    doubleDoubleSum,  // special double summation
+    ksToString,          // KeyString to string
+    newKs,               // new KeyString
+    abs,                 // absolute value
+    addToArray,          // agg function to append to an array
+    addToSet,            // agg function to append to a set
+    doubleDoubleSum,     // special double summation
+    concat,
+    substrBytes,
+    substrCP,
+    toLower,
+    toUpper,
+    coerceToString,
+    dateToString,
+    convert,             // conversion to a BSON type given by its numeric code
+    mergeObjects,        // merge a list of objects
+    aggMergeObjects,     // agg function to merge objects
+    minOf,               // minimum over a list of values
+    maxOf,               // maximum over a list of values
+    avgOf,               // average over a list of values
+    stdDevPopOf,         // population standard deviation over a list of values
+    stdDevSampOf,        // sample standard deviation over a list of values
+    aggAvg,              // agg function to compute a partial average
+    avgFinalize,         // compute the average from a partial average
+    aggStdDev,           // agg function to compute a partial standard deviation
+    stdDevPopFinalize,   // compute the population standard deviation from a partial result
+    stdDevSampFinalize,  // compute the sample standard deviation from a partial result
 };
 
 class CodeFragment {
@@ -217,22 +248,22 @@ public:
     void appendNegate();
     void appendNot();
     void appendLess() {
-        appendSimpleInstruction(Instruction::less);
+        appendSimpleInstructionOrFuse(Instruction::less, Instruction::lessImm);
     }
     void appendLessEq() {
-        appendSimpleInstruction(Instruction::lessEq);
+        appendSimpleInstructionOrFuse(Instruction::lessEq, Instruction::lessEqImm);
     }
     void appendGreater() {
-        appendSimpleInstruction(Instruction::greater);
+        appendSimpleInstructionOrFuse(Instruction::greater, Instruction::greaterImm);
     }
     void appendGreaterEq() {
-        appendSimpleInstruction(Instruction::greaterEq);
+        appendSimpleInstructionOrFuse(Instruction::greaterEq, Instruction::greaterEqImm);
     }
     void appendEq() {
-        appendSimpleInstruction(Instruction::eq);
+        appendSimpleInstructionOrFuse(Instruction::eq, Instruction::eqImm);
     }
     void appendNeq() {
-        appendSimpleInstruction(Instruction::neq);
+        appendSimpleInstructionOrFuse(Instruction::neq, Instruction::neqImm);
     }
     void appendCmp3w() {
         appendSimpleInstruction(Instruction::cmp3w);
@@ -265,7 +296,15 @@ public:
 
 private:
     void appendSimpleInstruction(Instruction::Tags tag);
+
+    /**
+     * Appends the instruction 'tag', or turns the pushConstVal just appended into the equivalent
+     * superinstruction 'fusedTag' if it is safe to do so.
+     */
+    void appendSimpleInstructionOrFuse(Instruction::Tags tag, Instruction::Tags fusedTag);
+
     auto allocateSpace(size_t size) {
+        _lastConstValOffset = boost::none;
         auto oldSize = _instrs.size();
         _instrs.resize(oldSize + size);
         return _instrs.data() + oldSize;
@@ -291,6 +330,14 @@ private:
     std::vector<FixUp> _fixUps;
 
     int _stackSize{0};
+
+    // The offset of the last instruction if it is a pushConstVal which can be fused with the
+    // instruction appended after it.
+    boost::optional<size_t> _lastConstValOffset;
+
+    // The furthest offset any jump in this fragment lands at. A pushConstVal starting before this
+    // offset is never fused as that would change the distance of the jump.
+    size_t _maxJumpTarget{0};
 };
 
 class ByteCode {
@@ -410,6 +457,33 @@ private:
     std::tuple<bool, value::TypeTags, value::Value> builtinAddToArray(uint8_t arity);
     std::tuple<bool, value::TypeTags, value::Value> builtinAddToSet(uint8_t arity);
     std::tuple<bool, value::TypeTags, value::Value> builtinDoubleDoubleSum(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinConcat(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinSubstrBytes(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinSubstrCP(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinToLower(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinToUpper(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinCoerceToString(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinDateToString(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinConvert(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinMergeObjects(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinAggMergeObjects(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinMinMaxOf(uint8_t arity, bool isMin);
+    std::tuple<bool, value::TypeTags, value::Value> builtinAvgOf(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinStdDevOf(uint8_t arity, bool isSamp);
+    std::tuple<bool, value::TypeTags, value::Value> builtinAggAvg(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinAvgFinalize(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinAggStdDev(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinStdDevFinalize(uint8_t arity,
+                                                                          bool isSamp);
+
+    /**
+     * Calls 'fn' for every argument of a builtin starting at stack offset 'first'. When the
+     * builtin was given exactly one argument and that argument is an array, 'fn' is called for
+     * every element of the array instead. This matches how expressions built from accumulators
+     * (e.g. {$avg: [...]}) treat their inputs.
+     */
+    template <typename Fn>
+    void forEachArgument(uint8_t arity, uint8_t first, Fn&& fn);
 
     std::tuple<bool, value::TypeTags, value::Value> dispatchBuiltin(Builtin f, uint8_t arity);
 
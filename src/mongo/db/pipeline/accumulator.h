@@ -378,4 +378,38 @@ private:
     MutableDocument _output;
 };
 
+/**
+ * Estimates the number of distinct values with a HyperLogLog sketch (Flajolet et al.,
+ * "HyperLogLog: the analysis of a near-optimal cardinality estimation algorithm"). Each value is
+ * hashed consistently with the collation, so values which compare equal count once. The sketch is a
+ * fixed array of 2^kPrecision one-byte registers and the estimate has a standard error of about
+ * 1.04 / sqrt(2^kPrecision). Partial results are the registers themselves, which merge by taking
+ * the maximum of each register.
+ */
+class AccumulatorApproxCountDistinct final : public AccumulatorState {
+public:
+    static constexpr int kPrecision = 12;
+    static constexpr size_t kNumRegisters = size_t{1} << kPrecision;
+
+    explicit AccumulatorApproxCountDistinct(ExpressionContext* const expCtx);
+
+    void processInternal(const Value& input, bool merging) final;
+    Value getValue(bool toBeMerged) final;
+    const char* getOpName() const final;
+    void reset() final;
+
+    static boost::intrusive_ptr<AccumulatorState> create(ExpressionContext* const expCtx);
+
+    bool isAssociative() const final {
+        return true;
+    }
+
+    bool isCommutative() const final {
+        return true;
+    }
+
+private:
+    std::vector<uint8_t> _registers;
+};
+
 }  // namespace mongo
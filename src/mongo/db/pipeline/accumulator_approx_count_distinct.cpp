@@ -0,0 +1,134 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cmath>
+
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+
+REGISTER_ACCUMULATOR(approxCountDistinct,
+                     genericParseSingleExpressionAccumulator<AccumulatorApproxCountDistinct>);
+
+namespace {
+/**
+ * Scrambles the bits of a Value hash, which may be as weak as the identity for small integers, so
+ * that both the register index and the run of leading zeros taken from it are uniform.
+ */
+uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+}  // namespace
+
+const char* AccumulatorApproxCountDistinct::getOpName() const {
+    return "$approxCountDistinct";
+}
+
+void AccumulatorApproxCountDistinct::processInternal(const Value& input, bool merging) {
+    if (!merging) {
+        // Like $addToSet, a missing value is not counted.
+        if (input.missing()) {
+            return;
+        }
+
+        const uint64_t hash = mixHash(getExpressionContext()->getValueComparator().hash(input));
+        const size_t idx = hash >> (64 - kPrecision);
+
+        // The rank is the position of the first set bit in the remaining bits. The guard bit
+        // bounds it when they are all zero.
+        const uint64_t remaining = (hash << kPrecision) | (uint64_t{1} << (kPrecision - 1));
+        const uint8_t rank = countLeadingZeros64(remaining) + 1;
+        if (rank > _registers[idx]) {
+            _registers[idx] = rank;
+        }
+    } else {
+        // This is what getValue(true) produced below.
+        verify(input.getType() == BinData);
+        const auto binData = input.getBinData();
+        verify(static_cast<size_t>(binData.length) == kNumRegisters);
+        const auto* registers = static_cast<const uint8_t*>(binData.data);
+        for (size_t i = 0; i < kNumRegisters; ++i) {
+            _registers[i] = std::max(_registers[i], registers[i]);
+        }
+    }
+}
+
+Value AccumulatorApproxCountDistinct::getValue(bool toBeMerged) {
+    if (toBeMerged) {
+        return Value(BSONBinData(_registers.data(), _registers.size(), BinDataGeneral));
+    }
+
+    const double m = kNumRegisters;
+    double harmonicSum = 0;
+    size_t numZeroRegisters = 0;
+    for (auto reg : _registers) {
+        harmonicSum += std::ldexp(1.0, -reg);
+        numZeroRegisters += (reg == 0);
+    }
+
+    const double alpha = 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / harmonicSum;
+
+    // For small cardinalities the raw estimate is biased; linear counting over the empty
+    // registers is more accurate there. With a 64-bit hash no large range correction is needed.
+    if (estimate <= 2.5 * m && numZeroRegisters > 0) {
+        estimate = m * std::log(m / numZeroRegisters);
+    }
+    return Value(static_cast<long long>(std::llround(estimate)));
+}
+
+AccumulatorApproxCountDistinct::AccumulatorApproxCountDistinct(ExpressionContext* const expCtx)
+    : AccumulatorState(expCtx), _registers(kNumRegisters, 0) {
+    // The sketch has a fixed size, so we never need to update this.
+    _memUsageBytes = sizeof(*this) + kNumRegisters;
+}
+
+void AccumulatorApproxCountDistinct::reset() {
+    std::fill(_registers.begin(), _registers.end(), 0);
+}
+
+intrusive_ptr<AccumulatorState> AccumulatorApproxCountDistinct::create(
+    ExpressionContext* const expCtx) {
+    return new AccumulatorApproxCountDistinct(expCtx);
+}
+
+}  // namespace mongo
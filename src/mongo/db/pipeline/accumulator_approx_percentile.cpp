@@ -0,0 +1,289 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/accumulator_approx_percentile.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+
+REGISTER_ACCUMULATOR(approxPercentile, AccumulatorApproxPercentile::parse);
+
+namespace {
+/**
+ * The k1 scale function of the t-digest paper, which maps a quantile to a scale on which each
+ * centroid may span at most one unit. Its slope is steepest at the extremes, keeping the centroids
+ * there small.
+ */
+double scale(double q) {
+    return AccumulatorApproxPercentile::kCompression / (2 * M_PI) * std::asin(2 * q - 1);
+}
+
+double parsePercentile(BSONElement elem) {
+    uassert(5073307,
+            str::stream() << "$approxPercentile 'p' must be a number or an array of numbers "
+                             "between 0 and 1; found: "
+                          << elem,
+            elem.isNumber() && elem.numberDouble() >= 0 && elem.numberDouble() <= 1);
+    return elem.numberDouble();
+}
+}  // namespace
+
+const char* AccumulatorApproxPercentile::getOpName() const {
+    return kAccumulatorName.rawData();
+}
+
+AccumulationExpression AccumulatorApproxPercentile::parse(ExpressionContext* const expCtx,
+                                                          BSONElement elem,
+                                                          VariablesParseState vps) {
+    /*
+     * {$approxPercentile: {
+     *   input: <expr>,  // evaluated once per document
+     *   p: <number or array of numbers>,
+     * }}
+     */
+    uassert(5073304,
+            str::stream() << "$approxPercentile expects an object as an argument; found: "
+                          << typeName(elem.type()),
+            elem.type() == BSONType::Object);
+
+    intrusive_ptr<Expression> input;
+    std::vector<double> percentiles;
+    bool percentilesIsArray = false;
+    bool seenPercentiles = false;
+    for (auto&& element : elem.embeddedObject()) {
+        auto name = element.fieldNameStringData();
+        if (name == "input") {
+            input = Expression::parseOperand(expCtx, element, vps);
+        } else if (name == "p") {
+            seenPercentiles = true;
+            if (element.type() == BSONType::Array) {
+                percentilesIsArray = true;
+                for (auto&& p : element.embeddedObject()) {
+                    percentiles.push_back(parsePercentile(p));
+                }
+            } else {
+                percentiles.push_back(parsePercentile(element));
+            }
+        } else {
+            uasserted(5073305,
+                      str::stream() << "$approxPercentile got an unexpected field: " << name);
+        }
+    }
+    uassert(5073306, "$approxPercentile missing required argument 'input'", input);
+    uassert(5073308, "$approxPercentile missing required argument 'p'", seenPercentiles);
+
+    auto initializer = ExpressionConstant::create(expCtx, Value(BSONNULL));
+    auto factory = [expCtx, percentiles = std::move(percentiles), percentilesIsArray]() {
+        return AccumulatorApproxPercentile::create(expCtx, percentiles, percentilesIsArray);
+    };
+    return {std::move(initializer), std::move(input), std::move(factory)};
+}
+
+Document AccumulatorApproxPercentile::serialize(intrusive_ptr<Expression> initializer,
+                                                intrusive_ptr<Expression> argument,
+                                                bool explain) const {
+    Value percentiles;
+    if (_percentilesIsArray) {
+        percentiles = Value(std::vector<Value>(_percentiles.begin(), _percentiles.end()));
+    } else {
+        percentiles = Value(_percentiles.front());
+    }
+    return DOC(getOpName() << DOC("input" << argument->serialize(explain) << "p" << percentiles));
+}
+
+void AccumulatorApproxPercentile::processInternal(const Value& input, bool merging) {
+    if (!merging) {
+        // Non-numeric types have no impact on the percentiles, and neither do NaN or infinities,
+        // which have no place to interpolate between.
+        if (!input.numeric()) {
+            return;
+        }
+        const double val = input.coerceToDouble();
+        if (!std::isfinite(val)) {
+            return;
+        }
+        add(val, 1);
+    } else {
+        // This is what getValue(true) produced below.
+        verify(input.getType() == Object);
+        const Value means = input["means"];
+        const Value weights = input["weights"];
+        verify(means.getType() == Array && weights.getType() == Array);
+        verify(means.getArrayLength() == weights.getArrayLength());
+        for (size_t i = 0; i < means.getArrayLength(); ++i) {
+            add(means[i].getDouble(), weights[i].getDouble());
+        }
+        if (means.getArrayLength() > 0) {
+            // The extremes are tracked exactly, independently of the centroids.
+            _min = std::min(_min, input["min"].getDouble());
+            _max = std::max(_max, input["max"].getDouble());
+        }
+    }
+}
+
+void AccumulatorApproxPercentile::add(double mean, double weight) {
+    if (_totalWeight == 0) {
+        _min = mean;
+        _max = mean;
+    } else {
+        _min = std::min(_min, mean);
+        _max = std::max(_max, mean);
+    }
+    _buffer.push_back({mean, weight});
+    _totalWeight += weight;
+    if (_buffer.size() >= kBufferSize) {
+        compress();
+    }
+}
+
+void AccumulatorApproxPercentile::compress() {
+    if (_buffer.empty()) {
+        return;
+    }
+
+    _buffer.insert(_buffer.end(), _centroids.begin(), _centroids.end());
+    std::sort(_buffer.begin(), _buffer.end(), [](const Centroid& lhs, const Centroid& rhs) {
+        return lhs.mean < rhs.mean;
+    });
+
+    // Sweep through the sorted centroids, merging each into its predecessor as long as the merged
+    // centroid spans no more than one unit of the scale function.
+    _centroids.clear();
+    double weightSoFar = 0;
+    Centroid current = _buffer.front();
+    for (auto it = std::next(_buffer.begin()); it != _buffer.end(); ++it) {
+        const double qLeft = weightSoFar / _totalWeight;
+        const double qRight = (weightSoFar + current.weight + it->weight) / _totalWeight;
+        if (scale(qRight) - scale(qLeft) <= 1) {
+            current.weight += it->weight;
+            current.mean += (it->mean - current.mean) * it->weight / current.weight;
+        } else {
+            weightSoFar += current.weight;
+            _centroids.push_back(current);
+            current = *it;
+        }
+    }
+    _centroids.push_back(current);
+    _buffer.clear();
+
+    _memUsageBytes =
+        sizeof(*this) + (_centroids.capacity() + _buffer.capacity()) * sizeof(Centroid);
+}
+
+double AccumulatorApproxPercentile::quantile(double percentile) const {
+    invariant(!_centroids.empty() && _buffer.empty());
+    const double target = percentile * _totalWeight;
+
+    // Each centroid is taken to sit at the middle of the weight it represents, and the estimate is
+    // interpolated linearly between the neighbouring centroids, or the exact minimum and maximum
+    // beyond the first and last of them.
+    const Centroid& first = _centroids.front();
+    if (target < first.weight / 2) {
+        return _min + (first.mean - _min) * target / (first.weight / 2);
+    }
+    double weightBefore = first.weight / 2;
+    for (size_t i = 1; i < _centroids.size(); ++i) {
+        const Centroid& left = _centroids[i - 1];
+        const Centroid& right = _centroids[i];
+        const double weightAfter = weightBefore + (left.weight + right.weight) / 2;
+        if (target < weightAfter) {
+            const double fraction = (target - weightBefore) / (weightAfter - weightBefore);
+            return left.mean + (right.mean - left.mean) * fraction;
+        }
+        weightBefore = weightAfter;
+    }
+    const Centroid& last = _centroids.back();
+    const double fraction = std::min(1.0, (target - weightBefore) / (last.weight / 2));
+    return last.mean + (_max - last.mean) * fraction;
+}
+
+Value AccumulatorApproxPercentile::getValue(bool toBeMerged) {
+    compress();
+
+    if (toBeMerged) {
+        std::vector<Value> means;
+        std::vector<Value> weights;
+        means.reserve(_centroids.size());
+        weights.reserve(_centroids.size());
+        for (auto&& centroid : _centroids) {
+            means.emplace_back(centroid.mean);
+            weights.emplace_back(centroid.weight);
+        }
+        return Value(DOC("min" << _min << "max" << _max << "means" << Value(std::move(means))
+                               << "weights" << Value(std::move(weights))));
+    }
+
+    if (_centroids.empty()) {
+        return Value(BSONNULL);  // percentiles are not defined without any numeric input
+    }
+    if (!_percentilesIsArray) {
+        return Value(quantile(_percentiles.front()));
+    }
+    std::vector<Value> results;
+    results.reserve(_percentiles.size());
+    for (auto percentile : _percentiles) {
+        results.emplace_back(quantile(percentile));
+    }
+    return Value(std::move(results));
+}
+
+AccumulatorApproxPercentile::AccumulatorApproxPercentile(ExpressionContext* const expCtx,
+                                                         std::vector<double> percentiles,
+                                                         bool percentilesIsArray)
+    : AccumulatorState(expCtx),
+      _percentiles(std::move(percentiles)),
+      _percentilesIsArray(percentilesIsArray) {
+    _buffer.reserve(kBufferSize);
+    _memUsageBytes = sizeof(*this) + _buffer.capacity() * sizeof(Centroid);
+}
+
+intrusive_ptr<AccumulatorState> AccumulatorApproxPercentile::create(
+    ExpressionContext* const expCtx, std::vector<double> percentiles, bool percentilesIsArray) {
+    return new AccumulatorApproxPercentile(expCtx, std::move(percentiles), percentilesIsArray);
+}
+
+void AccumulatorApproxPercentile::reset() {
+    _centroids.clear();
+    _buffer.clear();
+    _totalWeight = 0;
+    _min = 0;
+    _max = 0;
+}
+
+}  // namespace mongo
@@ -0,0 +1,120 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <vector>
+
+#include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/expression_context.h"
+
+namespace mongo {
+
+/**
+ * Estimates percentiles of the numeric input with a merging t-digest (Dunning and Ertl, "Computing
+ * Extremely Accurate Quantiles Using t-Digests"). The digest keeps a bounded number of centroids,
+ * which are small near the extremes and large around the median, so the tails are estimated most
+ * accurately. Partial results carry the centroids, which are merged into the digest like input.
+ *
+ * The syntax is {$approxPercentile: {input: <expression>, p: <number or array of numbers>}}, with
+ * each percentile between 0 and 1. The result is a number, or an array of numbers in the order of
+ * 'p' when 'p' is an array. Non-numeric and non-finite inputs are ignored, as $stdDevPop ignores
+ * non-numeric ones, and the result is null when there is no numeric input.
+ */
+class AccumulatorApproxPercentile final : public AccumulatorState {
+public:
+    static constexpr auto kAccumulatorName = "$approxPercentile"_sd;
+
+    // Bounds the number of centroids, and so the memory used, at the cost of accuracy.
+    static constexpr double kCompression = 100;
+
+    // The number of unmerged values to buffer before folding them into the centroids.
+    static constexpr size_t kBufferSize = 5 * kCompression;
+
+    AccumulatorApproxPercentile(ExpressionContext* const expCtx,
+                                std::vector<double> percentiles,
+                                bool percentilesIsArray);
+
+    static boost::intrusive_ptr<AccumulatorState> create(ExpressionContext* const expCtx,
+                                                         std::vector<double> percentiles,
+                                                         bool percentilesIsArray);
+
+    static AccumulationExpression parse(ExpressionContext* const expCtx,
+                                        BSONElement elem,
+                                        VariablesParseState vps);
+
+    void processInternal(const Value& input, bool merging) final;
+    Value getValue(bool toBeMerged) final;
+    const char* getOpName() const final;
+    void reset() final;
+
+    Document serialize(boost::intrusive_ptr<Expression> initializer,
+                       boost::intrusive_ptr<Expression> argument,
+                       bool explain) const final;
+
+    bool isAssociative() const final {
+        return true;
+    }
+
+    bool isCommutative() const final {
+        return true;
+    }
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    void add(double mean, double weight);
+
+    /**
+     * Merges the buffered values into the centroids.
+     */
+    void compress();
+
+    /**
+     * Returns the estimated value at 'percentile'. Requires a non-empty, compressed digest.
+     */
+    double quantile(double percentile) const;
+
+    const std::vector<double> _percentiles;
+    const bool _percentilesIsArray;
+
+    // Centroids sorted by mean, and the values or centroids added since the last compress().
+    std::vector<Centroid> _centroids;
+    std::vector<Centroid> _buffer;
+    double _totalWeight = 0;
+    double _min = 0;
+    double _max = 0;
+};
+
+}  // namespace mongo
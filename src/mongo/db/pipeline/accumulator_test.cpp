@@ -37,6 +37,7 @@
 #include "mongo/db/exec/document_value/document_value_test_util.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/accumulator_approx_percentile.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
 #include "mongo/dbtests/dbtests.h"
@@ -419,4 +420,148 @@ TEST(AccumulatorMergeObjects, MergingWithEmptyDocumentShouldIgnore) {
     assertExpectedResults<AccumulatorMergeObjects>(&expCtx, {{{first, second}, expected}});
 }
 
+/* ------------------------- Approximate accumulators -------------------------- */
+
+TEST(Accumulators, ApproxCountDistinct) {
+    auto expCtx = ExpressionContextForTest{};
+    assertExpectedResults<AccumulatorApproxCountDistinct>(
+        &expCtx,
+        {
+            // No documents evaluated.
+            {{}, Value(0LL)},
+            // Duplicates are counted once.
+            {{Value(1), Value(2), Value(1)}, Value(2LL)},
+            // Numerically equal values of different types are the same value.
+            {{Value(1), Value(1LL), Value(1.0)}, Value(1LL)},
+            // Null is a value, but missing values are ignored.
+            {{Value(BSONNULL), Value(), Value("a"_sd)}, Value(2LL)},
+        });
+}
+
+TEST(Accumulators, ApproxCountDistinctRespectsCollation) {
+    auto expCtx = ExpressionContextForTest{};
+    auto collator =
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    expCtx.setCollator(std::move(collator));
+    assertExpectedResults<AccumulatorApproxCountDistinct>(
+        &expCtx, {{{Value("a"_sd), Value("b"_sd), Value("c"_sd)}, Value(1LL)}});
+}
+
+TEST(Accumulators, ApproxCountDistinctMergesPartialsWithinTheErrorBound) {
+    auto expCtx = ExpressionContextForTest{};
+    const int numDistinct = 100 * 1000;
+    const int numShards = 4;
+
+    // Each shard sees every value twice and half of the values of its neighbour.
+    auto merger = AccumulatorApproxCountDistinct::create(&expCtx);
+    for (int shard = 0; shard < numShards; ++shard) {
+        auto accum = AccumulatorApproxCountDistinct::create(&expCtx);
+        const int begin = shard * numDistinct / numShards;
+        const int end = std::min(numDistinct, (shard + 1) * numDistinct / numShards + 1000);
+        for (int i = begin; i < end; ++i) {
+            accum->process(Value(i), false);
+            accum->process(Value(i), false);
+        }
+        merger->process(accum->getValue(true), true);
+    }
+
+    // The standard error with 4096 registers is about 1.6%.
+    const auto estimate = merger->getValue(false).getLong();
+    ASSERT_APPROX_EQUAL(estimate, numDistinct, 0.05 * numDistinct);
+    ASSERT_EQUALS(merger->memUsageForSorter(),
+                  AccumulatorApproxCountDistinct::create(&expCtx)->memUsageForSorter());
+}
+
+intrusive_ptr<AccumulatorState> makeApproxPercentile(ExpressionContext* const expCtx,
+                                                     const BSONObj& spec) {
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto statement = AccumulationStatement::parseAccumulationStatement(
+        expCtx, BSON("field" << spec).firstElement(), vps);
+    return statement.makeAccumulator();
+}
+
+TEST(Accumulators, ApproxPercentile) {
+    auto expCtx = ExpressionContextForTest{};
+    const int numValues = 10 * 1000;
+    const auto spec = fromjson("{$approxPercentile: {input: '$x', p: [0, 0.01, 0.5, 0.99, 1]}}");
+    const std::vector<double> expected{0, 100, 5000, 9900, 9999};
+
+    auto checkResult = [&](Value result) {
+        ASSERT_EQUALS(result.getType(), BSONType::Array);
+        ASSERT_EQUALS(result.getArrayLength(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_APPROX_EQUAL(result[i].getDouble(), expected[i], 0.005 * numValues);
+        }
+    };
+
+    // All values on one shard, added in a scrambled order; 7919 is coprime with 'numValues'.
+    auto accum = makeApproxPercentile(&expCtx, spec);
+    for (int i = 0; i < numValues; ++i) {
+        accum->process(Value((i * 7919) % numValues), false);
+    }
+    checkResult(accum->getValue(false));
+
+    // The values spread across several shards, with the partial digests merged.
+    const int numShards = 4;
+    auto merger = makeApproxPercentile(&expCtx, spec);
+    for (int shard = 0; shard < numShards; ++shard) {
+        auto shardAccum = makeApproxPercentile(&expCtx, spec);
+        for (int i = shard; i < numValues; i += numShards) {
+            shardAccum->process(Value((i * 7919) % numValues), false);
+        }
+        merger->process(shardAccum->getValue(true), true);
+    }
+    checkResult(merger->getValue(false));
+}
+
+TEST(Accumulators, ApproxPercentileWithScalarPercentile) {
+    auto expCtx = ExpressionContextForTest{};
+    const auto spec = fromjson("{$approxPercentile: {input: '$x', p: 0.5}}");
+
+    // Non-numeric and non-finite values are ignored.
+    auto accum = makeApproxPercentile(&expCtx, spec);
+    for (auto&& val : {Value(1),
+                       Value(2LL),
+                       Value("a"_sd),
+                       Value(std::numeric_limits<double>::quiet_NaN()),
+                       Value(std::numeric_limits<double>::infinity()),
+                       Value(Decimal128(3))}) {
+        accum->process(val, false);
+    }
+    ASSERT_VALUE_EQ(accum->getValue(false), Value(2.0));
+
+    // With no numeric input the result is null, also after merging.
+    auto empty = makeApproxPercentile(&expCtx, spec);
+    empty->process(Value("a"_sd), false);
+    ASSERT_VALUE_EQ(empty->getValue(false), Value(BSONNULL));
+    auto merger = makeApproxPercentile(&expCtx, spec);
+    merger->process(empty->getValue(true), true);
+    ASSERT_VALUE_EQ(merger->getValue(false), Value(BSONNULL));
+}
+
+TEST(Accumulators, ApproxPercentileSerializesItsArguments) {
+    auto expCtx = ExpressionContextForTest{};
+    VariablesParseState vps = expCtx.variablesParseState;
+    auto spec = fromjson("{field: {$approxPercentile: {p: [0.5, 0.9], input: '$x'}}}");
+    auto statement =
+        AccumulationStatement::parseAccumulationStatement(&expCtx, spec.firstElement(), vps);
+    auto accum = statement.makeAccumulator();
+    ASSERT_DOCUMENT_EQ(
+        accum->serialize(statement.expr.initializer, statement.expr.argument, false),
+        Document(fromjson("{$approxPercentile: {input: '$x', p: [0.5, 0.9]}}")));
+}
+
+TEST(Accumulators, ApproxPercentileRejectsInvalidArguments) {
+    auto expCtx = ExpressionContextForTest{};
+    auto assertFailsToParse = [&](const char* spec, int code) {
+        ASSERT_THROWS_CODE(makeApproxPercentile(&expCtx, fromjson(spec)), AssertionException, code);
+    };
+    assertFailsToParse("{$approxPercentile: '$x'}", 5073304);
+    assertFailsToParse("{$approxPercentile: {input: '$x', p: 0.5, q: 1}}", 5073305);
+    assertFailsToParse("{$approxPercentile: {p: 0.5}}", 5073306);
+    assertFailsToParse("{$approxPercentile: {input: '$x', p: 1.5}}", 5073307);
+    assertFailsToParse("{$approxPercentile: {input: '$x', p: ['a']}}", 5073307);
+    assertFailsToParse("{$approxPercentile: {input: '$x'}}", 5073308);
+}
+
 }  // namespace AccumulatorTests
@@ -31,8 +31,11 @@
 
 #include "mongo/db/pipeline/document_source_bucket_auto.h"
 
+#include <boost/filesystem/operations.hpp>
+
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/util/destructor_guard.h"
 
 namespace mongo {
 
@@ -89,24 +92,30 @@ const char* DocumentSourceBucketAuto::getSourceName() const {
 
 DocumentSource::GetNextResult DocumentSourceBucketAuto::doGetNext() {
     if (!_populated) {
-        const auto populationResult = populateSorter();
+        const auto populationResult = _approximate ? populateSketch() : populateSorter();
         if (populationResult.isPaused()) {
             return populationResult;
         }
         invariant(populationResult.isEOF());
 
-        populateBuckets();
-
+        if (_approximate) {
+            populateApproximateBuckets();
+        } else {
+            invariant(_sorter);
+            _sortedInput.reset(_sorter->done());
+            _sorter.reset();
+            _pendingBucket = populateNextBucket();
+        }
         _populated = true;
-        _bucketsIterator = _buckets.begin();
     }
 
-    if (_bucketsIterator == _buckets.end()) {
+    auto bucket = nextBucket();
+    if (!bucket) {
         dispose();
         return GetNextResult::makeEOF();
     }
 
-    return makeDocument(*(_bucketsIterator++));
+    return makeDocument(*bucket);
 }
 
 boost::intrusive_ptr<DocumentSource> DocumentSourceBucketAuto::optimize() {
@@ -145,23 +154,85 @@ DocumentSource::GetNextResult DocumentSourceBucketAuto::populateSorter() {
             opts.tempDir = pExpCtx->tempDir;
         }
         const auto& valueCmp = pExpCtx->getValueComparator();
-        auto comparator = [valueCmp](const Sorter<Value, Document>::Data& lhs,
-                                     const Sorter<Value, Document>::Data& rhs) {
+        auto comparator = [valueCmp](const Sorter<Value, Value>::Data& lhs,
+                                     const Sorter<Value, Value>::Data& rhs) {
             return valueCmp.compare(lhs.first, rhs.first);
         };
 
-        _sorter.reset(Sorter<Value, Document>::make(opts, comparator));
+        _sorter.reset(Sorter<Value, Value>::make(opts, comparator));
+    }
+
+    // Only the values the accumulators consume are sorted along with each key, rather than the
+    // whole document.
+    auto next = pSource->getNext();
+    for (; next.isAdvanced(); next = pSource->getNext()) {
+        auto nextDoc = next.releaseDocument();
+        _sorter->add(extractKey(nextDoc), extractAccumulatorArguments(nextDoc));
+        _nDocuments++;
+    }
+    _usedDisk = _usedDisk || _sorter->usedDisk();
+    return next;
+}
+
+DocumentSource::GetNextResult DocumentSourceBucketAuto::populateSketch() {
+    if (!_sketch) {
+        _sketch = std::make_unique<KllSketch>(pExpCtx->getValueComparator());
     }
 
+    const auto& valueCmp = pExpCtx->getValueComparator();
     auto next = pSource->getNext();
     for (; next.isAdvanced(); next = pSource->getNext()) {
         auto nextDoc = next.releaseDocument();
-        _sorter->add(extractKey(nextDoc), nextDoc);
+        auto key = extractKey(nextDoc);
+        if (!_minKey || valueCmp.evaluate(key < *_minKey)) {
+            _minKey = key;
+        }
+        if (!_maxKey || valueCmp.evaluate(key > *_maxKey)) {
+            _maxKey = key;
+        }
+        _sketch->add(key);
+
+        auto arguments = extractAccumulatorArguments(nextDoc);
+        _bufferedMemUsageBytes += key.getApproximateSize() + arguments.getApproximateSize();
+        _buffered.emplace_back(std::move(key), std::move(arguments));
         _nDocuments++;
+
+        if (_bufferedMemUsageBytes + _sketch->memUsageBytes() > _maxMemoryUsageBytes) {
+            uassert(ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed,
+                    str::stream() << "$bucketAuto exceeded memory limit of "
+                                  << _maxMemoryUsageBytes
+                                  << " bytes, but did not opt in to external sorting.",
+                    pExpCtx->allowDiskUse && !pExpCtx->inMongos);
+            spillBuffered();
+        }
     }
     return next;
 }
 
+void DocumentSourceBucketAuto::spillBuffered() {
+    if (_buffered.empty()) {
+        return;
+    }
+    _usedDisk = true;
+
+    if (_spillFileName.empty()) {
+        _spillFileName = pExpCtx->tempDir + "/" + nextFileName();
+        _nextSpillFileOffset = 0;
+    }
+
+    // The runs are read back one after another, so they do not need to be in key order.
+    SortedFileWriter<Value, Value> writer(
+        SortOptions().TempDir(pExpCtx->tempDir), _spillFileName, _nextSpillFileOffset);
+    for (auto&& entry : _buffered) {
+        writer.addAlreadySorted(entry.first, entry.second);
+    }
+    _spilledRuns.emplace_back(writer.done());
+    _nextSpillFileOffset = writer.getFileEndOffset();
+
+    _buffered.clear();
+    _bufferedMemUsageBytes = 0;
+}
+
 Value DocumentSourceBucketAuto::extractKey(const Document& doc) {
     if (!_groupByExpression) {
         return Value(BSONNULL);
@@ -193,137 +264,233 @@ Value DocumentSourceBucketAuto::extractKey(const Document& doc) {
     return key.missing() ? Value(BSONNULL) : std::move(key);
 }
 
-void DocumentSourceBucketAuto::addDocumentToBucket(const pair<Value, Document>& entry,
-                                                   Bucket& bucket) {
+Value DocumentSourceBucketAuto::extractAccumulatorArguments(const Document& doc) {
+    std::vector<Value> arguments;
+    arguments.reserve(_accumulatedFields.size());
+    for (auto&& accumulatedField : _accumulatedFields) {
+        arguments.push_back(accumulatedField.expr.argument->evaluate(doc, &pExpCtx->variables));
+    }
+    return Value(std::move(arguments));
+}
+
+DocumentSourceBucketAuto::Bucket DocumentSourceBucketAuto::makeBucket(Value min, Value max) {
+    Bucket bucket(pExpCtx, std::move(min), std::move(max), _accumulatedFields);
+
+    // Evaluate each initializer against an empty document. Normally the initializer can refer to
+    // the group key, but in $bucketAuto there is no single group key per bucket.
+    Document emptyDoc;
+    for (size_t k = 0; k < _accumulatedFields.size(); ++k) {
+        Value initializerValue =
+            _accumulatedFields[k].expr.initializer->evaluate(emptyDoc, &pExpCtx->variables);
+        bucket._accums[k]->startNewGroup(initializerValue);
+    }
+    return bucket;
+}
+
+void DocumentSourceBucketAuto::accumulate(const Value& arguments, Bucket& bucket) {
+    const auto& argumentValues = arguments.getArray();
+    invariant(argumentValues.size() == bucket._accums.size());
+    for (size_t k = 0; k < argumentValues.size(); k++) {
+        bucket._accums[k]->process(argumentValues[k], false);
+    }
+}
+
+void DocumentSourceBucketAuto::addDocumentToBucket(const KeyAndArguments& entry, Bucket& bucket) {
     invariant(pExpCtx->getValueComparator().evaluate(entry.first >= bucket._max));
     bucket._max = entry.first;
+    accumulate(entry.second, bucket);
+}
 
-    const size_t numAccumulators = _accumulatedFields.size();
-    for (size_t k = 0; k < numAccumulators; k++) {
-        bucket._accums[k]->process(
-            _accumulatedFields[k].expr.argument->evaluate(entry.second, &pExpCtx->variables),
-            false);
+boost::optional<DocumentSourceBucketAuto::Bucket> DocumentSourceBucketAuto::nextBucket() {
+    if (_approximate) {
+        if (_bucketsIterator == _buckets.end()) {
+            return boost::none;
+        }
+        return *(_bucketsIterator++);
     }
-}
 
-void DocumentSourceBucketAuto::populateBuckets() {
-    invariant(_sorter);
-    _sortedInput.reset(_sorter->done());
-    _sorter.reset();
+    if (!_pendingBucket) {
+        return boost::none;
+    }
 
-    // If there are no buckets, then we don't need to populate anything.
-    if (_nBuckets == 0) {
-        return;
+    auto bucket = std::move(*_pendingBucket);
+    _pendingBucket = populateNextBucket();
+    if (_pendingBucket) {
+        linkBuckets(bucket, *_pendingBucket);
+    } else if (_granularityRounder) {
+        // If we have a granularity, we round the last bucket's maximum up, so that all of the
+        // bucket boundaries are numbers in the granularity specification.
+        bucket._max = _granularityRounder->roundUp(bucket._max);
     }
 
-    // Calculate the approximate bucket size. We attempt to fill each bucket with this many
-    // documents.
-    long long approxBucketSize = std::round(double(_nDocuments) / double(_nBuckets));
+    if (!_returnedFirstBucket && _granularityRounder) {
+        // Likewise, the first bucket's minimum is rounded down.
+        bucket._min = _granularityRounder->roundDown(bucket._min);
+    }
+    _returnedFirstBucket = true;
+
+    return bucket;
+}
+
+boost::optional<DocumentSourceBucketAuto::Bucket> DocumentSourceBucketAuto::populateNextBucket() {
+    if (_nBucketsPopulated >= _nBuckets) {
+        return boost::none;
+    }
+    const bool isLastBucket = (_nBucketsPopulated == _nBuckets - 1);
+
+    if (_nBucketsPopulated == 0) {
+        // Calculate the approximate bucket size. We attempt to fill each bucket with this many
+        // documents.
+        _approxBucketSize = std::round(double(_nDocuments) / double(_nBuckets));
+
+        if (_approxBucketSize < 1) {
+            // If the number of buckets is larger than the number of documents, then we try to make
+            // as many buckets as possible by placing each document in its own bucket.
+            _approxBucketSize = 1;
+        }
+    }
 
-    if (approxBucketSize < 1) {
-        // If the number of buckets is larger than the number of documents, then we try to make as
-        // many buckets as possible by placing each document in its own bucket.
-        approxBucketSize = 1;
+    // Get the first value to place in this bucket.
+    KeyAndArguments currentValue;
+    if (_firstEntryInNextBucket) {
+        currentValue = std::move(*_firstEntryInNextBucket);
+        _firstEntryInNextBucket = boost::none;
+    } else if (_sortedInput->more()) {
+        currentValue = _sortedInput->next();
+    } else {
+        // No more values to process.
+        return boost::none;
     }
+    ++_nBucketsPopulated;
 
-    boost::optional<pair<Value, Document>> firstEntryInNextBucket;
+    // Initialize the current bucket and add the first value into it.
+    auto currentBucket = makeBucket(currentValue.first, currentValue.first);
+    addDocumentToBucket(currentValue, currentBucket);
 
-    // Start creating and populating the buckets.
-    for (int i = 0; i < _nBuckets; i++) {
-        bool isLastBucket = (i == _nBuckets - 1);
+    if (isLastBucket) {
+        // If this is the last bucket allowed, we need to put any remaining documents in the
+        // current bucket.
+        while (_sortedInput->more()) {
+            addDocumentToBucket(_sortedInput->next(), currentBucket);
+        }
+        return currentBucket;
+    }
 
-        // Get the first value to place in this bucket.
-        pair<Value, Document> currentValue;
-        if (firstEntryInNextBucket) {
-            currentValue = *firstEntryInNextBucket;
-            firstEntryInNextBucket = boost::none;
-        } else if (_sortedInput->more()) {
-            currentValue = _sortedInput->next();
+    // We go to _approxBucketSize - 1 because we already added the first value in order to keep
+    // track of the minimum value.
+    for (long long j = 0; j < _approxBucketSize - 1; j++) {
+        if (_sortedInput->more()) {
+            addDocumentToBucket(_sortedInput->next(), currentBucket);
         } else {
             // No more values to process.
             break;
         }
+    }
 
-        // Initialize the current bucket.
-        Bucket currentBucket(pExpCtx, currentValue.first, currentValue.first, _accumulatedFields);
-
-        // Evaluate each initializer against an empty document. Normally the
-        // initializer can refer to the group key, but in $bucketAuto there is no single
-        // group key per bucket.
-        Document emptyDoc;
-        for (size_t k = 0; k < _accumulatedFields.size(); ++k) {
-            Value initializerValue =
-                _accumulatedFields[k].expr.initializer->evaluate(emptyDoc, &pExpCtx->variables);
-            currentBucket._accums[k]->startNewGroup(initializerValue);
-        }
-
-        // Add the first value into the current bucket.
-        addDocumentToBucket(currentValue, currentBucket);
-
-        if (isLastBucket) {
-            // If this is the last bucket allowed, we need to put any remaining documents in
-            // the current bucket.
-            while (_sortedInput->more()) {
-                addDocumentToBucket(_sortedInput->next(), currentBucket);
-            }
-        } else {
-            // We go to approxBucketSize - 1 because we already added the first value in order
-            // to keep track of the minimum value.
-            for (long long j = 0; j < approxBucketSize - 1; j++) {
-                if (_sortedInput->more()) {
-                    addDocumentToBucket(_sortedInput->next(), currentBucket);
-                } else {
-                    // No more values to process.
-                    break;
-                }
-            }
+    boost::optional<KeyAndArguments> nextValue = _sortedInput->more()
+        ? boost::optional<KeyAndArguments>(_sortedInput->next())
+        : boost::none;
 
-            boost::optional<pair<Value, Document>> nextValue = _sortedInput->more()
-                ? boost::optional<pair<Value, Document>>(_sortedInput->next())
+    if (_granularityRounder) {
+        Value boundaryValue = _granularityRounder->roundUp(currentBucket._max);
+        // If there are any values that now fall into this bucket after we round the boundary,
+        // absorb them into this bucket too.
+        while (nextValue &&
+               pExpCtx->getValueComparator().evaluate(boundaryValue > nextValue->first)) {
+            addDocumentToBucket(*nextValue, currentBucket);
+            nextValue = _sortedInput->more()
+                ? boost::optional<KeyAndArguments>(_sortedInput->next())
                 : boost::none;
-
-            if (_granularityRounder) {
-                Value boundaryValue = _granularityRounder->roundUp(currentBucket._max);
-                // If there are any values that now fall into this bucket after we round the
-                // boundary, absorb them into this bucket too.
-                while (nextValue &&
-                       pExpCtx->getValueComparator().evaluate(boundaryValue > nextValue->first)) {
-                    addDocumentToBucket(*nextValue, currentBucket);
-                    nextValue = _sortedInput->more()
-                        ? boost::optional<pair<Value, Document>>(_sortedInput->next())
-                        : boost::none;
-                }
-                if (nextValue) {
-                    currentBucket._max = boundaryValue;
-                }
-            } else {
-                // If there are any more values that are equal to the boundary value, then absorb
-                // them into the current bucket too.
-                while (nextValue &&
-                       pExpCtx->getValueComparator().evaluate(currentBucket._max ==
-                                                              nextValue->first)) {
-                    addDocumentToBucket(*nextValue, currentBucket);
-                    nextValue = _sortedInput->more()
-                        ? boost::optional<pair<Value, Document>>(_sortedInput->next())
-                        : boost::none;
-                }
-            }
-            firstEntryInNextBucket = nextValue;
         }
+        if (nextValue) {
+            currentBucket._max = boundaryValue;
+        }
+    } else {
+        // If there are any more values that are equal to the boundary value, then absorb them into
+        // the current bucket too.
+        while (nextValue &&
+               pExpCtx->getValueComparator().evaluate(currentBucket._max == nextValue->first)) {
+            addDocumentToBucket(*nextValue, currentBucket);
+            nextValue = _sortedInput->more()
+                ? boost::optional<KeyAndArguments>(_sortedInput->next())
+                : boost::none;
+        }
+    }
+    _firstEntryInNextBucket = std::move(nextValue);
 
-        // Add the current bucket to the vector of buckets.
-        addBucket(currentBucket);
+    return currentBucket;
+}
+
+void DocumentSourceBucketAuto::populateApproximateBuckets() {
+    if (!_sketch || _sketch->empty()) {
+        return;
+    }
+    const auto& valueCmp = pExpCtx->getValueComparator();
+
+    // Estimate the minimum of every bucket but the first from the sketch, dropping the duplicates
+    // that a heavily repeated value produces. With a granularity the boundaries are rounded up, as
+    // the exact mode does with the maximum of each bucket.
+    std::vector<Value> boundaries;
+    for (int i = 1; i < _nBuckets; ++i) {
+        auto boundary = _sketch->quantile(double(i) / _nBuckets);
+        if (_granularityRounder) {
+            boundary = _granularityRounder->roundUp(boundary);
+        }
+        if (valueCmp.evaluate(boundary <= *_minKey) ||
+            (!boundaries.empty() && valueCmp.evaluate(boundary <= boundaries.back()))) {
+            continue;
+        }
+        boundaries.push_back(std::move(boundary));
+    }
+    _sketch.reset();
+
+    std::vector<Bucket> buckets;
+    buckets.reserve(boundaries.size() + 1);
+    buckets.push_back(makeBucket(*_minKey, boundaries.empty() ? *_maxKey : boundaries.front()));
+    for (size_t i = 0; i < boundaries.size(); ++i) {
+        buckets.push_back(
+            makeBucket(boundaries[i], i + 1 < boundaries.size() ? boundaries[i + 1] : *_maxKey));
+    }
+    std::vector<bool> isEmpty(buckets.size(), true);
+
+    auto addToBucket = [&](const KeyAndArguments& entry) {
+        // A document belongs to the last bucket whose minimum is not greater than its key.
+        auto it = std::upper_bound(
+            boundaries.begin(), boundaries.end(), entry.first, valueCmp.getLessThan());
+        const auto idx = std::distance(boundaries.begin(), it);
+        accumulate(entry.second, buckets[idx]);
+        isEmpty[idx] = false;
+    };
+    for (auto&& run : _spilledRuns) {
+        while (run->more()) {
+            addToBucket(run->next());
+        }
     }
+    for (auto&& entry : _buffered) {
+        addToBucket(entry);
+    }
+    _spilledRuns.clear();
+    _buffered.clear();
+    _bufferedMemUsageBytes = 0;
+
+    // A rounded boundary may leave a bucket without documents. Such buckets are left out and the
+    // maximum of the bucket before them is extended to the next minimum.
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (isEmpty[i]) {
+            continue;
+        }
+        if (!_buckets.empty()) {
+            _buckets.back()._max = buckets[i]._min;
+        }
+        _buckets.push_back(std::move(buckets[i]));
+    }
+    _buckets.back()._max = *_maxKey;
 
-    if (!_buckets.empty() && _granularityRounder) {
-        // If we we have a granularity, we round the first bucket's minimum down and the last
-        // bucket's maximum up. This way all of the bucket boundaries are rounded to numbers in the
-        // granularity specification.
-        Bucket& firstBucket = _buckets.front();
-        Bucket& lastBucket = _buckets.back();
-        firstBucket._min = _granularityRounder->roundDown(firstBucket._min);
-        lastBucket._max = _granularityRounder->roundUp(lastBucket._max);
+    if (_granularityRounder) {
+        _buckets.front()._min = _granularityRounder->roundDown(_buckets.front()._min);
+        _buckets.back()._max = _granularityRounder->roundUp(_buckets.back()._max);
     }
+    _bucketsIterator = _buckets.begin();
 }
 
 DocumentSourceBucketAuto::Bucket::Bucket(
@@ -338,35 +505,29 @@ DocumentSourceBucketAuto::Bucket::Bucket(
     }
 }
 
-void DocumentSourceBucketAuto::addBucket(Bucket& newBucket) {
-    if (!_buckets.empty()) {
-        Bucket& previous = _buckets.back();
-        if (_granularityRounder) {
-            // If we have a granularity specified and if there is a bucket that comes before the new
-            // bucket being added, then the new bucket's min boundary is updated to be the
-            // previous bucket's max boundary. This makes it so that bucket boundaries follow the
-            // granularity, have inclusive minimums, and have exclusive maximums.
-
-            double prevMax = previous._max.coerceToDouble();
-            if (prevMax == 0.0) {
-                // Handle the special case where the largest value in the first bucket is zero. In
-                // this case, we take the minimum boundary of the second bucket and round it down.
-                // We then set the maximum boundary of the first bucket to be the rounded down
-                // value. This maintains that the maximum boundary of the first bucket is exclusive
-                // and the minimum boundary of the second bucket is inclusive.
-                previous._max = _granularityRounder->roundDown(newBucket._min);
-            }
-
-            newBucket._min = previous._max;
-        } else {
-            // If there is a bucket that comes before the new bucket being added, then the previous
-            // bucket's max boundary is updated to the new bucket's min. This makes it so that
-            // buckets' min boundaries are inclusive and max boundaries are exclusive (except for
-            // the last bucket, which has an inclusive max).
-            previous._max = newBucket._min;
+void DocumentSourceBucketAuto::linkBuckets(Bucket& previous, Bucket& newBucket) {
+    if (_granularityRounder) {
+        // If we have a granularity specified, then the new bucket's min boundary is updated to be
+        // the previous bucket's max boundary. This makes it so that bucket boundaries follow the
+        // granularity, have inclusive minimums, and have exclusive maximums.
+
+        double prevMax = previous._max.coerceToDouble();
+        if (prevMax == 0.0) {
+            // Handle the special case where the largest value in the first bucket is zero. In this
+            // case, we take the minimum boundary of the second bucket and round it down. We then
+            // set the maximum boundary of the first bucket to be the rounded down value. This
+            // maintains that the maximum boundary of the first bucket is exclusive and the minimum
+            // boundary of the second bucket is inclusive.
+            previous._max = _granularityRounder->roundDown(newBucket._min);
         }
+
+        newBucket._min = previous._max;
+    } else {
+        // The previous bucket's max boundary is updated to the new bucket's min. This makes it so
+        // that buckets' min boundaries are inclusive and max boundaries are exclusive (except for
+        // the last bucket, which has an inclusive max).
+        previous._max = newBucket._min;
     }
-    _buckets.push_back(newBucket);
 }
 
 Document DocumentSourceBucketAuto::makeDocument(const Bucket& bucket) {
@@ -388,8 +549,28 @@ Document DocumentSourceBucketAuto::makeDocument(const Bucket& bucket) {
 }
 
 void DocumentSourceBucketAuto::doDispose() {
+    _sorter.reset();
     _sortedInput.reset();
+    _firstEntryInNextBucket = boost::none;
+    _pendingBucket = boost::none;
+    _sketch.reset();
+    _buffered.clear();
+    _buckets.clear();
     _bucketsIterator = _buckets.end();
+
+    _spilledRuns.clear();
+    if (!_spillFileName.empty()) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_spillFileName));
+        _spillFileName.clear();
+    }
+}
+
+DocumentSourceBucketAuto::~DocumentSourceBucketAuto() {
+    // Release any open file handles before the spill file is removed.
+    _spilledRuns.clear();
+    if (!_spillFileName.empty()) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_spillFileName));
+    }
 }
 
 Value DocumentSourceBucketAuto::serialize(
@@ -403,6 +584,10 @@ Value DocumentSourceBucketAuto::serialize(
         insides["granularity"] = Value(_granularityRounder->getName());
     }
 
+    if (_approximate) {
+        insides["approximate"] = Value(true);
+    }
+
     MutableDocument outputSpec(_accumulatedFields.size());
     for (auto&& accumulatedField : _accumulatedFields) {
         intrusive_ptr<AccumulatorState> accum = accumulatedField.makeAccumulator();
@@ -422,7 +607,8 @@ intrusive_ptr<DocumentSourceBucketAuto> DocumentSourceBucketAuto::create(
     int numBuckets,
     std::vector<AccumulationStatement> accumulationStatements,
     const boost::intrusive_ptr<GranularityRounder>& granularityRounder,
-    uint64_t maxMemoryUsageBytes) {
+    uint64_t maxMemoryUsageBytes,
+    bool approximate) {
     uassert(40243,
             str::stream() << "The $bucketAuto 'buckets' field must be greater than 0, but found: "
                           << numBuckets,
@@ -440,7 +626,8 @@ intrusive_ptr<DocumentSourceBucketAuto> DocumentSourceBucketAuto::create(
                                         numBuckets,
                                         accumulationStatements,
                                         granularityRounder,
-                                        maxMemoryUsageBytes);
+                                        maxMemoryUsageBytes,
+                                        approximate);
 }
 
 DocumentSourceBucketAuto::DocumentSourceBucketAuto(
@@ -449,10 +636,12 @@ DocumentSourceBucketAuto::DocumentSourceBucketAuto(
     int numBuckets,
     std::vector<AccumulationStatement> accumulationStatements,
     const boost::intrusive_ptr<GranularityRounder>& granularityRounder,
-    uint64_t maxMemoryUsageBytes)
+    uint64_t maxMemoryUsageBytes,
+    bool approximate)
     : DocumentSource(kStageName, pExpCtx),
       _nBuckets(numBuckets),
       _maxMemoryUsageBytes(maxMemoryUsageBytes),
+      _approximate(approximate),
       _groupByExpression(groupByExpression),
       _granularityRounder(granularityRounder) {
 
@@ -482,6 +671,7 @@ intrusive_ptr<DocumentSource> DocumentSourceBucketAuto::createFromBson(
     boost::intrusive_ptr<Expression> groupByExpression;
     boost::optional<int> numBuckets;
     boost::intrusive_ptr<GranularityRounder> granularityRounder;
+    bool approximate = false;
 
     for (auto&& argument : elem.Obj()) {
         const auto argName = argument.fieldNameStringData();
@@ -527,6 +717,13 @@ intrusive_ptr<DocumentSource> DocumentSourceBucketAuto::createFromBson(
                         << typeName(argument.type()),
                     argument.type() == BSONType::String);
             granularityRounder = GranularityRounder::getGranularityRounder(pExpCtx, argument.str());
+        } else if ("approximate" == argName) {
+            uassert(5073303,
+                    str::stream()
+                        << "The $bucketAuto 'approximate' field must be a boolean, but found type: "
+                        << typeName(argument.type()),
+                    argument.type() == BSONType::Bool);
+            approximate = argument.boolean();
         } else {
             uasserted(40245, str::stream() << "Unrecognized option to $bucketAuto: " << argName);
         }
@@ -536,8 +733,13 @@ intrusive_ptr<DocumentSource> DocumentSourceBucketAuto::createFromBson(
             "$bucketAuto requires 'groupBy' and 'buckets' to be specified",
             groupByExpression && numBuckets);
 
-    return DocumentSourceBucketAuto::create(
-        pExpCtx, groupByExpression, numBuckets.get(), accumulationStatements, granularityRounder);
+    return DocumentSourceBucketAuto::create(pExpCtx,
+                                            groupByExpression,
+                                            numBuckets.get(),
+                                            accumulationStatements,
+                                            granularityRounder,
+                                            kDefaultMaxMemoryUsageBytes,
+                                            approximate);
 }
 
 }  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/granularity_rounder.h"
+#include "mongo/db/pipeline/kll_sketch.h"
 #include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
@@ -41,6 +42,11 @@ namespace mongo {
 /**
  * The $bucketAuto stage takes a user-specified number of buckets and automatically determines
  * boundaries such that the values are approximately equally distributed between those buckets.
+ *
+ * By default the input is sorted by its 'groupBy' value, which may spill to disk, and the buckets
+ * are cut from the sorted stream one at a time. With 'approximate: true' the stage skips the sort:
+ * it estimates the boundaries from a KLL quantile sketch built while the input is buffered, and
+ * then drops each buffered document into its bucket with a binary search.
  */
 class DocumentSourceBucketAuto final : public DocumentSource {
 public:
@@ -84,7 +90,8 @@ public:
         int numBuckets,
         std::vector<AccumulationStatement> accumulationStatements = {},
         const boost::intrusive_ptr<GranularityRounder>& granularityRounder = nullptr,
-        uint64_t maxMemoryUsageBytes = kDefaultMaxMemoryUsageBytes);
+        uint64_t maxMemoryUsageBytes = kDefaultMaxMemoryUsageBytes,
+        bool approximate = false);
 
     /**
      * Parses a $bucketAuto stage from the user-supplied BSON.
@@ -95,6 +102,10 @@ public:
     const boost::intrusive_ptr<Expression> getGroupByExpression() const;
     const std::vector<AccumulationStatement>& getAccumulatedFields() const;
 
+    bool usedDisk() final {
+        return _usedDisk;
+    }
+
 protected:
     GetNextResult doGetNext() final;
     void doDispose() final;
@@ -105,7 +116,14 @@ private:
                              int numBuckets,
                              std::vector<AccumulationStatement> accumulationStatements,
                              const boost::intrusive_ptr<GranularityRounder>& granularityRounder,
-                             uint64_t maxMemoryUsageBytes);
+                             uint64_t maxMemoryUsageBytes,
+                             bool approximate);
+
+    ~DocumentSourceBucketAuto();
+
+    // The 'groupBy' value of an input document paired with an array of the values of the
+    // accumulator arguments evaluated against it. This is all that is kept of each document.
+    using KeyAndArguments = std::pair<Value, Value>;
 
     // struct for holding information about a bucket.
     struct Bucket {
@@ -126,25 +144,66 @@ private:
      */
     GetNextResult populateSorter();
 
+    /**
+     * Like populateSorter(), but for the approximate mode: adds the 'groupBy' value of every input
+     * document to the quantile sketch and buffers the documents unsorted, spilling the buffer to
+     * disk if it grows beyond the memory limit.
+     */
+    GetNextResult populateSketch();
+
     /**
      * Computes the 'groupBy' expression value for 'doc'.
      */
     Value extractKey(const Document& doc);
 
     /**
-     * Calculates the bucket boundaries for the input documents and places them into buckets.
+     * Evaluates the argument of every accumulator against 'doc' and returns the results in an
+     * array, in the order of '_accumulatedFields'.
      */
-    void populateBuckets();
+    Value extractAccumulatorArguments(const Document& doc);
+
+    /**
+     * Returns the next bucket to be output, or boost::none once all of the buckets were returned.
+     */
+    boost::optional<Bucket> nextBucket();
+
+    /**
+     * Cuts the next bucket from the sorted input. The boundaries of the returned bucket are not
+     * final until the bucket after it is known, see linkBuckets().
+     */
+    boost::optional<Bucket> populateNextBucket();
+
+    /**
+     * Computes the bucket boundaries from the quantile sketch and places all of the buffered
+     * documents into the buckets.
+     */
+    void populateApproximateBuckets();
+
+    /**
+     * Writes the buffered documents to the spill file and empties the buffer.
+     */
+    void spillBuffered();
+
+    /**
+     * Creates an empty bucket with the given boundaries and initialized accumulators.
+     */
+    Bucket makeBucket(Value min, Value max);
 
     /**
      * Adds the document in 'entry' to 'bucket' by updating the accumulators in 'bucket'.
      */
-    void addDocumentToBucket(const std::pair<Value, Document>& entry, Bucket& bucket);
+    void addDocumentToBucket(const KeyAndArguments& entry, Bucket& bucket);
 
     /**
-     * Adds 'newBucket' to _buckets and updates any boundaries if necessary.
+     * Feeds the accumulator arguments of a document to the accumulators of 'bucket'.
      */
-    void addBucket(Bucket& newBucket);
+    void accumulate(const Value& arguments, Bucket& bucket);
+
+    /**
+     * Adjusts the boundaries of the adjacent buckets 'previous' and 'next' so that the maximum of
+     * 'previous' is the minimum of 'next'.
+     */
+    void linkBuckets(Bucket& previous, Bucket& next);
 
     /**
      * Makes a document using the information from bucket. This is what is returned when getNext()
@@ -152,19 +211,40 @@ private:
      */
     Document makeDocument(const Bucket& bucket);
 
-    std::unique_ptr<Sorter<Value, Document>> _sorter;
-    std::unique_ptr<Sorter<Value, Document>::Iterator> _sortedInput;
+    std::unique_ptr<Sorter<Value, Value>> _sorter;
+    std::unique_ptr<Sorter<Value, Value>::Iterator> _sortedInput;
 
     std::vector<AccumulationStatement> _accumulatedFields;
 
     int _nBuckets;
     uint64_t _maxMemoryUsageBytes;
+    bool _approximate;
     bool _populated = false;
-    std::vector<Bucket> _buckets;
-    std::vector<Bucket>::iterator _bucketsIterator;
+    bool _usedDisk = false;
     boost::intrusive_ptr<Expression> _groupByExpression;
     boost::intrusive_ptr<GranularityRounder> _granularityRounder;
     long long _nDocuments = 0;
+
+    // State for cutting the buckets from the sorted input. The bucket which is returned next is
+    // held back until the bucket after it has been cut, because that may move their boundary.
+    long long _approxBucketSize = 0;
+    int _nBucketsPopulated = 0;
+    boost::optional<KeyAndArguments> _firstEntryInNextBucket;
+    boost::optional<Bucket> _pendingBucket;
+    bool _returnedFirstBucket = false;
+
+    // State for the approximate mode. The documents are buffered in '_buffered' and, once it
+    // exceeds the memory limit, appended to the spill file as unsorted runs.
+    std::unique_ptr<KllSketch> _sketch;
+    boost::optional<Value> _minKey;
+    boost::optional<Value> _maxKey;
+    std::vector<KeyAndArguments> _buffered;
+    size_t _bufferedMemUsageBytes = 0;
+    std::string _spillFileName;
+    std::streampos _nextSpillFileOffset = 0;
+    std::vector<std::unique_ptr<Sorter<Value, Value>::Iterator>> _spilledRuns;
+    std::vector<Bucket> _buckets;
+    std::vector<Bucket>::iterator _bucketsIterator;
 };
 
 }  // namespace mongo
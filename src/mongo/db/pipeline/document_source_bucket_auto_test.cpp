@@ -349,6 +349,23 @@ TEST_F(BucketAutoTests, ShouldPropagatePauses) {
     ASSERT_TRUE(bucketAutoStage->getNext().isEOF());
 }
 
+/**
+ * Returns the accumulators for the 'output' specification
+ * {count: {$sum: 1}, largeStr: {$max: '$largeStr'}}. The stage only buffers the values its
+ * accumulators read, so the tests which need it to exceed its memory limit accumulate the large
+ * strings in their input.
+ */
+vector<AccumulationStatement> countAndLargeStrOutput(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx) {
+    VariablesParseState vps = expCtx->variablesParseState;
+    vector<AccumulationStatement> accumulationStatements;
+    for (auto&& elem : fromjson("{count: {$sum: 1}, largeStr: {$max: '$largeStr'}}")) {
+        accumulationStatements.push_back(
+            AccumulationStatement::parseAccumulationStatement(expCtx.get(), elem, vps));
+    }
+    return accumulationStatements;
+}
+
 TEST_F(BucketAutoTests, ShouldBeAbleToCorrectlySpillToDisk) {
     auto expCtx = getExpCtx();
     unittest::TempDir tempDir("DocumentSourceBucketAutoTest");
@@ -360,8 +377,12 @@ TEST_F(BucketAutoTests, ShouldBeAbleToCorrectlySpillToDisk) {
     auto groupByExpression = ExpressionFieldPath::parse(expCtx.get(), "$a", vps);
 
     const int numBuckets = 2;
-    auto bucketAutoStage = DocumentSourceBucketAuto::create(
-        expCtx, groupByExpression, numBuckets, {}, nullptr, maxMemoryUsageBytes);
+    auto bucketAutoStage = DocumentSourceBucketAuto::create(expCtx,
+                                                            groupByExpression,
+                                                            numBuckets,
+                                                            countAndLargeStrOutput(expCtx),
+                                                            nullptr,
+                                                            maxMemoryUsageBytes);
 
     string largeStr(maxMemoryUsageBytes, 'x');
     auto mock = DocumentSourceMock::createForTest({Document{{"a", 0}, {"largeStr", largeStr}},
@@ -374,12 +395,16 @@ TEST_F(BucketAutoTests, ShouldBeAbleToCorrectlySpillToDisk) {
     auto next = bucketAutoStage->getNext();
     ASSERT_TRUE(next.isAdvanced());
     ASSERT_DOCUMENT_EQ(next.releaseDocument(),
-                       (Document{{"_id", Document{{"min", 0}, {"max", 2}}}, {"count", 2}}));
+                       (Document{{"_id", Document{{"min", 0}, {"max", 2}}},
+                                 {"count", 2},
+                                 {"largeStr", largeStr}}));
 
     next = bucketAutoStage->getNext();
     ASSERT_TRUE(next.isAdvanced());
     ASSERT_DOCUMENT_EQ(next.releaseDocument(),
-                       (Document{{"_id", Document{{"min", 2}, {"max", 3}}}, {"count", 2}}));
+                       (Document{{"_id", Document{{"min", 2}, {"max", 3}}},
+                                 {"count", 2},
+                                 {"largeStr", largeStr}}));
 
     ASSERT_TRUE(bucketAutoStage->getNext().isEOF());
 }
@@ -397,8 +422,12 @@ TEST_F(BucketAutoTests, ShouldBeAbleToPauseLoadingWhileSpilled) {
     auto groupByExpression = ExpressionFieldPath::parse(expCtx.get(), "$a", vps);
 
     const int numBuckets = 2;
-    auto bucketAutoStage = DocumentSourceBucketAuto::create(
-        expCtx, groupByExpression, numBuckets, {}, nullptr, maxMemoryUsageBytes);
+    auto bucketAutoStage = DocumentSourceBucketAuto::create(expCtx,
+                                                            groupByExpression,
+                                                            numBuckets,
+                                                            countAndLargeStrOutput(expCtx),
+                                                            nullptr,
+                                                            maxMemoryUsageBytes);
     auto sort = DocumentSourceSort::create(expCtx, BSON("_id" << -1), 0, maxMemoryUsageBytes);
 
     string largeStr(maxMemoryUsageBytes, 'x');
@@ -421,12 +450,16 @@ TEST_F(BucketAutoTests, ShouldBeAbleToPauseLoadingWhileSpilled) {
     auto next = bucketAutoStage->getNext();
     ASSERT_TRUE(next.isAdvanced());
     ASSERT_DOCUMENT_EQ(next.releaseDocument(),
-                       (Document{{"_id", Document{{"min", 0}, {"max", 2}}}, {"count", 2}}));
+                       (Document{{"_id", Document{{"min", 0}, {"max", 2}}},
+                                 {"count", 2},
+                                 {"largeStr", largeStr}}));
 
     next = bucketAutoStage->getNext();
     ASSERT_TRUE(next.isAdvanced());
     ASSERT_DOCUMENT_EQ(next.releaseDocument(),
-                       (Document{{"_id", Document{{"min", 2}, {"max", 3}}}, {"count", 2}}));
+                       (Document{{"_id", Document{{"min", 2}, {"max", 3}}},
+                                 {"count", 2},
+                                 {"largeStr", largeStr}}));
 
     ASSERT_TRUE(bucketAutoStage->getNext().isEOF());
 }
@@ -509,6 +542,15 @@ TEST_F(BucketAutoTests, SerializesGranularityFieldIfSpecified) {
     testSerialize(spec, expected);
 }
 
+TEST_F(BucketAutoTests, SerializesApproximateFieldIfSpecified) {
+    BSONObj spec = fromjson("{$bucketAuto : {groupBy : '$x', buckets : 2, approximate : true}}");
+    BSONObj expected = fromjson(
+        "{groupBy : '$x', buckets : 2, approximate : true, output : {count : {$sum : {$const : "
+        "1}}}}");
+
+    testSerialize(spec, expected);
+}
+
 TEST_F(BucketAutoTests, ShouldBeAbleToReParseSerializedStage) {
     auto bucketAuto =
         createBucketAuto(fromjson("{$bucketAuto : {groupBy : '$x', buckets : 2, granularity: 'R5', "
@@ -598,6 +640,11 @@ TEST_F(BucketAutoTests, FailsWithUnknownField) {
     ASSERT_THROWS_CODE(createBucketAuto(spec), AssertionException, 40245);
 }
 
+TEST_F(BucketAutoTests, FailsWithNonBoolApproximate) {
+    BSONObj spec = fromjson("{$bucketAuto : {groupBy : '$x', buckets : 2, approximate : 1}}");
+    ASSERT_THROWS_CODE(createBucketAuto(spec), AssertionException, 5073303);
+}
+
 TEST_F(BucketAutoTests, FailsWithInvalidExpressionToAccumulator) {
     auto spec = fromjson(
         "{$bucketAuto : {groupBy : '$x', buckets : 1, output : {avg : {$avg : ['$x', 1]}}}}");
@@ -639,8 +686,12 @@ void assertCannotSpillToDisk(const boost::intrusive_ptr<ExpressionContext>& expC
     auto groupByExpression = ExpressionFieldPath::parse(expCtx.get(), "$a", vps);
 
     const int numBuckets = 2;
-    auto bucketAutoStage = DocumentSourceBucketAuto::create(
-        expCtx, groupByExpression, numBuckets, {}, nullptr, maxMemoryUsageBytes);
+    auto bucketAutoStage = DocumentSourceBucketAuto::create(expCtx,
+                                                            groupByExpression,
+                                                            numBuckets,
+                                                            countAndLargeStrOutput(expCtx),
+                                                            nullptr,
+                                                            maxMemoryUsageBytes);
 
     string largeStr(maxMemoryUsageBytes, 'x');
     auto mock = DocumentSourceMock::createForTest(
@@ -678,8 +729,12 @@ TEST_F(BucketAutoTests, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     auto groupByExpression = ExpressionFieldPath::parse(expCtx.get(), "$a", vps);
 
     const int numBuckets = 2;
-    auto bucketAutoStage = DocumentSourceBucketAuto::create(
-        expCtx, groupByExpression, numBuckets, {}, nullptr, maxMemoryUsageBytes);
+    auto bucketAutoStage = DocumentSourceBucketAuto::create(expCtx,
+                                                            groupByExpression,
+                                                            numBuckets,
+                                                            countAndLargeStrOutput(expCtx),
+                                                            nullptr,
+                                                            maxMemoryUsageBytes);
 
     string largeStr(maxMemoryUsageBytes / 2, 'x');
     auto mock =
@@ -815,5 +870,110 @@ TEST_F(BucketAutoTests, ShouldFailOnNegativeNumbersWhenGranularitySpecified) {
         AssertionException,
         40260);
 }
+
+TEST_F(BucketAutoTests, ApproximateModeReturnsEvenlySizedBuckets) {
+    auto bucketAutoSpec =
+        fromjson("{$bucketAuto : {groupBy : '$x', buckets : 4, approximate : true}}");
+    deque<Document> inputs;
+    for (int i = 99; i >= 0; --i) {
+        inputs.push_back(Document{{"x", i}});
+    }
+
+    auto results = getResults(bucketAutoSpec, std::move(inputs));
+    ASSERT_EQUALS(results.size(), 4UL);
+    ASSERT_DOCUMENT_EQ(results[0], Document(fromjson("{_id : {min : 0, max : 25}, count : 25}")));
+    ASSERT_DOCUMENT_EQ(results[1], Document(fromjson("{_id : {min : 25, max : 50}, count : 25}")));
+    ASSERT_DOCUMENT_EQ(results[2], Document(fromjson("{_id : {min : 50, max : 75}, count : 25}")));
+    ASSERT_DOCUMENT_EQ(results[3], Document(fromjson("{_id : {min : 75, max : 99}, count : 25}")));
+}
+
+TEST_F(BucketAutoTests, ApproximateModeKeepsDuplicatesInOneBucket) {
+    auto bucketAutoSpec =
+        fromjson("{$bucketAuto : {groupBy : '$x', buckets : 3, approximate : true}}");
+    deque<Document> inputs;
+    for (int i = 0; i < 10; ++i) {
+        inputs.push_back(Document{{"x", 1}});
+    }
+    inputs.push_back(Document{{"x", 2}});
+
+    // Both interior boundaries land on the repeated value, so only two buckets are returned.
+    auto results = getResults(bucketAutoSpec, std::move(inputs));
+    ASSERT_EQUALS(results.size(), 2UL);
+    ASSERT_DOCUMENT_EQ(results[0], Document(fromjson("{_id : {min : 1, max : 2}, count : 10}")));
+    ASSERT_DOCUMENT_EQ(results[1], Document(fromjson("{_id : {min : 2, max : 2}, count : 1}")));
+}
+
+TEST_F(BucketAutoTests, ApproximateModeShouldBeAbleToSpillToDisk) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceBucketAutoTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 1000;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx.get(), "$a", vps);
+
+    const int numBuckets = 2;
+    auto bucketAutoStage = DocumentSourceBucketAuto::create(expCtx,
+                                                            groupByExpression,
+                                                            numBuckets,
+                                                            countAndLargeStrOutput(expCtx),
+                                                            nullptr,
+                                                            maxMemoryUsageBytes,
+                                                            true);
+
+    string largeStr(maxMemoryUsageBytes, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"a", 3}, {"largeStr", largeStr}},
+                                                   Document{{"a", 1}, {"largeStr", largeStr}},
+                                                   Document{{"a", 2}, {"largeStr", largeStr}},
+                                                   Document{{"a", 0}, {"largeStr", largeStr}}},
+                                                  expCtx);
+    bucketAutoStage->setSource(mock.get());
+
+    auto next = bucketAutoStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"_id", Document{{"min", 0}, {"max", 2}}},
+                                 {"count", 2},
+                                 {"largeStr", largeStr}}));
+
+    next = bucketAutoStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"_id", Document{{"min", 2}, {"max", 3}}},
+                                 {"count", 2},
+                                 {"largeStr", largeStr}}));
+
+    ASSERT_TRUE(bucketAutoStage->getNext().isEOF());
+    ASSERT_TRUE(bucketAutoStage->usedDisk());
+}
+
+TEST_F(BucketAutoTests, ApproximateModeShouldFailIfBufferingTooMuchWithoutDiskUse) {
+    auto expCtx = getExpCtx();
+    expCtx->allowDiskUse = false;
+    const size_t maxMemoryUsageBytes = 1000;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx.get(), "$a", vps);
+
+    const int numBuckets = 2;
+    auto bucketAutoStage = DocumentSourceBucketAuto::create(expCtx,
+                                                            groupByExpression,
+                                                            numBuckets,
+                                                            countAndLargeStrOutput(expCtx),
+                                                            nullptr,
+                                                            maxMemoryUsageBytes,
+                                                            true);
+
+    string largeStr(maxMemoryUsageBytes, 'x');
+    auto mock = DocumentSourceMock::createForTest(
+        {Document{{"a", 0}, {"largeStr", largeStr}}, Document{{"a", 1}, {"largeStr", largeStr}}},
+        expCtx);
+    bucketAutoStage->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(bucketAutoStage->getNext(),
+                       AssertionException,
+                       ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed);
+}
 }  // namespace
 }  // namespace mongo
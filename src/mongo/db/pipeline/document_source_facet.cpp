@@ -38,8 +38,10 @@
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/bsontypes.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_tee_consumer.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/field_path.h"
@@ -150,13 +152,24 @@ DocumentSource::GetNextResult DocumentSourceFacet::doGetNext() {
         return GetNextResult::makeEOF();
     }
 
+    // Account for the output of each facet separately, so that an error can point at the facet
+    // responsible for the bulk of the output document.
     const size_t maxBytes = _maxOutputDocSizeBytes;
-    auto ensureUnderMemoryLimit = [usedBytes = 0ul, &maxBytes](long long additional) mutable {
+    vector<size_t> facetUsedBytes(_facets.size(), 0);
+    auto ensureUnderMemoryLimit = [&, usedBytes = 0ul](size_t facetId,
+                                                        long long additional) mutable {
         usedBytes += additional;
-        uassert(4031700,
-                str::stream() << "document constructed by $facet is " << usedBytes
-                              << " bytes, which exceeds the limit of " << maxBytes << " bytes",
-                usedBytes <= maxBytes);
+        facetUsedBytes[facetId] += additional;
+        if (MONGO_likely(usedBytes <= maxBytes)) {
+            return;
+        }
+        auto largest = std::max_element(facetUsedBytes.begin(), facetUsedBytes.end());
+        uasserted(4031700,
+                  str::stream() << "document constructed by $facet is " << usedBytes
+                                << " bytes, which exceeds the limit of " << maxBytes
+                                << " bytes. The largest facet, '"
+                                << _facets[largest - facetUsedBytes.begin()].name << "', is "
+                                << *largest << " bytes");
     };
 
     vector<vector<Value>> results(_facets.size());
@@ -167,7 +180,7 @@ DocumentSource::GetNextResult DocumentSourceFacet::doGetNext() {
             const auto& pipeline = _facets[facetId].pipeline;
             auto next = pipeline->getSources().back()->getNext();
             for (; next.isAdvanced(); next = pipeline->getSources().back()->getNext()) {
-                ensureUnderMemoryLimit(next.getDocument().getApproximateSize());
+                ensureUnderMemoryLimit(facetId, next.getDocument().getApproximateSize());
                 results[facetId].emplace_back(next.releaseDocument());
             }
             allPipelinesEOF = allPipelinesEOF && next.isEOF();
@@ -183,6 +196,43 @@ DocumentSource::GetNextResult DocumentSourceFacet::doGetNext() {
     return resultDoc.freeze();
 }
 
+Pipeline::SourceContainer::iterator DocumentSourceFacet::doOptimizeAt(
+    Pipeline::SourceContainer::iterator itr, Pipeline::SourceContainer* container) {
+    invariant(*itr == this);
+
+    boost::intrusive_ptr<DocumentSourceMatch> commonMatch;
+    for (auto&& facet : _facets) {
+        // Each sub-pipeline begins with the $teeConsumer that feeds it from '_teeBuffer'.
+        const auto& sources = facet.pipeline->getSources();
+        if (sources.size() < 2) {
+            return std::next(itr);
+        }
+
+        auto match = dynamic_cast<DocumentSourceMatch*>(std::next(sources.begin())->get());
+        if (!match || match->getSourceName() != DocumentSourceMatch::kStageName) {
+            return std::next(itr);
+        }
+
+        if (!commonMatch) {
+            commonMatch = match;
+        } else if (SimpleBSONObjComparator::kInstance.evaluate(commonMatch->getQuery() !=
+                                                               match->getQuery())) {
+            return std::next(itr);
+        }
+    }
+
+    for (auto&& facet : _facets) {
+        auto teeConsumer = facet.pipeline->popFront();
+        facet.pipeline->popFront();
+        facet.pipeline->addInitialSource(std::move(teeConsumer));
+    }
+
+    // The stage before the hoisted $match may be able to optimize further, if there is such a
+    // stage.
+    auto matchItr = container->insert(itr, std::move(commonMatch));
+    return matchItr == container->begin() ? matchItr : std::prev(matchItr);
+}
+
 Value DocumentSourceFacet::serialize(boost::optional<ExplainOptions::Verbosity> explain) const {
     MutableDocument serialized;
     for (auto&& facet : _facets) {
@@ -149,6 +149,14 @@ protected:
     GetNextResult doGetNext() final;
     void doDispose() final;
 
+    /**
+     * If every sub-pipeline begins with the same $match, moves that $match in front of this stage
+     * so that it is evaluated once over the shared input, and can potentially be pushed down into
+     * the query layer, rather than once per facet.
+     */
+    Pipeline::SourceContainer::iterator doOptimizeAt(Pipeline::SourceContainer::iterator itr,
+                                                     Pipeline::SourceContainer* container) final;
+
 private:
     DocumentSourceFacet(std::vector<FacetPipeline> facetPipelines,
                         const boost::intrusive_ptr<ExpressionContext>& expCtx,
@@ -563,6 +563,37 @@ TEST_F(DocumentSourceFacetTest, ShouldOptimizeInnerPipelines) {
     ASSERT_TRUE(dummy->isOptimized);
 }
 
+TEST_F(DocumentSourceFacetTest, ShouldHoistMatchSharedByAllFacets) {
+    auto ctx = getExpCtx();
+    auto pipeline = Pipeline::parse({fromjson("{$facet: {"
+                                              "  a: [{$match: {x: 1}}, {$limit: 1}],"
+                                              "  b: [{$match: {x: 1}}, {$skip: 1}]"
+                                              "}}")},
+                                    ctx);
+    pipeline->optimizePipeline();
+
+    auto serialized = pipeline->serializeToBson();
+    ASSERT_EQ(serialized.size(), 2UL);
+    ASSERT_BSONOBJ_EQ(serialized[0], fromjson("{$match: {x: 1}}"));
+    ASSERT_BSONOBJ_EQ(serialized[1], fromjson("{$facet: {a: [{$limit: 1}], b: [{$skip: 1}]}}"));
+}
+
+TEST_F(DocumentSourceFacetTest, ShouldNotHoistMatchUnlessAllFacetsShareIt) {
+    auto ctx = getExpCtx();
+    const auto facetSpec = fromjson(
+        "{$facet: {"
+        "  a: [{$match: {x: 1}}, {$limit: 1}],"
+        "  b: [{$match: {x: 2}}, {$skip: 1}],"
+        "  c: [{$match: {x: 1}}]"
+        "}}");
+    auto pipeline = Pipeline::parse({facetSpec}, ctx);
+    pipeline->optimizePipeline();
+
+    auto serialized = pipeline->serializeToBson();
+    ASSERT_EQ(serialized.size(), 1UL);
+    ASSERT_BSONOBJ_EQ(serialized[0], facetSpec);
+}
+
 TEST_F(DocumentSourceFacetTest, ShouldPropagateDetachingAndReattachingOfOpCtx) {
     auto ctx = getExpCtx();
     // We're going to be changing the OperationContext, so we need to use a MongoProcessInterface
@@ -31,6 +31,7 @@
 
 #include "mongo/db/pipeline/document_source_graph_lookup.h"
 
+#include <boost/filesystem/operations.hpp>
 #include <memory>
 
 #include "mongo/base/init.h"
@@ -44,6 +45,7 @@
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner_common.h"
+#include "mongo/util/destructor_guard.h"
 
 namespace mongo {
 
@@ -51,6 +53,55 @@ namespace {
 bool foreignShardedLookupAllowed() {
     return getTestCommandsEnabled() && internalQueryAllowShardedLookup.load();
 }
+
+/**
+ * Generates a new file name on each call using a static, atomic and monotonically increasing
+ * number. See the comment on nextFileName() in document_source_group.cpp.
+ */
+std::string nextFileName() {
+    static AtomicWord<unsigned> documentSourceGraphLookUpFileCounter;
+    return "extsort-doc-graph-lookup." +
+        std::to_string(documentSourceGraphLookUpFileCounter.fetchAndAdd(1));
+}
+
+/**
+ * Orders spilled (_id, document) pairs by _id. Like '_visited', this uses the simple collation.
+ */
+class SpilledIdComparator {
+public:
+    int operator()(const std::pair<Value, Value>& lhs, const std::pair<Value, Value>& rhs) const {
+        return ValueComparator::kInstance.compare(lhs.first, rhs.first);
+    }
+};
+
+// The number of bits set in the spilled ids Bloom filter for each id. With the filter sized at
+// 1/32 of the memory limit, this keeps the false positive rate around 2% until the spilled ids
+// outnumber the filter's bits by a factor of eight.
+const size_t kSpilledIdsFilterNumHashes = 4;
+
+/**
+ * Invokes 'callback' with the position of each bit corresponding to 'id' in a Bloom filter of
+ * 'numBits' bits. The positions are derived from a single hash of 'id' by double hashing.
+ */
+template <typename Callback>
+void forEachSpilledIdsFilterBit(const Value& id, size_t numBits, Callback callback) {
+    size_t hash = 0;
+    id.hash_combine(hash, nullptr);
+
+    // Derive the stride with the MurmurHash3 finalizer, forcing it to be odd so that it cannot
+    // share a factor of two with the power of two sized filter.
+    uint64_t stride = hash;
+    stride ^= stride >> 33;
+    stride *= 0xff51afd7ed558ccdULL;
+    stride ^= stride >> 33;
+    stride *= 0xc4ceb9fe1a85ec53ULL;
+    stride ^= stride >> 33;
+    stride |= 1;
+
+    for (size_t i = 0; i < kSpilledIdsFilterNumHashes; ++i) {
+        callback((hash + i * stride) % numBits);
+    }
+}
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -106,11 +157,9 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::doGetNext() {
     performSearch();
 
     std::vector<Value> results;
-    while (!_visited.empty()) {
-        // Remove elements one at a time to avoid consuming more memory.
-        auto it = _visited.begin();
-        results.push_back(Value(it->second));
-        _visited.erase(it);
+    // Remove elements one at a time to avoid consuming more memory.
+    while (auto result = popNextResult()) {
+        results.push_back(Value(std::move(*result)));
     }
 
     MutableDocument output(*_input);
@@ -118,7 +167,7 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::doGetNext() {
 
     _visitedUsageBytes = 0;
 
-    invariant(_visited.empty());
+    invariant(!hasMoreResults());
 
     return output.freeze();
 }
@@ -129,7 +178,7 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
     // If the unwind is not preserving empty arrays, we might have to process multiple inputs before
     // we get one that will produce an output.
     while (true) {
-        if (_visited.empty()) {
+        if (!hasMoreResults()) {
             // No results are left for the current input, so we should move on to the next one and
             // perform a new search.
 
@@ -145,7 +194,8 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
         }
         MutableDocument unwound(*_input);
 
-        if (_visited.empty()) {
+        auto result = popNextResult();
+        if (!result) {
             if ((*_unwind)->preserveNullAndEmptyArrays()) {
                 // Since "preserveNullAndEmptyArrays" was specified, output a document even though
                 // we had no result.
@@ -159,13 +209,11 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
                 continue;
             }
         } else {
-            auto it = _visited.begin();
-            unwound.setNestedField(_as, Value(it->second));
+            unwound.setNestedField(_as, Value(std::move(*result)));
             if (indexPath) {
                 unwound.setNestedField(*indexPath, Value(_outputIndex));
                 ++_outputIndex;
             }
-            _visited.erase(it);
         }
 
         return unwound.freeze();
@@ -176,6 +224,15 @@ void DocumentSourceGraphLookUp::doDispose() {
     _cache.clear();
     _frontier.clear();
     _visited.clear();
+    _unconfirmedVisits.clear();
+    _spilledResults.reset();
+    discardSpilledVisited();
+}
+
+DocumentSourceGraphLookUp::~DocumentSourceGraphLookUp() {
+    // Release any open file handles before the spill file is removed.
+    _spilledResults.reset();
+    discardSpilledVisited();
 }
 
 void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
@@ -233,6 +290,8 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
             checkMemoryUsage();
         }
 
+        shouldPerformAnotherQuery = resolveUnconfirmedVisits(depth) || shouldPerformAnotherQuery;
+
         ++depth;
     } while (shouldPerformAnotherQuery && depth < std::numeric_limits<long long>::max() &&
              (!_maxDepth || depth <= *_maxDepth));
@@ -249,6 +308,23 @@ bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long lo
         return false;
     }
 
+    if (mayHaveSpilledId(id)) {
+        // We may have seen this object before it was spilled. Defer the decision until we can
+        // check all such objects against the spilled runs at once.
+        _unconfirmedVisitsUsageBytes += result.getApproximateSize();
+        _unconfirmedVisits.push_back(std::move(result));
+        return false;
+    }
+
+    insertIntoVisitedAndFrontier(std::move(result), depth);
+
+    // We inserted into _visited, so return true.
+    return true;
+}
+
+void DocumentSourceGraphLookUp::insertIntoVisitedAndFrontier(Document result, long long depth) {
+    auto id = result.getField("_id");
+
     // We have not seen this node before. If '_depthField' was specified, add the field to the
     // object.
     if (_depthField) {
@@ -271,9 +347,166 @@ bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long lo
     _visitedUsageBytes += result.getApproximateSize();
 
     _visited[id] = std::move(result);
+}
 
-    // We inserted into _visited, so return true.
-    return true;
+bool DocumentSourceGraphLookUp::mayHaveSpilledId(const Value& id) const {
+    if (_spilledIdsFilter.empty()) {
+        return false;
+    }
+
+    bool mayHaveSpilled = true;
+    forEachSpilledIdsFilterBit(id, _spilledIdsFilter.size() * 64, [&](size_t bit) {
+        mayHaveSpilled = mayHaveSpilled && (_spilledIdsFilter[bit / 64] & (1ULL << (bit % 64)));
+    });
+    return mayHaveSpilled;
+}
+
+void DocumentSourceGraphLookUp::spillVisited() {
+    if (_visited.empty()) {
+        return;
+    }
+    _usedDisk = true;
+
+    if (_spilledIdsFilter.empty()) {
+        // Dedicate 1/32 of the memory limit to the filter, rounded down to a power of two.
+        size_t numWords = 1;
+        while (numWords * 2 * sizeof(uint64_t) <= _maxMemoryUsageBytes / 32) {
+            numWords *= 2;
+        }
+        _spilledIdsFilter.assign(numWords, 0);
+    }
+
+    if (_spillFileName.empty()) {
+        _spillFileName = pExpCtx->tempDir + "/" + nextFileName();
+        _nextSpillFileOffset = 0;
+    }
+
+    std::vector<const ValueUnorderedMap<Document>::value_type*> ptrs;
+    ptrs.reserve(_visited.size());
+    for (auto&& entry : _visited) {
+        ptrs.push_back(&entry);
+    }
+    std::sort(ptrs.begin(), ptrs.end(), [](const auto* lhs, const auto* rhs) {
+        return ValueComparator::kInstance.evaluate(lhs->first < rhs->first);
+    });
+
+    const size_t numBits = _spilledIdsFilter.size() * 64;
+    SortedFileWriter<Value, Value> writer(
+        SortOptions().TempDir(pExpCtx->tempDir), _spillFileName, _nextSpillFileOffset);
+    for (auto&& entry : ptrs) {
+        forEachSpilledIdsFilterBit(entry->first, numBits, [&](size_t bit) {
+            _spilledIdsFilter[bit / 64] |= (1ULL << (bit % 64));
+        });
+        writer.addAlreadySorted(entry->first, Value(entry->second));
+    }
+    _spilledVisited.emplace_back(writer.done());
+    _nextSpillFileOffset = writer.getFileEndOffset();
+
+    _visited.clear();
+    _visitedUsageBytes = 0;
+}
+
+bool DocumentSourceGraphLookUp::resolveUnconfirmedVisits(long long depth) {
+    if (_unconfirmedVisits.empty()) {
+        return false;
+    }
+    invariant(!_spilledVisited.empty());
+
+    auto unconfirmed = std::move(_unconfirmedVisits);
+    _unconfirmedVisits.clear();
+    _unconfirmedVisitsUsageBytes = 0;
+
+    std::stable_sort(unconfirmed.begin(), unconfirmed.end(), [](const auto& lhs, const auto& rhs) {
+        return ValueComparator::kInstance.evaluate(lhs["_id"] < rhs["_id"]);
+    });
+
+    // The spilled runs can only be read once, so we merge them into a single run in a new file as
+    // we go. The merge iterator deletes the old file once it is destroyed.
+    std::vector<bool> alreadyVisited(unconfirmed.size(), false);
+    {
+        std::unique_ptr<Sorter<Value, Value>::Iterator> spilled(
+            Sorter<Value, Value>::Iterator::merge(
+                _spilledVisited, _spillFileName, SortOptions(), SpilledIdComparator()));
+        _spilledVisited.clear();
+        _spillFileName = pExpCtx->tempDir + "/" + nextFileName();
+        _nextSpillFileOffset = 0;
+
+        SortedFileWriter<Value, Value> writer(
+            SortOptions().TempDir(pExpCtx->tempDir), _spillFileName, _nextSpillFileOffset);
+        size_t pos = 0;
+        while (spilled->more()) {
+            auto next = spilled->next();
+            while (pos < unconfirmed.size() &&
+                   ValueComparator::kInstance.evaluate(unconfirmed[pos]["_id"] < next.first)) {
+                ++pos;
+            }
+            for (size_t i = pos; i < unconfirmed.size() &&
+                 ValueComparator::kInstance.evaluate(unconfirmed[i]["_id"] == next.first);
+                 ++i) {
+                alreadyVisited[i] = true;
+            }
+            writer.addAlreadySorted(next.first, next.second);
+        }
+        _spilledVisited.emplace_back(writer.done());
+        _nextSpillFileOffset = writer.getFileEndOffset();
+    }
+
+    bool inserted = false;
+    for (size_t i = 0; i < unconfirmed.size(); ++i) {
+        // The same document may have been set aside more than once in this iteration.
+        if (alreadyVisited[i] || _visited.find(unconfirmed[i]["_id"]) != _visited.end()) {
+            continue;
+        }
+        insertIntoVisitedAndFrontier(std::move(unconfirmed[i]), depth);
+        inserted = true;
+    }
+    checkMemoryUsage();
+    return inserted;
+}
+
+void DocumentSourceGraphLookUp::discardSpilledVisited() {
+    if (!_spilledVisited.empty()) {
+        _spilledVisited.clear();
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_spillFileName));
+    }
+    _spillFileName.clear();
+    _nextSpillFileOffset = 0;
+    _spilledIdsFilter.clear();
+}
+
+void DocumentSourceGraphLookUp::prepareResults() {
+    invariant(_unconfirmedVisits.empty());
+    if (_spilledVisited.empty()) {
+        return;
+    }
+
+    // The merge iterator takes over the deletion of the spill file.
+    _spilledResults.reset(Sorter<Value, Value>::Iterator::merge(
+        _spilledVisited, _spillFileName, SortOptions(), SpilledIdComparator()));
+    _spilledVisited.clear();
+    discardSpilledVisited();
+
+    if (!_spilledResults->more()) {
+        _spilledResults.reset();
+    }
+}
+
+boost::optional<Document> DocumentSourceGraphLookUp::popNextResult() {
+    if (_spilledResults) {
+        auto result = _spilledResults->next().second.getDocument();
+        if (!_spilledResults->more()) {
+            _spilledResults.reset();
+        }
+        return result;
+    }
+
+    if (!_visited.empty()) {
+        auto it = _visited.begin();
+        auto result = std::move(it->second);
+        _visited.erase(it);
+        return result;
+    }
+    return boost::none;
 }
 
 void DocumentSourceGraphLookUp::addToCache(const Document& result,
@@ -359,6 +592,7 @@ void DocumentSourceGraphLookUp::performSearch() {
 
     try {
         doBreadthFirstSearch();
+        prepareResults();
     } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
         // If lookup on a sharded collection is disallowed and the foreign collection is sharded,
         // throw a custom exception.
@@ -403,11 +637,20 @@ Pipeline::SourceContainer::iterator DocumentSourceGraphLookUp::doOptimizeAt(
 }
 
 void DocumentSourceGraphLookUp::checkMemoryUsage() {
-    // TODO SERVER-23980: Implement spilling to disk if allowDiskUse is specified.
+    const size_t filterUsageBytes = _spilledIdsFilter.size() * sizeof(uint64_t);
+    auto usageBytes = [&] {
+        return _visitedUsageBytes + _frontierUsageBytes + _unconfirmedVisitsUsageBytes +
+            filterUsageBytes;
+    };
+
+    if (_allowDiskUse && usageBytes() >= _maxMemoryUsageBytes) {
+        spillVisited();
+    }
+
     uassert(40099,
             "$graphLookup reached maximum memory consumption",
-            (_visitedUsageBytes + _frontierUsageBytes) < _maxMemoryUsageBytes);
-    _cache.evictDownTo(_maxMemoryUsageBytes - _frontierUsageBytes - _visitedUsageBytes);
+            usageBytes() < _maxMemoryUsageBytes);
+    _cache.evictDownTo(_maxMemoryUsageBytes - usageBytes());
 }
 
 void DocumentSourceGraphLookUp::serializeToArray(
@@ -477,6 +720,8 @@ DocumentSourceGraphLookUp::DocumentSourceGraphLookUp(
       _additionalFilter(additionalFilter),
       _depthField(depthField),
       _maxDepth(maxDepth),
+      _maxMemoryUsageBytes(internalDocumentSourceGraphLookupMaxMemoryBytes.load()),
+      _allowDiskUse(expCtx->allowDiskUse && !expCtx->inMongos),
       _frontier(pExpCtx->getValueComparator().makeUnorderedValueSet()),
       _visited(ValueComparator::kInstance.makeUnorderedValueMap<Document>()),
       _cache(pExpCtx->getValueComparator()),
@@ -626,3 +871,6 @@ void DocumentSourceGraphLookUp::addInvolvedCollections(
     }
 }
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
+#include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
 
@@ -41,6 +42,8 @@ class DocumentSourceGraphLookUp final : public DocumentSource {
 public:
     static constexpr StringData kStageName = "$graphLookup"_sd;
 
+    ~DocumentSourceGraphLookUp();
+
     class LiteParsed : public LiteParsedDocumentSourceForeignCollection {
     public:
         LiteParsed(std::string parseTimeName, NamespaceString foreignNss)
@@ -95,7 +98,7 @@ public:
         StageConstraints constraints(StreamType::kStreaming,
                                      PositionRequirement::kNone,
                                      HostTypeRequirement::kPrimaryShard,
-                                     DiskUseRequirement::kNoDiskUse,
+                                     DiskUseRequirement::kWritesTmpData,
                                      FacetRequirement::kAllowed,
                                      TransactionRequirement::kAllowed,
                                      LookupRequirement::kAllowed,
@@ -117,6 +120,10 @@ public:
 
     void addInvolvedCollections(stdx::unordered_set<NamespaceString>* collectionNames) const final;
 
+    bool usedDisk() final {
+        return _usedDisk;
+    }
+
     void detachFromOperationContext() final;
 
     void reattachToOperationContext(OperationContext* opCtx) final;
@@ -200,19 +207,67 @@ private:
     void addToCache(const Document& result, const ValueUnorderedSet& queried);
 
     /**
-     * Assert that '_visited' and '_frontier' have not exceeded the maximum meory usage, and then
-     * evict from '_cache' until this source is using less than '_maxMemoryUsageBytes'.
+     * Spill '_visited' to disk if it has grown too large and disk use is allowed. Then assert that
+     * '_visited' and '_frontier' have not exceeded the maximum memory usage, and evict from
+     * '_cache' until this source is using less than '_maxMemoryUsageBytes'.
      */
     void checkMemoryUsage();
 
     /**
      * Process 'result', adding it to '_visited' with the given 'depth', and updating '_frontier'
-     * with the object's 'connectTo' values.
+     * with the object's 'connectTo' values. If the '_id' of 'result' may belong to a spilled
+     * document, 'result' is instead set aside in '_unconfirmedVisits' until the end of the current
+     * search iteration.
      *
      * Returns whether '_visited' was updated, and thus, whether the search should recurse.
      */
     bool addToVisitedAndFrontier(Document result, long long depth);
 
+    /**
+     * Adds 'result', which is known not to have been visited yet, to '_visited' with the given
+     * 'depth' and updates '_frontier' with the object's 'connectTo' values.
+     */
+    void insertIntoVisitedAndFrontier(Document result, long long depth);
+
+    /**
+     * Returns false if a document with the given '_id' has definitely not been spilled to disk.
+     */
+    bool mayHaveSpilledId(const Value& id) const;
+
+    /**
+     * Writes the contents of '_visited' to a new sorted run in '_spillFileName', recording the
+     * spilled ids in '_spilledIdsFilter'.
+     */
+    void spillVisited();
+
+    /**
+     * Checks the documents in '_unconfirmedVisits' against the spilled runs, which are rewritten as
+     * a single run in the process, and adds those which were not spilled to '_visited' with the
+     * given 'depth'. Returns true if any document was added.
+     */
+    bool resolveUnconfirmedVisits(long long depth);
+
+    /**
+     * Deletes any spilled runs and resets the state used to track them.
+     */
+    void discardSpilledVisited();
+
+    /**
+     * Called once the search for the current input is complete. Merges any spilled runs into
+     * '_spilledResults' so that they can be returned alongside the contents of '_visited'.
+     */
+    void prepareResults();
+
+    bool hasMoreResults() const {
+        return _spilledResults || !_visited.empty();
+    }
+
+    /**
+     * Removes and returns the next document found by the search for the current input, or
+     * boost::none if there are no more.
+     */
+    boost::optional<Document> popNextResult();
+
     // $graphLookup options.
     NamespaceString _from;
     FieldPath _as;
@@ -230,11 +285,17 @@ private:
     // The aggregation pipeline to perform against the '_from' namespace.
     std::vector<BSONObj> _fromPipeline;
 
-    size_t _maxMemoryUsageBytes = 100 * 1024 * 1024;
+    size_t _maxMemoryUsageBytes;
 
     // Track memory usage to ensure we don't exceed '_maxMemoryUsageBytes'.
     size_t _visitedUsageBytes = 0;
     size_t _frontierUsageBytes = 0;
+    size_t _unconfirmedVisitsUsageBytes = 0;
+
+    // Whether '_visited' may be spilled to disk once it exceeds '_maxMemoryUsageBytes', and
+    // whether it has been.
+    const bool _allowDiskUse;
+    bool _usedDisk = false;
 
     // Only used during the breadth-first search, tracks the set of values on the current frontier.
     ValueUnorderedSet _frontier;
@@ -244,6 +305,20 @@ private:
     // using the simple collation.
     ValueUnorderedMap<Document> _visited;
 
+    // The following members are used to spill '_visited' to disk. Spilled documents are written
+    // to '_spillFileName' in runs sorted by '_id', and a Bloom filter over the spilled ids lets us
+    // skip the disk for the vast majority of ids that were never spilled. Documents whose ids may
+    // have been spilled are collected in '_unconfirmedVisits' and checked against the runs in a
+    // single pass at the end of each search iteration.
+    std::string _spillFileName;
+    std::streampos _nextSpillFileOffset = 0;
+    std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> _spilledVisited;
+    std::vector<uint64_t> _spilledIdsFilter;
+    std::vector<Document> _unconfirmedVisits;
+
+    // Iterates over the spilled documents once the search for the current input is complete.
+    std::unique_ptr<Sorter<Value, Value>::Iterator> _spilledResults;
+
     // Caches query results to avoid repeating any work. This structure is maintained across calls
     // to getNext().
     LookupSetCache _cache;
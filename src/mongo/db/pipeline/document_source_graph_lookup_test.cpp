@@ -38,8 +38,11 @@
 #include "mongo/db/pipeline/document_source_graph_lookup.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/process_interface/stub_mongo_process_interface.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
@@ -613,5 +616,72 @@ TEST_F(DocumentSourceGraphLookUpTest, ShouldNotExpandArraysWithinArraysAtEndOfCo
     ASSERT(graphLookupStage->getNext().isEOF());
 }
 
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSpillVisitedDocumentsWhenAllowDiskUseIsSet) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceGraphLookUpTest");
+    expCtx->tempDir = tempDir.path();
+
+    const auto originalMaxMemoryBytes = internalDocumentSourceGraphLookupMaxMemoryBytes.load();
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(2 * 1024);
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(originalMaxMemoryBytes); });
+
+    // Make a cycle 0 -> 1 -> ... -> 49 -> 0, which is far larger than the memory limit. Revisiting
+    // 0 at the end requires checking it against the documents spilled to disk.
+    const int numNodes = 50;
+    std::deque<DocumentSource::GetNextResult> fromContents;
+    for (int i = 0; i < numNodes; ++i) {
+        fromContents.push_back(Document{{"_id", i},
+                                        {"to", i},
+                                        {"from", (i + 1) % numNodes},
+                                        {"payload", std::string(64, 'x')}});
+    }
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    expCtx->mongoProcessInterface = std::make_shared<MockMongoInterface>(std::move(fromContents));
+
+    auto inputMock = DocumentSourceMock::createForTest(
+        {Document{{"startPoint", 0}}, Document{{"startPoint", 0}}}, expCtx);
+    auto makeGraphLookupStage = [&] {
+        auto stage = DocumentSourceGraphLookUp::create(
+            expCtx,
+            fromNs,
+            "results",
+            "from",
+            "to",
+            ExpressionFieldPath::deprecatedCreate(expCtx.get(), "startPoint"),
+            boost::none,
+            FieldPath("depth"),
+            boost::none,
+            boost::none);
+        stage->setSource(inputMock.get());
+        return stage;
+    };
+
+    expCtx->allowDiskUse = false;
+    auto inMemoryStage = makeGraphLookupStage();
+    ASSERT_THROWS_CODE(inMemoryStage->getNext(), AssertionException, 40099);
+
+    expCtx->allowDiskUse = true;
+    auto spillingStage = makeGraphLookupStage();
+    auto next = spillingStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_TRUE(spillingStage->usedDisk());
+
+    // Every node is returned exactly once, with the depth at which it was first discovered.
+    auto results = next.getDocument()["results"].getArray();
+    ASSERT_EQ(results.size(), static_cast<size_t>(numNodes));
+    std::vector<bool> seen(numNodes, false);
+    for (auto&& result : results) {
+        auto id = result["_id"].getInt();
+        ASSERT_FALSE(seen[id]);
+        seen[id] = true;
+        ASSERT_VALUE_EQ(result["depth"], Value(static_cast<long long>(id)));
+    }
+    ASSERT_TRUE(spillingStage->getNext().isEOF());
+}
+
 }  // namespace
 }  // namespace mongo
@@ -83,6 +83,31 @@ void lookupPipeValidator(const Pipeline& pipeline) {
     });
 }
 
+/**
+ * Returns true if a local field value of 'value' can be matched against the foreign collection by
+ * a batched $in query and then paired with the returned foreign documents by hashing. This holds
+ * for scalar types whose query equality semantics coincide with Value equality. Null and missing
+ * values also match missing foreign fields, regexes are treated as patterns by $in, and nested
+ * arrays or objects would need the matcher's full array traversal rules, so these are excluded.
+ */
+bool isBatchableLocalValue(const Value& value) {
+    switch (value.getType()) {
+        case NumberInt:
+        case NumberLong:
+        case NumberDouble:
+        case NumberDecimal:
+        case String:
+        case jstOID:
+        case Bool:
+        case Date:
+        case bsonTimestamp:
+        case BinData:
+            return true;
+        default:
+            return false;
+    }
+}
+
 bool foreignShardedLookupAllowed() {
     return getTestCommandsEnabled() && internalQueryAllowShardedLookup.load();
 }
@@ -276,6 +301,10 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
         return unwindResult();
     }
 
+    if (!_batch.empty() || _batchTerminator || shouldBatchForeignQueries()) {
+        return batchedResult();
+    }
+
     auto nextInput = pSource->getNext();
     if (!nextInput.isAdvanced()) {
         return nextInput;
@@ -287,16 +316,181 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline.back() = matchStage;
+    auto results = lookUpForeignDocuments(inputDoc);
+
+    MutableDocument output(std::move(inputDoc));
+    output.setNestedField(_as, Value(std::move(results)));
+    return output.freeze();
+}
+
+bool DocumentSourceLookUp::shouldBatchForeignQueries() const {
+    if (wasConstructedWithPipelineSyntax() || internalLookupStageBatchSize.load() <= 1) {
+        return false;
     }
 
-    std::unique_ptr<Pipeline, PipelineDeleter> pipeline;
+    // Positional path components such as the "0" in "a.0.b" are interpreted differently by the
+    // query matcher and by document_path_support, so the foreign matches could not be reliably
+    // redistributed.
+    for (size_t i = 0; i < _foreignField->getPathLength(); ++i) {
+        if (str::parseUnsignedBase10Integer(_foreignField->getFieldName(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::batchedResult() {
+    if (_batch.empty()) {
+        if (_batchTerminator) {
+            auto terminator = std::move(*_batchTerminator);
+            _batchTerminator = boost::none;
+            return terminator;
+        }
+
+        // The batch is also cut short once its input documents take up the memory budget, which
+        // they share with the foreign documents they are joined with.
+        const size_t batchSize = internalLookupStageBatchSize.load();
+        const auto maxBatchBytes = internalLookupStageBatchMaxSizeBytes.load();
+        long long batchBytes = 0;
+        while (_batch.size() < batchSize && batchBytes < maxBatchBytes) {
+            auto nextInput = pSource->getNext();
+            if (!nextInput.isAdvanced()) {
+                if (_batch.empty()) {
+                    return nextInput;
+                }
+                // Serve the documents buffered so far before propagating the pause or EOF.
+                _batchTerminator = std::move(nextInput);
+                break;
+            }
+            _batch.push_back({nextInput.releaseDocument(), boost::none});
+            batchBytes += _batch.back().doc.getApproximateSize();
+        }
+
+        runBatchedForeignQuery();
+    }
+
+    auto next = std::move(_batch.front());
+    _batch.pop_front();
+
+    auto results = next.results ? std::move(*next.results) : lookUpForeignDocuments(next.doc);
+
+    MutableDocument output(std::move(next.doc));
+    output.setNestedField(_as, Value(std::move(results)));
+    return output.freeze();
+}
+
+void DocumentSourceLookUp::runBatchedForeignQuery() {
+    // Maps each distinct local value to the positions in '_batch' of the documents that hold it.
+    // The comparator honours the collation, which the foreign query shares with this stage.
+    auto localValueToBatchPositions =
+        _fromExpCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>();
+    BSONArrayBuilder inValues;
+
+    for (size_t pos = 0; pos < _batch.size(); ++pos) {
+        std::vector<Value> localValues;
+        bool batchable = true;
+        document_path_support::visitAllValuesAtPath(
+            _batch[pos].doc, *_localField, [&](const Value& nextValue) {
+                batchable = batchable && isBatchableLocalValue(nextValue);
+                localValues.push_back(nextValue);
+            });
+
+        // Documents without local values join on null, which also matches missing foreign fields,
+        // so they are looked up individually along with any other ineligible documents. We also
+        // stop growing the $in list well before it approaches the maximum BSON size.
+        if (!batchable || localValues.empty() || inValues.len() > BSONObjMaxUserSize / 2) {
+            continue;
+        }
+
+        _batch[pos].results.emplace();
+        for (auto&& localValue : localValues) {
+            auto [it, inserted] = localValueToBatchPositions.try_emplace(localValue);
+            if (inserted) {
+                inValues << localValue;
+            }
+            if (it->second.empty() || it->second.back() != pos) {
+                it->second.push_back(pos);
+            }
+        }
+    }
+
+    if (localValueToBatchPositions.empty()) {
+        return;
+    }
+
+    const auto foreignFieldName = _foreignField->fullPath();
+    _resolvedPipeline.back() =
+        BSON("$match" << BSON(foreignFieldName << BSON("$in" << inValues.arr())));
+
+    // The 'let' variables are unused by the localField/foreignField syntax, so any document in the
+    // batch may stand in for the whole of it.
+    auto pipeline = buildPipelineForInput(_batch.front().doc);
+
+    // The foreign documents held for the batch as a whole are bounded by
+    // 'internalLookupStageBatchMaxSizeBytes', and those held for any one document by the usual
+    // $lookup limit. If either is exceeded, the batch is given up on and its documents are looked
+    // up individually instead, which raises the usual error if a single document is to blame.
+    const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
+    const auto maxBatchBytes = internalLookupStageBatchMaxSizeBytes.load();
+    long long batchBytes = 0;
+    for (auto&& input : _batch) {
+        batchBytes += input.doc.getApproximateSize();
+    }
+    std::vector<long long> resultSizes(_batch.size(), 0);
+    bool exceededMemoryLimit = false;
+
+    // The ordinal of the last foreign document appended to each batch position, used to avoid
+    // joining a foreign document twice when it matches several values of the same local document.
+    std::vector<long long> lastForeignDoc(_batch.size(), -1);
+    long long foreignDocOrdinal = 0;
+
+    while (auto result = pipeline->getNext()) {
+        const Value foreignDoc(std::move(*result));
+        const auto foreignDocSize = foreignDoc.getApproximateSize();
+        bool joined = false;
+        document_path_support::visitAllValuesAtPath(
+            foreignDoc.getDocument(), *_foreignField, [&](const Value& foreignValue) {
+                auto it = localValueToBatchPositions.find(foreignValue);
+                if (it == localValueToBatchPositions.end()) {
+                    return;
+                }
+                for (auto pos : it->second) {
+                    if (lastForeignDoc[pos] == foreignDocOrdinal) {
+                        continue;
+                    }
+                    lastForeignDoc[pos] = foreignDocOrdinal;
+
+                    long long safeSum = 0;
+                    if (overflow::add(resultSizes[pos], foreignDocSize, &safeSum) ||
+                        safeSum > maxBytes) {
+                        exceededMemoryLimit = true;
+                    }
+                    resultSizes[pos] = safeSum;
+                    _batch[pos].results->push_back(foreignDoc);
+                    joined = true;
+                }
+            });
+        ++foreignDocOrdinal;
+
+        // A foreign document shared between several inputs is only held in memory once.
+        if (joined && (overflow::add(batchBytes, foreignDocSize, &batchBytes) ||
+                       batchBytes > maxBatchBytes)) {
+            exceededMemoryLimit = true;
+        }
+        if (exceededMemoryLimit) {
+            for (auto&& input : _batch) {
+                input.results = boost::none;
+            }
+            break;
+        }
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+}
+
+std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipelineForInput(
+    const Document& inputDoc) {
     try {
-        pipeline = buildPipeline(inputDoc);
+        return buildPipeline(inputDoc);
     } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
         // If lookup on a sharded collection is disallowed and the foreign collection is sharded,
         // throw a custom exception.
@@ -308,6 +502,17 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
         }
         throw;
     }
+}
+
+std::vector<Value> DocumentSourceLookUp::lookUpForeignDocuments(const Document& inputDoc) {
+    if (!wasConstructedWithPipelineSyntax()) {
+        auto matchStage =
+            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+        _resolvedPipeline.back() = matchStage;
+    }
+
+    auto pipeline = buildPipelineForInput(inputDoc);
 
     std::vector<Value> results;
     long long objsize = 0;
@@ -326,10 +531,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
         results.emplace_back(std::move(*result));
     }
     _usedDisk = _usedDisk || pipeline->usedDisk();
-
-    MutableDocument output(std::move(inputDoc));
-    output.setNestedField(_as, Value(std::move(results)));
-    return output.freeze();
+    return results;
 }
 
 std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
@@ -531,6 +733,8 @@ bool DocumentSourceLookUp::usedDisk() {
 }
 
 void DocumentSourceLookUp::doDispose() {
+    _batch.clear();
+    _batchTerminator = boost::none;
     if (_pipeline) {
         _usedDisk = _usedDisk || _pipeline->usedDisk();
         _pipeline->dispose(pExpCtx->opCtx);
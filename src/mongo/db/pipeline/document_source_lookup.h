@@ -30,6 +30,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 
 #include "mongo/db/exec/document_value/value_comparator.h"
 #include "mongo/db/pipeline/document_source.h"
@@ -239,6 +240,41 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Returns true if the foreign collection should be probed with one $in query per batch of
+     * input documents rather than with one query per input document. Only applies to $lookups
+     * specified with the localField/foreignField syntax which have not absorbed a $unwind.
+     */
+    bool shouldBatchForeignQueries() const;
+
+    /**
+     * Returns the next input document joined with its foreign matches, refilling '_batch' from
+     * the source and issuing a single batched foreign query whenever it runs empty.
+     */
+    GetNextResult batchedResult();
+
+    /**
+     * Issues one $match {<foreignField>: {$in: [...]}} query covering the local values of every
+     * eligible document in '_batch' and distributes the foreign documents it returns among them
+     * through a hash table keyed on the local values. Documents whose local values cannot be
+     * matched by hashing (e.g. missing, null, regex or array values) are left without results
+     * and are later looked up individually, as are all of the documents if their foreign
+     * matches would take up too much memory.
+     */
+    void runBatchedForeignQuery();
+
+    /**
+     * Builds the $lookup pipeline for 'inputDoc', raising a dedicated error if the foreign
+     * collection turns out to be sharded and that is not allowed.
+     */
+    std::unique_ptr<Pipeline, PipelineDeleter> buildPipelineForInput(const Document& inputDoc);
+
+    /**
+     * Runs the $lookup pipeline for a single 'inputDoc' and returns the foreign documents it
+     * produced.
+     */
+    std::vector<Value> lookUpForeignDocuments(const Document& inputDoc);
+
     /**
      * Resolves let defined variables against 'localDoc' and stores the results in 'variables'.
      */
@@ -314,6 +350,18 @@ private:
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
+
+    // The following members are used to hold onto state across getNext() calls when the foreign
+    // collection is probed in batches. Each buffered input document carries its foreign matches
+    // if they were resolved by the batched query.
+    struct BatchedInput {
+        Document doc;
+        boost::optional<std::vector<Value>> results;
+    };
+    std::deque<BatchedInput> _batch;
+    // The non-advanced result (pause or EOF) which ended the current batch, returned to the
+    // caller once '_batch' has been drained.
+    boost::optional<GetNextResult> _batchTerminator;
 };
 
 }  // namespace mongo
@@ -50,6 +50,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -684,12 +685,18 @@ public:
 
         pipeline->addInitialSource(
             DocumentSourceMock::createForTest(_mockResults, pipeline->getContext()));
+        ++_numPipelinesAttached;
         return pipeline;
     }
 
+    size_t numPipelinesAttached() const {
+        return _numPipelinesAttached;
+    }
+
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
     bool _removeLeadingQueryStages = false;
+    size_t _numPipelinesAttached = 0;
 };
 
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
@@ -745,6 +752,115 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
     lookup->dispose();
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldProbeForeignCollectionOncePerBatch) {
+    const auto oldBatchSize = internalLookupStageBatchSize.load();
+    internalLookupStageBatchSize.store(100);
+    ON_BLOCK_EXIT([&] { internalLookupStageBatchSize.store(oldBatchSize); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    // The document without a local value joins on null and must be looked up on its own.
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"_id", 0}, {"fk", 1}},
+                                           Document{fromjson("{_id: 1, fk: [1, 2]}")},
+                                           Document{{"_id", 2}},
+                                           Document{{"_id", 3}, {"fk", 3}}},
+                                          expCtx);
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{fromjson("{_id: 'a', key: 1}")},
+        Document{fromjson("{_id: 'b', key: [1, 2]}")},
+        Document{fromjson("{_id: 'c'}")}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    auto parsed = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'fk', foreignField: 'key', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    parsed->setSource(mockLocalSource.get());
+
+    auto next = parsed->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        Document{fromjson("{_id: 0, fk: 1, as: [{_id: 'a', key: 1}, {_id: 'b', key: [1, 2]}]}")},
+        next.releaseDocument());
+
+    next = parsed->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 1, fk: [1, 2], as: [{_id: 'a', key: 1}, "
+                                         "{_id: 'b', key: [1, 2]}]}")},
+                       next.releaseDocument());
+
+    next = parsed->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 2, as: [{_id: 'c'}]}")}, next.releaseDocument());
+
+    next = parsed->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(Document{fromjson("{_id: 3, fk: 3, as: []}")}, next.releaseDocument());
+
+    ASSERT_TRUE(parsed->getNext().isEOF());
+
+    // One batched query for the documents with local values, plus one for the null join.
+    ASSERT_EQ(mongoInterface->numPipelinesAttached(), 2U);
+    parsed->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldLookUpIndividuallyIfBatchExceedsMemoryLimit) {
+    const auto oldBatchSize = internalLookupStageBatchSize.load();
+    internalLookupStageBatchSize.store(100);
+    ON_BLOCK_EXIT([&] { internalLookupStageBatchSize.store(oldBatchSize); });
+    const auto oldMaxBatchBytes = internalLookupStageBatchMaxSizeBytes.load();
+    internalLookupStageBatchMaxSizeBytes.store(15 * 1024);
+    ON_BLOCK_EXIT([&] { internalLookupStageBatchMaxSizeBytes.store(oldMaxBatchBytes); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    auto mockLocalSource = DocumentSourceMock::createForTest(
+        {Document{{"_id", 0}, {"fk", 1}}, Document{{"_id", 1}, {"fk", 2}}}, expCtx);
+
+    // Each foreign document fits in the batch's memory budget, but the two together do not.
+    const std::string bigString(10 * 1024, 'x');
+    const Document foreignDoc1{{"key", 1}, {"str", bigString}};
+    const Document foreignDoc2{{"key", 2}, {"str", bigString}};
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        DocumentSource::GetNextResult(Document(foreignDoc1)),
+        DocumentSource::GetNextResult(Document(foreignDoc2))};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    auto parsed = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'fk', foreignField: 'key', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    parsed->setSource(mockLocalSource.get());
+
+    auto next = parsed->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        (Document{{"_id", 0}, {"fk", 1}, {"as", vector<Value>{Value(foreignDoc1)}}}),
+        next.releaseDocument());
+
+    next = parsed->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        (Document{{"_id", 1}, {"fk", 2}, {"as", vector<Value>{Value(foreignDoc2)}}}),
+        next.releaseDocument());
+
+    ASSERT_TRUE(parsed->getNext().isEOF());
+
+    // The abandoned batched query, then one query per document.
+    ASSERT_EQ(mongoInterface->numPipelinesAttached(), 3U);
+    parsed->dispose();
+}
+
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
@@ -139,6 +139,10 @@ private:
     BSONObj _originalOutOptions;
     std::list<BSONObj> _originalIndexes;
 
+    // The indexes of the output collection which are built on the temp collection only once all
+    // documents are written to it.
+    std::vector<BSONObj> _deferredIndexes;
+
     // The temporary namespace for the $out writes.
     NamespaceString _tempNs;
 };
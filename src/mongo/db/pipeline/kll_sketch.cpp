@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/kll_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+// The ratio between the capacities of two adjacent levels.
+constexpr double kCapacityDecay = 2.0 / 3.0;
+}  // namespace
+
+KllSketch::KllSketch(const ValueComparator& comparator, size_t k)
+    : _comparator(comparator), _k(std::max<size_t>(k, 8)), _levels(1), _keepOdd(1, false) {}
+
+size_t KllSketch::levelCapacity(size_t level) const {
+    const auto depth = _levels.size() - 1 - level;
+    return std::max<size_t>(2, std::floor(_k * std::pow(kCapacityDecay, depth)));
+}
+
+void KllSketch::add(Value value) {
+    _memUsageBytes += value.getApproximateSize();
+    _levels[0].push_back(std::move(value));
+    ++_numRetained;
+    ++_count;
+
+    size_t totalCapacity = 0;
+    for (size_t level = 0; level < _levels.size(); ++level) {
+        totalCapacity += levelCapacity(level);
+    }
+    if (_numRetained >= totalCapacity) {
+        compress();
+    }
+}
+
+void KllSketch::compress() {
+    for (size_t level = 0; level < _levels.size(); ++level) {
+        if (_levels[level].size() < levelCapacity(level)) {
+            continue;
+        }
+
+        if (level + 1 == _levels.size()) {
+            _levels.emplace_back();
+            _keepOdd.push_back(false);
+        }
+
+        auto& items = _levels[level];
+        std::sort(items.begin(), items.end(), _comparator.getLessThan());
+
+        // An odd item out stays at this level so that the weights still add up to the count.
+        boost::optional<Value> leftover;
+        if (items.size() % 2 == 1) {
+            leftover = std::move(items.back());
+            items.pop_back();
+        }
+
+        // Half of the items are promoted with twice the weight and the other half is dropped.
+        auto& promoted = _levels[level + 1];
+        const size_t firstKept = _keepOdd[level] ? 1 : 0;
+        for (size_t idx = 0; idx < items.size(); ++idx) {
+            if (idx % 2 == firstKept) {
+                promoted.push_back(std::move(items[idx]));
+            } else {
+                _memUsageBytes -= items[idx].getApproximateSize();
+            }
+        }
+        _keepOdd[level] = !_keepOdd[level];
+        _numRetained -= items.size() / 2;
+
+        items.clear();
+        if (leftover) {
+            items.push_back(std::move(*leftover));
+        }
+        return;
+    }
+}
+
+Value KllSketch::quantile(double rank) const {
+    invariant(!empty());
+
+    std::vector<std::pair<Value, uint64_t>> weighted;
+    weighted.reserve(_numRetained);
+    for (size_t level = 0; level < _levels.size(); ++level) {
+        for (auto&& item : _levels[level]) {
+            weighted.emplace_back(item, uint64_t{1} << level);
+        }
+    }
+
+    const auto lessThan = _comparator.getLessThan();
+    std::sort(weighted.begin(), weighted.end(), [&](const auto& lhs, const auto& rhs) {
+        return lessThan(lhs.first, rhs.first);
+    });
+
+    // Return the first item whose weight reaches past the requested rank, so that a rank of i/n
+    // of n distinct values yields the (i + 1)-th smallest of them.
+    const double target = std::max(0.0, std::min(rank, 1.0)) * _count;
+    uint64_t cumulativeWeight = 0;
+    for (auto&& [item, weight] : weighted) {
+        cumulativeWeight += weight;
+        if (cumulativeWeight > target) {
+            return item;
+        }
+    }
+    return weighted.back().first;
+}
+
+}  // namespace mongo
@@ -0,0 +1,114 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+
+namespace mongo {
+
+/**
+ * A KLL quantile sketch (Karnin, Lang and Liberty, "Optimal Quantile Approximation in Streams")
+ * over Values. The sketch keeps a small sample of its input in a stack of compactors: an item
+ * retained at level h stands for 2^h input values. When the sample outgrows its capacity, the
+ * lowest full level is sorted and every other item of it is promoted to the next level, so the
+ * memory used stays proportional to 'k' however many values are added. Quantiles are accurate to
+ * within roughly a 1/k fraction of the number of values added.
+ *
+ * Values are ordered by the ValueComparator given to the constructor, so the sketch works for any
+ * mix of BSON types and respects the collation.
+ */
+class KllSketch {
+public:
+    static constexpr size_t kDefaultK = 200;
+
+    explicit KllSketch(const ValueComparator& comparator, size_t k = kDefaultK);
+
+    /**
+     * Adds 'value' to the sketch.
+     */
+    void add(Value value);
+
+    /**
+     * Returns an input value whose rank is approximately 'rank' * count(), for a 'rank' between 0
+     * and 1. Illegal to call on an empty sketch.
+     */
+    Value quantile(double rank) const;
+
+    /**
+     * The number of values added to the sketch.
+     */
+    uint64_t count() const {
+        return _count;
+    }
+
+    bool empty() const {
+        return _count == 0;
+    }
+
+    /**
+     * Returns the approximate number of bytes held by the retained values.
+     */
+    size_t memUsageBytes() const {
+        return _memUsageBytes;
+    }
+
+private:
+    /**
+     * Returns the number of items that level 'level' may hold before it has to be compacted.
+     * Lower levels get geometrically smaller capacities than the top level, which holds 'k'.
+     */
+    size_t levelCapacity(size_t level) const;
+
+    /**
+     * Compacts the lowest level which has reached its capacity into the level above it.
+     */
+    void compress();
+
+    const ValueComparator _comparator;
+    const size_t _k;
+
+    // The retained items by level. Items at level h have a weight of 2^h.
+    std::vector<std::vector<Value>> _levels;
+
+    // Whether the next compaction of each level keeps its items at odd rather than even positions.
+    // Alternating between the two keeps the rank estimates unbiased without randomness.
+    std::vector<bool> _keepOdd;
+
+    size_t _numRetained = 0;
+    uint64_t _count = 0;
+    size_t _memUsageBytes = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,96 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/kll_sketch.h"
+
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(KllSketchTest, ReturnsExactQuantilesWhileNothingHasBeenCompacted) {
+    KllSketch sketch(ValueComparator{});
+    for (int i = 9; i >= 0; --i) {
+        sketch.add(Value(i));
+    }
+
+    ASSERT_EQUALS(sketch.count(), 10ULL);
+    ASSERT_VALUE_EQ(sketch.quantile(0), Value(0));
+    ASSERT_VALUE_EQ(sketch.quantile(0.5), Value(5));
+    ASSERT_VALUE_EQ(sketch.quantile(0.95), Value(9));
+    ASSERT_VALUE_EQ(sketch.quantile(1), Value(9));
+}
+
+TEST(KllSketchTest, EstimatesQuantilesOfALargeInputWithinTheErrorBound) {
+    const int numValues = 100 * 1000;
+    KllSketch sketch(ValueComparator{});
+    for (int i = 0; i < numValues; ++i) {
+        // Add the values in a scrambled order; 7919 is prime and so coprime with 'numValues'.
+        sketch.add(Value((i * 7919) % numValues));
+    }
+
+    ASSERT_EQUALS(sketch.count(), static_cast<uint64_t>(numValues));
+    for (double rank : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+        ASSERT_APPROX_EQUAL(
+            sketch.quantile(rank).coerceToDouble(), rank * numValues, 0.02 * numValues);
+    }
+}
+
+TEST(KllSketchTest, MemoryUsageDoesNotGrowWithTheInput) {
+    KllSketch sketch(ValueComparator{});
+    for (int i = 0; i < 10 * 1000; ++i) {
+        sketch.add(Value(i));
+    }
+    const auto memUsageAfterTenThousand = sketch.memUsageBytes();
+
+    for (int i = 10 * 1000; i < 1000 * 1000; ++i) {
+        sketch.add(Value(i));
+    }
+    ASSERT_LT(sketch.memUsageBytes(), 2 * memUsageAfterTenThousand);
+}
+
+TEST(KllSketchTest, OrdersValuesOfDifferentTypesAndRespectsTheCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kReverseString);
+    KllSketch sketch{ValueComparator(&collator)};
+    sketch.add(Value("ab"_sd));
+    sketch.add(Value("ba"_sd));
+    sketch.add(Value(1));
+
+    // Numbers sort before strings, and the mock collator compares the strings reversed.
+    ASSERT_VALUE_EQ(sketch.quantile(0), Value(1));
+    ASSERT_VALUE_EQ(sketch.quantile(0.5), Value("ba"_sd));
+    ASSERT_VALUE_EQ(sketch.quantile(1), Value("ab"_sd));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,280 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/pipeline_result_cache.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/service_context.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+
+namespace {
+
+const auto getPipelineResultCache = ServiceContext::declareDecoration<PipelineResultCache>();
+
+Counter64 pipelineResultCacheHits;
+Counter64 pipelineResultCacheMisses;
+Counter64 pipelineResultCacheInserts;
+Counter64 pipelineResultCacheInvalidations;
+
+ServerStatusMetricField<Counter64> displayHits("query.pipelineResultCache.hits",
+                                               &pipelineResultCacheHits);
+ServerStatusMetricField<Counter64> displayMisses("query.pipelineResultCache.misses",
+                                                 &pipelineResultCacheMisses);
+ServerStatusMetricField<Counter64> displayInserts("query.pipelineResultCache.inserts",
+                                                  &pipelineResultCacheInserts);
+ServerStatusMetricField<Counter64> displayInvalidations("query.pipelineResultCache.invalidations",
+                                                        &pipelineResultCacheInvalidations);
+
+/**
+ * Reports the number of results currently held in the cache of the global service context.
+ */
+class PipelineResultCacheEntriesMetric : public ServerStatusMetric {
+public:
+    PipelineResultCacheEntriesMetric() : ServerStatusMetric("query.pipelineResultCache.entries") {}
+
+    void appendAtLeaf(BSONObjBuilder& b) const override {
+        b.appendNumber(_leafName,
+                       static_cast<long long>(
+                           PipelineResultCache::get(getGlobalServiceContext()).size()));
+    }
+} displayEntries;
+
+// The stages whose output depends only on their input and on the collections they name. Any stage
+// which is not listed here makes a pipeline uncacheable.
+const StringDataSet kCacheableStages = {"$addFields",
+                                        "$bucketAuto",
+                                        "$facet",
+                                        "$geoNear",
+                                        "$graphLookup",
+                                        "$group",
+                                        "$limit",
+                                        "$lookup",
+                                        "$match",
+                                        "$project",
+                                        "$redact",
+                                        "$replaceRoot",
+                                        "$set",
+                                        "$skip",
+                                        "$sort",
+                                        "$sortByCount",
+                                        "$unionWith",
+                                        "$unwind"};
+
+// Operators which may appear anywhere within a stage and whose result is nondeterministic.
+const StringDataSet kNondeterministicOperators = {
+    "$accumulator", "$function", "$rand", "$sampleRate", "$where"};
+
+// System variables whose value is fixed per operation rather than by the data read.
+const std::vector<StringData> kOperationVariables = {"$$NOW"_sd, "$$CLUSTER_TIME"_sd};
+
+bool isDeterministic(const Value& value) {
+    switch (value.getType()) {
+        case Object: {
+            auto it = value.getDocument().fieldIterator();
+            while (it.more()) {
+                auto field = it.next();
+                if (kNondeterministicOperators.count(field.first) ||
+                    !isDeterministic(field.second)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case Array:
+            for (auto&& elem : value.getArray()) {
+                if (!isDeterministic(elem)) {
+                    return false;
+                }
+            }
+            return true;
+        case String: {
+            auto str = value.getStringData();
+            for (auto&& variable : kOperationVariables) {
+                if (str.startsWith(variable) &&
+                    (str.size() == variable.size() || str[variable.size()] == '.')) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+bool isCacheableSubPipeline(const Value& subPipeline) {
+    return subPipeline.missing() ||
+        (subPipeline.getType() == Array &&
+         PipelineResultCache::isCacheablePipeline(subPipeline.getArray()));
+}
+
+}  // namespace
+
+PipelineResultCache::PipelineResultCache()
+    : _cache(static_cast<size_t>(internalQueryPipelineResultCacheSize.load())) {}
+
+PipelineResultCache& PipelineResultCache::get(ServiceContext* serviceContext) {
+    return getPipelineResultCache(serviceContext);
+}
+
+PipelineResultCache& PipelineResultCache::get(OperationContext* opCtx) {
+    return get(opCtx->getServiceContext());
+}
+
+bool PipelineResultCache::isEnabled() {
+    return internalQueryEnablePipelineResultCache.load();
+}
+
+bool PipelineResultCache::isCacheablePipeline(const std::vector<Value>& serializedPipeline) {
+    for (auto&& stage : serializedPipeline) {
+        if (stage.getType() != Object || stage.getDocument().empty()) {
+            return false;
+        }
+
+        auto stageIt = stage.getDocument().fieldIterator();
+        auto stageName = stageIt.next().first;
+        if (stageIt.more() || !kCacheableStages.count(stageName)) {
+            return false;
+        }
+
+        // Stages which run sub-pipelines are only cacheable if all of their sub-pipelines are.
+        const auto& spec = stage[stageName];
+        if (stageName == "$facet"_sd) {
+            auto it = spec.getDocument().fieldIterator();
+            while (it.more()) {
+                if (!isCacheableSubPipeline(it.next().second)) {
+                    return false;
+                }
+            }
+        } else if (stageName == "$lookup"_sd || stageName == "$unionWith"_sd) {
+            if (spec.getType() == Object && !isCacheableSubPipeline(spec["pipeline"])) {
+                return false;
+            }
+        }
+
+        if (!isDeterministic(stage)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PipelineResultCache::isCacheableLetParameters(const BSONObj& letParameters) {
+    return isDeterministic(Value(letParameters));
+}
+
+std::string PipelineResultCache::makeKey(const NamespaceString& nss,
+                                         const std::vector<Value>& serializedPipeline,
+                                         const BSONObj& options) {
+    BSONObjBuilder bob;
+    bob.append("ns", nss.ns());
+    {
+        BSONArrayBuilder pipelineBuilder(bob.subarrayStart("pipeline"));
+        for (auto&& stage : serializedPipeline) {
+            stage.addToBsonArray(&pipelineBuilder);
+        }
+    }
+    bob.append("options", options);
+    auto key = bob.done();
+    return std::string(key.objdata(), key.objsize());
+}
+
+PipelineResultCache::Epochs PipelineResultCache::getEpochs(
+    const std::vector<NamespaceString>& namespaces) const {
+    Epochs epochs;
+    epochs.global = _globalEpoch.load();
+    epochs.perNamespace.reserve(namespaces.size());
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& nss : namespaces) {
+        auto it = _epochs.find(nss.ns());
+        epochs.perNamespace.push_back(it == _epochs.end() ? 0 : it->second);
+    }
+    return epochs;
+}
+
+void PipelineResultCache::onWrite(const NamespaceString& nss) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    ++_epochs[nss.ns()];
+}
+
+void PipelineResultCache::onGlobalWrite() {
+    _globalEpoch.fetchAndAdd(1);
+}
+
+boost::optional<std::vector<BSONObj>> PipelineResultCache::lookup(const std::string& key,
+                                                                  const Epochs& currentEpochs) {
+    auto entry = _cache.get(key);
+    if (!entry) {
+        pipelineResultCacheMisses.increment();
+        return boost::none;
+    }
+
+    if (!(entry->epochs == currentEpochs)) {
+        // One of the namespaces the entry was computed from has been written to since.
+        _cache.invalidate(key);
+        pipelineResultCacheInvalidations.increment();
+        pipelineResultCacheMisses.increment();
+        return boost::none;
+    }
+
+    pipelineResultCacheHits.increment();
+    return entry->results;
+}
+
+void PipelineResultCache::insert(const std::string& key,
+                                 Epochs epochs,
+                                 std::vector<BSONObj> results) {
+    const long long maxSizeBytes = internalQueryPipelineResultCacheMaxEntrySizeBytes.load();
+    long long sizeBytes = 0;
+    for (auto&& result : results) {
+        sizeBytes += result.objsize();
+        if (sizeBytes > maxSizeBytes) {
+            return;
+        }
+    }
+
+    _cache.insertOrAssign(key, {std::move(epochs), std::move(results)});
+    pipelineResultCacheInserts.increment();
+}
+
+size_t PipelineResultCache::size() const {
+    return _cache.getCacheInfo().size();
+}
+
+}  // namespace mongo
@@ -0,0 +1,175 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/util/invalidating_lru_cache.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+class OperationContext;
+class ServiceContext;
+
+/**
+ * Caches the complete results of read-only aggregations so that an identical aggregation can be
+ * answered without executing its pipeline. Entries are keyed by the serialized form of the parsed
+ * pipeline together with the namespace and every request option which can change the results.
+ *
+ * Rather than tracking which documents a result depends on, the cache keeps a write epoch for
+ * each namespace, which the PipelineResultCacheOpObserver advances whenever a write to that
+ * namespace commits. An entry records the epochs of all the namespaces its pipeline reads at the
+ * time the pipeline started executing, and is only served while none of them have changed.
+ */
+class PipelineResultCache {
+    PipelineResultCache(const PipelineResultCache&) = delete;
+    PipelineResultCache& operator=(const PipelineResultCache&) = delete;
+
+public:
+    /**
+     * The write epochs of a set of namespaces at a point in time. The global epoch is advanced by
+     * writes which are not attributed to a single namespace, such as dropping a database or
+     * rolling back, and by every write while the cache is disabled.
+     */
+    struct Epochs {
+        bool operator==(const Epochs& other) const {
+            return global == other.global && perNamespace == other.perNamespace;
+        }
+
+        std::uint64_t global = 0;
+        std::vector<std::uint64_t> perNamespace;
+    };
+
+    /**
+     * A cached result, along with the epochs of the namespaces it was computed from.
+     */
+    struct Entry {
+        Epochs epochs;
+        std::vector<BSONObj> results;
+    };
+
+    using Cache = InvalidatingLRUCache<std::string, Entry>;
+
+    /**
+     * Creates a cache holding up to internalQueryPipelineResultCacheSize results.
+     */
+    PipelineResultCache();
+
+    explicit PipelineResultCache(size_t cacheSize) : _cache(cacheSize) {}
+
+    static PipelineResultCache& get(ServiceContext* serviceContext);
+    static PipelineResultCache& get(OperationContext* opCtx);
+
+    /**
+     * Returns true if the internalQueryEnablePipelineResultCache knob is set.
+     */
+    static bool isEnabled();
+
+    /**
+     * Returns true if the results of the given serialized pipeline depend only on the contents of
+     * the collections it reads, so that they can be reused until one of them is written to. This
+     * rejects stages which write, read server state, or sample at random, and expressions which
+     * refer to the current time or are nondeterministic.
+     */
+    static bool isCacheablePipeline(const std::vector<Value>& serializedPipeline);
+
+    /**
+     * Returns true if none of the 'let' parameters of an aggregation refer to the current time or
+     * are nondeterministic, since the pipeline sees their values through user variables.
+     */
+    static bool isCacheableLetParameters(const BSONObj& letParameters);
+
+    /**
+     * Builds the cache key for an aggregation over 'nss' with the given serialized pipeline and
+     * options. 'options' should contain every request parameter, such as the collation, hint and
+     * 'let' variables, which can change the results.
+     */
+    static std::string makeKey(const NamespaceString& nss,
+                               const std::vector<Value>& serializedPipeline,
+                               const BSONObj& options);
+
+    /**
+     * Returns the current write epochs of 'namespaces'. Callers must always list the namespaces of
+     * a given key in the same order. This must be called before the aggregation
+     * whose results may be cached opens its storage snapshot, so that any write the snapshot
+     * misses is guaranteed to advance an epoch afterwards.
+     */
+    Epochs getEpochs(const std::vector<NamespaceString>& namespaces) const;
+
+    /**
+     * Advances the write epoch of 'nss', invalidating every cached result which read from it.
+     */
+    void onWrite(const NamespaceString& nss);
+
+    /**
+     * Advances the global write epoch, invalidating every cached result.
+     */
+    void onGlobalWrite();
+
+    /**
+     * Returns the cached results for 'key' if they were produced while every namespace they read
+     * had the epoch in 'currentEpochs', or boost::none otherwise. A stale entry is
+     * removed from the cache.
+     */
+    boost::optional<std::vector<BSONObj>> lookup(const std::string& key,
+                                                 const Epochs& currentEpochs);
+
+    /**
+     * Caches 'results' under 'key', unless their total size exceeds
+     * internalQueryPipelineResultCacheMaxEntrySizeBytes. 'epochs' must have been obtained from
+     * getEpochs() before the aggregation producing 'results' started.
+     */
+    void insert(const std::string& key, Epochs epochs, std::vector<BSONObj> results);
+
+    /**
+     * Returns the number of results currently held in the cache.
+     */
+    size_t size() const;
+
+private:
+    Cache _cache;
+
+    AtomicWord<unsigned long long> _globalEpoch{0};
+
+    // Protects '_epochs'. Epochs of namespaces which have never been written to since startup are
+    // implicitly zero. Entries are never removed, so that an epoch can never move backwards.
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("PipelineResultCache::_mutex");
+    StringMap<std::uint64_t> _epochs;
+};
+
+}  // namespace mongo
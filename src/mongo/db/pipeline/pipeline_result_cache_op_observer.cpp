@@ -0,0 +1,170 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/pipeline_result_cache_op_observer.h"
+
+#include "mongo/db/concurrency/locker.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/pipeline/pipeline_result_cache.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Runs 'bump' once the current write unit of work commits, or immediately if there is none.
+ * Deferring the bump until after the commit guarantees that a reader which observes the old epoch
+ * and then opens its snapshot either sees the write or sees the epoch change.
+ */
+template <typename BumpFn>
+void bumpOnCommit(OperationContext* opCtx, BumpFn bump) {
+    auto serviceContext = opCtx->getServiceContext();
+    if (!opCtx->lockState()->inAWriteUnitOfWork()) {
+        bump(PipelineResultCache::get(serviceContext));
+        return;
+    }
+    opCtx->recoveryUnit()->onCommit([serviceContext, bump](boost::optional<Timestamp>) {
+        bump(PipelineResultCache::get(serviceContext));
+    });
+}
+
+}  // namespace
+
+void PipelineResultCacheOpObserver::_onWrite(OperationContext* opCtx, const NamespaceString& nss) {
+    bumpOnCommit(opCtx, [nss](PipelineResultCache& cache) {
+        // While the cache is disabled nothing reads the per-namespace epochs, so avoid taking the
+        // cache's mutex on every write and invalidate everything at once instead.
+        if (PipelineResultCache::isEnabled()) {
+            cache.onWrite(nss);
+        } else {
+            cache.onGlobalWrite();
+        }
+    });
+}
+
+void PipelineResultCacheOpObserver::_onGlobalWrite(OperationContext* opCtx) {
+    bumpOnCommit(opCtx, [](PipelineResultCache& cache) { cache.onGlobalWrite(); });
+}
+
+void PipelineResultCacheOpObserver::onInserts(OperationContext* opCtx,
+                                              const NamespaceString& nss,
+                                              OptionalCollectionUUID uuid,
+                                              std::vector<InsertStatement>::const_iterator first,
+                                              std::vector<InsertStatement>::const_iterator last,
+                                              bool fromMigrate) {
+    if (nss.isSystemDotViews()) {
+        // A view definition changed, which can change the results of any aggregation on the
+        // database.
+        _onGlobalWrite(opCtx);
+        return;
+    }
+    _onWrite(opCtx, nss);
+}
+
+void PipelineResultCacheOpObserver::onUpdate(OperationContext* opCtx,
+                                             const OplogUpdateEntryArgs& args) {
+    if (args.nss.isSystemDotViews()) {
+        _onGlobalWrite(opCtx);
+        return;
+    }
+    _onWrite(opCtx, args.nss);
+}
+
+void PipelineResultCacheOpObserver::onDelete(OperationContext* opCtx,
+                                             const NamespaceString& nss,
+                                             OptionalCollectionUUID uuid,
+                                             StmtId stmtId,
+                                             bool fromMigrate,
+                                             const boost::optional<BSONObj>& deletedDoc) {
+    if (nss.isSystemDotViews()) {
+        _onGlobalWrite(opCtx);
+        return;
+    }
+    _onWrite(opCtx, nss);
+}
+
+void PipelineResultCacheOpObserver::onReplicationRollback(OperationContext* opCtx,
+                                                          const RollbackObserverInfo& rbInfo) {
+    _onGlobalWrite(opCtx);
+}
+
+void PipelineResultCacheOpObserver::onCreateCollection(OperationContext* opCtx,
+                                                       Collection* coll,
+                                                       const NamespaceString& collectionName,
+                                                       const CollectionOptions& options,
+                                                       const BSONObj& idIndex,
+                                                       const OplogSlot& createOpTime) {
+    // The new collection's default collation applies to aggregations which previously ran
+    // against a non-existent namespace.
+    _onWrite(opCtx, collectionName);
+}
+
+void PipelineResultCacheOpObserver::onDropDatabase(OperationContext* opCtx,
+                                                   const std::string& dbName) {
+    _onGlobalWrite(opCtx);
+}
+
+repl::OpTime PipelineResultCacheOpObserver::onDropCollection(OperationContext* opCtx,
+                                                             const NamespaceString& collectionName,
+                                                             OptionalCollectionUUID uuid,
+                                                             std::uint64_t numRecords,
+                                                             const CollectionDropType dropType) {
+    _onWrite(opCtx, collectionName);
+    return {};
+}
+
+void PipelineResultCacheOpObserver::onRenameCollection(OperationContext* opCtx,
+                                                       const NamespaceString& fromCollection,
+                                                       const NamespaceString& toCollection,
+                                                       OptionalCollectionUUID uuid,
+                                                       OptionalCollectionUUID dropTargetUUID,
+                                                       std::uint64_t numRecords,
+                                                       bool stayTemp) {
+    postRenameCollection(opCtx, fromCollection, toCollection, uuid, dropTargetUUID, stayTemp);
+}
+
+void PipelineResultCacheOpObserver::postRenameCollection(OperationContext* opCtx,
+                                                         const NamespaceString& fromCollection,
+                                                         const NamespaceString& toCollection,
+                                                         OptionalCollectionUUID uuid,
+                                                         OptionalCollectionUUID dropTargetUUID,
+                                                         bool stayTemp) {
+    _onWrite(opCtx, fromCollection);
+    _onWrite(opCtx, toCollection);
+}
+
+void PipelineResultCacheOpObserver::onEmptyCapped(OperationContext* opCtx,
+                                                  const NamespaceString& collectionName,
+                                                  OptionalCollectionUUID uuid) {
+    _onWrite(opCtx, collectionName);
+}
+
+}  // namespace mongo
@@ -0,0 +1,237 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/bson/json.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/pipeline_result_cache.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kTestNss("test.coll");
+const NamespaceString kForeignNss("test.foreign");
+
+std::vector<Value> makePipeline(const std::vector<std::string>& stages) {
+    std::vector<Value> pipeline;
+    for (auto&& stage : stages) {
+        pipeline.emplace_back(fromjson(stage));
+    }
+    return pipeline;
+}
+
+std::string makeKey(const std::string& stage) {
+    return PipelineResultCache::makeKey(kTestNss, makePipeline({stage}), BSONObj());
+}
+
+std::vector<BSONObj> makeResults(int count) {
+    std::vector<BSONObj> results;
+    for (int i = 0; i < count; ++i) {
+        results.push_back(BSON("_id" << i));
+    }
+    return results;
+}
+
+TEST(PipelineResultCacheTest, AcceptsDeterministicReadOnlyPipelines) {
+    ASSERT_TRUE(PipelineResultCache::isCacheablePipeline(makePipeline({})));
+    ASSERT_TRUE(PipelineResultCache::isCacheablePipeline(
+        makePipeline({"{$match: {a: {$gt: 1}}}",
+                      "{$group: {_id: '$b', total: {$sum: '$c'}}}",
+                      "{$sort: {total: -1}}",
+                      "{$limit: 10}"})));
+    ASSERT_TRUE(PipelineResultCache::isCacheablePipeline(makePipeline(
+        {"{$lookup: {from: 'foreign', as: 'joined', let: {x: '$x'}, pipeline: [{$match: {}}]}}",
+         "{$facet: {a: [{$skip: 1}], b: [{$unwind: {path: '$joined'}}]}}"})));
+}
+
+TEST(PipelineResultCacheTest, RejectsStagesWhichWriteOrReadServerState) {
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(makePipeline({"{$out: 'target'}"})));
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(
+        makePipeline({"{$match: {}}", "{$merge: {into: 'target'}}"})));
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(makePipeline({"{$sample: {size: 1}}"})));
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(makePipeline({"{$indexStats: {}}"})));
+}
+
+TEST(PipelineResultCacheTest, RejectsNondeterministicSubPipelines) {
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(
+        makePipeline({"{$facet: {a: [{$match: {}}], b: [{$sample: {size: 1}}]}}"})));
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(
+        makePipeline({"{$unionWith: {coll: 'foreign', pipeline: [{$sample: {size: 1}}]}}"})));
+}
+
+TEST(PipelineResultCacheTest, RejectsNondeterministicExpressions) {
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(
+        makePipeline({"{$project: {now: '$$NOW'}}"})));
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(
+        makePipeline({"{$addFields: {t: '$$CLUSTER_TIME.t'}}"})));
+    ASSERT_FALSE(PipelineResultCache::isCacheablePipeline(
+        makePipeline({"{$match: {$expr: {$lt: [{$rand: {}}, 0.5]}}}"})));
+    ASSERT_FALSE(
+        PipelineResultCache::isCacheablePipeline(makePipeline({"{$match: {$sampleRate: 0.5}}"})));
+
+    // A field which happens to share the variable's name is unaffected.
+    ASSERT_TRUE(
+        PipelineResultCache::isCacheablePipeline(makePipeline({"{$project: {a: '$NOW'}}"})));
+}
+
+TEST(PipelineResultCacheTest, RejectsNondeterministicLetParameters) {
+    ASSERT_TRUE(PipelineResultCache::isCacheableLetParameters(BSONObj()));
+    ASSERT_TRUE(PipelineResultCache::isCacheableLetParameters(fromjson("{x: 1, y: '$NOW'}")));
+    ASSERT_FALSE(PipelineResultCache::isCacheableLetParameters(fromjson("{now: '$$NOW'}")));
+    ASSERT_FALSE(PipelineResultCache::isCacheableLetParameters(
+        fromjson("{t: {$add: ['$$CLUSTER_TIME', 1]}}")));
+    ASSERT_FALSE(PipelineResultCache::isCacheableLetParameters(fromjson("{r: {$rand: {}}}")));
+}
+
+TEST(PipelineResultCacheTest, KeyDependsOnNamespacePipelineAndOptions) {
+    auto pipeline = makePipeline({"{$match: {a: 1}}"});
+    auto key = PipelineResultCache::makeKey(kTestNss, pipeline, BSON("collation" << BSONObj()));
+
+    ASSERT_EQ(key,
+              PipelineResultCache::makeKey(kTestNss, pipeline, BSON("collation" << BSONObj())));
+    ASSERT_NE(key,
+              PipelineResultCache::makeKey(kForeignNss, pipeline, BSON("collation" << BSONObj())));
+    ASSERT_NE(key,
+              PipelineResultCache::makeKey(
+                  kTestNss, makePipeline({"{$match: {a: 2}}"}), BSON("collation" << BSONObj())));
+    ASSERT_NE(key,
+              PipelineResultCache::makeKey(
+                  kTestNss, pipeline, BSON("collation" << BSON("locale"
+                                                               << "fr"))));
+}
+
+TEST(PipelineResultCacheTest, ServesResultsWhileEpochsAreUnchanged) {
+    PipelineResultCache cache(10);
+    const std::vector<NamespaceString> namespaces{kForeignNss, kTestNss};
+    const auto key = makeKey("{$match: {a: 1}}");
+
+    ASSERT_FALSE(cache.lookup(key, cache.getEpochs(namespaces)));
+
+    cache.insert(key, cache.getEpochs(namespaces), makeResults(3));
+    ASSERT_EQ(cache.size(), 1U);
+
+    auto results = cache.lookup(key, cache.getEpochs(namespaces));
+    ASSERT_TRUE(results);
+    ASSERT_EQ(results->size(), 3U);
+    ASSERT_BSONOBJ_EQ(results->back(), BSON("_id" << 2));
+}
+
+TEST(PipelineResultCacheTest, WriteToAnyNamespaceReadInvalidatesResults) {
+    PipelineResultCache cache(10);
+    const std::vector<NamespaceString> namespaces{kForeignNss, kTestNss};
+    const auto key = makeKey("{$match: {a: 1}}");
+
+    // A write to a namespace the pipeline does not read leaves the results valid.
+    cache.insert(key, cache.getEpochs(namespaces), makeResults(1));
+    cache.onWrite(NamespaceString("test.other"));
+    ASSERT_TRUE(cache.lookup(key, cache.getEpochs(namespaces)));
+
+    cache.onWrite(kForeignNss);
+    ASSERT_FALSE(cache.lookup(key, cache.getEpochs(namespaces)));
+    ASSERT_EQ(cache.size(), 0U);
+
+    cache.insert(key, cache.getEpochs(namespaces), makeResults(1));
+    ASSERT_TRUE(cache.lookup(key, cache.getEpochs(namespaces)));
+    cache.onWrite(kTestNss);
+    ASSERT_FALSE(cache.lookup(key, cache.getEpochs(namespaces)));
+}
+
+TEST(PipelineResultCacheTest, ResultsComputedBeforeConcurrentWriteAreNotServed) {
+    PipelineResultCache cache(10);
+    const std::vector<NamespaceString> namespaces{kTestNss};
+    const auto key = makeKey("{$match: {a: 1}}");
+
+    // The aggregation records the epochs before it starts, and a write commits while it runs.
+    auto epochsAtStart = cache.getEpochs(namespaces);
+    cache.onWrite(kTestNss);
+    cache.insert(key, std::move(epochsAtStart), makeResults(1));
+
+    ASSERT_FALSE(cache.lookup(key, cache.getEpochs(namespaces)));
+}
+
+TEST(PipelineResultCacheTest, GlobalWriteInvalidatesAllResults) {
+    PipelineResultCache cache(10);
+    const std::vector<NamespaceString> namespaces{kTestNss};
+    const auto firstKey = makeKey("{$match: {a: 1}}");
+    const auto secondKey = makeKey("{$match: {a: 2}}");
+
+    cache.insert(firstKey, cache.getEpochs(namespaces), makeResults(1));
+    cache.insert(secondKey, cache.getEpochs(namespaces), makeResults(1));
+    cache.onGlobalWrite();
+
+    ASSERT_FALSE(cache.lookup(firstKey, cache.getEpochs(namespaces)));
+    ASSERT_FALSE(cache.lookup(secondKey, cache.getEpochs(namespaces)));
+}
+
+TEST(PipelineResultCacheTest, DoesNotStoreResultsLargerThanMaxEntrySize) {
+    const auto originalMaxSizeBytes = internalQueryPipelineResultCacheMaxEntrySizeBytes.load();
+    ON_BLOCK_EXIT([&] {
+        internalQueryPipelineResultCacheMaxEntrySizeBytes.store(originalMaxSizeBytes);
+    });
+
+    PipelineResultCache cache(10);
+    const std::vector<NamespaceString> namespaces{kTestNss};
+    const auto key = makeKey("{$match: {a: 1}}");
+    const auto results = makeResults(10);
+    internalQueryPipelineResultCacheMaxEntrySizeBytes.store(results[0].objsize() * 10 - 1);
+
+    cache.insert(key, cache.getEpochs(namespaces), results);
+    ASSERT_FALSE(cache.lookup(key, cache.getEpochs(namespaces)));
+    ASSERT_EQ(cache.size(), 0U);
+
+    cache.insert(key, cache.getEpochs(namespaces), makeResults(9));
+    ASSERT_TRUE(cache.lookup(key, cache.getEpochs(namespaces)));
+}
+
+TEST(PipelineResultCacheTest, EvictsLeastRecentlyUsedResults) {
+    PipelineResultCache cache(2);
+    const std::vector<NamespaceString> namespaces{kTestNss};
+    const auto firstKey = makeKey("{$match: {a: 1}}");
+    const auto secondKey = makeKey("{$match: {a: 2}}");
+    const auto thirdKey = makeKey("{$match: {a: 3}}");
+
+    cache.insert(firstKey, cache.getEpochs(namespaces), makeResults(1));
+    cache.insert(secondKey, cache.getEpochs(namespaces), makeResults(1));
+    ASSERT_TRUE(cache.lookup(firstKey, cache.getEpochs(namespaces)));
+    cache.insert(thirdKey, cache.getEpochs(namespaces), makeResults(1));
+
+    ASSERT_EQ(cache.size(), 2U);
+    ASSERT_TRUE(cache.lookup(firstKey, cache.getEpochs(namespaces)));
+    ASSERT_FALSE(cache.lookup(secondKey, cache.getEpochs(namespaces)));
+    ASSERT_TRUE(cache.lookup(thirdKey, cache.getEpochs(namespaces)));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -251,6 +251,17 @@ public:
                                                 const NamespaceString& ns,
                                                 const std::vector<BSONObj>& indexSpecs) = 0;
 
+    /**
+     * Builds the given indexes on 'ns', which unlike for createIndexesOnEmptyCollection() may
+     * already hold documents. The indexes are built by the IndexBuildsCoordinator with the same
+     * protocol as the createIndexes command, i.e. a two-phase build on a replica set, and this
+     * waits for the build to finish. If running on a shardsvr this targets the primary shard of
+     * the database part of 'ns'.
+     */
+    virtual void createIndexesOnPopulatedCollection(OperationContext* opCtx,
+                                                    const NamespaceString& ns,
+                                                    const std::vector<BSONObj>& indexSpecs) = 0;
+
     virtual void dropCollection(OperationContext* opCtx, const NamespaceString& collection) = 0;
 
     /**
@@ -144,6 +144,12 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    void createIndexesOnPopulatedCollection(OperationContext* opCtx,
+                                            const NamespaceString& ns,
+                                            const std::vector<BSONObj>& indexSpecs) final {
+        MONGO_UNREACHABLE;
+    }
+
     void dropCollection(OperationContext* opCtx, const NamespaceString& collection) final {
         MONGO_UNREACHABLE;
     }
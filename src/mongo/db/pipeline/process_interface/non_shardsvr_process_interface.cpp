@@ -40,6 +40,7 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/index_builds_coordinator.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/repl/replication_coordinator.h"
 
 namespace mongo {
 
@@ -144,6 +145,75 @@ void NonShardServerProcessInterface::createIndexesOnEmptyCollection(
             wuow.commit();
         });
 }
+
+void NonShardServerProcessInterface::createIndexesOnPopulatedCollection(
+    OperationContext* opCtx, const NamespaceString& ns, const std::vector<BSONObj>& indexSpecs) {
+    OptionalCollectionUUID collectionUUID;
+    std::vector<BSONObj> filteredIndexes;
+    {
+        AutoGetCollection autoColl(opCtx, ns, MODE_IS);
+        uassert(ErrorCodes::DatabaseDropPending,
+                str::stream() << "The database is in the process of being dropped " << ns.db(),
+                autoColl.getDb() && !autoColl.getDb()->isDropPending(opCtx));
+
+        auto collection = autoColl.getCollection();
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << "Failed to create indexes for aggregation because collection "
+                                 "does not exist: "
+                              << ns << ": " << BSON("indexes" << indexSpecs),
+                collection);
+
+        collectionUUID = collection->uuid();
+        auto removeIndexBuildsToo = false;
+        filteredIndexes = collection->getIndexCatalog()->removeExistingIndexes(
+            opCtx, indexSpecs, removeIndexBuildsToo);
+    }
+
+    if (filteredIndexes.empty()) {
+        return;
+    }
+
+    // Build the indexes the same way the createIndexes command does. On a replica set the
+    // two-phase protocol scans the collection under intent locks and lets the secondaries build the
+    // indexes concurrently, instead of holding up replication behind a foreground build. The
+    // commit quorum is disabled, so that the primary commits the build on its own like it does
+    // the inserts, and the rename which follows is subject to the write concern of the $out.
+    auto replCoord = repl::ReplicationCoordinator::get(opCtx);
+    IndexBuildsCoordinator::IndexBuildOptions indexBuildOptions;
+    IndexBuildProtocol protocol = IndexBuildProtocol::kSinglePhase;
+    if (!replCoord->isOplogDisabledFor(opCtx, ns)) {
+        protocol = IndexBuildProtocol::kTwoPhase;
+        indexBuildOptions.commitQuorum = CommitQuorumOptions(CommitQuorumOptions::kDisabled);
+    }
+
+    auto indexBuildsCoord = IndexBuildsCoordinator::get(opCtx);
+    auto buildUUID = UUID::gen();
+    auto buildIndexFuture = uassertStatusOK(indexBuildsCoord->startIndexBuild(opCtx,
+                                                                              ns.db().toString(),
+                                                                              *collectionUUID,
+                                                                              filteredIndexes,
+                                                                              buildUUID,
+                                                                              protocol,
+                                                                              indexBuildOptions));
+    try {
+        buildIndexFuture.get(opCtx);
+    } catch (const DBException& ex) {
+        // The temporary collection is dropped when $out fails, so there is no point in letting the
+        // build carry on in the background. The current OperationContext may have been
+        // interrupted, so use a new one to abort the build. This is a no-op if the build has
+        // already failed by itself.
+        auto newClient = opCtx->getServiceContext()->makeClient("abort-index-build");
+        AlternativeClientRegion acr(newClient);
+        const auto abortCtx = cc().makeOperationContext();
+        indexBuildsCoord->abortIndexBuildByBuildUUID(
+            abortCtx.get(),
+            buildUUID,
+            IndexBuildAction::kPrimaryAbort,
+            str::stream() << "Index build aborted: " << buildUUID << ": " << ex.toString());
+        throw;
+    }
+}
+
 void NonShardServerProcessInterface::renameIfOptionsAndIndexesHaveNotChanged(
     OperationContext* opCtx,
     const BSONObj& renameCommandObj,
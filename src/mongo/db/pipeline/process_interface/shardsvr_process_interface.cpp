@@ -298,6 +298,12 @@ void ShardServerProcessInterface::createCollection(OperationContext* opCtx,
 }
 
 void ShardServerProcessInterface::createIndexesOnEmptyCollection(
+    OperationContext* opCtx, const NamespaceString& ns, const std::vector<BSONObj>& indexSpecs) {
+    // The createIndexes command sent to the primary shard handles empty collections as well.
+    createIndexesOnPopulatedCollection(opCtx, ns, indexSpecs);
+}
+
+void ShardServerProcessInterface::createIndexesOnPopulatedCollection(
     OperationContext* opCtx, const NamespaceString& ns, const std::vector<BSONObj>& indexSpecs) {
     auto cachedDbInfo =
         uassertStatusOK(Grid::get(opCtx)->catalogCache()->getDatabase(opCtx, ns.db()));
@@ -312,7 +318,7 @@ void ShardServerProcessInterface::createIndexesOnEmptyCollection(
         opCtx,
         Grid::get(opCtx)->catalogCache(),
         ns,
-        "copying index for empty collection {}"_format(ns.ns()),
+        "creating indexes for collection {}"_format(ns.ns()),
         [&] {
             auto response = executeRawCommandAgainstDatabasePrimary(
                 opCtx,
@@ -37,16 +37,22 @@
 
 namespace mongo {
 
-TeeBuffer::TeeBuffer(size_t nConsumers, size_t bufferSizeBytes)
-    : _bufferSizeBytes(bufferSizeBytes), _consumers(nConsumers) {}
+TeeBuffer::TeeBuffer(size_t nConsumers, size_t bufferSizeBytes, size_t bufferSizeDocs)
+    : _bufferSizeBytes(bufferSizeBytes), _bufferSizeDocs(bufferSizeDocs), _consumers(nConsumers) {}
 
-boost::intrusive_ptr<TeeBuffer> TeeBuffer::create(size_t nConsumers, int bufferSizeBytes) {
+boost::intrusive_ptr<TeeBuffer> TeeBuffer::create(size_t nConsumers,
+                                                  int bufferSizeBytes,
+                                                  int bufferSizeDocs) {
     uassert(40309, "need at least one consumer for a TeeBuffer", nConsumers > 0);
     uassert(40310,
             str::stream() << "TeeBuffer requires a positive buffer size, was given "
                           << bufferSizeBytes,
             bufferSizeBytes > 0);
-    return new TeeBuffer(nConsumers, bufferSizeBytes);
+    uassert(5073302,
+            str::stream() << "TeeBuffer requires a positive document batch size, was given "
+                          << bufferSizeDocs,
+            bufferSizeDocs > 0);
+    return new TeeBuffer(nConsumers, bufferSizeBytes, bufferSizeDocs);
 }
 
 DocumentSource::GetNextResult TeeBuffer::getNext(size_t consumerId) {
@@ -85,7 +91,7 @@ void TeeBuffer::loadNextBatch() {
         bytesInBuffer += input.getDocument().getApproximateSize();
         _buffer.push_back(std::move(input));
 
-        if (bytesInBuffer >= _bufferSizeBytes) {
+        if (bytesInBuffer >= _bufferSizeBytes || _buffer.size() >= _bufferSizeDocs) {
             break;  // Need to break here so we don't get the next input and accidentally ignore it.
         }
     }
@@ -45,15 +45,22 @@ namespace mongo {
  * do so, it will batch incoming documents and allow each consumer to consume one batch at a time.
  * As a consequence, consumers must be able to pause their execution to allow other consumers to
  * process the batch before moving to the next batch.
+ *
+ * Batches are bounded both in bytes and in documents. Keeping batches small means each document is
+ * handed to every consumer shortly after it was produced, so the consumers effectively stream over
+ * the shared input rather than over a large materialized buffer.
  */
 class TeeBuffer : public RefCountable {
 public:
     /**
      * Creates a TeeBuffer that will make results available to 'nConsumers' consumers. Note that
      * 'bufferSizeBytes' is a soft cap, and may be exceeded by one document's worth (~16MB).
+     * 'bufferSizeDocs' is the maximum number of documents in each batch.
      */
     static boost::intrusive_ptr<TeeBuffer> create(
-        size_t nConsumers, int bufferSizeBytes = internalQueryFacetBufferSizeBytes.load());
+        size_t nConsumers,
+        int bufferSizeBytes = internalQueryFacetBufferSizeBytes.load(),
+        int bufferSizeDocs = internalQueryFacetBufferSizeDocs.load());
 
     void setSource(DocumentSource* source) {
         _source = source;
@@ -84,18 +91,19 @@ public:
     DocumentSource::GetNextResult getNext(size_t consumerId);
 
 private:
-    TeeBuffer(size_t nConsumers, size_t bufferSizeBytes);
+    TeeBuffer(size_t nConsumers, size_t bufferSizeBytes, size_t bufferSizeDocs);
 
     /**
      * Clears '_buffer', then keeps requesting results from '_source' and pushing them all into
-     * '_buffer', until more than '_bufferSizeBytes' of documents have been returned, or until
-     * '_source' is exhausted.
+     * '_buffer', until more than '_bufferSizeBytes' of documents or '_bufferSizeDocs' documents
+     * have been returned, or until '_source' is exhausted.
      */
     void loadNextBatch();
 
     DocumentSource* _source = nullptr;
 
     const size_t _bufferSizeBytes;
+    const size_t _bufferSizeDocs;
     std::vector<DocumentSource::GetNextResult> _buffer;
 
     struct ConsumerInfo {
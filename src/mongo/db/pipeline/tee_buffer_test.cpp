@@ -52,6 +52,10 @@ TEST_F(TeeBufferTest, ShouldRequirePositiveBatchSize) {
     ASSERT_THROWS_CODE(TeeBuffer::create(1, -2), AssertionException, 40310);
 }
 
+TEST_F(TeeBufferTest, ShouldRequirePositiveMaxDocsPerBatch) {
+    ASSERT_THROWS_CODE(TeeBuffer::create(1, 1, 0), AssertionException, 5073302);
+}
+
 TEST_F(TeeBufferTest, ShouldBeExhaustedIfInputIsExhausted) {
     auto mock = DocumentSourceMock::createForTest(getExpCtx());
     auto teeBuffer = TeeBuffer::create(1);
@@ -143,6 +147,32 @@ TEST_F(TeeBufferTest, ShouldTellConsumerToPauseIfItFinishesBatchBeforeOtherConsu
     ASSERT_TRUE(teeBuffer->getNext(1).isEOF());
 }
 
+TEST_F(TeeBufferTest, ShouldLimitNumberOfDocumentsPerBatch) {
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"a", 1}}, Document{{"a", 2}}};
+    auto mock = DocumentSourceMock::createForTest(inputs, getExpCtx());
+
+    const size_t nConsumers = 2;
+    const size_t bufferBytes = 1024;  // Both docs would fit in a single batch by size.
+    const size_t bufferDocs = 1;
+    auto teeBuffer = TeeBuffer::create(nConsumers, bufferBytes, bufferDocs);
+    teeBuffer->setSource(mock.get());
+
+    auto next0 = teeBuffer->getNext(0);
+    ASSERT_TRUE(next0.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next0.getDocument(), inputs.front().getDocument());
+
+    // Consumer #1 hasn't seen the first doc yet, so consumer #0 must wait for it.
+    ASSERT_TRUE(teeBuffer->getNext(0).isPaused());
+
+    auto next1 = teeBuffer->getNext(1);
+    ASSERT_TRUE(next1.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next1.getDocument(), inputs.front().getDocument());
+
+    next0 = teeBuffer->getNext(0);
+    ASSERT_TRUE(next0.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next0.getDocument(), inputs.back().getDocument());
+}
+
 TEST_F(TeeBufferTest, ShouldAllowOtherConsumersToAdvanceOnceTrailingConsumerIsDisposed) {
     std::deque<DocumentSource::GetNextResult> inputs{Document{{"a", 1}}, Document{{"a", 2}}};
     auto mock = DocumentSourceMock::createForTest(inputs, getExpCtx());
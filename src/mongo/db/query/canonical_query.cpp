@@ -43,6 +43,7 @@
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/projection_parser.h"
 #include "mongo/db/query/query_planner_common.h"
+#include "mongo/db/query/query_shape_interner.h"
 
 namespace mongo {
 namespace {
@@ -114,15 +115,36 @@ StatusWith<std::unique_ptr<CanonicalQuery>> CanonicalQuery::canonicalize(
         }
     }
 
-    StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(
-        qr->getFilter(), newExpCtx, extensionsCallback, allowedFeatures);
-    if (!statusWithMatcher.isOK()) {
-        return statusWithMatcher.getStatus();
+    // Filters of a shape which has been seen before can skip parsing, and take their tree from the
+    // interned shape instead.
+    auto& shapeInterner = QueryShapeInterner::get(opCtx->getServiceContext());
+    boost::optional<std::string> shapeKey;
+    if (QueryShapeInterner::isEnabled() && !newExpCtx->isParsingCollectionValidator) {
+        shapeKey = QueryShapeInterner::computeShapeKey(qr->getFilter());
+    }
+
+    boost::optional<std::pair<std::unique_ptr<MatchExpression>, std::string>> interned;
+    if (shapeKey) {
+        interned = shapeInterner.instantiate(*shapeKey, qr->getFilter(), newExpCtx->getCollator());
+    }
+
+    std::unique_ptr<MatchExpression> me;
+    boost::optional<std::string> encodedMatch;
+    if (interned) {
+        me = std::move(interned->first);
+        encodedMatch = std::move(interned->second);
+    } else {
+        StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(
+            qr->getFilter(), newExpCtx, extensionsCallback, allowedFeatures);
+        if (!statusWithMatcher.isOK()) {
+            return statusWithMatcher.getStatus();
+        }
+        me = std::move(statusWithMatcher.getValue());
     }
-    std::unique_ptr<MatchExpression> me = std::move(statusWithMatcher.getValue());
 
     // Make the CQ we'll hopefully return.
     std::unique_ptr<CanonicalQuery> cq(new CanonicalQuery());
+    cq->_encodedMatch = std::move(encodedMatch);
 
     Status initStatus =
         cq->init(opCtx,
@@ -135,6 +157,10 @@ StatusWith<std::unique_ptr<CanonicalQuery>> CanonicalQuery::canonicalize(
     if (!initStatus.isOK()) {
         return initStatus;
     }
+
+    if (shapeKey && !cq->_encodedMatch) {
+        shapeInterner.intern(*shapeKey, cq->getQueryRequest().getFilter(), *cq->root());
+    }
     return std::move(cq);
 }
 
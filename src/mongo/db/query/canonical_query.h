@@ -177,6 +177,15 @@ public:
      */
     QueryShapeString encodeKey() const;
 
+    /**
+     * Returns the encoding of this query's match expression if it was already known when the
+     * query was canonicalized, which is the case when its filter shape had been interned by the
+     * QueryShapeInterner.
+     */
+    const boost::optional<std::string>& getEncodedMatch() const {
+        return _encodedMatch;
+    }
+
     /**
      * Sets this CanonicalQuery's collator, and sets the collator on this CanonicalQuery's match
      * expression tree.
@@ -247,6 +256,9 @@ private:
     QueryMetadataBitSet _metadataDeps;
 
     bool _canHaveNoopMatchNodes = false;
+
+    // The encoding of '_root' taken from an interned filter shape, if there was one.
+    boost::optional<std::string> _encodedMatch;
 };
 
 }  // namespace mongo
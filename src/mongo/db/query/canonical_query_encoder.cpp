@@ -521,7 +521,11 @@ namespace canonical_query_encoder {
 
 CanonicalQuery::QueryShapeString encode(const CanonicalQuery& cq) {
     StringBuilder keyBuilder;
-    encodeKeyForMatch(cq.root(), &keyBuilder);
+    if (auto&& encodedMatch = cq.getEncodedMatch()) {
+        keyBuilder << *encodedMatch;
+    } else {
+        encodeKeyForMatch(cq.root(), &keyBuilder);
+    }
     encodeKeyForSort(cq.getQueryRequest().getSort(), &keyBuilder);
     encodeKeyForProj(cq.getProj(), &keyBuilder);
     encodeCollation(cq.getCollator(), &keyBuilder);
@@ -529,6 +533,12 @@ CanonicalQuery::QueryShapeString encode(const CanonicalQuery& cq) {
     return keyBuilder.str();
 }
 
+std::string encodeMatch(const MatchExpression* tree) {
+    StringBuilder keyBuilder;
+    encodeKeyForMatch(tree, &keyBuilder);
+    return keyBuilder.str();
+}
+
 uint32_t computeHash(StringData key) {
     return SimpleStringDataComparator::kInstance.hash(key);
 }
@@ -41,6 +41,12 @@ namespace canonical_query_encoder {
  */
 CanonicalQuery::QueryShapeString encode(const CanonicalQuery& cq);
 
+/**
+ * Encode only the given normalized match expression, without values. This is the leading part of
+ * the encoding of any CanonicalQuery whose root is 'tree'.
+ */
+std::string encodeMatch(const MatchExpression* tree);
+
 /**
  * Returns a hash of the given key (produced from either a QueryShapeString or a PlanCacheKey).
  */
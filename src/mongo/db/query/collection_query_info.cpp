@@ -49,7 +49,10 @@
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/service_context.h"
+#include "mongo/db/storage/execution_context.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/logv2/log.h"
 #include "mongo/util/clock_source.h"
 
@@ -77,6 +80,80 @@ CoreIndexInfo indexInfoFromIndexCatalogEntry(const IndexCatalogEntry& ice) {
             projExec};
 }
 
+/**
+ * Builds statistics for 'coll' by drawing a random sample of its documents and generating the
+ * keys each of its btree indexes holds for them. Returns nullptr if the collection's storage does
+ * not support random sampling.
+ */
+std::shared_ptr<const plan_cost_estimator::CollectionStatistics> buildCollectionStatistics(
+    OperationContext* opCtx, const Collection* coll) {
+    auto cursor = coll->getRecordStore()->getRandomCursor(opCtx);
+    if (!cursor) {
+        return nullptr;
+    }
+
+    auto statistics = std::make_shared<plan_cost_estimator::CollectionStatistics>();
+    statistics->numRecords = coll->numRecords(opCtx);
+
+    struct IndexSample {
+        const IndexCatalogEntry* entry;
+        std::vector<BSONObj> keys;
+    };
+    std::vector<IndexSample> indexSamples;
+    std::unique_ptr<IndexCatalog::IndexIterator> ii =
+        coll->getIndexCatalog()->getIndexIterator(opCtx, false /* includeUnfinishedIndexes */);
+    while (ii->more()) {
+        const IndexCatalogEntry* entry = ii->next();
+        if (entry->descriptor()->getIndexType() == IndexType::INDEX_BTREE) {
+            indexSamples.push_back({entry, {}});
+        }
+    }
+
+    const auto sampleSize = std::min(
+        static_cast<double>(internalQueryIndexStatisticsSampleSize.load()), statistics->numRecords);
+    auto& executionCtx = StorageExecutionContext::get(opCtx);
+    size_t documentsSampled = 0;
+    for (; documentsSampled < sampleSize; ++documentsSampled) {
+        auto record = cursor->next();
+        if (!record) {
+            break;
+        }
+
+        const auto doc = record->data.toBson();
+        for (auto&& indexSample : indexSamples) {
+            const auto filter = indexSample.entry->getFilterExpression();
+            if (filter && !filter->matchesBSON(doc)) {
+                continue;
+            }
+
+            auto keys = executionCtx.keys();
+            const auto iam = indexSample.entry->accessMethod();
+            iam->getKeys(executionCtx.pooledBufferBuilder(),
+                         doc,
+                         IndexAccessMethod::GetKeysMode::kRelaxConstraints,
+                         IndexAccessMethod::GetKeysContext::kValidatingKeys,
+                         keys.get(),
+                         nullptr /* multikeyMetadataKeys */,
+                         nullptr /* multikeyPaths */,
+                         record->id,
+                         IndexAccessMethod::kNoopOnSuppressedErrorFn);
+            const auto ordering = iam->getSortedDataInterface()->getOrdering();
+            for (auto&& key : *keys) {
+                indexSample.keys.push_back(KeyString::toBson(key, ordering));
+            }
+        }
+    }
+
+    for (auto&& indexSample : indexSamples) {
+        const auto descriptor = indexSample.entry->descriptor();
+        statistics->indexHistograms.emplace(
+            descriptor->indexName(),
+            IndexKeyHistogram(
+                descriptor->keyPattern(), std::move(indexSample.keys), documentsSampled));
+    }
+    return statistics;
+}
+
 }  // namespace
 
 CollectionQueryInfo::CollectionQueryInfo()
@@ -189,6 +266,44 @@ void CollectionQueryInfo::clearQueryCache(const Collection* coll) {
     if (nullptr != _planCache.get()) {
         _planCache->clear();
     }
+
+    stdx::lock_guard<Latch> lk(_statisticsMutex);
+    _statistics.reset();
+}
+
+std::shared_ptr<const plan_cost_estimator::CollectionStatistics>
+CollectionQueryInfo::getCollectionStatistics(OperationContext* opCtx,
+                                             const Collection* coll) const {
+    {
+        stdx::lock_guard<Latch> lk(_statisticsMutex);
+        if (_statistics) {
+            // Changes smaller than the sample the statistics were built from are ignored, so that
+            // the statistics of a small collection are not rebuilt on every insert.
+            const double numRecords = coll->numRecords(opCtx);
+            const double threshold = internalQueryIndexStatisticsRefreshRatio.load() *
+                std::max(_statistics->numRecords,
+                         static_cast<double>(internalQueryIndexStatisticsSampleSize.load()));
+            if (std::abs(numRecords - _statistics->numRecords) <= threshold) {
+                return _statistics;
+            }
+        }
+    }
+
+    // Build the statistics without holding the mutex, since sampling reads from storage. Queries
+    // which race to build them each use their own, and the last one built is kept.
+    auto statistics = buildCollectionStatistics(opCtx, coll);
+    if (statistics) {
+        LOGV2_DEBUG(5073315,
+                    2,
+                    "Built collection statistics for plan cost estimation",
+                    "namespace"_attr = coll->ns(),
+                    "numRecords"_attr = statistics->numRecords,
+                    "numIndexes"_attr = statistics->indexHistograms.size());
+    }
+
+    stdx::lock_guard<Latch> lk(_statisticsMutex);
+    _statistics = statistics;
+    return statistics;
 }
 
 PlanCache* CollectionQueryInfo::getPlanCache() const {
@@ -31,8 +31,10 @@
 
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_cost_estimator.h"
 #include "mongo/db/query/plan_summary_stats.h"
 #include "mongo/db/update_index_data.h"
+#include "mongo/platform/mutex.h"
 
 namespace mongo {
 
@@ -82,7 +84,18 @@ public:
     void droppedIndex(OperationContext* opCtx, Collection* coll, StringData indexName);
 
     /**
-     * Removes all cached query plans.
+     * Get the statistics about this collection and its indexes used to estimate the cost of
+     * candidate query plans. They are built from a random sample of the collection's documents the
+     * first time they are needed, and rebuilt once the number of documents in the collection has
+     * changed by more than internalQueryIndexStatisticsRefreshRatio, or the indexes change.
+     *
+     * Returns nullptr if the collection's storage does not support random sampling.
+     */
+    std::shared_ptr<const plan_cost_estimator::CollectionStatistics> getCollectionStatistics(
+        OperationContext* opCtx, const Collection* coll) const;
+
+    /**
+     * Removes all cached query plans, along with the collection statistics.
      */
     void clearQueryCache(const Collection* coll);
 
@@ -106,6 +119,10 @@ private:
 
     // A cache for query plans.
     std::unique_ptr<PlanCache> _planCache;
+
+    // Statistics for estimating the cost of query plans, built lazily by getCollectionStatistics().
+    mutable Mutex _statisticsMutex = MONGO_MAKE_LATCH("CollectionQueryInfo::_statisticsMutex");
+    mutable std::shared_ptr<const plan_cost_estimator::CollectionStatistics> _statistics;
 };
 
 }  // namespace mongo
@@ -578,9 +578,71 @@ BSONObj Explain::statsToBSON(const PlanStageStats& stats, ExplainOptions::Verbos
     return bob.obj();
 }
 
+namespace {
+/**
+ * Converts the SBE stats tree 'stats' into BSON. Only the stages which report disk usage have
+ * their specific stats included for now.
+ */
+void sbeStatsToBSON(const sbe::PlanStageStats& stats,
+                    ExplainOptions::Verbosity verbosity,
+                    BSONObjBuilder* bob) {
+    bob->append("stage", stats.common.stageType);
+
+    if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+        bob->appendNumber("nReturned", static_cast<long long>(stats.common.advances));
+        bob->appendNumber("opens", static_cast<long long>(stats.common.opens));
+        bob->appendNumber("closes", static_cast<long long>(stats.common.closes));
+        bob->appendNumber("saveState", static_cast<long long>(stats.common.yields));
+        bob->appendNumber("restoreState", static_cast<long long>(stats.common.unyields));
+        bob->appendNumber("isEOF", stats.common.isEOF);
+
+        if (stats.common.stageType == "hj"_sd && stats.specific) {
+            auto spec = static_cast<const sbe::HashJoinStats*>(stats.specific.get());
+            bob->appendBool("usedDisk", spec->usedDisk);
+            bob->appendNumber("numPartitions", static_cast<long long>(spec->numPartitions));
+            bob->appendNumber("spilledBuildRecords",
+                              static_cast<long long>(spec->spilledBuildRecords));
+            bob->appendNumber("spilledProbeRecords",
+                              static_cast<long long>(spec->spilledProbeRecords));
+            bob->appendNumber("spilledBytes", static_cast<long long>(spec->spilledBytes));
+        } else if (stats.common.stageType == "group"_sd && stats.specific) {
+            auto spec = static_cast<const sbe::HashAggStats*>(stats.specific.get());
+            bob->appendBool("usedDisk", spec->usedDisk);
+            bob->appendNumber("spills", static_cast<long long>(spec->spills));
+            bob->appendNumber("spilledRecords", static_cast<long long>(spec->spilledRecords));
+        } else if (stats.common.stageType == "sort"_sd && stats.specific) {
+            auto spec = static_cast<const sbe::SortStats*>(stats.specific.get());
+            bob->appendBool("usedDisk", spec->usedDisk);
+            bob->appendNumber("keysSorted", static_cast<long long>(spec->keysSorted));
+            bob->appendNumber("keysSkippedByLimit",
+                              static_cast<long long>(spec->keysSkippedByLimit));
+            bob->appendNumber("totalDataSizeSorted",
+                              static_cast<long long>(spec->totalDataSizeBytes));
+        }
+    }
+
+    if (stats.children.empty()) {
+        return;
+    }
+
+    if (1 == stats.children.size()) {
+        BSONObjBuilder childBob(bob->subobjStart("inputStage"));
+        sbeStatsToBSON(*stats.children[0], verbosity, &childBob);
+        return;
+    }
+
+    BSONArrayBuilder childrenBob(bob->subarrayStart("inputStages"));
+    for (auto&& child : stats.children) {
+        BSONObjBuilder childBob(childrenBob.subobjStart());
+        sbeStatsToBSON(*child, verbosity, &childBob);
+    }
+}
+}  // namespace
+
 BSONObj Explain::statsToBSON(const sbe::PlanStageStats& stats,
                              ExplainOptions::Verbosity verbosity) {
     BSONObjBuilder bob;
+    sbeStatsToBSON(stats, verbosity, &bob);
     return bob.obj();
 }
 
@@ -71,6 +71,7 @@
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_cost_estimator.h"
 #include "mongo/db/query/plan_executor_factory.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/planner_analysis.h"
@@ -321,6 +322,10 @@ void fillOutPlannerParams(OperationContext* opCtx,
         plannerParams->options |= QueryPlannerParams::GENERATE_COVERED_IXSCANS;
     }
 
+    if (internalQueryPlannerEnableSkipScan.load()) {
+        plannerParams->options |= QueryPlannerParams::GENERATE_SKIP_SCANS;
+    }
+
     plannerParams->options |= QueryPlannerParams::SPLIT_LIMITED_SORT;
 
     if (shouldWaitForOplogVisibility(
@@ -592,8 +597,7 @@ public:
                                     "query"_attr = redact(_cq->toStringShort()));
                     }
 
-                    return buildCachedPlan(
-                        std::move(querySolution), plannerParams, cs->decisionWorks);
+                    return buildCachedPlan(std::move(querySolution), plannerParams, *cs);
                 }
             }
         }
@@ -636,6 +640,26 @@ public:
             }
         }
 
+        // Discard candidates which index statistics show to be much more expensive than another,
+        // rather than spending a trial period on them. This is not done for queries with a sort or
+        // limit, since a plan which is more expensive to run to completion may still be the best
+        // one if it can stop early.
+        if (solutions.size() > 1 && internalQueryEnableCostBasedPlanPruning.load() &&
+            _cq->getQueryRequest().getSort().isEmpty() && !_cq->getQueryRequest().getLimit() &&
+            !_cq->getQueryRequest().getNToReturn()) {
+            if (auto statistics = CollectionQueryInfo::get(_collection)
+                                      .getCollectionStatistics(_opCtx, _collection)) {
+                const auto numPruned =
+                    plan_cost_estimator::pruneDominatedSolutions(*statistics, &solutions);
+                LOGV2_DEBUG(5073316,
+                            2,
+                            "Pruned candidate plans using collection statistics",
+                            "query"_attr = redact(_cq->toStringShort()),
+                            "numPruned"_attr = numPruned,
+                            "numRemaining"_attr = solutions.size());
+            }
+        }
+
         if (1 == solutions.size()) {
             auto result = makeResult();
             // Only one possible plan. Run it. Build the stages from the solution.
@@ -688,10 +712,12 @@ protected:
      *       deactivated and we use multi-planning to select an entirely new  winning plan.
      *     * Or stores additional information in the result object, in case runtime planning is
      *       implemented as a standalone component, rather than as part of the execution tree.
+     *
+     * 'cs' is the cached solution 'solution' was reconstructed from.
      */
     virtual std::unique_ptr<ResultType> buildCachedPlan(std::unique_ptr<QuerySolution> solution,
                                                         const QueryPlannerParams& plannerParams,
-                                                        size_t decisionWorks) = 0;
+                                                        const CachedSolution& cs) = 0;
 
     /**
      * Constructs a special PlanStage tree for rooted $or queries. Each clause of the $or is planned
@@ -813,7 +839,7 @@ protected:
     std::unique_ptr<ClassicPrepareExecutionResult> buildCachedPlan(
         std::unique_ptr<QuerySolution> solution,
         const QueryPlannerParams& plannerParams,
-        size_t decisionWorks) final {
+        const CachedSolution& cs) final {
         auto result = makeResult();
         auto&& root = buildExecutableTree(*solution);
 
@@ -826,7 +852,7 @@ protected:
                                                           _ws,
                                                           _cq,
                                                           plannerParams,
-                                                          decisionWorks,
+                                                          cs.decisionWorks,
                                                           std::move(root)),
                         std::move(solution));
         return result;
@@ -908,11 +934,23 @@ protected:
     std::unique_ptr<SlotBasedPrepareExecutionResult> buildCachedPlan(
         std::unique_ptr<QuerySolution> solution,
         const QueryPlannerParams& plannerParams,
-        size_t decisionWorks) final {
+        const CachedSolution& cs) final {
         auto result = makeResult();
-        auto execTree = buildExecutableTree(*solution, true);
+
+        // If the cache entry holds an execution tree built for a solution of the same shape, clone
+        // it instead of building the tree from scratch.
+        auto execTree = [&]() {
+            if (auto cachedTree =
+                    dynamic_cast<const stage_builder::CachedPlanTree*>(cs.executionTree.get())) {
+                if (auto clonedTree = stage_builder::cloneCachedPlanTree(
+                        _opCtx, _collection, *_cq, *solution, *cachedTree, _yieldPolicy)) {
+                    return std::move(*clonedTree);
+                }
+            }
+            return buildExecutableTree(*solution, true);
+        }();
         result->emplace(std::move(execTree), std::move(solution));
-        result->setDecisionWorks(decisionWorks);
+        result->setDecisionWorks(cs.decisionWorks);
         return result;
     }
 
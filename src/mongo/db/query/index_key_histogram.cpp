@@ -0,0 +1,81 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_key_histogram.h"
+
+#include <algorithm>
+
+#include "mongo/bson/ordering.h"
+
+namespace mongo {
+
+IndexKeyHistogram::IndexKeyHistogram(BSONObj keyPattern,
+                                     std::vector<BSONObj> sampledKeys,
+                                     size_t documentsSampled)
+    : _keyPattern(keyPattern.getOwned()),
+      _boundaries(std::move(sampledKeys)),
+      _documentsSampled(documentsSampled) {
+    const auto ordering = Ordering::make(_keyPattern);
+    std::sort(_boundaries.begin(),
+              _boundaries.end(),
+              [&ordering](const BSONObj& lhs, const BSONObj& rhs) {
+                  return lhs.woCompare(rhs, ordering, false) < 0;
+              });
+}
+
+double IndexKeyHistogram::keysPerDocument() const {
+    if (_documentsSampled == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(_boundaries.size()) / _documentsSampled;
+}
+
+double IndexKeyHistogram::estimateSelectivity(const IndexBounds& bounds, int direction) const {
+    // Simple ranges, which come from a min() or max() on the query, are not checked against a key
+    // pattern, so conservatively assume that they scan the whole index.
+    if (bounds.isSimpleRange) {
+        return 1.0;
+    }
+
+    IndexBoundsChecker checker(&bounds, _keyPattern, direction);
+    size_t keysWithinBounds = 0;
+    for (auto&& key : _boundaries) {
+        if (checker.isValidKey(key)) {
+            ++keysWithinBounds;
+        }
+    }
+
+    // Count half a key towards every estimate, so that bounds which no sampled key falls within
+    // are estimated to select less than one bucket, rather than none of the index.
+    return (keysWithinBounds + 0.5) / (_boundaries.size() + 1);
+}
+
+}  // namespace mongo
@@ -0,0 +1,87 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/query/index_bounds.h"
+
+namespace mongo {
+
+/**
+ * An equi-depth histogram of the keys of a single index, built from the keys generated by a
+ * uniform random sample of the collection's documents. The bucket boundaries are the sampled keys
+ * themselves, in index order, so that each bucket holds an equal share of the index. The fraction
+ * of boundaries which lie within a set of index bounds then estimates the fraction of the index a
+ * scan over those bounds examines.
+ *
+ * Keeping whole keys rather than only their leading field allows bounds over several fields of a
+ * compound index to be estimated as precisely as bounds over one.
+ */
+class IndexKeyHistogram {
+public:
+    /**
+     * Builds a histogram for the index with 'keyPattern' from the keys generated by
+     * 'documentsSampled' sampled documents. The keys must have empty field names, as they do when
+     * they are decoded from KeyStrings.
+     */
+    IndexKeyHistogram(BSONObj keyPattern,
+                      std::vector<BSONObj> sampledKeys,
+                      size_t documentsSampled);
+
+    /**
+     * Returns the estimated average number of keys each document in the collection generates for
+     * this index. This is greater than one for a multikey index, and may be less for a sparse or
+     * partial index.
+     */
+    double keysPerDocument() const;
+
+    /**
+     * Returns the estimated fraction of this index's keys which lie within 'bounds', scanning in
+     * 'direction'. Returns a small non-zero fraction if no sampled key lies within the bounds,
+     * since the sample cannot rule out that some of the index does.
+     */
+    double estimateSelectivity(const IndexBounds& bounds, int direction) const;
+
+    size_t numBuckets() const {
+        return _boundaries.size();
+    }
+
+private:
+    BSONObj _keyPattern;
+
+    // The sampled keys, sorted in index order.
+    std::vector<BSONObj> _boundaries;
+
+    size_t _documentsSampled;
+};
+
+}  // namespace mongo
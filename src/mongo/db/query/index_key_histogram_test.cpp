@@ -0,0 +1,132 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_key_histogram.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+OrderedIntervalList makeInterval(const std::string& field, BSONObj range) {
+    OrderedIntervalList oil(field);
+    oil.intervals.push_back(Interval(range, true, true));
+    return oil;
+}
+
+IndexBounds makeBounds(std::vector<OrderedIntervalList> fields) {
+    IndexBounds bounds;
+    bounds.fields = std::move(fields);
+    return bounds;
+}
+
+// Returns one key for each value in [0, n).
+std::vector<BSONObj> makeKeys(int n) {
+    std::vector<BSONObj> keys;
+    for (int i = n - 1; i >= 0; --i) {
+        keys.push_back(BSON("" << i));
+    }
+    return keys;
+}
+
+TEST(IndexKeyHistogramTest, EstimatesSelectivityOfRange) {
+    IndexKeyHistogram histogram(BSON("a" << 1), makeKeys(99), 99);
+    ASSERT_EQ(histogram.numBuckets(), 99U);
+    ASSERT_EQ(histogram.keysPerDocument(), 1.0);
+
+    // 10 of the 99 keys are in [10, 19].
+    auto bounds = makeBounds({makeInterval("a", BSON("" << 10 << "" << 19))});
+    ASSERT_APPROX_EQUAL(histogram.estimateSelectivity(bounds, 1), 10.5 / 100, 1e-9);
+
+    auto allValues = makeBounds({makeInterval("a", BSON("" << MINKEY << "" << MAXKEY))});
+    ASSERT_APPROX_EQUAL(histogram.estimateSelectivity(allValues, 1), 99.5 / 100, 1e-9);
+}
+
+TEST(IndexKeyHistogramTest, EstimatesBoundsOutsideSampleAsLessThanOneBucket) {
+    IndexKeyHistogram histogram(BSON("a" << 1), makeKeys(99), 99);
+    auto bounds = makeBounds({makeInterval("a", BSON("" << 1000 << "" << 2000))});
+
+    const auto selectivity = histogram.estimateSelectivity(bounds, 1);
+    ASSERT_GT(selectivity, 0.0);
+    ASSERT_LT(selectivity, 1.0 / 99);
+}
+
+TEST(IndexKeyHistogramTest, EstimatesSelectivityOfDescendingScan) {
+    IndexKeyHistogram histogram(BSON("a" << -1), makeKeys(99), 99);
+
+    // Bounds over a descending index scanned forwards run from high values to low.
+    auto bounds = makeBounds({makeInterval("a", BSON("" << 19 << "" << 10))});
+    ASSERT_APPROX_EQUAL(histogram.estimateSelectivity(bounds, 1), 10.5 / 100, 1e-9);
+}
+
+TEST(IndexKeyHistogramTest, EstimatesBoundsOnAllFieldsOfCompoundIndex) {
+    // Keys {a: i % 10, b: i} for i in [0, 100).
+    std::vector<BSONObj> keys;
+    for (int i = 0; i < 100; ++i) {
+        keys.push_back(BSON("" << i % 10 << "" << i));
+    }
+    IndexKeyHistogram histogram(BSON("a" << 1 << "b" << 1), std::move(keys), 100);
+
+    // {a: 3} selects 10 keys, and {a: 3, b: {$lt: 50}} 5 of them.
+    auto pointBounds = makeBounds({makeInterval("a", BSON("" << 3 << "" << 3)),
+                                   makeInterval("b", BSON("" << MINKEY << "" << MAXKEY))});
+    ASSERT_APPROX_EQUAL(histogram.estimateSelectivity(pointBounds, 1), 10.5 / 101, 1e-9);
+
+    auto rangeBounds = makeBounds({makeInterval("a", BSON("" << 3 << "" << 3)),
+                                   makeInterval("b", BSON("" << MINKEY << "" << 49))});
+    ASSERT_APPROX_EQUAL(histogram.estimateSelectivity(rangeBounds, 1), 5.5 / 101, 1e-9);
+}
+
+TEST(IndexKeyHistogramTest, KeysPerDocumentReflectsMultikeyAndSparseIndexes) {
+    // A multikey index with three keys for each of the ten sampled documents.
+    IndexKeyHistogram multikeyHistogram(BSON("a" << 1), makeKeys(30), 10);
+    ASSERT_EQ(multikeyHistogram.keysPerDocument(), 3.0);
+
+    // A sparse index with keys for only half of the sampled documents.
+    IndexKeyHistogram sparseHistogram(BSON("a" << 1), makeKeys(5), 10);
+    ASSERT_EQ(sparseHistogram.keysPerDocument(), 0.5);
+
+    IndexKeyHistogram emptyHistogram(BSON("a" << 1), {}, 0);
+    ASSERT_EQ(emptyHistogram.keysPerDocument(), 0.0);
+}
+
+TEST(IndexKeyHistogramTest, AssumesSimpleRangeScansWholeIndex) {
+    IndexKeyHistogram histogram(BSON("a" << 1), makeKeys(10), 10);
+    IndexBounds bounds;
+    bounds.isSimpleRange = true;
+    bounds.startKey = BSON("" << 1);
+    bounds.endKey = BSON("" << 2);
+    ASSERT_EQ(histogram.estimateSelectivity(bounds, 1), 1.0);
+}
+
+}  // namespace
+}  // namespace mongo
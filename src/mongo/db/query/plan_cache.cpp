@@ -67,6 +67,11 @@ ServerStatusMetricField<Counter64> totalPlanCacheSizeEstimateBytesMetric(
 const char kEncodeDiscriminatorsBegin = '<';
 const char kEncodeDiscriminatorsEnd = '>';
 
+// The fewest entries a plan cache partition is given when the cache is split into partitions.
+// Below this, evicting the least recently used entry of a partition rather than of the whole cache
+// would noticeably shorten the life of entries in busy partitions.
+const size_t kMinEntriesPerPartition = 64;
+
 void encodeIndexabilityForDiscriminators(const MatchExpression* tree,
                                          const IndexToDiscriminatorMap& discriminators,
                                          StringBuilder* keyBuilder) {
@@ -175,7 +180,8 @@ CachedSolution::CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& en
       sort(entry.sort.getOwned()),
       projection(entry.projection.getOwned()),
       collation(entry.collation.getOwned()),
-      decisionWorks(entry.works) {
+      decisionWorks(entry.works),
+      executionTree(entry.executionTree) {
     // CachedSolution should not having any references into
     // cache entry. All relevant data should be cloned/copied.
     for (size_t i = 0; i < entry.plannerData.size(); ++i) {
@@ -205,7 +211,8 @@ std::unique_ptr<PlanCacheEntry> PlanCacheEntry::create(
     uint32_t planCacheKey,
     Date_t timeOfCreation,
     bool isActive,
-    size_t works) {
+    size_t works,
+    std::shared_ptr<const CachedExecutionTree> executionTree) {
     invariant(decision);
 
     // The caller of this constructor is responsible for ensuring
@@ -241,6 +248,7 @@ std::unique_ptr<PlanCacheEntry> PlanCacheEntry::create(
         queryHash,
         planCacheKey,
         std::move(decision),
+        std::move(executionTree),
         isActive,
         works));
 }
@@ -254,6 +262,7 @@ PlanCacheEntry::PlanCacheEntry(std::vector<std::unique_ptr<const SolutionCacheDa
                                const uint32_t queryHash,
                                const uint32_t planCacheKey,
                                std::unique_ptr<const plan_ranker::PlanRankingDecision> decision,
+                               std::shared_ptr<const CachedExecutionTree> executionTree,
                                const bool isActive,
                                const size_t works)
     : plannerData(std::move(plannerData)),
@@ -265,6 +274,7 @@ PlanCacheEntry::PlanCacheEntry(std::vector<std::unique_ptr<const SolutionCacheDa
       queryHash(queryHash),
       planCacheKey(planCacheKey),
       decision(std::move(decision)),
+      executionTree(std::move(executionTree)),
       isActive(isActive),
       works(works),
       _entireObjectSize(_estimateObjectSizeInBytes()) {
@@ -294,6 +304,7 @@ std::unique_ptr<PlanCacheEntry> PlanCacheEntry::clone() const {
                                                               queryHash,
                                                               planCacheKey,
                                                               std::move(decisionPtr),
+                                                              executionTree,
                                                               isActive,
                                                               works));
 }
@@ -306,6 +317,8 @@ uint64_t PlanCacheEntry::_estimateObjectSizeInBytes() const {
             true) +
         // Add the entire size of 'decision' object.
         (decision ? decision->estimateObjectSizeInBytes() : 0) +
+        // Add the size of the cached execution tree.
+        (executionTree ? executionTree->estimateObjectSizeInBytes() : 0) +
         // Add the size of all the owned BSON objects.
         query.objsize() + sort.objsize() + projection.objsize() + collation.objsize() +
         // Add size of the object.
@@ -415,6 +428,10 @@ std::string SolutionCacheData::toString() const {
             verify(this->tree.get());
             return str::stream() << "(index-tagged expression tree: "
                                  << "tree=" << this->tree->toString() << ")";
+        case SKIP_IXSCAN_SOLN:
+            verify(this->tree.get());
+            return str::stream() << "(skip scan solution: "
+                                 << "tree=" << this->tree->toString() << ")";
     }
     MONGO_UNREACHABLE;
 }
@@ -425,7 +442,18 @@ std::string SolutionCacheData::toString() const {
 
 PlanCache::PlanCache() : PlanCache(internalQueryCacheSize.load()) {}
 
-PlanCache::PlanCache(size_t size) : _cache(size) {}
+PlanCache::PlanCache(size_t size) : PlanCache(size, internalQueryCacheNumPartitions.load()) {}
+
+PlanCache::PlanCache(size_t size, size_t numPartitions) {
+    numPartitions = std::max<size_t>(1, std::min(numPartitions, size / kMinEntriesPerPartition));
+
+    // Spread the capacity over the partitions so that it adds up to exactly 'size'.
+    _partitions.reserve(numPartitions);
+    for (size_t i = 0; i < numPartitions; ++i) {
+        const size_t partitionSize = size / numPartitions + (i < size % numPartitions ? 1 : 0);
+        _partitions.push_back(std::make_unique<Partition>(partitionSize));
+    }
+}
 
 PlanCache::~PlanCache() {}
 
@@ -545,7 +573,8 @@ Status PlanCache::set(const CanonicalQuery& query,
                       const std::vector<QuerySolution*>& solns,
                       std::unique_ptr<plan_ranker::PlanRankingDecision> why,
                       Date_t now,
-                      boost::optional<double> worksGrowthCoefficient) {
+                      boost::optional<double> worksGrowthCoefficient,
+                      std::shared_ptr<const CachedExecutionTree> executionTree) {
     invariant(why);
 
     if (solns.empty()) {
@@ -577,7 +606,8 @@ Status PlanCache::set(const CanonicalQuery& query,
                                  }},
         why->stats);
     const auto key = computeKey(query);
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = _getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
     bool isNewEntryActive = false;
     uint32_t queryHash;
     uint32_t planCacheKey;
@@ -588,7 +618,7 @@ Status PlanCache::set(const CanonicalQuery& query,
         queryHash = canonical_query_encoder::computeHash(key.getStableKeyStringData());
     } else {
         PlanCacheEntry* oldEntry = nullptr;
-        Status cacheStatus = _cache.get(key, &oldEntry);
+        Status cacheStatus = partition.cache.get(key, &oldEntry);
         invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
         if (oldEntry) {
             queryHash = oldEntry->queryHash;
@@ -612,10 +642,17 @@ Status PlanCache::set(const CanonicalQuery& query,
         isNewEntryActive = newState.shouldBeActive;
     }
 
-    auto newEntry(PlanCacheEntry::create(
-        solns, std::move(why), query, queryHash, planCacheKey, now, isNewEntryActive, newWorks));
+    auto newEntry(PlanCacheEntry::create(solns,
+                                         std::move(why),
+                                         query,
+                                         queryHash,
+                                         planCacheKey,
+                                         now,
+                                         isNewEntryActive,
+                                         newWorks,
+                                         std::move(executionTree)));
 
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, newEntry.release());
+    std::unique_ptr<PlanCacheEntry> evictedEntry = partition.cache.add(key, newEntry.release());
 
     if (nullptr != evictedEntry.get()) {
         LOGV2_DEBUG(20942,
@@ -635,9 +672,10 @@ void PlanCache::deactivate(const CanonicalQuery& query) {
     }
 
     PlanCacheKey key = computeKey(query);
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = _getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return;
@@ -652,9 +690,10 @@ PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
 }
 
 PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = _getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return {CacheEntryState::kNotPresent, nullptr};
@@ -667,13 +706,17 @@ PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    const auto key = computeKey(canonicalQuery);
+    auto& partition = _getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
+    return partition.cache.remove(key);
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        partition->cache.clear();
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -687,9 +730,10 @@ PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
 StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQuery& query) const {
     PlanCacheKey key = computeKey(query);
 
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = _getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -699,20 +743,26 @@ StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQ
 }
 
 std::vector<std::unique_ptr<PlanCacheEntry>> PlanCache::getAllEntries() const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
     std::vector<std::unique_ptr<PlanCacheEntry>> entries;
 
-    for (auto&& cacheEntry : _cache) {
-        auto entry = cacheEntry.second;
-        entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        for (auto&& cacheEntry : partition->cache) {
+            auto entry = cacheEntry.second;
+            entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+        }
     }
 
     return entries;
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t total = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        total += partition->cache.size();
+    }
+    return total;
 }
 
 void PlanCache::notifyOfIndexUpdates(const std::vector<CoreIndexInfo>& indexCores) {
@@ -723,17 +773,30 @@ std::vector<BSONObj> PlanCache::getMatchingStats(
     const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
     const std::function<bool(const BSONObj&)>& filterFunc) const {
     std::vector<BSONObj> results;
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
 
-    for (auto&& cacheEntry : _cache) {
-        const auto entry = cacheEntry.second;
-        auto serializedEntry = serializationFunc(*entry);
-        if (filterFunc(serializedEntry)) {
-            results.push_back(serializedEntry);
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        for (auto&& cacheEntry : partition->cache) {
+            const auto entry = cacheEntry.second;
+            auto serializedEntry = serializationFunc(*entry);
+            if (filterFunc(serializedEntry)) {
+                results.push_back(serializedEntry);
+            }
         }
     }
 
     return results;
 }
 
+PlanCache::Partition& PlanCache::_getPartition(const PlanCacheKey& key) const {
+    if (_partitions.size() == 1) {
+        return *_partitions.front();
+    }
+    // The partition's hash map uses the same hash, so pick the partition from the high bits of a
+    // remixed hash. Taking the hash modulo the partition count instead would make the keys of one
+    // partition share their low bits, which the map relies on to tell keys apart.
+    const uint64_t mixed = static_cast<uint64_t>(key.hash()) * 0x9E3779B97F4A7C15ULL;
+    return *_partitions[((mixed >> 32) * _partitions.size()) >> 32];
+}
+
 }  // namespace mongo
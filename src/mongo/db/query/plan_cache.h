@@ -52,6 +52,7 @@ public:
         _lengthOfStablePart = shapeString.size();
         _key = std::move(shapeString);
         _key += indexabilityString;
+        _hash = std::hash<std::string>{}(_key);
     }
 
     CanonicalQuery::QueryShapeString getStableKey() const {
@@ -77,6 +78,14 @@ public:
         return _key;
     }
 
+    /**
+     * Returns a hash of the whole key. It is computed once on construction, so that picking a plan
+     * cache partition and looking the key up within it do not each hash the key string.
+     */
+    size_t hash() const {
+        return _hash;
+    }
+
     bool operator==(const PlanCacheKey& other) const {
         return other._key == _key && other._lengthOfStablePart == _lengthOfStablePart;
     }
@@ -94,6 +103,8 @@ private:
 
     // How long the "stable key" is.
     size_t _lengthOfStablePart;
+
+    size_t _hash;
 };
 
 std::ostream& operator<<(std::ostream& stream, const PlanCacheKey& key);
@@ -102,7 +113,7 @@ StringBuilder& operator<<(StringBuilder& builder, const PlanCacheKey& key);
 class PlanCacheKeyHasher {
 public:
     std::size_t operator()(const PlanCacheKey& k) const {
-        return std::hash<std::string>{}(k.toString());
+        return k.hash();
     }
 };
 
@@ -252,7 +263,11 @@ struct SolutionCacheData {
 
         // Build the solution by using 'tree'
         // to tag the match expression.
-        USE_INDEX_TAGS_SOLN
+        USE_INDEX_TAGS_SOLN,
+
+        // The cached plan skip scans the index
+        // stored in 'tree'.
+        SKIP_IXSCAN_SOLN
     } solnType;
 
     // The direction of the index scan used as
@@ -266,6 +281,23 @@ struct SolutionCacheData {
 
 class PlanCacheEntry;
 
+/**
+ * An execution engine specific representation of the winning plan which can be stored in a plan
+ * cache entry alongside the planner data, so that a cache hit can reuse it rather than rebuilding
+ * the execution tree from the QuerySolution. Once stored in the cache the tree is immutable and is
+ * shared between all the copies of the entry.
+ */
+class CachedExecutionTree {
+public:
+    virtual ~CachedExecutionTree() = default;
+
+    /**
+     * Returns the approximate size of this object in bytes, which is accounted for in the size of
+     * the plan cache entry holding it.
+     */
+    virtual uint64_t estimateObjectSizeInBytes() const = 0;
+};
+
 /**
  * Information returned from a get(...) query.
  */
@@ -298,6 +330,9 @@ public:
     // The number of work cycles taken to decide on a winning plan when the plan was first
     // cached.
     size_t decisionWorks;
+
+    // The execution tree of the winning plan, if one was stored in the cache entry.
+    std::shared_ptr<const CachedExecutionTree> executionTree;
 };
 
 /**
@@ -319,7 +354,8 @@ public:
         uint32_t planCacheKey,
         Date_t timeOfCreation,
         bool isActive,
-        size_t works);
+        size_t works,
+        std::shared_ptr<const CachedExecutionTree> executionTree = nullptr);
 
     ~PlanCacheEntry();
 
@@ -365,6 +401,10 @@ public:
     // Information that went into picking the winning plan and also why the other plans lost.
     const std::unique_ptr<const plan_ranker::PlanRankingDecision> decision;
 
+    // The execution tree built for the winning plan, or nullptr if the execution engine could not
+    // provide one which is reusable across queries of this shape.
+    const std::shared_ptr<const CachedExecutionTree> executionTree;
+
     // Whether or not the cache entry is active. Inactive cache entries should not be used for
     // planning.
     bool isActive = false;
@@ -393,6 +433,7 @@ private:
                    uint32_t queryHash,
                    uint32_t planCacheKey,
                    std::unique_ptr<const plan_ranker::PlanRankingDecision> decision,
+                   std::shared_ptr<const CachedExecutionTree> executionTree,
                    bool isActive,
                    size_t works);
 
@@ -411,6 +452,10 @@ private:
  * Caches the best solution to a query.  Aside from the (CanonicalQuery -> QuerySolution)
  * mapping, the cache contains information on why that mapping was made and statistics on the
  * cache entry's actual performance on subsequent runs.
+ *
+ * The cache is split into partitions by the hash of the PlanCacheKey. Each partition is an
+ * independent LRU store with its own latch and an equal share of the cache's capacity, so that
+ * concurrent operations on different query shapes of the same collection do not contend.
  */
 class PlanCache {
 private:
@@ -459,6 +504,13 @@ public:
 
     PlanCache(size_t size);
 
+    /**
+     * Creates a cache of at most 'size' entries split into at most 'numPartitions' partitions.
+     * Fewer partitions are used if 'size' is too small to give each of them a useful number of
+     * entries, since eviction within a partition only approximates eviction across the cache.
+     */
+    PlanCache(size_t size, size_t numPartitions);
+
     ~PlanCache();
 
     /**
@@ -473,13 +525,17 @@ public:
      * an inactive cache entry.  If boost::none is provided, the function will use
      * 'internalQueryCacheWorksGrowthCoefficient'.
      *
+     * If 'executionTree' is provided, it is stored in the new cache entry so that subsequent cache
+     * hits can reuse it instead of building the execution tree for the best plan from scratch.
+     *
      * If the mapping was set successfully, returns Status::OK(), even if it evicted another entry.
      */
     Status set(const CanonicalQuery& query,
                const std::vector<QuerySolution*>& solns,
                std::unique_ptr<plan_ranker::PlanRankingDecision> why,
                Date_t now,
-               boost::optional<double> worksGrowthCoefficient = boost::none);
+               boost::optional<double> worksGrowthCoefficient = boost::none,
+               std::shared_ptr<const CachedExecutionTree> executionTree = nullptr);
 
     /**
      * Set a cache entry back to the 'inactive' state. Rather than completely evicting an entry
@@ -553,6 +609,13 @@ public:
      */
     size_t size() const;
 
+    /**
+     * Returns the number of partitions the cache is split into.
+     */
+    size_t numPartitions() const {
+        return _partitions.size();
+    }
+
     /**
      * Updates internal state kept about the collection's indexes.  Must be called when the set
      * of indexes on the associated collection have changed.
@@ -564,6 +627,9 @@ public:
     /**
      * Iterates over the plan cache. For each entry, serializes the PlanCacheEntry according to
      * 'serializationFunc'. Returns a vector of all serialized entries which match 'filterFunc'.
+     *
+     * The partitions are visited one at a time, so the result is not a point-in-time view of the
+     * whole cache if it is modified concurrently.
      */
     std::vector<BSONObj> getMatchingStats(
         const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
@@ -582,10 +648,22 @@ private:
                                    size_t newWorks,
                                    double growthCoefficient);
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> _cache;
+    /**
+     * One independently locked LRU store holding the entries whose keys hash to it.
+     */
+    struct Partition {
+        explicit Partition(size_t size) : cache(size) {}
+
+        LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> cache;
+
+        // Protects 'cache'.
+        mutable Mutex mutex = MONGO_MAKE_LATCH("PlanCache::Partition::mutex");
+    };
+
+    Partition& _getPartition(const PlanCacheKey& key) const;
 
-    // Protects _cache.
-    mutable Mutex _cacheMutex = MONGO_MAKE_LATCH("PlanCache::_cacheMutex");
+    // Never resized after construction, so may be read without synchronization.
+    std::vector<std::unique_ptr<Partition>> _partitions;
 
     // Holds computed information about the collection's indexes.  Used for generating plan
     // cache keys.
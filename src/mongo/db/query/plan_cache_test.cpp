@@ -572,6 +572,46 @@ TEST(PlanCacheTest, PlanCacheLRUPolicyRemovesInactiveEntries) {
     ASSERT_EQ(planCache.get(*cqC).state, PlanCache::CacheEntryState::kPresentInactive);
 }
 
+TEST(PlanCacheTest, SmallCachesAreNotPartitioned) {
+    ASSERT_EQ(PlanCache(0, 16).numPartitions(), 1U);
+    ASSERT_EQ(PlanCache(100, 16).numPartitions(), 1U);
+    ASSERT_EQ(PlanCache(256, 16).numPartitions(), 4U);
+    ASSERT_EQ(PlanCache(5000, 16).numPartitions(), 16U);
+    ASSERT_EQ(PlanCache(5000, 1).numPartitions(), 1U);
+}
+
+TEST(PlanCacheTest, PartitionedCacheOperatesOnEveryPartition) {
+    PlanCache planCache(256, 4);
+    ASSERT_EQ(planCache.numPartitions(), 4U);
+
+    // Add an entry for each of enough shapes that every partition holds some of them.
+    std::vector<unique_ptr<CanonicalQuery>> queries;
+    for (char field = 'a'; field <= 'z'; ++field) {
+        queries.push_back(canonicalize(BSON(std::string(1, field) << 1)));
+        addCacheEntryForShape(*queries.back(), &planCache);
+    }
+    ASSERT_EQ(planCache.size(), queries.size());
+    ASSERT_EQ(planCache.getAllEntries().size(), queries.size());
+    ASSERT_EQ(planCache
+                  .getMatchingStats([](const PlanCacheEntry& entry) { return BSONObj(); },
+                                    [](const BSONObj& obj) { return true; })
+                  .size(),
+              queries.size());
+    for (auto&& cq : queries) {
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+
+    ASSERT_OK(planCache.remove(*queries.front()));
+    ASSERT_EQ(planCache.get(*queries.front()).state, PlanCache::CacheEntryState::kNotPresent);
+    ASSERT_EQ(planCache.size(), queries.size() - 1);
+
+    planCache.clear();
+    ASSERT_EQ(planCache.size(), 0U);
+    for (auto&& cq : queries) {
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
+    }
+}
+
 TEST(PlanCacheTest, PlanCacheRemoveDeletesInactiveEntries) {
     PlanCache planCache;
     unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -826,6 +866,39 @@ TEST(PlanCacheTest, DeactivateCacheEntry) {
     ASSERT_EQ(entry->works, 20U);
 }
 
+TEST(PlanCacheTest, ExecutionTreeIsPassedToCachedSolution) {
+    struct FakeExecutionTree final : public CachedExecutionTree {
+        uint64_t estimateObjectSizeInBytes() const final {
+            return sizeof(*this);
+        }
+    };
+
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+    auto executionTree = std::make_shared<const FakeExecutionTree>();
+
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(
+        *cq, solns, createDecision(1U, 50), Date_t{}, boost::none, executionTree));
+    ASSERT_OK(planCache.set(
+        *cq, solns, createDecision(1U, 20), Date_t{}, boost::none, executionTree));
+
+    // The execution tree is shared between the cache entry and the solutions handed out from it.
+    auto entry = assertGet(planCache.getEntry(*cq));
+    ASSERT_EQ(entry->executionTree.get(), executionTree.get());
+    auto cs = planCache.getCacheEntryIfActive(planCache.computeKey(*cq));
+    ASSERT(cs);
+    ASSERT_EQ(cs->executionTree.get(), executionTree.get());
+
+    // Entries created without an execution tree do not have one.
+    planCache.clear();
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 20), Date_t{}));
+    entry = assertGet(planCache.getEntry(*cq));
+    ASSERT_FALSE(entry->executionTree);
+}
+
 TEST(PlanCacheTest, GetMatchingStatsMatchesAndSerializesCorrectly) {
     PlanCache planCache;
 
@@ -0,0 +1,153 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cost_estimator.h"
+
+#include <algorithm>
+
+#include "mongo/db/query/query_knobs_gen.h"
+
+namespace mongo::plan_cost_estimator {
+
+namespace {
+
+boost::optional<Estimate> estimateIndexScan(const IndexScanNode& ixscan,
+                                            const CollectionStatistics& stats) {
+    if (ixscan.index.type != IndexType::INDEX_BTREE) {
+        return boost::none;
+    }
+
+    auto it = stats.indexHistograms.find(ixscan.index.identifier.catalogName);
+    if (it == stats.indexHistograms.end()) {
+        return boost::none;
+    }
+
+    const auto& histogram = it->second;
+    const double keysExamined = stats.numRecords * histogram.keysPerDocument() *
+        histogram.estimateSelectivity(ixscan.bounds, ixscan.direction);
+    return Estimate{keysExamined, keysExamined};
+}
+
+}  // namespace
+
+boost::optional<Estimate> estimate(const QuerySolutionNode* node,
+                                   const CollectionStatistics& stats) {
+    switch (node->getType()) {
+        case STAGE_COLLSCAN:
+            return Estimate{stats.numRecords, stats.numRecords};
+        case STAGE_IXSCAN:
+            return estimateIndexScan(*static_cast<const IndexScanNode*>(node), stats);
+        case STAGE_AND_HASH:
+        case STAGE_AND_SORTED:
+        case STAGE_OR:
+        case STAGE_SORT_MERGE: {
+            // Every child is scanned in full. An intersection produces at most as many results as
+            // its most selective child, and a union at most as many as all of its children.
+            const bool isIntersection =
+                node->getType() == STAGE_AND_HASH || node->getType() == STAGE_AND_SORTED;
+            Estimate total;
+            boost::optional<double> minCardinality;
+            for (auto&& child : node->children) {
+                auto childEstimate = estimate(child, stats);
+                if (!childEstimate) {
+                    return boost::none;
+                }
+                total.cost += childEstimate->cost;
+                total.cardinality += childEstimate->cardinality;
+                minCardinality = std::min(minCardinality.value_or(childEstimate->cardinality),
+                                          childEstimate->cardinality);
+            }
+            if (isIntersection && minCardinality) {
+                total.cardinality = *minCardinality;
+            }
+            return total;
+        }
+        case STAGE_FETCH:
+        case STAGE_SORT_DEFAULT:
+        case STAGE_SORT_SIMPLE: {
+            // Each result of the child is fetched or buffered once.
+            invariant(node->children.size() == 1);
+            auto childEstimate = estimate(node->children[0], stats);
+            if (!childEstimate) {
+                return boost::none;
+            }
+            return Estimate{childEstimate->cost + childEstimate->cardinality,
+                            childEstimate->cardinality};
+        }
+        case STAGE_PROJECTION_COVERED:
+        case STAGE_PROJECTION_DEFAULT:
+        case STAGE_PROJECTION_SIMPLE:
+        case STAGE_RETURN_KEY:
+        case STAGE_SHARDING_FILTER:
+        case STAGE_SKIP:
+        case STAGE_SORT_KEY_GENERATOR: {
+            invariant(node->children.size() == 1);
+            return estimate(node->children[0], stats);
+        }
+        default:
+            return boost::none;
+    }
+}
+
+size_t pruneDominatedSolutions(const CollectionStatistics& stats,
+                               std::vector<std::unique_ptr<QuerySolution>>* solutions) {
+    invariant(solutions);
+
+    std::vector<boost::optional<double>> costs;
+    boost::optional<double> minCost;
+    for (auto&& solution : *solutions) {
+        auto solutionEstimate = estimate(solution->root.get(), stats);
+        costs.push_back(solutionEstimate ? boost::make_optional(solutionEstimate->cost)
+                                         : boost::none);
+        if (solutionEstimate) {
+            minCost = std::min(minCost.value_or(solutionEstimate->cost), solutionEstimate->cost);
+        }
+    }
+    if (!minCost) {
+        return 0;
+    }
+
+    const double maxCost = internalQueryCostBasedPlanPruningRatio.load() *
+        std::max(*minCost, static_cast<double>(internalQueryPlanEvaluationMaxResults.load()));
+
+    size_t numPruned = 0;
+    for (size_t i = 0; i < solutions->size(); ++i) {
+        if (costs[i] && *costs[i] > maxCost) {
+            (*solutions)[i].reset();
+            ++numPruned;
+        }
+    }
+    solutions->erase(std::remove(solutions->begin(), solutions->end(), nullptr), solutions->end());
+    invariant(!solutions->empty());
+    return numPruned;
+}
+
+}  // namespace mongo::plan_cost_estimator
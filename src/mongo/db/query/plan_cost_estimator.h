@@ -0,0 +1,90 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/db/query/index_key_histogram.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/stdx/unordered_map.h"
+
+/**
+ * Estimates the cost of candidate query solutions from statistics about the collection and its
+ * indexes, so that candidates which are clearly more expensive than another can be discarded
+ * before the multi-planner spends a trial period on them.
+ *
+ * Costs are measured in the same unit as the 'works' of a trial period: every index key examined,
+ * every document fetched and every document scanned by a collection scan costs one.
+ */
+namespace mongo::plan_cost_estimator {
+
+/**
+ * The statistics about a collection which the cost of its query solutions is estimated from.
+ */
+struct CollectionStatistics {
+    double numRecords = 0;
+
+    // Histograms of the keys of the collection's btree indexes, keyed by index name. An index
+    // without a histogram makes the cost of every solution which scans it unknown.
+    stdx::unordered_map<std::string, IndexKeyHistogram> indexHistograms;
+};
+
+/**
+ * The estimated cost of a query solution subtree, and the number of results it produces.
+ */
+struct Estimate {
+    double cost = 0;
+    double cardinality = 0;
+};
+
+/**
+ * Returns the estimated cost of the subtree rooted at 'node', or boost::none if it contains a
+ * stage whose cost cannot be estimated from 'stats', such as a text or geo stage, or a scan of an
+ * index without a histogram.
+ */
+boost::optional<Estimate> estimate(const QuerySolutionNode* node,
+                                   const CollectionStatistics& stats);
+
+/**
+ * Removes from 'solutions' every candidate whose estimated cost is more than
+ * internalQueryCostBasedPlanPruningRatio times that of the cheapest candidate. Candidates whose
+ * cost cannot be estimated are kept. Costs below internalQueryPlanEvaluationMaxResults are treated
+ * as equal to it, since a trial period over plans that cheap ends almost immediately anyway, and
+ * the statistics are not precise enough to tell them apart.
+ *
+ * Returns the number of candidates removed. At least one candidate always remains.
+ */
+size_t pruneDominatedSolutions(const CollectionStatistics& stats,
+                               std::vector<std::unique_ptr<QuerySolution>>* solutions);
+
+}  // namespace mongo::plan_cost_estimator
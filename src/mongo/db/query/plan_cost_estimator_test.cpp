@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cost_estimator.h"
+
+#include "mongo/db/query/index_entry.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo::plan_cost_estimator {
+namespace {
+
+IndexEntry buildSimpleIndexEntry(const BSONObj& kp, const std::string& indexName) {
+    return {kp,
+            IndexNames::nameToType(IndexNames::findPluginName(kp)),
+            false,
+            {},
+            {},
+            false,
+            false,
+            CoreIndexInfo::Identifier(indexName),
+            nullptr,
+            {},
+            nullptr,
+            nullptr};
+}
+
+// Returns a histogram over the single field 'a' with one key for each value in [0, 99).
+IndexKeyHistogram makeHistogram() {
+    std::vector<BSONObj> keys;
+    for (int i = 0; i < 99; ++i) {
+        keys.push_back(BSON("" << i));
+    }
+    return IndexKeyHistogram(BSON("a" << 1), std::move(keys), 99);
+}
+
+CollectionStatistics makeStats(double numRecords) {
+    CollectionStatistics stats;
+    stats.numRecords = numRecords;
+    stats.indexHistograms.emplace("a_1", makeHistogram());
+    return stats;
+}
+
+// Returns a FETCH over a scan of the index 'indexName' on {a: 1} with the bounds [min, max].
+std::unique_ptr<QuerySolutionNode> makeFetchIndexScan(const std::string& indexName,
+                                                      int min,
+                                                      int max) {
+    auto ixscan = std::make_unique<IndexScanNode>(buildSimpleIndexEntry(BSON("a" << 1), indexName));
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(Interval(BSON("" << min << "" << max), true, true));
+    ixscan->bounds.fields.push_back(std::move(oil));
+
+    auto fetch = std::make_unique<FetchNode>();
+    fetch->children.push_back(ixscan.release());
+    return fetch;
+}
+
+std::unique_ptr<QuerySolution> makeSolution(std::unique_ptr<QuerySolutionNode> root) {
+    auto solution = std::make_unique<QuerySolution>();
+    solution->root = std::move(root);
+    return solution;
+}
+
+TEST(PlanCostEstimatorTest, FetchCostIncludesEveryKeyExamined) {
+    auto stats = makeStats(100000);
+    auto root = makeFetchIndexScan("a_1", 10, 19);
+
+    // 10.5 of every 100 keys are in [10, 19], and each of them is fetched.
+    auto ixscanEstimate = estimate(root->children[0], stats);
+    ASSERT(ixscanEstimate);
+    ASSERT_APPROX_EQUAL(ixscanEstimate->cost, 10500, 1e-6);
+
+    auto fetchEstimate = estimate(root.get(), stats);
+    ASSERT(fetchEstimate);
+    ASSERT_APPROX_EQUAL(fetchEstimate->cost, 21000, 1e-6);
+    ASSERT_APPROX_EQUAL(fetchEstimate->cardinality, 10500, 1e-6);
+}
+
+TEST(PlanCostEstimatorTest, PrunesCollectionScanDominatedBySelectiveIndexScan) {
+    auto stats = makeStats(100000);
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makeSolution(std::make_unique<CollectionScanNode>()));
+    solutions.push_back(makeSolution(makeFetchIndexScan("a_1", 10, 10)));
+
+    ASSERT_EQ(pruneDominatedSolutions(stats, &solutions), 1U);
+    ASSERT_EQ(solutions.size(), 1U);
+    ASSERT_EQ(solutions[0]->root->getType(), STAGE_FETCH);
+}
+
+TEST(PlanCostEstimatorTest, KeepsSolutionsOfComparableCost) {
+    auto stats = makeStats(100000);
+    stats.indexHistograms.emplace("a_1_copy", makeHistogram());
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makeSolution(makeFetchIndexScan("a_1", 10, 19)));
+    solutions.push_back(makeSolution(makeFetchIndexScan("a_1_copy", 10, 29)));
+
+    ASSERT_EQ(pruneDominatedSolutions(stats, &solutions), 0U);
+    ASSERT_EQ(solutions.size(), 2U);
+}
+
+TEST(PlanCostEstimatorTest, KeepsSolutionsWhoseCostIsUnknown) {
+    auto stats = makeStats(100000);
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makeSolution(std::make_unique<CollectionScanNode>()));
+    solutions.push_back(makeSolution(makeFetchIndexScan("no_histogram", 10, 10)));
+
+    ASSERT_FALSE(estimate(solutions[1]->root.get(), stats));
+    ASSERT_EQ(pruneDominatedSolutions(stats, &solutions), 0U);
+    ASSERT_EQ(solutions.size(), 2U);
+}
+
+TEST(PlanCostEstimatorTest, DoesNotPruneBelowTrialPeriodFloor) {
+    // The collection scan is more than ten times as expensive as the index scan, but both are
+    // cheaper than a trial period, so neither is pruned.
+    auto stats = makeStats(500);
+    std::vector<std::unique_ptr<QuerySolution>> solutions;
+    solutions.push_back(makeSolution(std::make_unique<CollectionScanNode>()));
+    solutions.push_back(makeSolution(makeFetchIndexScan("a_1", 10, 10)));
+
+    ASSERT_EQ(pruneDominatedSolutions(stats, &solutions), 0U);
+    ASSERT_EQ(solutions.size(), 2U);
+}
+
+}  // namespace
+}  // namespace mongo::plan_cost_estimator
@@ -43,6 +43,7 @@
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/matcher/expression_text.h"
+#include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/index_tag.h"
 #include "mongo/db/query/indexability.h"
@@ -135,6 +136,24 @@ std::vector<bool> canProvideSortWithMergeSort(
     return shouldReverseScan;
 }
 
+/**
+ * Returns true if 'expr' is a leaf predicate whose index bounds can be used to constrain a
+ * non-leading field of a skip scan.
+ */
+bool isSkipScanPredicate(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::MATCH_IN:
+            return true;
+        default:
+            return false;
+    }
+}
+
 }  // namespace
 
 namespace mongo {
@@ -1500,4 +1519,76 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeIndexScan(
     return solnRoot;
 }
 
+std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeSkipScan(
+    const IndexEntry& index, const CanonicalQuery& query, const QueryPlannerParams& params) {
+    // Only plain, non-sparse, non-partial compound indexes can be skip scanned. Sparse and partial
+    // indexes may not contain every document, and an index with a different collation would
+    // produce string bounds in the wrong order.
+    if (index.type != INDEX_BTREE || index.sparse || index.filterExpr ||
+        index.keyPattern.nFields() < 2 ||
+        !CollatorInterface::collatorsMatch(index.collator, query.getCollator())) {
+        return nullptr;
+    }
+
+    // Gather the top-level leaf predicates; anything else is only applied by the fetch filter.
+    std::vector<const MatchExpression*> predicates;
+    const MatchExpression* root = query.root();
+    if (MatchExpression::AND == root->matchType()) {
+        for (size_t i = 0; i < root->numChildren(); ++i) {
+            if (isSkipScanPredicate(root->getChild(i))) {
+                predicates.push_back(root->getChild(i));
+            }
+        }
+    } else if (isSkipScanPredicate(root)) {
+        predicates.push_back(root);
+    }
+
+    auto isn = std::make_unique<IndexScanNode>(index);
+    isn->addKeyMetadata = query.metadataDeps()[DocumentMetadataFields::kIndexKey];
+    isn->queryCollator = query.getCollator();
+    isn->bounds.fields.resize(index.keyPattern.nFields());
+
+    bool hasConstrainedField = false;
+    size_t fieldIdx = 0;
+    for (auto&& elt : index.keyPattern) {
+        OrderedIntervalList* oil = &isn->bounds.fields[fieldIdx];
+        IndexBoundsBuilder::allValuesForField(elt, oil);
+
+        for (auto&& pred : predicates) {
+            if (pred->path() != elt.fieldNameStringData()) {
+                continue;
+            }
+            // A skip scan is only useful when the leading field is unconstrained; otherwise the
+            // regular planner already produces a tighter plan.
+            if (fieldIdx == 0) {
+                return nullptr;
+            }
+            // Bounds over different fields of a multikey index cannot always be compounded, nor
+            // can several predicates over the same multikey field be intersected. The fetch filter
+            // applies the whole query, so a single predicate is enough to keep the scan correct.
+            if (index.multikey && hasConstrainedField) {
+                break;
+            }
+
+            IndexBoundsBuilder::BoundsTightness tightness;
+            IndexBoundsBuilder::translateAndIntersect(pred, elt, index, oil, &tightness);
+            hasConstrainedField = true;
+        }
+        ++fieldIdx;
+    }
+
+    if (!hasConstrainedField) {
+        return nullptr;
+    }
+
+    IndexBoundsBuilder::alignBounds(&isn->bounds, index.keyPattern);
+
+    // The index scan only narrows down the candidate keys, so always fetch and re-apply the
+    // complete predicate.
+    auto fetch = std::make_unique<FetchNode>();
+    fetch->filter = query.root()->shallowClone();
+    fetch->children.push_back(isn.release());
+    return fetch;
+}
+
 }  // namespace mongo
@@ -119,6 +119,18 @@ public:
                                                             const BSONObj& startKey,
                                                             const BSONObj& endKey);
 
+    /**
+     * Return a plan that skip scans the provided compound index for a query which has no predicate
+     * over the index's leading field. The leading field is scanned over all of its values, while
+     * later fields are bounded by the top-level predicates of 'query' over them, so that the index
+     * scan seeks from one distinct leading value to the next rather than examining every key.
+     *
+     * Returns nullptr if the index cannot be skip scanned for this query.
+     */
+    static std::unique_ptr<QuerySolutionNode> makeSkipScan(const IndexEntry& index,
+                                                           const CanonicalQuery& query,
+                                                           const QueryPlannerParams& params);
+
     /**
      * Consructs a data access plan for 'query' which answers the predicate contained in 'root'.
      * Assumes the presence of the passed in indices. Planning behavior is controlled by the
@@ -176,6 +176,9 @@ string optionString(size_t options) {
             case QueryPlannerParams::ASSERT_MIN_TS_HAS_NOT_FALLEN_OFF_OPLOG:
                 ss << "ASSERT_MIN_TS_HAS_NOT_FALLEN_OFF_OPLOG ";
                 break;
+            case QueryPlannerParams::GENERATE_SKIP_SCANS:
+                ss << "GENERATE_SKIP_SCANS ";
+                break;
             case QueryPlannerParams::DEFAULT:
                 MONGO_UNREACHABLE;
                 break;
@@ -331,6 +334,17 @@ std::unique_ptr<QuerySolution> buildWholeIXSoln(const IndexEntry& index,
     return QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
 }
 
+std::unique_ptr<QuerySolution> buildSkipScanSoln(const IndexEntry& index,
+                                                 const CanonicalQuery& query,
+                                                 const QueryPlannerParams& params) {
+    std::unique_ptr<QuerySolutionNode> solnRoot(
+        QueryPlannerAccess::makeSkipScan(index, query, params));
+    if (!solnRoot) {
+        return nullptr;
+    }
+    return QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
+}
+
 bool providesSort(const CanonicalQuery& query, const BSONObj& kp) {
     return query.getQueryRequest().getSort().isPrefixOf(kp, SimpleBSONElementComparator::kInstance);
 }
@@ -510,6 +524,13 @@ StatusWith<std::unique_ptr<QuerySolution>> QueryPlanner::planFromCache(
         } else {
             return {std::move(soln)};
         }
+    } else if (SolutionCacheData::SKIP_IXSCAN_SOLN == winnerCacheData.solnType) {
+        auto soln = buildSkipScanSoln(*winnerCacheData.tree->entry, query, params);
+        if (!soln) {
+            return Status(ErrorCodes::NoQueryExecutionPlans, "plan cache error: skip scan soln");
+        } else {
+            return {std::move(soln)};
+        }
     }
 
     // SolutionCacheData::USE_TAGS_SOLN == cacheData->solnType
@@ -925,6 +946,38 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
         }
     }
 
+    // If no index could be used to answer the predicate, a compound index may still be skip scanned
+    // when the query constrains some field after its leading one. Whether that beats a collection
+    // scan depends on how many distinct values the leading field has, so make the two compete.
+    bool skipScanGenerated = false;
+    if (params.options & QueryPlannerParams::GENERATE_SKIP_SCANS && out.empty() &&
+        hintedIndex.isEmpty() &&
+        !QueryPlannerCommon::hasNode(query.root(), MatchExpression::GEO_NEAR) &&
+        !QueryPlannerCommon::hasNode(query.root(), MatchExpression::TEXT)) {
+        for (auto&& index : fullIndexList) {
+            auto soln = buildSkipScanSoln(index, query, params);
+            if (!soln) {
+                continue;
+            }
+            LOGV2_DEBUG(5073318,
+                        5,
+                        "Planner: outputting soln that skip scans index",
+                        "index"_attr = index.identifier);
+            PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+            indexTree->setIndexEntry(index);
+            SolutionCacheData* scd = new SolutionCacheData();
+            scd->tree.reset(indexTree);
+            scd->solnType = SolutionCacheData::SKIP_IXSCAN_SOLN;
+            soln->cacheData.reset(scd);
+            out.push_back(std::move(soln));
+            skipScanGenerated = true;
+
+            if (out.size() >= params.maxIndexedSolutions) {
+                break;
+            }
+        }
+    }
+
     // An index was hinted. If there are any solutions, they use the hinted index.  If not, we
     // scan the entire index to provide results and output that as our plan.  This is the
     // desired behavior when an index is hinted that is not relevant to the query. In the case that
@@ -1076,7 +1129,9 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
     }
 
     // The caller can explicitly ask for a collscan.
-    bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN);
+    // A skip scan must also compete against a collscan, if one is allowed.
+    bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN) ||
+        (skipScanGenerated && canTableScan);
 
     // No indexed plans?  We must provide a collscan if possible or else we can't run the query.
     bool collScanRequired = 0 == out.size();
@@ -1125,6 +1180,12 @@ StatusWith<QueryPlanner::SubqueriesPlanningResult> QueryPlanner::planSubqueries(
     invariant(query.root()->matchType() == MatchExpression::OR);
     invariant(query.root()->numChildren(), "Cannot plan subqueries for an $or with no children");
 
+    // The plan for the whole $or is rebuilt from the index tags of its branches' plans, and a skip
+    // scan cannot be expressed as index tags. So the branches are planned without skip scans, and
+    // cached skip scans are ignored.
+    QueryPlannerParams branchParams = params;
+    branchParams.options &= ~QueryPlannerParams::GENERATE_SKIP_SCANS;
+
     SubqueriesPlanningResult planningResult{query.root()->shallowClone()};
     for (size_t i = 0; i < params.indices.size(); ++i) {
         const IndexEntry& ie = params.indices[i];
@@ -1162,7 +1223,9 @@ StatusWith<QueryPlanner::SubqueriesPlanningResult> QueryPlanner::planSubqueries(
         // Populate branchResult->cachedSolution if an active cachedSolution entry exists.
         if (planCache && planCache->shouldCacheQuery(*branchResult->canonicalQuery)) {
             auto planCacheKey = planCache->computeKey(*branchResult->canonicalQuery);
-            if (auto cachedSol = planCache->getCacheEntryIfActive(planCacheKey)) {
+            auto cachedSol = planCache->getCacheEntryIfActive(planCacheKey);
+            if (cachedSol &&
+                cachedSol->plannerData[0]->solnType != SolutionCacheData::SKIP_IXSCAN_SOLN) {
                 // We have a CachedSolution. Store it for later.
                 LOGV2_DEBUG(20599,
                             5,
@@ -1185,7 +1248,7 @@ StatusWith<QueryPlanner::SubqueriesPlanningResult> QueryPlanner::planSubqueries(
             // We don't set NO_TABLE_SCAN because peeking at the cache data will keep us from
             // considering any plan that's a collscan.
             invariant(branchResult->solutions.empty());
-            auto solutions = QueryPlanner::plan(*branchResult->canonicalQuery, params);
+            auto solutions = QueryPlanner::plan(*branchResult->canonicalQuery, branchParams);
             if (!solutions.isOK()) {
                 str::stream ss;
                 ss << "Can't plan for subchild " << branchResult->canonicalQuery->toString() << " "
@@ -1426,5 +1426,60 @@ TEST_F(QueryPlannerTest, PlansForWholeIndexScanWithSortAreGenerated) {
         "{proj: {spec: {'b': 1, _id: 0}, node: {fetch: {node: {ixscan: {pattern: {a: 1}}}}}}}");
 }
 
+TEST_F(QueryPlannerTest, SkipScanIsGeneratedForUnconstrainedLeadingFieldIfEnabled) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {b: {$gt: 5}}}"));
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {b: {$gt: 5}}}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: {$gt: 5}}, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, Infinity, false, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanIsNotGeneratedIfDisabled) {
+    params.options &= ~QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {b: {$gt: 5}}}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {b: {$gt: 5}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanIsNotGeneratedIfAnotherIndexIsUsable) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << 1));
+    addIndex(BSON("c" << 1));
+
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {b: 1, c: 1}}"));
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {filter: {b: 1}, node: {ixscan: {pattern: {c: 1}, bounds: "
+        "{c: [[1, 1, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanBoundsAreAlignedToTheIndexDirection) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << -1 << "c" << 1));
+
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {b: {$gte: 1, $lt: 5}}}"));
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {node: {ixscan: {pattern: {a: 1, b: -1, c: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, 1, false, true]], "
+        "c: [['MinKey', 'MaxKey', true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanIsNotGeneratedForSparseIndex) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << 1), false, true);
+
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {b: 1}}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
 }  // namespace
 }  // namespace mongo
@@ -101,6 +101,10 @@ struct QueryPlannerParams {
         // Set this on an oplog scan to uassert that the oplog has not already rolled over the
         // minimum 'ts' timestamp specified in the query.
         ASSERT_MIN_TS_HAS_NOT_FALLEN_OFF_OPLOG = 1 << 11,
+
+        // Set this to generate skip scan plans over compound indexes whose leading field is not
+        // constrained by the query, when no other index can be used.
+        GENERATE_SKIP_SCANS = 1 << 12,
     };
 
     // See Options enum above.
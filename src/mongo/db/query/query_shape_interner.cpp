@@ -0,0 +1,215 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_shape_interner.h"
+
+#include <algorithm>
+
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/query/canonical_query_encoder.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/service_context.h"
+
+namespace mongo {
+
+namespace {
+
+const auto getQueryShapeInterner = ServiceContext::declareDecoration<QueryShapeInterner>();
+
+Counter64 queryShapeInternerHits;
+Counter64 queryShapeInternerMisses;
+Counter64 queryShapeInternerInserts;
+
+ServerStatusMetricField<Counter64> displayHits("query.shapeInterning.hits",
+                                               &queryShapeInternerHits);
+ServerStatusMetricField<Counter64> displayMisses("query.shapeInterning.misses",
+                                                 &queryShapeInternerMisses);
+ServerStatusMetricField<Counter64> displayInserts("query.shapeInterning.inserts",
+                                                  &queryShapeInternerInserts);
+
+// Filters with more fields than this are rare enough in point lookups that interning them would
+// mostly evict more useful shapes.
+const size_t kMaxInternedFields = 32;
+
+bool isInternableConstant(const BSONElement& elem) {
+    switch (elem.type()) {
+        case NumberDouble:
+        case NumberInt:
+        case NumberLong:
+        case NumberDecimal:
+        case String:
+        case jstOID:
+        case Bool:
+        case Date:
+        case bsonTimestamp:
+        case BinData:
+            return true;
+        default:
+            // Objects and arrays may contain operators, regexes parse to a different expression,
+            // and the remaining types are either rare or have special equality semantics.
+            return false;
+    }
+}
+
+/**
+ * Appends to 'leaves' the leaves of 'root' in pre-order. Returns false if 'root' contains
+ * anything other than equalities and the $and above them.
+ */
+bool collectEqualityLeaves(MatchExpression* root,
+                           std::vector<ComparisonMatchExpressionBase*>* leaves) {
+    if (root->matchType() == MatchExpression::EQ) {
+        leaves->push_back(static_cast<ComparisonMatchExpressionBase*>(root));
+        return true;
+    }
+    if (root->matchType() != MatchExpression::AND) {
+        return false;
+    }
+    for (size_t i = 0; i < root->numChildren(); ++i) {
+        if (!collectEqualityLeaves(root->getChild(i), leaves)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Binds the leaves of 'root' to the elements of 'filter' according to 'bindings'.
+ */
+void bindConstants(MatchExpression* root,
+                   const std::vector<size_t>& bindings,
+                   const BSONObj& filter) {
+    std::vector<BSONElement> elements;
+    for (auto&& elem : filter) {
+        elements.push_back(elem);
+    }
+
+    std::vector<ComparisonMatchExpressionBase*> leaves;
+    invariant(collectEqualityLeaves(root, &leaves));
+    invariant(leaves.size() == bindings.size());
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        invariant(bindings[i] < elements.size());
+        leaves[i]->setData(elements[bindings[i]]);
+    }
+}
+
+}  // namespace
+
+QueryShapeInterner::QueryShapeInterner()
+    : QueryShapeInterner(internalQueryShapeInterningCacheSize.load()) {}
+
+QueryShapeInterner& QueryShapeInterner::get(ServiceContext* serviceContext) {
+    return getQueryShapeInterner(serviceContext);
+}
+
+bool QueryShapeInterner::isEnabled() {
+    return internalQueryEnableShapeInterning.load();
+}
+
+boost::optional<std::string> QueryShapeInterner::computeShapeKey(const BSONObj& filter) {
+    if (filter.isEmpty()) {
+        return boost::none;
+    }
+
+    std::string shapeKey;
+    size_t numFields = 0;
+    for (auto&& elem : filter) {
+        auto fieldName = elem.fieldNameStringData();
+        if (++numFields > kMaxInternedFields || fieldName.empty() || fieldName[0] == '$' ||
+            !isInternableConstant(elem)) {
+            return boost::none;
+        }
+        shapeKey.push_back(static_cast<char>(canonicalizeBSONType(elem.type())));
+        shapeKey.append(fieldName.rawData(), fieldName.size());
+        shapeKey.push_back('\0');
+    }
+    return shapeKey;
+}
+
+boost::optional<std::pair<std::unique_ptr<MatchExpression>, std::string>>
+QueryShapeInterner::instantiate(const std::string& shapeKey,
+                                const BSONObj& filter,
+                                const CollatorInterface* collator) {
+    auto tmpl = _cache.get(shapeKey);
+    if (!tmpl) {
+        queryShapeInternerMisses.increment();
+        return boost::none;
+    }
+
+    auto root = tmpl->root->shallowClone();
+    bindConstants(root.get(), tmpl->bindings, filter);
+    root->setCollator(collator);
+
+    queryShapeInternerHits.increment();
+    return std::make_pair(std::move(root), tmpl->encodedMatch);
+}
+
+void QueryShapeInterner::intern(const std::string& shapeKey,
+                                const BSONObj& filter,
+                                const MatchExpression& root) {
+    Template tmpl;
+    tmpl.root = root.shallowClone();
+
+    std::vector<ComparisonMatchExpressionBase*> leaves;
+    if (!collectEqualityLeaves(tmpl.root.get(), &leaves)) {
+        return;
+    }
+
+    // The parser binds each equality directly to the filter element it was parsed from, so the
+    // position of that element can be recovered from the address of its data.
+    std::vector<const char*> elementData;
+    for (auto&& elem : filter) {
+        elementData.push_back(elem.rawdata());
+    }
+    for (auto&& leaf : leaves) {
+        auto it = std::find(elementData.begin(), elementData.end(), leaf->getData().rawdata());
+        if (it == elementData.end()) {
+            return;
+        }
+        tmpl.bindings.push_back(it - elementData.begin());
+    }
+
+    // Rebind the template to a copy of the filter it owns, and drop the collator, which belongs to
+    // the operation that parsed it.
+    tmpl.filter = filter.getOwned();
+    bindConstants(tmpl.root.get(), tmpl.bindings, tmpl.filter);
+    tmpl.root->setCollator(nullptr);
+    tmpl.encodedMatch = canonical_query_encoder::encodeMatch(tmpl.root.get());
+
+    _cache.insertOrAssign(shapeKey, std::move(tmpl));
+    queryShapeInternerInserts.increment();
+}
+
+size_t QueryShapeInterner::size() const {
+    return _cache.getCacheInfo().size();
+}
+
+}  // namespace mongo
@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/util/invalidating_lru_cache.h"
+
+namespace mongo {
+
+class CollatorInterface;
+class ServiceContext;
+
+/**
+ * Caches the parsed and normalized MatchExpression for each shape of simple find filter, so that
+ * later filters of the same shape can skip MatchExpressionParser::parse() and the encoding of the
+ * match portion of the query shape. Only filters whose every top-level field is an equality to a
+ * scalar, such as {_id: 5} or {tenant: "x", status: "open"}, are interned: for these, neither the
+ * parser, nor normalization, nor the shape encoding depend on the values being compared to.
+ *
+ * A hit clones the cached tree and binds the constants of the new filter in place of those of the
+ * filter it was originally parsed from.
+ */
+class QueryShapeInterner {
+    QueryShapeInterner(const QueryShapeInterner&) = delete;
+    QueryShapeInterner& operator=(const QueryShapeInterner&) = delete;
+
+public:
+    /**
+     * The parsed form of one filter shape.
+     */
+    struct Template {
+        // The normalized tree, with constants bound to 'filter'.
+        std::unique_ptr<MatchExpression> root;
+
+        // For each leaf of 'root' in pre-order, the position in the filter of the element it
+        // compares to.
+        std::vector<size_t> bindings;
+
+        // The encoding of 'root' produced by canonical_query_encoder::encodeMatch().
+        std::string encodedMatch;
+
+        // The filter 'root' was parsed from, which owns the constants it is bound to.
+        BSONObj filter;
+    };
+
+    using Cache = InvalidatingLRUCache<std::string, Template>;
+
+    /**
+     * Creates an interner holding up to internalQueryShapeInterningCacheSize shapes.
+     */
+    QueryShapeInterner();
+
+    explicit QueryShapeInterner(size_t cacheSize) : _cache(cacheSize) {}
+
+    static QueryShapeInterner& get(ServiceContext* serviceContext);
+
+    /**
+     * Returns true if the internalQueryEnableShapeInterning knob is set.
+     */
+    static bool isEnabled();
+
+    /**
+     * Returns the key identifying the shape of 'filter', or boost::none if 'filter' is not a
+     * simple enough filter to be interned. The key is made of the field names and canonical types
+     * of the filter's elements, in order.
+     */
+    static boost::optional<std::string> computeShapeKey(const BSONObj& filter);
+
+    /**
+     * If a filter with the shape 'shapeKey' has been interned, returns its normalized tree bound
+     * to the constants of 'filter' and using 'collator', along with the encoding of the tree.
+     * Otherwise returns boost::none. The returned tree refers to the elements of 'filter', which
+     * must outlive it.
+     */
+    boost::optional<std::pair<std::unique_ptr<MatchExpression>, std::string>> instantiate(
+        const std::string& shapeKey, const BSONObj& filter, const CollatorInterface* collator);
+
+    /**
+     * Interns 'root', the normalized tree parsed from 'filter', under 'shapeKey'. Does nothing if
+     * the leaves of 'root' are not all equalities to elements of 'filter', since the constants of
+     * such a tree could not be rebound.
+     */
+    void intern(const std::string& shapeKey, const BSONObj& filter, const MatchExpression& root);
+
+    /**
+     * Returns the number of shapes currently interned.
+     */
+    size_t size() const;
+
+private:
+    Cache _cache;
+};
+
+}  // namespace mongo
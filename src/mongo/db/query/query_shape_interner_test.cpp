@@ -0,0 +1,183 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_shape_interner.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/canonical_query_encoder.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/query/query_test_service_context.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString nss("testdb.testcoll");
+
+std::unique_ptr<MatchExpression> parseAndNormalize(const BSONObj& filter) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto statusWithMatcher = MatchExpressionParser::parse(filter, expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    return MatchExpression::normalize(std::move(statusWithMatcher.getValue()));
+}
+
+std::unique_ptr<CanonicalQuery> canonicalize(OperationContext* opCtx,
+                                             const BSONObj& filter,
+                                             const BSONObj& collation = BSONObj()) {
+    auto qr = std::make_unique<QueryRequest>(nss);
+    qr->setFilter(filter);
+    qr->setCollation(collation);
+    auto statusWithCQ = CanonicalQuery::canonicalize(opCtx, std::move(qr));
+    ASSERT_OK(statusWithCQ.getStatus());
+    return std::move(statusWithCQ.getValue());
+}
+
+TEST(QueryShapeInternerTest, ComputesShapeKeyOnlyForScalarEqualities) {
+    ASSERT(QueryShapeInterner::computeShapeKey(fromjson("{_id: 5}")));
+    ASSERT(QueryShapeInterner::computeShapeKey(fromjson("{a: 'x', 'b.c': true, d: 1.5}")));
+
+    ASSERT_FALSE(QueryShapeInterner::computeShapeKey(BSONObj()));
+    ASSERT_FALSE(QueryShapeInterner::computeShapeKey(fromjson("{a: {$gt: 5}}")));
+    ASSERT_FALSE(QueryShapeInterner::computeShapeKey(fromjson("{a: {b: 5}}")));
+    ASSERT_FALSE(QueryShapeInterner::computeShapeKey(fromjson("{a: [1, 2]}")));
+    ASSERT_FALSE(QueryShapeInterner::computeShapeKey(fromjson("{a: /x/}")));
+    ASSERT_FALSE(QueryShapeInterner::computeShapeKey(fromjson("{a: null}")));
+    ASSERT_FALSE(QueryShapeInterner::computeShapeKey(fromjson("{a: 1, $comment: 'x'}")));
+    ASSERT_FALSE(QueryShapeInterner::computeShapeKey(fromjson("{$or: [{a: 1}, {b: 1}]}")));
+}
+
+TEST(QueryShapeInternerTest, ShapeKeyDependsOnFieldsAndTypesButNotValues) {
+    auto key = QueryShapeInterner::computeShapeKey(fromjson("{a: 1, b: 'x'}"));
+    ASSERT_TRUE(key == QueryShapeInterner::computeShapeKey(fromjson("{a: 2, b: 'y'}")));
+    ASSERT_TRUE(key == QueryShapeInterner::computeShapeKey(fromjson("{a: NumberLong(2), b: 'y'}")));
+    ASSERT_FALSE(key == QueryShapeInterner::computeShapeKey(fromjson("{b: 'x', a: 1}")));
+    ASSERT_FALSE(key == QueryShapeInterner::computeShapeKey(fromjson("{a: 'x', b: 'x'}")));
+    ASSERT_FALSE(key == QueryShapeInterner::computeShapeKey(fromjson("{a: 1, c: 'x'}")));
+}
+
+TEST(QueryShapeInternerTest, InstantiateBindsConstantsOfNewFilter) {
+    QueryShapeInterner interner(10);
+    auto filter = fromjson("{b: 2, a: 'x', c: 3}");
+    auto shapeKey = *QueryShapeInterner::computeShapeKey(filter);
+    ASSERT_FALSE(interner.instantiate(shapeKey, filter, nullptr));
+
+    auto root = parseAndNormalize(filter);
+    interner.intern(shapeKey, filter, *root);
+    ASSERT_EQ(interner.size(), 1U);
+
+    auto newFilter = fromjson("{b: 7, a: 'y', c: 8}");
+    auto instance = interner.instantiate(shapeKey, newFilter, nullptr);
+    ASSERT(instance);
+
+    auto expected = parseAndNormalize(newFilter);
+    ASSERT(instance->first->equivalent(expected.get()));
+    ASSERT_EQ(instance->second, canonical_query_encoder::encodeMatch(expected.get()));
+    ASSERT_TRUE(instance->first->matchesBSON(fromjson("{a: 'y', b: 7, c: 8}")));
+    ASSERT_FALSE(instance->first->matchesBSON(fromjson("{a: 'x', b: 2, c: 3}")));
+}
+
+TEST(QueryShapeInternerTest, InstantiateBindsRepeatedPaths) {
+    QueryShapeInterner interner(10);
+    auto filter = fromjson("{a: 1, a: 2}");
+    auto shapeKey = *QueryShapeInterner::computeShapeKey(filter);
+    interner.intern(shapeKey, filter, *parseAndNormalize(filter));
+
+    auto newFilter = fromjson("{a: 3, a: 4}");
+    auto instance = interner.instantiate(shapeKey, newFilter, nullptr);
+    ASSERT(instance);
+    ASSERT(instance->first->equivalent(parseAndNormalize(newFilter).get()));
+    ASSERT_TRUE(instance->first->matchesBSON(fromjson("{a: [3, 4]}")));
+    ASSERT_FALSE(instance->first->matchesBSON(fromjson("{a: [1, 2]}")));
+}
+
+TEST(QueryShapeInternerTest, DoesNotInternTreeNotParsedFromFilter) {
+    QueryShapeInterner interner(10);
+    auto filter = fromjson("{a: 1}");
+    auto shapeKey = *QueryShapeInterner::computeShapeKey(filter);
+
+    // The tree's constant does not come from 'filter', so it could not be rebound.
+    auto otherFilter = fromjson("{a: 1}");
+    interner.intern(shapeKey, filter, *parseAndNormalize(otherFilter));
+    ASSERT_EQ(interner.size(), 0U);
+}
+
+TEST(QueryShapeInternerTest, CanonicalizeReusesInternedShape) {
+    QueryTestServiceContext serviceContext;
+    auto opCtx = serviceContext.makeOperationContext();
+    internalQueryEnableShapeInterning.store(true);
+    ON_BLOCK_EXIT([] { internalQueryEnableShapeInterning.store(false); });
+
+    auto first = canonicalize(opCtx.get(), fromjson("{b: 2, a: 'x'}"));
+    ASSERT_FALSE(first->getEncodedMatch());
+    ASSERT_EQ(QueryShapeInterner::get(serviceContext.getServiceContext()).size(), 1U);
+
+    auto second = canonicalize(opCtx.get(), fromjson("{b: 7, a: 'y'}"));
+    ASSERT(second->getEncodedMatch());
+    ASSERT_EQ(second->encodeKey(), first->encodeKey());
+    ASSERT(second->root()->equivalent(parseAndNormalize(fromjson("{b: 7, a: 'y'}")).get()));
+}
+
+TEST(QueryShapeInternerTest, CanonicalizeBindsCollatorOfQuery) {
+    QueryTestServiceContext serviceContext;
+    auto opCtx = serviceContext.makeOperationContext();
+    internalQueryEnableShapeInterning.store(true);
+    ON_BLOCK_EXIT([] { internalQueryEnableShapeInterning.store(false); });
+    const auto collation = BSON("locale"
+                                << "reverse");
+
+    canonicalize(opCtx.get(), fromjson("{a: 'x'}"));
+    auto cq = canonicalize(opCtx.get(), fromjson("{a: 'y'}"), collation);
+    ASSERT(cq->getEncodedMatch());
+    ASSERT(cq->getCollator());
+    ASSERT_EQ(cq->root()->matchType(), MatchExpression::EQ);
+    ASSERT_EQ(static_cast<ComparisonMatchExpressionBase*>(cq->root())->getCollator(),
+              cq->getCollator());
+}
+
+TEST(QueryShapeInternerTest, CanonicalizeDoesNotInternWhenDisabled) {
+    QueryTestServiceContext serviceContext;
+    auto opCtx = serviceContext.makeOperationContext();
+
+    // Interning is off by default.
+    canonicalize(opCtx.get(), fromjson("{a: 1}"));
+    auto cq = canonicalize(opCtx.get(), fromjson("{a: 2}"));
+    ASSERT_FALSE(cq->getEncodedMatch());
+    ASSERT_EQ(QueryShapeInterner::get(serviceContext.getServiceContext()).size(), 0U);
+}
+
+}  // namespace
+}  // namespace mongo
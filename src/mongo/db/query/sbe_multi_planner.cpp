@@ -86,9 +86,23 @@ plan_ranker::CandidatePlan MultiPlanner::finalizeExecutionPlans(
         winner.results = decltype(winner.results){};
     }
 
+    // If the winning tree was built with its query constants bound to runtime parameters, store a
+    // copy of it along with the cache entry, so that the next query of the same shape can reuse it
+    // instead of rebuilding the tree from the cached solution.
+    std::shared_ptr<const stage_builder::CachedPlanTree> executionTree;
+    if (_cachingMode != PlanCachingMode::NeverCache && winner.data.inputParamsShape) {
+        executionTree = std::make_shared<const stage_builder::CachedPlanTree>(
+            winner.root->clone(), winner.data.makeCopy());
+    }
+
     // Writes a cache entry for the winning plan to the plan cache if possible.
-    plan_cache_util::updatePlanCache(
-        _opCtx, _collection, _cachingMode, _cq, std::move(decision), candidates);
+    plan_cache_util::updatePlanCache(_opCtx,
+                                     _collection,
+                                     _cachingMode,
+                                     _cq,
+                                     std::move(decision),
+                                     candidates,
+                                     std::move(executionTree));
 
     return std::move(winner);
 }
@@ -35,9 +35,11 @@
 #include "mongo/db/exec/sbe/stages/co_scan.h"
 #include "mongo/db/exec/sbe/stages/filter.h"
 #include "mongo/db/exec/sbe/stages/hash_agg.h"
+#include "mongo/db/exec/sbe/stages/hash_join.h"
 #include "mongo/db/exec/sbe/stages/limit_skip.h"
 #include "mongo/db/exec/sbe/stages/loop_join.h"
 #include "mongo/db/exec/sbe/stages/makeobj.h"
+#include "mongo/db/exec/sbe/stages/merge_join.h"
 #include "mongo/db/exec/sbe/stages/project.h"
 #include "mongo/db/exec/sbe/stages/scan.h"
 #include "mongo/db/exec/sbe/stages/sort.h"
@@ -68,9 +70,41 @@ std::unique_ptr<sbe::RuntimeEnvironment> makeRuntimeEnvironment(
     return env;
 }
 
+namespace {
+/**
+ * Creates a group stage which removes duplicate record ids produced by 'input'. The stage may only
+ * spill its hash table to disk if the query allows it. Otherwise it is left unbounded, the same as
+ * the set of seen record ids kept by the classic OR and TEXT_OR stages.
+ */
+std::unique_ptr<sbe::PlanStage> makeRecordIdDedup(std::unique_ptr<sbe::PlanStage> input,
+                                                  sbe::value::SlotId recordIdSlot,
+                                                  bool allowDiskUse) {
+    const size_t memoryLimit = allowDiskUse
+        ? static_cast<size_t>(internalDocumentSourceGroupMaxMemoryBytes.load())
+        : std::numeric_limits<size_t>::max();
+    return sbe::makeS<sbe::HashAggStage>(
+        std::move(input),
+        sbe::makeSV(recordIdSlot),
+        sbe::makeEM(),
+        sbe::value::SlotMap<std::pair<sbe::value::SlotId, std::unique_ptr<sbe::EExpression>>>{},
+        allowDiskUse,
+        memoryLimit);
+}
+}  // namespace
+
 std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildCollScan(
     const QuerySolutionNode* root) {
     auto csn = static_cast<const CollectionScanNode*>(root);
+
+    // A scan in the natural order must return the documents in the order they are stored, which
+    // the parallel scan cannot guarantee.
+    const auto& qr = _cq.getQueryRequest();
+    const bool needsNaturalOrder =
+        qr.getSort().hasField(QueryRequest::kNaturalSortField) ||
+        qr.getHint().hasField(QueryRequest::kNaturalSortField);
+    const size_t degreeOfParallelism =
+        needsNaturalOrder ? 1 : static_cast<size_t>(internalQueryDefaultDOP.load());
+
     auto [resultSlot, recordIdSlot, oplogTsSlot, stage] =
         generateCollScan(_opCtx,
                          _collection,
@@ -79,7 +113,9 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildCollScan(
                          _yieldPolicy,
                          _data.env,
                          _isTailableCollScanResumeBranch,
-                         _data.trialRunProgressTracker.get());
+                         _data.trialRunProgressTracker.get(),
+                         degreeOfParallelism,
+                         _inputParams.get_ptr());
     _data.resultSlot = resultSlot;
     _data.recordIdSlot = recordIdSlot;
     _data.oplogTsSlot = oplogTsSlot;
@@ -106,7 +142,9 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildIndexScan(
                                            &_slotIdGenerator,
                                            &_spoolIdGenerator,
                                            _yieldPolicy,
-                                           _data.trialRunProgressTracker.get());
+                                           _data.trialRunProgressTracker.get(),
+                                           _data.env,
+                                           _inputParams.get_ptr());
     _data.recordIdSlot = slot;
     return std::move(stage);
 }
@@ -152,8 +190,12 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildFetch(const QuerySol
                              _returnKeySlot ? sbe::makeSV(*_returnKeySlot) : sbe::makeSV());
 
     if (fn->filter) {
-        stage = generateFilter(
-            fn->filter.get(), std::move(stage), &_slotIdGenerator, *_data.resultSlot);
+        stage = generateFilter(fn->filter.get(),
+                               std::move(stage),
+                               &_slotIdGenerator,
+                               *_data.resultSlot,
+                               _data.env,
+                               _inputParams.get_ptr());
     }
 
     return stage;
@@ -360,15 +402,110 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildOr(const QuerySoluti
                                              sbe::makeSV(*_data.resultSlot, *_data.recordIdSlot));
 
     if (orn->dedup) {
-        stage = sbe::makeS<sbe::HashAggStage>(
-            std::move(stage), sbe::makeSV(*_data.recordIdSlot), sbe::makeEM());
+        stage = makeRecordIdDedup(
+            std::move(stage), *_data.recordIdSlot, _cq.getExpCtx()->allowDiskUse);
     }
 
     if (orn->filter) {
-        stage = generateFilter(
-            orn->filter.get(), std::move(stage), &_slotIdGenerator, *_data.resultSlot);
+        stage = generateFilter(orn->filter.get(),
+                               std::move(stage),
+                               &_slotIdGenerator,
+                               *_data.resultSlot,
+                               _data.env,
+                               _inputParams.get_ptr());
+    }
+
+    return stage;
+}
+
+std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildAndSorted(
+    const QuerySolutionNode* root) {
+    auto andSortedNode = static_cast<const AndSortedNode*>(root);
+    invariant(andSortedNode->children.size() >= 2);
+
+    // Every child of the index intersection would have to populate the same return key slot.
+    uassert(5073301, "returnKey is not supported with index intersection", !_returnKeySlot);
+
+    // The children produce their record ids in ascending order, so the intersection is computed by
+    // merge-joining them on the record id one by one. The record id and, if any child fetches the
+    // documents, the result slot are carried along the outer side of the joins.
+    invariant(andSortedNode->children[0]->sortedByDiskLoc());
+    _data.resultSlot = boost::none;
+    auto stage = build(andSortedNode->children[0]);
+    invariant(_data.recordIdSlot);
+    const auto recordIdSlot = *_data.recordIdSlot;
+    auto resultSlot = _data.resultSlot;
+
+    for (size_t idx = 1; idx < andSortedNode->children.size(); ++idx) {
+        invariant(andSortedNode->children[idx]->sortedByDiskLoc());
+        _data.resultSlot = boost::none;
+        auto innerStage = build(andSortedNode->children[idx]);
+        invariant(_data.recordIdSlot);
+
+        stage = sbe::makeS<sbe::MergeJoinStage>(
+            std::move(stage),
+            std::move(innerStage),
+            sbe::makeSV(recordIdSlot),
+            resultSlot ? sbe::makeSV(*resultSlot) : sbe::makeSV(),
+            sbe::makeSV(*_data.recordIdSlot),
+            std::vector<sbe::value::SortDirection>{sbe::value::SortDirection::Ascending});
+
+        if (!resultSlot) {
+            resultSlot = _data.resultSlot;
+        }
+    }
+
+    _data.recordIdSlot = recordIdSlot;
+    _data.resultSlot = resultSlot;
+    return stage;
+}
+
+std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildAndHash(const QuerySolutionNode* root) {
+    auto andHashNode = static_cast<const AndHashNode*>(root);
+    invariant(andHashNode->children.size() >= 2);
+
+    // Every child of the index intersection would have to populate the same return key slot.
+    uassert(5073338, "returnKey is not supported with index intersection", !_returnKeySlot);
+
+    // The children are intersected by hash-joining them on the record id one by one. Each join
+    // loads the intersection so far into its hash table and probes it with the next child, so the
+    // results come out in the order of the last child, the same as in the classic AND_HASH stage.
+    // If any child fetches the documents, the result slot is carried along through the joins. The
+    // hash tables may only spill to disk if the query allows it.
+    _data.resultSlot = boost::none;
+    auto stage = build(andHashNode->children[0]);
+    invariant(_data.recordIdSlot);
+    auto recordIdSlot = *_data.recordIdSlot;
+    auto resultSlot = _data.resultSlot;
+
+    for (size_t idx = 1; idx < andHashNode->children.size(); ++idx) {
+        _data.resultSlot = boost::none;
+        auto innerStage = build(andHashNode->children[idx]);
+        invariant(_data.recordIdSlot);
+
+        // Any inner slot read above the join must be projected in case the join spills.
+        auto outerProjects = resultSlot ? sbe::makeSV(*resultSlot) : sbe::makeSV();
+        auto innerProjects =
+            !resultSlot && _data.resultSlot ? sbe::makeSV(*_data.resultSlot) : sbe::makeSV();
+
+        stage = sbe::makeS<sbe::HashJoinStage>(
+            std::move(stage),
+            std::move(innerStage),
+            sbe::makeSV(recordIdSlot),
+            std::move(outerProjects),
+            sbe::makeSV(*_data.recordIdSlot),
+            std::move(innerProjects),
+            _cq.getExpCtx()->allowDiskUse,
+            static_cast<size_t>(internalQueryMaxBlockingSortMemoryUsageBytes.load()));
+
+        recordIdSlot = *_data.recordIdSlot;
+        if (!resultSlot) {
+            resultSlot = _data.resultSlot;
+        }
     }
 
+    _data.recordIdSlot = recordIdSlot;
+    _data.resultSlot = resultSlot;
     return stage;
 }
 
@@ -442,8 +579,8 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildText(const QuerySolu
     // TODO: If text score metadata is requested, then we should sum over the text scores inside the
     // index keys for a given document. This will require expression evaluation to be able to
     // extract the score directly from the key string.
-    auto hashAggStage = sbe::makeS<sbe::HashAggStage>(
-        std::move(unionStage), sbe::makeSV(*_data.recordIdSlot), sbe::makeEM());
+    auto hashAggStage = makeRecordIdDedup(
+        std::move(unionStage), *_data.recordIdSlot, _cq.getExpCtx()->allowDiskUse);
 
     auto nljStage = makeLoopJoinForFetch(std::move(hashAggStage), *_data.recordIdSlot);
 
@@ -583,6 +720,8 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::build(const QuerySolution
             {STAGE_PROJECTION_SIMPLE, std::mem_fn(&SlotBasedStageBuilder::buildProjectionSimple)},
             {STAGE_PROJECTION_DEFAULT, std::mem_fn(&SlotBasedStageBuilder::buildProjectionDefault)},
             {STAGE_OR, &SlotBasedStageBuilder::buildOr},
+            {STAGE_AND_HASH, &SlotBasedStageBuilder::buildAndHash},
+            {STAGE_AND_SORTED, &SlotBasedStageBuilder::buildAndSorted},
             {STAGE_TEXT, &SlotBasedStageBuilder::buildText},
             {STAGE_RETURN_KEY, &SlotBasedStageBuilder::buildReturnKey}};
 
@@ -30,11 +30,15 @@
 #pragma once
 
 #include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/exec/sbe/util/debug_print.h"
 #include "mongo/db/exec/sbe/values/id_generators.h"
 #include "mongo/db/exec/sbe/values/slot.h"
 #include "mongo/db/exec/trial_period_utils.h"
 #include "mongo/db/exec/trial_run_progress_tracker.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_yield_policy_sbe.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/query/sbe_stage_builder_input_params.h"
 #include "mongo/db/query/stage_builder.h"
 
 namespace mongo::stage_builder {
@@ -71,6 +75,23 @@ struct PlanStageData {
         return builder.str();
     }
 
+    /**
+     * Makes a copy of this data with its own runtime environment, so that the copy can be used to
+     * execute a clone of the PlanStage tree independently from the original. The trial run
+     * progress tracker is not copied.
+     */
+    PlanStageData makeCopy() const {
+        PlanStageData copy{env->makeDeepCopy()};
+        copy.resultSlot = resultSlot;
+        copy.recordIdSlot = recordIdSlot;
+        copy.oplogTsSlot = oplogTsSlot;
+        copy.shouldTrackLatestOplogTimestamp = shouldTrackLatestOplogTimestamp;
+        copy.shouldTrackResumeToken = shouldTrackResumeToken;
+        copy.shouldUseTailableScan = shouldUseTailableScan;
+        copy.inputParamsShape = inputParamsShape;
+        return copy;
+    }
+
     boost::optional<sbe::value::SlotId> resultSlot;
     boost::optional<sbe::value::SlotId> recordIdSlot;
     boost::optional<sbe::value::SlotId> oplogTsSlot;
@@ -81,6 +102,39 @@ struct PlanStageData {
     bool shouldUseTailableScan{false};
     // Used during the trial run of the runtime planner to track progress of the work done so far.
     std::unique_ptr<TrialRunProgressTracker> trialRunProgressTracker;
+    // Set if the constants of the query were bound to runtime environment slots while building the
+    // tree. Holds the shape of the query solution the tree was built from, see 'InputParams'.
+    boost::optional<std::string> inputParamsShape;
+};
+
+/**
+ * A PlanStage tree, along with the data needed to execute it, stored in the plan cache. The tree
+ * must have been built with its query constants bound to runtime environment slots, so that it can
+ * be cloned and re-bound to the constants of another query of the same shape.
+ */
+struct CachedPlanTree final : public CachedExecutionTree {
+    CachedPlanTree(std::unique_ptr<sbe::PlanStage> root, PlanStageData data)
+        : root{std::move(root)}, data{std::move(data)} {
+        invariant(this->data.inputParamsShape);
+
+        // The stages have no way to report their own size, so the size of the tree is estimated
+        // from its debug representation, which lists every stage along with its slots,
+        // expressions and constants, and therefore grows with the tree. The same goes for the
+        // values held by the runtime environment. This is computed once, since the plan cache
+        // asks for the size of an entry every time it is added or evicted.
+        _estimatedSizeBytes = sizeof(*this) + sbe::DebugPrinter{}.print(this->root.get()).size() +
+            this->data.debugString().size() + this->data.inputParamsShape->capacity();
+    }
+
+    uint64_t estimateObjectSizeInBytes() const final {
+        return _estimatedSizeBytes;
+    }
+
+    const std::unique_ptr<sbe::PlanStage> root;
+    const PlanStageData data;
+
+private:
+    uint64_t _estimatedSizeBytes;
 };
 
 /**
@@ -100,6 +154,15 @@ public:
             const auto maxNumReads{trial_period::getTrialPeriodMaxWorks(_opCtx, _collection)};
             _data.trialRunProgressTracker =
                 std::make_unique<TrialRunProgressTracker>(maxNumResults, maxNumReads);
+
+            // Only the plans which are candidates for the plan cache are built with a trial run
+            // tracker, so parameterize only those.
+            if (internalQueryCacheSlotBasedExecutionTrees.load()) {
+                _inputParams = InputParams::collect(_opCtx, _collection, _cq, _solution);
+                if (_inputParams) {
+                    _data.inputParamsShape = _inputParams->shape();
+                }
+            }
         }
     }
 
@@ -120,6 +183,8 @@ private:
     std::unique_ptr<sbe::PlanStage> buildProjectionSimple(const QuerySolutionNode* root);
     std::unique_ptr<sbe::PlanStage> buildProjectionDefault(const QuerySolutionNode* root);
     std::unique_ptr<sbe::PlanStage> buildOr(const QuerySolutionNode* root);
+    std::unique_ptr<sbe::PlanStage> buildAndHash(const QuerySolutionNode* root);
+    std::unique_ptr<sbe::PlanStage> buildAndSorted(const QuerySolutionNode* root);
     std::unique_ptr<sbe::PlanStage> buildText(const QuerySolutionNode* root);
     std::unique_ptr<sbe::PlanStage> buildReturnKey(const QuerySolutionNode* root);
 
@@ -151,6 +216,10 @@ private:
 
     PlanYieldPolicySBE* const _yieldPolicy;
 
+    // If set, the query constants are bound to runtime environment slots named by these params,
+    // rather than being embedded into the tree as constants.
+    boost::optional<InputParams> _inputParams;
+
     // Apart from generating just an execution tree, this builder will also produce some auxiliary
     // data which is needed to execute the tree, such as a result slot, or a recordId slot.
     PlanStageData _data{makeRuntimeEnvironment(_opCtx, &_slotIdGenerator)};
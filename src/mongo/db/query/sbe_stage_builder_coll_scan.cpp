@@ -41,8 +41,10 @@
 #include "mongo/db/exec/sbe/stages/loop_join.h"
 #include "mongo/db/exec/sbe/stages/project.h"
 #include "mongo/db/exec/sbe/stages/scan.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/sbe_stage_builder_filter.h"
 #include "mongo/db/query/util/make_data_structure.h"
+#include "mongo/db/repl/read_concern_args.h"
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/logv2/log.h"
 #include "mongo/util/str.h"
@@ -283,7 +285,8 @@ generateGenericCollScan(const Collection* collection,
                         PlanYieldPolicy* yieldPolicy,
                         sbe::RuntimeEnvironment* env,
                         bool isTailableResumeBranch,
-                        TrialRunProgressTracker* tracker) {
+                        TrialRunProgressTracker* tracker,
+                        const InputParams* inputParams) {
     const auto forward = csn->direction == CollectionScanParams::FORWARD;
 
     invariant(!csn->shouldTrackLatestOplogTimestamp || collection->ns().isOplog());
@@ -317,7 +320,8 @@ generateGenericCollScan(const Collection* collection,
                                             forward,
                                             yieldPolicy,
                                             tracker,
-                                            makeOpenCallbackIfNeeded(collection, csn));
+                                            makeOpenCallbackIfNeeded(collection, csn),
+                                            internalQuerySlotBasedExecutionEnableBlockMode.load());
 
     // Check if the scan should be started after the provided resume RecordId and construct a nested
     // loop join sub-tree to project out the resume RecordId as a seekRecordIdSlot and feed it to
@@ -347,11 +351,75 @@ generateGenericCollScan(const Collection* collection,
         // 'generateOptimizedOplogScan()'.
         invariant(!csn->stopApplyingFilterAfterFirstMatch);
 
-        stage = generateFilter(csn->filter.get(), std::move(stage), slotIdGenerator, resultSlot);
+        stage = generateFilter(
+            csn->filter.get(), std::move(stage), slotIdGenerator, resultSlot, env, inputParams);
     }
 
     return {resultSlot, recordIdSlot, tsSlot, std::move(stage)};
 }
+
+/**
+ * Checks whether the collection scan can be split between multiple threads. The parallel scan
+ * stage can only scan the whole collection forward, and it cannot report trial run progress, so
+ * it cannot take part in multi-planning. The producer threads run on their own operation contexts
+ * and read their own snapshots, so the scan must not be part of a multi-document transaction nor
+ * read at any read concern other than "local".
+ */
+bool canScanInParallel(OperationContext* opCtx,
+                       const Collection* collection,
+                       const CollectionScanNode* csn,
+                       bool isTailableResumeBranch,
+                       TrialRunProgressTracker* tracker) {
+    if (opCtx->inMultiDocumentTransaction() ||
+        repl::ReadConcernArgs::get(opCtx).getLevel() !=
+            repl::ReadConcernLevel::kLocalReadConcern) {
+        return false;
+    }
+
+    return csn->direction == CollectionScanParams::FORWARD && !csn->minTs && !csn->maxTs &&
+        !csn->resumeAfterRecordId && !csn->requestResumeToken && !csn->tailable &&
+        !csn->shouldTrackLatestOplogTimestamp && !isTailableResumeBranch && !tracker &&
+        !collection->ns().isOplog();
+}
+
+/**
+ * Generates a collection scan sub-tree executed by 'degreeOfParallelism' producer threads. Every
+ * producer runs its own copy of the parallel scan and the filter over the RecordId ranges it
+ * claims, and the exchange stage hands the matching documents over to the calling thread.
+ *
+ * The producers run with their own operation contexts, which inherit the caller's deadline and are
+ * interrupted along with it. If 'yieldPolicy' is set, every producer yields its own copy of the
+ * scan on its own schedule.
+ */
+std::tuple<sbe::value::SlotId,
+           sbe::value::SlotId,
+           boost::optional<sbe::value::SlotId>,
+           std::unique_ptr<sbe::PlanStage>>
+generateParallelCollScan(const Collection* collection,
+                         const CollectionScanNode* csn,
+                         sbe::value::SlotIdGenerator* slotIdGenerator,
+                         PlanYieldPolicy* yieldPolicy,
+                         size_t degreeOfParallelism) {
+    auto resultSlot = slotIdGenerator->generate();
+    auto recordIdSlot = slotIdGenerator->generate();
+
+    NamespaceStringOrUUID nss{collection->ns().db().toString(), collection->uuid()};
+    std::unique_ptr<sbe::PlanStage> stage = sbe::makeS<sbe::ParallelScanStage>(
+        nss, resultSlot, recordIdSlot, std::vector<std::string>{}, sbe::makeSV(), yieldPolicy);
+
+    if (csn->filter) {
+        stage = generateFilter(csn->filter.get(), std::move(stage), slotIdGenerator, resultSlot);
+    }
+
+    stage = sbe::makeS<sbe::ExchangeConsumer>(std::move(stage),
+                                              degreeOfParallelism,
+                                              sbe::makeSV(resultSlot, recordIdSlot),
+                                              sbe::ExchangePolicy::roundrobin,
+                                              nullptr,
+                                              nullptr);
+
+    return {resultSlot, recordIdSlot, boost::none, std::move(stage)};
+}
 }  // namespace
 
 std::tuple<sbe::value::SlotId,
@@ -365,10 +433,16 @@ generateCollScan(OperationContext* opCtx,
                  PlanYieldPolicy* yieldPolicy,
                  sbe::RuntimeEnvironment* env,
                  bool isTailableResumeBranch,
-                 TrialRunProgressTracker* tracker) {
+                 TrialRunProgressTracker* tracker,
+                 size_t degreeOfParallelism,
+                 const InputParams* inputParams) {
 
     auto [resultSlot, recordIdSlot, oplogTsSlot, stage] = [&]() {
-        if (csn->minTs || csn->maxTs) {
+        if (degreeOfParallelism > 1 &&
+            canScanInParallel(opCtx, collection, csn, isTailableResumeBranch, tracker)) {
+            return generateParallelCollScan(
+                collection, csn, slotIdGenerator, yieldPolicy, degreeOfParallelism);
+        } else if (csn->minTs || csn->maxTs) {
             return generateOptimizedOplogScan(opCtx,
                                               collection,
                                               csn,
@@ -384,7 +458,8 @@ generateCollScan(OperationContext* opCtx,
                                            yieldPolicy,
                                            env,
                                            isTailableResumeBranch,
-                                           tracker);
+                                           tracker,
+                                           inputParams);
         }
     }();
 
@@ -34,6 +34,7 @@
 #include "mongo/db/exec/sbe/values/id_generators.h"
 #include "mongo/db/exec/trial_run_progress_tracker.h"
 #include "mongo/db/query/query_solution.h"
+#include "mongo/db/query/sbe_stage_builder_input_params.h"
 
 namespace mongo::stage_builder {
 /**
@@ -46,6 +47,13 @@ namespace mongo::stage_builder {
  *     were requested to track this data.
  *   * A generated PlanStage sub-tree.
  *
+ * If 'degreeOfParallelism' is greater than one and the scan does not need any of the features which
+ * only a serial scan provides (e.g. resuming, tailing or reporting trial run progress), the
+ * collection is scanned by that many threads and the documents are returned in no particular order.
+ *
+ * If 'inputParams' is provided, the constants in the scan's filter are bound to the runtime
+ * environment slots named by it, so that the generated tree can be re-bound to other values.
+ *
  * In cases of an error, throws.
  */
 std::tuple<sbe::value::SlotId,
@@ -59,5 +67,7 @@ generateCollScan(OperationContext* opCtx,
                  PlanYieldPolicy* yieldPolicy,
                  sbe::RuntimeEnvironment* env,
                  bool isTailableResumeBranch,
-                 TrialRunProgressTracker* tracker);
+                 TrialRunProgressTracker* tracker,
+                 size_t degreeOfParallelism = 1,
+                 const InputParams* inputParams = nullptr);
 }  // namespace mongo::stage_builder
@@ -396,6 +396,25 @@ std::unique_ptr<sbe::EExpression> generateNullOrMissing(const sbe::FrameId frame
         sbe::makeE<sbe::EFunction>("isNull", sbe::makeEs(var.clone())));
 }
 
+/**
+ * Generates an expression that evaluates 'expr' and falls back to evaluating 'fallback' when the
+ * result is Nothing. Unlike fillEmpty, the fallback is only evaluated when it is needed, so it can
+ * be an EFail.
+ */
+std::unique_ptr<sbe::EExpression> generateFallbackIfNothing(
+    std::unique_ptr<sbe::EExpression> expr,
+    std::unique_ptr<sbe::EExpression> fallback,
+    sbe::value::FrameIdGenerator* frameIdGenerator) {
+    auto frameId = frameIdGenerator->generate();
+    sbe::EVariable resultRef{frameId, 0};
+    return sbe::makeE<sbe::ELocalBind>(
+        frameId,
+        sbe::makeEs(std::move(expr)),
+        sbe::makeE<sbe::EIf>(sbe::makeE<sbe::EFunction>("exists", sbe::makeEs(resultRef.clone())),
+                             resultRef.clone(),
+                             std::move(fallback)));
+}
+
 class ExpressionPreVisitor final : public ExpressionVisitor {
 public:
     ExpressionPreVisitor(ExpressionVisitorContext* context) : _context{context} {}
@@ -985,7 +1004,13 @@ public:
             sbe::makeE<sbe::ELocalBind>(frameId, std::move(operands), std::move(cmpWithFallback)));
     }
     void visit(ExpressionConcat* expr) final {
-        unsupportedExpression(expr->getOpName());
+        auto arity = expr->getChildren().size();
+        if (arity == 0) {
+            // An empty $concat evaluates to the empty string.
+            _context->pushExpr(sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::StringSmall, 0));
+            return;
+        }
+        _context->pushExpr(sbe::makeE<sbe::EFunction>("concat", popArguments(arity)));
     }
     void visit(ExpressionConcatArrays* expr) final {
         unsupportedExpression(expr->getOpName());
@@ -1296,7 +1321,58 @@ public:
         unsupportedExpression("$dateFromString");
     }
     void visit(ExpressionDateToString* expr) final {
-        unsupportedExpression("$dateFromString");
+        // Some of the children are optional, only pop the ones that exist.
+        auto children = expr->getChildren();
+        invariant(children.size() == 4);
+
+        auto eOnNull = children[3] ? _context->popExpr() : nullptr;
+        auto eTimezone = children[2] ? _context->popExpr() : nullptr;
+        auto eDate = _context->popExpr();
+        auto eFormat = children[0] ? _context->popExpr() : nullptr;
+
+        auto frameId = _context->frameIdGenerator->generate();
+        sbe::EVariable dateRef(frameId, 0);
+        sbe::EVariable formatRef(frameId, 1);
+        sbe::EVariable timezoneRef(frameId, 2);
+
+        // The default format is the ISO format and the default timezone is UTC (an empty string
+        // for the builtin).
+        auto operands = sbe::makeEs(
+            std::move(eDate),
+            eFormat ? std::move(eFormat)
+                    : sbe::makeE<sbe::EConstant>(std::string_view{
+                          Value::kISOFormatString.rawData(), Value::kISOFormatString.size()}),
+            eTimezone ? std::move(eTimezone)
+                      : sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::StringSmall, 0));
+
+        auto timeZoneDBSlot = _context->runtimeEnvironment->getSlot("timeZoneDB"_sd);
+        auto dateToString = sbe::makeE<sbe::EFunction>(
+            "dateToString",
+            sbe::makeEs(sbe::makeE<sbe::EVariable>(timeZoneDBSlot),
+                        dateRef.clone(),
+                        formatRef.clone(),
+                        timezoneRef.clone()));
+
+        // A null or missing date evaluates to 'onNull', null format or timezone evaluate to null.
+        // The builtin only returns Nothing when the format or the timezone is not a string.
+        auto dateToStringExpr = sbe::makeE<sbe::EIf>(
+            generateNullOrMissing(frameId, 0),
+            eOnNull ? std::move(eOnNull)
+                    : sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::Null, 0),
+            sbe::makeE<sbe::EIf>(
+                sbe::makeE<sbe::EPrimBinary>(sbe::EPrimBinary::logicOr,
+                                             generateNullOrMissing(frameId, 1),
+                                             generateNullOrMissing(frameId, 2)),
+                sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::Null, 0),
+                generateFallbackIfNothing(
+                    std::move(dateToString),
+                    sbe::makeE<sbe::EFail>(ErrorCodes::Error{5073200},
+                                           "$dateToString requires that 'format' and 'timezone' "
+                                           "be strings"),
+                    _context->frameIdGenerator)));
+
+        _context->pushExpr(sbe::makeE<sbe::ELocalBind>(
+            frameId, std::move(operands), std::move(dateToStringExpr)));
     }
     void visit(ExpressionDivide* expr) final {
         unsupportedExpression(expr->getOpName());
@@ -1490,10 +1566,10 @@ public:
         unsupportedExpression(expr->getOpName());
     }
     void visit(ExpressionSubstrBytes* expr) final {
-        unsupportedExpression(expr->getOpName());
+        _context->pushExpr(sbe::makeE<sbe::EFunction>("substrBytes", popArguments(3)));
     }
     void visit(ExpressionSubstrCP* expr) final {
-        unsupportedExpression(expr->getOpName());
+        _context->pushExpr(sbe::makeE<sbe::EFunction>("substrCP", popArguments(3)));
     }
     void visit(ExpressionStrLenBytes* expr) final {
         unsupportedExpression(expr->getOpName());
@@ -1511,10 +1587,10 @@ public:
         visitConditionalExpression(expr);
     }
     void visit(ExpressionToLower* expr) final {
-        unsupportedExpression(expr->getOpName());
+        _context->pushExpr(sbe::makeE<sbe::EFunction>("toLower", popArguments(1)));
     }
     void visit(ExpressionToUpper* expr) final {
-        unsupportedExpression(expr->getOpName());
+        _context->pushExpr(sbe::makeE<sbe::EFunction>("toUpper", popArguments(1)));
     }
     void visit(ExpressionTrim* expr) final {
         unsupportedExpression("$trim");
@@ -1529,7 +1605,75 @@ public:
         unsupportedExpression("$zip");
     }
     void visit(ExpressionConvert* expr) final {
-        unsupportedExpression("$convert");
+        auto children = expr->getChildren();
+        invariant(children.size() == 4);
+
+        // Only conversions to a constant numeric, string or boolean type are supported.
+        auto toExpr = dynamic_cast<ExpressionConstant*>(children[1].get());
+        if (!toExpr) {
+            unsupportedExpression("$convert");
+        }
+        boost::optional<BSONType> targetType;
+        auto toValue = toExpr->getValue();
+        if (toValue.getType() == BSONType::String) {
+            targetType = typeFromName(toValue.getStringData());
+        } else if (toValue.numeric() && isValidBSONType(toValue.coerceToInt())) {
+            targetType = static_cast<BSONType>(toValue.coerceToInt());
+        } else if (!toValue.nullish()) {
+            unsupportedExpression("$convert");
+        }
+        if (targetType) {
+            switch (*targetType) {
+                case BSONType::NumberDouble:
+                case BSONType::String:
+                case BSONType::Bool:
+                case BSONType::NumberInt:
+                case BSONType::NumberLong:
+                case BSONType::NumberDecimal:
+                    break;
+                default:
+                    unsupportedExpression("$convert");
+            }
+        }
+
+        auto eOnNull = children[3] ? _context->popExpr() : nullptr;
+        auto eOnError = children[2] ? _context->popExpr() : nullptr;
+        _context->popExpr();  // The constant 'to' expression.
+        auto eInput = _context->popExpr();
+
+        auto frameId = _context->frameIdGenerator->generate();
+        sbe::EVariable inputRef(frameId, 0);
+
+        // A null or missing input evaluates to 'onNull' and a null target type evaluates to null.
+        // A failed conversion evaluates to 'onError' when it is given and throws otherwise.
+        std::unique_ptr<sbe::EExpression> convertExpr;
+        if (targetType) {
+            convertExpr = generateFallbackIfNothing(
+                sbe::makeE<sbe::EFunction>(
+                    "convert",
+                    sbe::makeEs(inputRef.clone(),
+                                sbe::makeE<sbe::EConstant>(
+                                    sbe::value::TypeTags::NumberInt32,
+                                    sbe::value::bitcastFrom<int32_t>(*targetType)))),
+                eOnError ? std::move(eOnError)
+                         : sbe::makeE<sbe::EFail>(ErrorCodes::ConversionFailure,
+                                                  str::stream()
+                                                      << "Failed conversion to "
+                                                      << typeName(*targetType)
+                                                      << " in $convert with no onError value"),
+                _context->frameIdGenerator);
+        } else {
+            convertExpr = sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::Null, 0);
+        }
+
+        _context->pushExpr(sbe::makeE<sbe::ELocalBind>(
+            frameId,
+            sbe::makeEs(std::move(eInput)),
+            sbe::makeE<sbe::EIf>(generateNullOrMissing(frameId, 0),
+                                 eOnNull ? std::move(eOnNull)
+                                         : sbe::makeE<sbe::EConstant>(
+                                               sbe::value::TypeTags::Null, 0),
+                                 std::move(convertExpr))));
     }
     void visit(ExpressionRegexFind* expr) final {
         unsupportedExpression("$regexFind");
@@ -1625,25 +1769,25 @@ public:
         unsupportedExpression("$year");
     }
     void visit(ExpressionFromAccumulator<AccumulatorAvg>* expr) final {
-        unsupportedExpression(expr->getOpName());
+        visitAccumulatorExpression(expr, "avgOf");
     }
     void visit(ExpressionFromAccumulator<AccumulatorMax>* expr) final {
-        unsupportedExpression(expr->getOpName());
+        visitAccumulatorExpression(expr, "maxOf");
     }
     void visit(ExpressionFromAccumulator<AccumulatorMin>* expr) final {
-        unsupportedExpression(expr->getOpName());
+        visitAccumulatorExpression(expr, "minOf");
     }
     void visit(ExpressionFromAccumulator<AccumulatorStdDevPop>* expr) final {
-        unsupportedExpression(expr->getOpName());
+        visitAccumulatorExpression(expr, "stdDevPopOf");
     }
     void visit(ExpressionFromAccumulator<AccumulatorStdDevSamp>* expr) final {
-        unsupportedExpression(expr->getOpName());
+        visitAccumulatorExpression(expr, "stdDevSampOf");
     }
     void visit(ExpressionFromAccumulator<AccumulatorSum>* expr) final {
         unsupportedExpression(expr->getOpName());
     }
     void visit(ExpressionFromAccumulator<AccumulatorMergeObjects>* expr) final {
-        unsupportedExpression(expr->getOpName());
+        visitAccumulatorExpression(expr, "mergeObjects");
     }
     void visit(ExpressionTests::Testable* expr) final {
         unsupportedExpression("$test");
@@ -1751,6 +1895,35 @@ private:
         _context->generateSubTreeForSelectiveExecution();
     }
 
+    /**
+     * Pops 'arity' expressions off the stack and returns them in the order they were pushed.
+     */
+    std::vector<std::unique_ptr<sbe::EExpression>> popArguments(size_t arity) {
+        _context->ensureArity(arity);
+        std::vector<std::unique_ptr<sbe::EExpression>> args(arity);
+        for (auto it = args.rbegin(); it != args.rend(); ++it) {
+            *it = _context->popExpr();
+        }
+        return args;
+    }
+
+    /**
+     * Handle the expressions built from accumulators, e.g. {$avg: [...]}. They are evaluated by a
+     * builtin that applies the accumulator to the list of arguments, or to the elements of the
+     * array when there is a single array argument.
+     */
+    void visitAccumulatorExpression(Expression* expr, const char* builtin) {
+        auto arity = expr->getChildren().size();
+        if (arity == 0) {
+            // An empty argument list produces the same result as a list of missing values.
+            _context->pushExpr(sbe::makeE<sbe::EFunction>(
+                builtin,
+                sbe::makeEs(sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::Nothing, 0))));
+            return;
+        }
+        _context->pushExpr(sbe::makeE<sbe::EFunction>(builtin, popArguments(arity)));
+    }
+
     void unsupportedExpression(const char* op) const {
         uasserted(ErrorCodes::InternalErrorNotSupported,
                   str::stream() << "Expression is not supported in SBE: " << op);
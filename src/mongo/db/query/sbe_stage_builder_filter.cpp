@@ -90,8 +90,14 @@ using MakePredicateEExprFn =
 struct MatchExpressionVisitorContext {
     MatchExpressionVisitorContext(sbe::value::SlotIdGenerator* slotIdGenerator,
                                   std::unique_ptr<sbe::PlanStage> inputStage,
-                                  sbe::value::SlotId inputVar)
-        : slotIdGenerator{slotIdGenerator}, inputStage{std::move(inputStage)}, inputVar{inputVar} {}
+                                  sbe::value::SlotId inputVar,
+                                  sbe::RuntimeEnvironment* env,
+                                  const InputParams* inputParams)
+        : slotIdGenerator{slotIdGenerator},
+          inputStage{std::move(inputStage)},
+          inputVar{inputVar},
+          env{env},
+          inputParams{inputParams} {}
 
     std::unique_ptr<sbe::PlanStage> done() {
         if (!predicateVars.empty()) {
@@ -108,6 +114,8 @@ struct MatchExpressionVisitorContext {
     std::stack<sbe::value::SlotId> predicateVars;
     std::stack<std::pair<const MatchExpression*, size_t>> nestedLogicalExprs;
     sbe::value::SlotId inputVar;
+    sbe::RuntimeEnvironment* env;
+    const InputParams* inputParams;
 };
 
 std::unique_ptr<sbe::PlanStage> makeLimitCoScanTree(long long limit = 1) {
@@ -425,16 +433,21 @@ void generateTraverseForArraySize(MatchExpressionVisitorContext* context,
 void generateTraverseForComparisonPredicate(MatchExpressionVisitorContext* context,
                                             const ComparisonMatchExpression* expr,
                                             sbe::EPrimBinary::Op binaryOp) {
-    auto makeEExprFn = [expr, binaryOp](sbe::value::SlotId inputSlot) {
-        const auto& rhs = expr->getData();
-        auto [tagView, valView] = sbe::bson::convertFrom(
-            true, rhs.rawdata(), rhs.rawdata() + rhs.size(), rhs.fieldNameSize() - 1);
-
-        // SBE EConstant assumes ownership of the value so we have to make a copy here.
-        auto [tag, val] = sbe::value::copyValue(tagView, valView);
-
+    const auto& rhs = expr->getData();
+    auto [tagView, valView] = sbe::bson::convertFrom(
+        true, rhs.rawdata(), rhs.rawdata() + rhs.size(), rhs.fieldNameSize() - 1);
+
+    // SBE EConstant assumes ownership of the value so we have to make a copy here. The constant
+    // becomes an input parameter if the filter is built for a parameterized plan.
+    auto [tag, val] = sbe::value::copyValue(tagView, valView);
+    auto paramName =
+        context->inputParams ? context->inputParams->getFilterParamName(expr) : nullptr;
+    std::shared_ptr<sbe::EExpression> rhsExpr =
+        makeInputParam(context->env, context->slotIdGenerator, paramName, tag, val);
+
+    auto makeEExprFn = [rhsExpr, binaryOp](sbe::value::SlotId inputSlot) {
         return makeFillEmptyFalse(sbe::makeE<sbe::EPrimBinary>(
-            binaryOp, sbe::makeE<sbe::EVariable>(inputSlot), sbe::makeE<sbe::EConstant>(tag, val)));
+            binaryOp, sbe::makeE<sbe::EVariable>(inputSlot), rhsExpr->clone()));
     };
     generateTraverse(context, expr, std::move(makeEExprFn));
 }
@@ -915,14 +928,17 @@ private:
 std::unique_ptr<sbe::PlanStage> generateFilter(const MatchExpression* root,
                                                std::unique_ptr<sbe::PlanStage> stage,
                                                sbe::value::SlotIdGenerator* slotIdGenerator,
-                                               sbe::value::SlotId inputVar) {
+                                               sbe::value::SlotId inputVar,
+                                               sbe::RuntimeEnvironment* env,
+                                               const InputParams* inputParams) {
     // The planner adds an $and expression without the operands if the query was empty. We can bail
     // out early without generating the filter plan stage if this is the case.
     if (root->matchType() == MatchExpression::AND && root->numChildren() == 0) {
         return stage;
     }
 
-    MatchExpressionVisitorContext context{slotIdGenerator, std::move(stage), inputVar};
+    MatchExpressionVisitorContext context{
+        slotIdGenerator, std::move(stage), inputVar, env, inputParams};
     MatchExpressionPreVisitor preVisitor{&context};
     MatchExpressionInVisitor inVisitor{&context};
     MatchExpressionPostVisitor postVisitor{&context};
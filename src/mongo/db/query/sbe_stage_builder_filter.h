@@ -32,16 +32,21 @@
 #include "mongo/db/exec/sbe/stages/stages.h"
 #include "mongo/db/exec/sbe/values/id_generators.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/query/sbe_stage_builder_input_params.h"
 
 namespace mongo::stage_builder {
 /**
  * Generates an SBE plan stage sub-tree implementing a filter expression represented by the 'root'
  * expression. The 'stage' parameter defines an input stage to the generate SBE plan stage sub-tree.
- * The 'inputVar' defines a variable to read the input document from.
+ * The 'inputVar' defines a variable to read the input document from. If 'inputParams' are
+ * provided, the parameterized constants of the filter are registered as input parameters in the
+ * runtime environment 'env'.
  */
 std::unique_ptr<sbe::PlanStage> generateFilter(const MatchExpression* root,
                                                std::unique_ptr<sbe::PlanStage> stage,
                                                sbe::value::SlotIdGenerator* slotIdGenerator,
-                                               sbe::value::SlotId inputVar);
+                                               sbe::value::SlotId inputVar,
+                                               sbe::RuntimeEnvironment* env = nullptr,
+                                               const InputParams* inputParams = nullptr);
 
 }  // namespace mongo::stage_builder
@@ -49,12 +49,21 @@
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/query/sbe_stage_builder_input_params.h"
 #include "mongo/db/query/util/make_data_structure.h"
 #include "mongo/logv2/log.h"
 #include "mongo/util/str.h"
 
 namespace mongo::stage_builder {
 namespace {
+const IndexAccessMethod* getIndexAccessMethod(OperationContext* opCtx,
+                                              const Collection* collection,
+                                              const IndexScanNode* ixn) {
+    auto descriptor =
+        collection->getIndexCatalog()->findIndexByName(opCtx, ixn->index.identifier.catalogName);
+    return collection->getIndexCatalog()->getEntry(descriptor)->accessMethod();
+}
+
 /**
  * Returns 'true' if the index bounds in 'intervalLists' can be represented as a number of intervals
  * between low and high keys, which can be statically generated. Inclusivity of each bound is
@@ -195,11 +204,10 @@ std::vector<std::pair<BSONObj, BSONObj>> decomposeIntoSingleIntervals(
  * a single interval between the low and high keys, or multiple single intervals. If index bounds
  * for some interval cannot be expressed as valid low/high keys, then an empty vector is returned.
  */
-std::vector<std::pair<std::unique_ptr<KeyString::Value>, std::unique_ptr<KeyString::Value>>>
-makeIntervalsFromIndexBounds(const IndexBounds& bounds,
-                             bool forward,
-                             KeyString::Version version,
-                             Ordering ordering) {
+IndexIntervals makeIntervalsFromIndexBounds(const IndexBounds& bounds,
+                                           bool forward,
+                                           KeyString::Version version,
+                                           Ordering ordering) {
     auto lowKeyInclusive{IndexBounds::isStartIncludedInBound(bounds.boundInclusion)};
     auto highKeyInclusive{IndexBounds::isEndIncludedInBound(bounds.boundInclusion)};
     auto intervals = [&]() -> std::vector<std::pair<BSONObj, BSONObj>> {
@@ -220,8 +228,7 @@ makeIntervalsFromIndexBounds(const IndexBounds& bounds,
 
     LOGV2_DEBUG(
         4742905, 5, "Number of generated interval(s) for ixscan", "num"_attr = intervals.size());
-    std::vector<std::pair<std::unique_ptr<KeyString::Value>, std::unique_ptr<KeyString::Value>>>
-        result;
+    IndexIntervals result;
     for (auto&& [lowKey, highKey] : intervals) {
         LOGV2_DEBUG(4742906,
                     5,
@@ -269,33 +276,24 @@ generateOptimizedMultiIntervalIndexScan(
     const Collection* collection,
     const std::string& indexName,
     bool forward,
-    std::vector<std::pair<std::unique_ptr<KeyString::Value>, std::unique_ptr<KeyString::Value>>>
-        intervals,
+    IndexIntervals intervals,
     sbe::IndexKeysInclusionSet indexKeysToInclude,
     sbe::value::SlotVector vars,
     sbe::value::SlotIdGenerator* slotIdGenerator,
     PlanYieldPolicy* yieldPolicy,
-    TrialRunProgressTracker* tracker) {
+    TrialRunProgressTracker* tracker,
+    sbe::RuntimeEnvironment* env,
+    const std::string* paramName) {
     using namespace std::literals;
 
     auto recordIdSlot = slotIdGenerator->generate();
     auto lowKeySlot = slotIdGenerator->generate();
     auto highKeySlot = slotIdGenerator->generate();
 
-    // Construct an array containing objects with the low and high keys for each interval. E.g.,
-    //    [ {l: KS(...), h: KS(...)},
-    //      {l: KS(...), h: KS(...)}, ... ]
-    auto [boundsTag, boundsVal] = sbe::value::makeNewArray();
-    auto arr = sbe::value::getArrayView(boundsVal);
-    for (auto&& [lowKey, highKey] : intervals) {
-        auto [tag, val] = sbe::value::makeNewObject();
-        auto obj = sbe::value::getObjectView(val);
-        obj->push_back(
-            "l"sv, sbe::value::TypeTags::ksValue, sbe::value::bitcastFrom(lowKey.release()));
-        obj->push_back(
-            "h"sv, sbe::value::TypeTags::ksValue, sbe::value::bitcastFrom(highKey.release()));
-        arr->push_back(tag, val);
-    }
+    auto [boundsTag, boundsVal] = packIndexIntervals(std::move(intervals));
+    auto boundsName = paramName
+        ? boost::make_optional(*paramName + InputParams::kIntervalsSuffix)
+        : boost::none;
 
     auto boundsSlot = slotIdGenerator->generate();
     auto unwindSlot = slotIdGenerator->generate();
@@ -306,7 +304,8 @@ generateOptimizedMultiIntervalIndexScan(
         sbe::makeProjectStage(
             sbe::makeS<sbe::LimitSkipStage>(sbe::makeS<sbe::CoScanStage>(), 1, boost::none),
             boundsSlot,
-            sbe::makeE<sbe::EConstant>(boundsTag, boundsVal)),
+            makeInputParam(
+                env, slotIdGenerator, boundsName.get_ptr(), boundsTag, boundsVal)),
         boundsSlot,
         unwindSlot,
         slotIdGenerator->generate(), /* We don't need an index slot but must to provide it. */
@@ -586,6 +585,37 @@ generateGenericMultiIntervalIndexScan(const Collection* collection,
 }
 }  // namespace
 
+IndexIntervals makeIndexScanIntervals(OperationContext* opCtx,
+                                      const Collection* collection,
+                                      const IndexScanNode* ixn) {
+    auto accessMethod = getIndexAccessMethod(opCtx, collection, ixn);
+    return makeIntervalsFromIndexBounds(
+        ixn->bounds,
+        ixn->direction == 1,
+        accessMethod->getSortedDataInterface()->getKeyStringVersion(),
+        accessMethod->getSortedDataInterface()->getOrdering());
+}
+
+std::pair<sbe::value::TypeTags, sbe::value::Value> packIndexIntervals(IndexIntervals intervals) {
+    using namespace std::literals;
+
+    // Construct an array containing objects with the low and high keys for each interval. E.g.,
+    //    [ {l: KS(...), h: KS(...)},
+    //      {l: KS(...), h: KS(...)}, ... ]
+    auto [boundsTag, boundsVal] = sbe::value::makeNewArray();
+    auto arr = sbe::value::getArrayView(boundsVal);
+    for (auto&& [lowKey, highKey] : intervals) {
+        auto [tag, val] = sbe::value::makeNewObject();
+        auto obj = sbe::value::getObjectView(val);
+        obj->push_back(
+            "l"sv, sbe::value::TypeTags::ksValue, sbe::value::bitcastFrom(lowKey.release()));
+        obj->push_back(
+            "h"sv, sbe::value::TypeTags::ksValue, sbe::value::bitcastFrom(highKey.release()));
+        arr->push_back(tag, val);
+    }
+    return {boundsTag, boundsVal};
+}
+
 std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateSingleIntervalIndexScan(
     const Collection* collection,
     const std::string& indexName,
@@ -597,21 +627,36 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateSingleInt
     boost::optional<sbe::value::SlotId> recordSlot,
     sbe::value::SlotIdGenerator* slotIdGenerator,
     PlanYieldPolicy* yieldPolicy,
-    TrialRunProgressTracker* tracker) {
+    TrialRunProgressTracker* tracker,
+    sbe::RuntimeEnvironment* env,
+    const std::string* paramName) {
     auto recordIdSlot = slotIdGenerator->generate();
     auto lowKeySlot = slotIdGenerator->generate();
     auto highKeySlot = slotIdGenerator->generate();
 
+    auto lowKeyName = paramName
+        ? boost::make_optional(*paramName + InputParams::kLowKeySuffix)
+        : boost::none;
+    auto highKeyName = paramName
+        ? boost::make_optional(*paramName + InputParams::kHighKeySuffix)
+        : boost::none;
+
     // Construct a constant table scan to deliver a single row with two fields 'lowKeySlot' and
     // 'highKeySlot', representing seek boundaries, into the index scan.
     auto project = sbe::makeProjectStage(
         sbe::makeS<sbe::LimitSkipStage>(sbe::makeS<sbe::CoScanStage>(), 1, boost::none),
         lowKeySlot,
-        sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::ksValue,
-                                   sbe::value::bitcastFrom(lowKey.release())),
+        makeInputParam(env,
+                       slotIdGenerator,
+                       lowKeyName.get_ptr(),
+                       sbe::value::TypeTags::ksValue,
+                       sbe::value::bitcastFrom(lowKey.release())),
         highKeySlot,
-        sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::ksValue,
-                                   sbe::value::bitcastFrom(highKey.release())));
+        makeInputParam(env,
+                       slotIdGenerator,
+                       highKeyName.get_ptr(),
+                       sbe::value::TypeTags::ksValue,
+                       sbe::value::bitcastFrom(highKey.release())));
 
     // Scan the index in the range {'lowKeySlot', 'highKeySlot'} (subject to inclusive or
     // exclusive boundaries), and produce a single field recordIdSlot that can be used to
@@ -647,18 +692,15 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
     sbe::value::SlotIdGenerator* slotIdGenerator,
     sbe::value::SpoolIdGenerator* spoolIdGenerator,
     PlanYieldPolicy* yieldPolicy,
-    TrialRunProgressTracker* tracker) {
+    TrialRunProgressTracker* tracker,
+    sbe::RuntimeEnvironment* env,
+    const InputParams* inputParams) {
     invariant(returnKeySlot || !ixn->addKeyMetadata);
     uassert(4822864, "Index scans with a filter are not supported in SBE", !ixn->filter);
 
-    auto descriptor =
-        collection->getIndexCatalog()->findIndexByName(opCtx, ixn->index.identifier.catalogName);
-    auto accessMethod = collection->getIndexCatalog()->getEntry(descriptor)->accessMethod();
-    auto intervals =
-        makeIntervalsFromIndexBounds(ixn->bounds,
-                                     ixn->direction == 1,
-                                     accessMethod->getSortedDataInterface()->getKeyStringVersion(),
-                                     accessMethod->getSortedDataInterface()->getOrdering());
+    auto accessMethod = getIndexAccessMethod(opCtx, collection, ixn);
+    auto intervals = makeIndexScanIntervals(opCtx, collection, ixn);
+    auto paramName = inputParams ? inputParams->getIndexScanParamName(ixn) : nullptr;
 
 
     auto [returnKeyExpr, vars, indexKeysToInclude] =
@@ -707,7 +749,9 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
                                                    boost::none,  // recordSlot
                                                    slotIdGenerator,
                                                    yieldPolicy,
-                                                   tracker);
+                                                   tracker,
+                                                   env,
+                                                   paramName);
         } else if (intervals.size() > 1) {
             // Or, if we were able to decompose multi-interval index bounds into a number of
             // single-interval bounds, we can also built an optimized sub-tree to perform an index
@@ -720,7 +764,9 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
                                                            vars,
                                                            slotIdGenerator,
                                                            yieldPolicy,
-                                                           tracker);
+                                                           tracker,
+                                                           env,
+                                                           paramName);
         } else {
             // Otherwise, build a generic index scan for multi-interval index bounds.
             return generateGenericMultiIntervalIndexScan(
@@ -737,7 +783,7 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
         }
     }();
 
-    if (ixn->shouldDedup) {
+    if (indexScanNeedsDedup(ixn)) {
         sbe::value::SlotMap<std::unique_ptr<sbe::EExpression>> forwardedVarSlots;
         for (auto varSlot : vars) {
             forwardedVarSlots.insert(
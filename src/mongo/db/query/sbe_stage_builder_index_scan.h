@@ -33,10 +33,39 @@
 #include "mongo/db/exec/sbe/values/id_generators.h"
 #include "mongo/db/exec/trial_run_progress_tracker.h"
 #include "mongo/db/query/query_solution.h"
+#include "mongo/db/query/sbe_stage_builder_input_params.h"
 
 namespace mongo::stage_builder {
+using IndexIntervals =
+    std::vector<std::pair<std::unique_ptr<KeyString::Value>, std::unique_ptr<KeyString::Value>>>;
+
+/**
+ * Returns the low/high seek keys of the intervals an index scan built for 'ixn' seeks through, or
+ * an empty vector if the index bounds cannot be represented as such intervals, in which case a
+ * generic index scan is used.
+ */
+IndexIntervals makeIndexScanIntervals(OperationContext* opCtx,
+                                      const Collection* collection,
+                                      const IndexScanNode* ixn);
+
 /**
- * Generates an SBE plan stage sub-tree implementing an index scan.
+ * Packs the given 'intervals' into an array of {l: KS(...), h: KS(...)} objects, which is unwound
+ * to feed the intervals into a multi-interval index scan.
+ */
+std::pair<sbe::value::TypeTags, sbe::value::Value> packIndexIntervals(IndexIntervals intervals);
+
+/**
+ * Returns true if the index scan built for 'ixn' must remove duplicate record ids from its output.
+ * A scan over a single point of a multikey index cannot see the same record id twice, so it does
+ * not need to be deduplicated and keeps its output sorted by record id.
+ */
+inline bool indexScanNeedsDedup(const IndexScanNode* ixn) {
+    return ixn->shouldDedup && !ixn->sortedByDiskLoc();
+}
+
+/**
+ * Generates an SBE plan stage sub-tree implementing an index scan. If 'inputParams' are provided,
+ * the index bounds are registered as input parameters in the runtime environment 'env'.
  */
 std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan(
     OperationContext* opCtx,
@@ -46,7 +75,9 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
     sbe::value::SlotIdGenerator* slotIdGenerator,
     sbe::value::SpoolIdGenerator* spoolIdGenerator,
     PlanYieldPolicy* yieldPolicy,
-    TrialRunProgressTracker* tracker);
+    TrialRunProgressTracker* tracker,
+    sbe::RuntimeEnvironment* env = nullptr,
+    const InputParams* inputParams = nullptr);
 
 /**
  * Constructs the most simple version of an index scan from the single interval index bounds. The
@@ -65,6 +96,9 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
  *
  * If 'recordSlot' is provided, than the corresponding slot will be filled out with each KeyString
  * in the index.
+ *
+ * If 'paramName' is provided, the low and high keys are registered as input parameters with this
+ * name prefix in the runtime environment 'env', rather than embedded as constants.
  */
 std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateSingleIntervalIndexScan(
     const Collection* collection,
@@ -77,5 +111,7 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateSingleInt
     boost::optional<sbe::value::SlotId> recordSlot,
     sbe::value::SlotIdGenerator* slotIdGenerator,
     PlanYieldPolicy* yieldPolicy,
-    TrialRunProgressTracker* tracker);
+    TrialRunProgressTracker* tracker,
+    sbe::RuntimeEnvironment* env = nullptr,
+    const std::string* paramName = nullptr);
 }  // namespace mongo::stage_builder
@@ -0,0 +1,217 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/sbe_stage_builder_input_params.h"
+
+#include "mongo/db/exec/sbe/values/bson.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/query/sbe_stage_builder_index_scan.h"
+
+namespace mongo::stage_builder {
+InputParams::~InputParams() {
+    for (auto&& param : _params) {
+        sbe::value::releaseValue(param.tag, param.val);
+    }
+}
+
+boost::optional<InputParams> InputParams::collect(OperationContext* opCtx,
+                                                  const Collection* collection,
+                                                  const CanonicalQuery& cq,
+                                                  const QuerySolution& solution) {
+    InputParams params;
+
+    // The projection and the memory limits of a blocking sort are not fully captured by the
+    // solution tree, but are embedded into the plan tree by the stage builder.
+    params._shape = str::stream()
+        << cq.getQueryRequest().getProj() << cq.getExpCtx()->allowDiskUse
+        << internalQueryMaxBlockingSortMemoryUsageBytes.load();
+    if (!params.collectNode(opCtx, collection, solution.root.get(), "param")) {
+        return boost::none;
+    }
+    return std::move(params);
+}
+
+bool InputParams::collectNode(OperationContext* opCtx,
+                              const Collection* collection,
+                              const QuerySolutionNode* node,
+                              const std::string& name) {
+    _shape += str::stream() << "{" << node->getType();
+
+    switch (node->getType()) {
+        case STAGE_COLLSCAN: {
+            // Tailable and oplog scans track the state of a particular execution, and parallel
+            // scans share a read-only runtime environment between the threads.
+            auto csn = static_cast<const CollectionScanNode*>(node);
+            if (csn->tailable || csn->minTs || csn->maxTs || csn->resumeAfterRecordId ||
+                csn->requestResumeToken || csn->shouldTrackLatestOplogTimestamp ||
+                internalQueryDefaultDOP.load() > 1) {
+                return false;
+            }
+            _shape += str::stream() << " " << csn->direction << " "
+                                    << internalQuerySlotBasedExecutionEnableBlockMode.load();
+            break;
+        }
+        case STAGE_IXSCAN: {
+            auto ixn = static_cast<const IndexScanNode*>(node);
+            if (ixn->filter || ixn->addKeyMetadata) {
+                return false;
+            }
+
+            auto intervals = makeIndexScanIntervals(opCtx, collection, ixn);
+            if (intervals.empty()) {
+                // The generic index scan embeds the bounds into the plan tree.
+                return false;
+            }
+
+            _shape += str::stream() << " " << ixn->index.identifier.catalogName << " "
+                                    << ixn->direction << " " << indexScanNeedsDedup(ixn);
+            if (intervals.size() == 1) {
+                _shape += " ?single";
+                auto&& [lowKey, highKey] = intervals[0];
+                addParam(name + kLowKeySuffix,
+                         sbe::value::TypeTags::ksValue,
+                         sbe::value::bitcastFrom(lowKey.release()));
+                addParam(name + kHighKeySuffix,
+                         sbe::value::TypeTags::ksValue,
+                         sbe::value::bitcastFrom(highKey.release()));
+            } else {
+                _shape += " ?multi";
+                auto [tag, val] = packIndexIntervals(std::move(intervals));
+                addParam(name + kIntervalsSuffix, tag, val);
+            }
+            _names.emplace(ixn, name);
+            break;
+        }
+        case STAGE_FETCH:
+        case STAGE_PROJECTION_SIMPLE:
+        case STAGE_PROJECTION_DEFAULT:
+            break;
+        case STAGE_OR:
+            _shape += str::stream() << " " << static_cast<const OrNode*>(node)->dedup;
+            break;
+        case STAGE_LIMIT:
+            _shape += str::stream() << " " << static_cast<const LimitNode*>(node)->limit;
+            break;
+        case STAGE_SKIP:
+            _shape += str::stream() << " " << static_cast<const SkipNode*>(node)->skip;
+            break;
+        case STAGE_SORT_SIMPLE:
+        case STAGE_SORT_DEFAULT: {
+            auto sn = static_cast<const SortNode*>(node);
+            _shape += str::stream() << " " << sn->pattern << " " << sn->limit;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    if (node->filter && !collectFilter(node->filter.get(), name + "/f")) {
+        return false;
+    }
+
+    for (size_t idx = 0; idx < node->children.size(); ++idx) {
+        if (!collectNode(
+                opCtx, collection, node->children[idx], str::stream() << name << "." << idx)) {
+            return false;
+        }
+    }
+
+    _shape += "}";
+    return true;
+}
+
+bool InputParams::collectFilter(const MatchExpression* expr, const std::string& name) {
+    _shape += str::stream() << "{" << expr->matchType() << " " << expr->path();
+
+    switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOT:
+            for (size_t idx = 0; idx < expr->numChildren(); ++idx) {
+                if (!collectFilter(expr->getChild(idx), str::stream() << name << "." << idx)) {
+                    return false;
+                }
+            }
+            break;
+        case MatchExpression::EXISTS:
+        case MatchExpression::ALWAYS_FALSE:
+        case MatchExpression::ALWAYS_TRUE:
+            break;
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            const auto& rhs = static_cast<const ComparisonMatchExpression*>(expr)->getData();
+            auto [tagView, valView] = sbe::bson::convertFrom(
+                true, rhs.rawdata(), rhs.rawdata() + rhs.size(), rhs.fieldNameSize() - 1);
+            auto [tag, val] = sbe::value::copyValue(tagView, valView);
+            addParam(name, tag, val);
+            _names.emplace(expr, name);
+            _shape += " ?";
+            break;
+        }
+        default:
+            // Other predicates embed their constants into the plan tree.
+            return false;
+    }
+
+    _shape += "}";
+    return true;
+}
+
+void InputParams::addParam(std::string name, sbe::value::TypeTags tag, sbe::value::Value val) {
+    _params.push_back({std::move(name), tag, val});
+}
+
+void InputParams::bind(sbe::RuntimeEnvironment* env) {
+    for (auto&& param : _params) {
+        env->resetSlot(env->getSlot(param.name), param.tag, param.val, true);
+        // The environment has taken ownership of the value.
+        param.tag = sbe::value::TypeTags::Nothing;
+    }
+    _params.clear();
+}
+
+std::unique_ptr<sbe::EExpression> makeInputParam(sbe::RuntimeEnvironment* env,
+                                                 sbe::value::SlotIdGenerator* slotIdGenerator,
+                                                 const std::string* name,
+                                                 sbe::value::TypeTags tag,
+                                                 sbe::value::Value val) {
+    if (!name) {
+        return sbe::makeE<sbe::EConstant>(tag, val);
+    }
+
+    invariant(env);
+    return sbe::makeE<sbe::EVariable>(env->registerSlot(*name, tag, val, true, slotIdGenerator));
+}
+}  // namespace mongo::stage_builder
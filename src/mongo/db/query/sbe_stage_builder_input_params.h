@@ -0,0 +1,132 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/exec/sbe/values/id_generators.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/stdx/unordered_map.h"
+
+namespace mongo::stage_builder {
+/**
+ * Describes the constants of a QuerySolution which the SBE stage builder can turn into slots of the
+ * runtime environment, rather than embedding them into the plan tree. A tree built this way can be
+ * cached and reused for any other query whose solution has the same shape, by binding the slots to
+ * the constants of that query.
+ *
+ * Each input parameter is named after the position of its source in the solution tree. All the
+ * other properties of the solution which the stage builder bakes into the tree (stage types, field
+ * paths, limits, index names and so on) are captured by the 'shape' string, so two solutions with
+ * equal shapes produce identical trees up to the values of the input parameters.
+ */
+class InputParams {
+public:
+    static constexpr auto kLowKeySuffix = ".low"_sd;
+    static constexpr auto kHighKeySuffix = ".high"_sd;
+    static constexpr auto kIntervalsSuffix = ".intervals"_sd;
+
+    InputParams() = default;
+    InputParams(InputParams&&) = default;
+    InputParams& operator=(InputParams&&) = default;
+    ~InputParams();
+
+    /**
+     * Collects the input parameters of the given 'solution'. Returns boost::none if the solution
+     * contains a constant which the stage builder cannot parameterize, or a stage which depends on
+     * the state of a particular execution, in which case a tree built for this solution cannot be
+     * reused by other queries.
+     */
+    static boost::optional<InputParams> collect(OperationContext* opCtx,
+                                                const Collection* collection,
+                                                const CanonicalQuery& cq,
+                                                const QuerySolution& solution);
+
+    const std::string& shape() const {
+        return _shape;
+    }
+
+    /**
+     * Returns the name of the input parameter for the constant of the given comparison 'expr', or
+     * nullptr if the constant is not parameterized.
+     */
+    const std::string* getFilterParamName(const MatchExpression* expr) const {
+        auto it = _names.find(expr);
+        return it != _names.end() ? &it->second : nullptr;
+    }
+
+    /**
+     * Returns the name prefix of the input parameters for the index bounds of the given 'ixn'. The
+     * low and high keys of a single interval scan are named with the 'kLowKeySuffix' and
+     * 'kHighKeySuffix' suffixes, and the intervals of a multi-interval scan are named with the
+     * 'kIntervalsSuffix' suffix. Returns nullptr if the bounds are not parameterized.
+     */
+    const std::string* getIndexScanParamName(const IndexScanNode* ixn) const {
+        auto it = _names.find(ixn);
+        return it != _names.end() ? &it->second : nullptr;
+    }
+
+    /**
+     * Moves the values of the collected input parameters into the slots of the runtime environment
+     * 'env', which must have been produced by building a tree for a solution of the same shape.
+     */
+    void bind(sbe::RuntimeEnvironment* env);
+
+private:
+    struct Param {
+        std::string name;
+        sbe::value::TypeTags tag;
+        sbe::value::Value val;
+    };
+
+    bool collectNode(OperationContext* opCtx,
+                     const Collection* collection,
+                     const QuerySolutionNode* node,
+                     const std::string& name);
+    bool collectFilter(const MatchExpression* expr, const std::string& name);
+    void addParam(std::string name, sbe::value::TypeTags tag, sbe::value::Value val);
+
+    std::string _shape;
+    stdx::unordered_map<const void*, std::string> _names;
+    std::vector<Param> _params;
+};
+
+/**
+ * Returns an expression producing the owned value 'tag'/'val'. If a parameter 'name' is given, the
+ * value is stored in a new slot of the runtime environment 'env' registered under this name and the
+ * expression reads this slot, so that the value can be rebound with InputParams::bind(). Otherwise,
+ * the value is embedded into the expression as a constant.
+ */
+std::unique_ptr<sbe::EExpression> makeInputParam(sbe::RuntimeEnvironment* env,
+                                                 sbe::value::SlotIdGenerator* slotIdGenerator,
+                                                 const std::string* name,
+                                                 sbe::value::TypeTags tag,
+                                                 sbe::value::Value val);
+}  // namespace mongo::stage_builder
@@ -75,4 +75,36 @@ buildSlotBasedExecutableTree(OperationContext* opCtx,
     auto data = builder->getPlanStageData();
     return {std::move(root), std::move(data)};
 }
+
+boost::optional<std::pair<std::unique_ptr<sbe::PlanStage>, stage_builder::PlanStageData>>
+cloneCachedPlanTree(OperationContext* opCtx,
+                    const Collection* collection,
+                    const CanonicalQuery& cq,
+                    const QuerySolution& solution,
+                    const CachedPlanTree& cachedTree,
+                    PlanYieldPolicy* yieldPolicy) {
+    invariant(!cq.canHaveNoopMatchNodes());
+    invariant(solution.root);
+
+    auto inputParams = InputParams::collect(opCtx, collection, cq, solution);
+    if (!inputParams || inputParams->shape() != *cachedTree.data.inputParamsShape) {
+        return boost::none;
+    }
+
+    auto root = cachedTree.root->clone();
+    auto data = cachedTree.data.makeCopy();
+
+    const auto maxNumResults{trial_period::getTrialPeriodNumToReturn(cq)};
+    const auto maxNumReads{trial_period::getTrialPeriodMaxWorks(opCtx, collection)};
+    data.trialRunProgressTracker =
+        std::make_unique<TrialRunProgressTracker>(maxNumResults, maxNumReads);
+
+    // The cloned stages still point to the yield policy and the trial run tracker of the query
+    // which populated the cache entry.
+    root->attachNewYieldPolicy(yieldPolicy);
+    root->attachNewTrialRunTracker(data.trialRunProgressTracker.get());
+
+    inputParams->bind(data.env);
+    return std::make_pair(std::move(root), std::move(data));
+}
 }  // namespace mongo::stage_builder
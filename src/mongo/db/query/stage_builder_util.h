@@ -58,4 +58,21 @@ buildSlotBasedExecutableTree(OperationContext* opCtx,
                              PlanYieldPolicy* yieldPolicy,
                              bool needsTrialRunProgressTracker);
 
+/**
+ * Produces an executable tree for 'solution' by cloning the tree stored in the plan cache entry
+ * 'cachedTree', rather than building it from scratch, and binding the runtime parameters of the
+ * clone to the constants of 'cq'. The clone is set up to run a trial period, same as a tree built
+ * by buildSlotBasedExecutableTree() with 'needsTrialRunProgressTracker' set to true.
+ *
+ * Returns boost::none if 'solution' does not have the same shape as the solution 'cachedTree' was
+ * built from, in which case the caller must build the tree from scratch.
+ */
+boost::optional<std::pair<std::unique_ptr<sbe::PlanStage>, stage_builder::PlanStageData>>
+cloneCachedPlanTree(OperationContext* opCtx,
+                    const Collection* collection,
+                    const CanonicalQuery& cq,
+                    const QuerySolution& solution,
+                    const CachedPlanTree& cachedTree,
+                    PlanYieldPolicy* yieldPolicy);
+
 }  // namespace mongo::stage_builder
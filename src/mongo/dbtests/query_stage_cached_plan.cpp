@@ -38,6 +38,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/dbhelpers.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/mock_stage.h"
 #include "mongo/db/jsobj.h"
@@ -168,6 +169,61 @@ public:
         ASSERT_OK(cachedPlanStage.pickBestPlan(&yieldPolicy));
     }
 
+    /**
+     * Returns a CachedPlanStage whose trial period ends once it returns the document {_id: 8},
+     * but which then makes no progress for far longer than its 'decisionWorks' suggests. The trial
+     * period must end after one result.
+     */
+    std::unique_ptr<CachedPlanStage> makeStallingCachedPlan(const Collection* collection,
+                                                            CanonicalQuery* cq) {
+        QueryPlannerParams plannerParams;
+        fillOutPlannerParams(&_opCtx, collection, cq, &plannerParams);
+
+        auto mockChild = std::make_unique<MockStage>(_expCtx.get(), &_ws);
+        {
+            WorkingSetID id = _ws.allocate();
+            WorkingSetMember* member = _ws.get(id);
+            member->recordId = Helpers::findOne(&_opCtx, collection, BSON("_id" << 8), false);
+            member->doc = {SnapshotId(), Document{BSON("_id" << 8 << "a" << 8 << "b" << 1)}};
+            _ws.transitionToRecordIdAndObj(id);
+            mockChild->enqueueAdvanced(id);
+        }
+        for (size_t i = 0; i < 3000; i++) {
+            mockChild->enqueueStateCode(PlanStage::NEED_TIME);
+        }
+
+        const size_t decisionWorks = 10;
+        auto cachedPlanStage = std::make_unique<CachedPlanStage>(_expCtx.get(),
+                                                                 collection,
+                                                                 &_ws,
+                                                                 cq,
+                                                                 plannerParams,
+                                                                 decisionWorks,
+                                                                 std::move(mockChild));
+
+        NoopYieldPolicy yieldPolicy(_opCtx.getServiceContext()->getFastClockSource());
+        ASSERT_OK(cachedPlanStage->pickBestPlan(&yieldPolicy));
+        return cachedPlanStage;
+    }
+
+    /**
+     * Works 'stage' to EOF and returns the _id of each result.
+     */
+    std::vector<int> getResultIds(CachedPlanStage* stage) {
+        std::vector<int> ids;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (state != PlanStage::IS_EOF) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            state = stage->work(&id);
+            if (state == PlanStage::ADVANCED) {
+                ids.push_back(_ws.get(id)->doc.value()["_id"].getInt());
+                _ws.free(id);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
 protected:
     const ServiceContext::UniqueOperationContext _opCtxPtr = cc().makeOperationContext();
     OperationContext& _opCtx = *_opCtxPtr;
@@ -529,4 +585,110 @@ TEST_F(QueryStageCachedPlan, DoesNotThrowOnYieldRecoveryWhenIndexIsDroppedAferPl
     cachedPlanStage.restoreState();
 }
 
+TEST_F(QueryStageCachedPlan, ReplansDuringExecutionWhenCachedPlanStalls) {
+    const auto oldMaxResults = internalQueryPlanEvaluationMaxResults.load();
+    const auto oldMinWorks = internalQueryAdaptiveReplanningMinWorks.load();
+    internalQueryPlanEvaluationMaxResults.store(1);
+    internalQueryEnableAdaptiveReplanning.store(true);
+    internalQueryAdaptiveReplanningMinWorks.store(0);
+    ON_BLOCK_EXIT([&] {
+        internalQueryPlanEvaluationMaxResults.store(oldMaxResults);
+        internalQueryEnableAdaptiveReplanning.store(false);
+        internalQueryAdaptiveReplanningMinWorks.store(oldMinWorks);
+    });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    const Collection* collection = ctx.getCollection();
+    ASSERT(collection);
+    auto cq = canonicalQueryFromFilterObj(opCtx(), nss, fromjson("{a: {$gte: 8}, b: 1}"));
+
+    auto cachedPlanStage = makeStallingCachedPlan(collection, cq.get());
+
+    // The new plan finds both matching documents, but {_id: 8} was already returned by the cached
+    // plan, so it is not returned again.
+    ASSERT(getResultIds(cachedPlanStage.get()) == std::vector<int>({8, 9}));
+
+    auto stats = static_cast<const CachedPlanStats*>(cachedPlanStage->getSpecificStats());
+    ASSERT(stats->replanReason);
+    ASSERT_STRING_CONTAINS(*stats->replanReason, "during execution");
+
+    // The plan chosen by replanning is cached.
+    PlanCache* cache = CollectionQueryInfo::get(collection).getPlanCache();
+    ASSERT_NE(cache->get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
+}
+
+TEST_F(QueryStageCachedPlan, DoesNotReplanDuringExecutionUnlessEnabled) {
+    const auto oldMaxResults = internalQueryPlanEvaluationMaxResults.load();
+    internalQueryPlanEvaluationMaxResults.store(1);
+    ON_BLOCK_EXIT([&] { internalQueryPlanEvaluationMaxResults.store(oldMaxResults); });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    const Collection* collection = ctx.getCollection();
+    ASSERT(collection);
+    auto cq = canonicalQueryFromFilterObj(opCtx(), nss, fromjson("{a: {$gte: 8}, b: 1}"));
+
+    auto cachedPlanStage = makeStallingCachedPlan(collection, cq.get());
+    ASSERT(getResultIds(cachedPlanStage.get()) == std::vector<int>({8}));
+    auto stats = static_cast<const CachedPlanStats*>(cachedPlanStage->getSpecificStats());
+    ASSERT_FALSE(stats->replanReason);
+}
+
+TEST_F(QueryStageCachedPlan, DoesNotReplanDuringExecutionWhenReturnedResultsCannotBeSkipped) {
+    const auto oldMaxResults = internalQueryPlanEvaluationMaxResults.load();
+    const auto oldMaxDedupRecordIds = internalQueryAdaptiveReplanningMaxDedupRecordIds.load();
+    internalQueryPlanEvaluationMaxResults.store(1);
+    internalQueryEnableAdaptiveReplanning.store(true);
+    const auto oldMinWorks = internalQueryAdaptiveReplanningMinWorks.load();
+    internalQueryAdaptiveReplanningMaxDedupRecordIds.store(0);
+    internalQueryAdaptiveReplanningMinWorks.store(0);
+    ON_BLOCK_EXIT([&] {
+        internalQueryPlanEvaluationMaxResults.store(oldMaxResults);
+        internalQueryEnableAdaptiveReplanning.store(false);
+        internalQueryAdaptiveReplanningMaxDedupRecordIds.store(oldMaxDedupRecordIds);
+        internalQueryAdaptiveReplanningMinWorks.store(oldMinWorks);
+    });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    const Collection* collection = ctx.getCollection();
+    ASSERT(collection);
+    auto cq = canonicalQueryFromFilterObj(opCtx(), nss, fromjson("{a: {$gte: 8}, b: 1}"));
+
+    // The RecordId of the result returned at the end of the trial period cannot be remembered, so
+    // a new plan could return it again.
+    auto cachedPlanStage = makeStallingCachedPlan(collection, cq.get());
+    ASSERT(getResultIds(cachedPlanStage.get()) == std::vector<int>({8}));
+    auto stats = static_cast<const CachedPlanStats*>(cachedPlanStage->getSpecificStats());
+    ASSERT_FALSE(stats->replanReason);
+}
+
+TEST_F(QueryStageCachedPlan, DoesNotReplanDuringExecutionAfterReturningSortedResults) {
+    const auto oldMaxResults = internalQueryPlanEvaluationMaxResults.load();
+    const auto oldMinWorks = internalQueryAdaptiveReplanningMinWorks.load();
+    internalQueryPlanEvaluationMaxResults.store(1);
+    internalQueryEnableAdaptiveReplanning.store(true);
+    internalQueryAdaptiveReplanningMinWorks.store(0);
+    ON_BLOCK_EXIT([&] {
+        internalQueryPlanEvaluationMaxResults.store(oldMaxResults);
+        internalQueryEnableAdaptiveReplanning.store(false);
+        internalQueryAdaptiveReplanningMinWorks.store(oldMinWorks);
+    });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    const Collection* collection = ctx.getCollection();
+    ASSERT(collection);
+    auto qr = std::make_unique<QueryRequest>(nss);
+    qr->setFilter(fromjson("{a: {$gte: 8}, b: 1}"));
+    qr->setSort(BSON("a" << 1));
+    auto statusWithCQ = CanonicalQuery::canonicalize(opCtx(), std::move(qr));
+    ASSERT_OK(statusWithCQ.getStatus());
+    auto cq = std::move(statusWithCQ.getValue());
+
+    // The result returned at the end of the trial period cannot be skipped by a new plan, since
+    // results are returned in sort order, so the stalling plan is never replaced.
+    auto cachedPlanStage = makeStallingCachedPlan(collection, cq.get());
+    ASSERT(getResultIds(cachedPlanStage.get()) == std::vector<int>({8}));
+    auto stats = static_cast<const CachedPlanStats*>(cachedPlanStage->getSpecificStats());
+    ASSERT_FALSE(stats->replanReason);
+}
+
 }  // namespace QueryStageCachedPlan
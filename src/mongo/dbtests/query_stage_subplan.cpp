@@ -45,6 +45,7 @@
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/mock_yield_policies.h"
+#include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/assert_util.h"
@@ -512,6 +513,60 @@ TEST_F(QueryStageSubplanTest, QueryStageSubplanPlanRootedOrNE) {
     ASSERT_EQ(numResults, 4U);
 }
 
+/**
+ * The composite plan for an $or is built from index tags, which cannot describe a skip scan. Ensure
+ * that the branches of an $or are planned without skip scans even if the planner may generate them.
+ */
+TEST_F(QueryStageSubplanTest, QueryStageSubplanDoesNotGenerateSkipScansForBranches) {
+    dbtests::WriteContextForTests ctx(opCtx(), nss.ns());
+    addIndex(BSON("a" << 1 << "b" << 1));
+    addIndex(BSON("c" << 1));
+
+    for (int i = 0; i < 10; i++) {
+        insert(BSON("a" << 1 << "b" << i << "c" << i));
+    }
+
+    auto qr = std::make_unique<QueryRequest>(nss);
+    qr->setFilter(fromjson("{$or: [{b: 5}, {c: 1}]}"));
+    auto cq = unittest::assertGet(CanonicalQuery::canonicalize(opCtx(), std::move(qr)));
+
+    Collection* collection = ctx.getCollection();
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(opCtx(), collection, cq.get(), &plannerParams);
+    plannerParams.options |= QueryPlannerParams::GENERATE_SKIP_SCANS;
+
+    auto planningResult = unittest::assertGet(
+        QueryPlanner::planSubqueries(opCtx(), collection, nullptr, *cq, plannerParams));
+    ASSERT_EQ(planningResult.branches.size(), 2U);
+    for (auto&& branch : planningResult.branches) {
+        ASSERT_FALSE(branch->solutions.empty());
+        for (auto&& soln : branch->solutions) {
+            ASSERT_FALSE(soln->cacheData &&
+                         soln->cacheData->solnType == SolutionCacheData::SKIP_IXSCAN_SOLN);
+        }
+    }
+
+    WorkingSet ws;
+    std::unique_ptr<SubplanStage> subplan(
+        new SubplanStage(_expCtx.get(), collection, &ws, plannerParams, cq.get()));
+
+    NoopYieldPolicy yieldPolicy(_clock);
+    ASSERT_OK(subplan->pickBestPlan(&yieldPolicy));
+
+    size_t numResults = 0;
+    PlanStage::StageState stageState = PlanStage::NEED_TIME;
+    while (stageState != PlanStage::IS_EOF) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        stageState = subplan->work(&id);
+        if (stageState == PlanStage::ADVANCED) {
+            ++numResults;
+        }
+    }
+
+    ASSERT_EQ(numResults, 2U);
+}
+
 TEST_F(QueryStageSubplanTest, ShouldReportErrorIfExceedsTimeLimitDuringPlanning) {
     dbtests::WriteContextForTests ctx(opCtx(), nss.ns());
     // Build a query with a rooted $or.